@@ -0,0 +1,187 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "BenchmarkSupport.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+uint64_t HugBenchmarkGetNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+static int sCompareUInt64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+
+HugBenchmarkStats HugBenchmarkGetStats(uint64_t *samples, size_t count)
+{
+    HugBenchmarkStats stats = {0};
+    if (!count) return stats;
+
+    qsort(samples, count, sizeof(uint64_t), sCompareUInt64);
+
+    for (size_t i = 0; i < count; i++) {
+        stats.total += samples[i];
+    }
+
+    stats.count = count;
+    stats.p50   = samples[(count * 50) / 100];
+    stats.p99   = samples[(count * 99) / 100];
+    stats.max   = samples[count - 1];
+
+    return stats;
+}
+
+
+#pragma mark - Audio
+
+static uint32_t sReadLE(const uint8_t *p, size_t bytes)
+{
+    uint32_t result = 0;
+
+    for (size_t i = 0; i < bytes; i++) {
+        result |= (uint32_t)p[i] << (8 * i);
+    }
+
+    return result;
+}
+
+
+static float sDecodeSample(const uint8_t *p, uint16_t format, uint16_t bitsPerSample)
+{
+    if (format == 3 && bitsPerSample == 32) {
+        float f;
+        memcpy(&f, p, sizeof(float));
+        return f;
+    }
+
+    if (bitsPerSample == 16) return (int16_t)sReadLE(p, 2) / 32768.0f;
+    if (bitsPerSample == 24) return ((int32_t)(sReadLE(p, 3) << 8) >> 8) / 8388608.0f;
+    if (bitsPerSample == 32) return (int32_t)sReadLE(p, 4) / 2147483648.0f;
+
+    return 0;
+}
+
+
+bool HugBenchmarkAudioReadWAV(const char *path, HugBenchmarkAudio *outAudio)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *bytes = length > 12 ? malloc(length) : NULL;
+    bool ok = bytes && (fread(bytes, 1, length, file) == (size_t)length);
+    fclose(file);
+
+    ok = ok && !memcmp(bytes, "RIFF", 4) && !memcmp(bytes + 8, "WAVE", 4);
+
+    uint16_t format = 0, channels = 0, bitsPerSample = 0;
+    uint32_t sampleRate = 0;
+    const uint8_t *data = NULL;
+    size_t dataLength = 0;
+
+    size_t offset = 12;
+    while (ok && offset + 8 <= (size_t)length) {
+        const uint8_t *chunk = bytes + offset;
+        size_t chunkLength = sReadLE(chunk + 4, 4);
+
+        if (offset + 8 + chunkLength > (size_t)length) {
+            chunkLength = length - offset - 8;
+        }
+
+        if (!memcmp(chunk, "fmt ", 4) && chunkLength >= 16) {
+            format        = sReadLE(chunk + 8,  2);
+            channels      = sReadLE(chunk + 10, 2);
+            sampleRate    = sReadLE(chunk + 12, 4);
+            bitsPerSample = sReadLE(chunk + 22, 2);
+
+            // WAVE_FORMAT_EXTENSIBLE stores the real format in the sub-format GUID
+            if (format == 0xFFFE && chunkLength >= 26) {
+                format = sReadLE(chunk + 32, 2);
+            }
+
+        } else if (!memcmp(chunk, "data", 4)) {
+            data = chunk + 8;
+            dataLength = chunkLength;
+        }
+
+        offset += 8 + chunkLength + (chunkLength & 1);
+    }
+
+    ok = ok && data && channels && sampleRate;
+    ok = ok && (format == 1 || format == 3) && (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32);
+
+    if (ok) {
+        size_t bytesPerSample = bitsPerSample / 8;
+        size_t frameCount = dataLength / (bytesPerSample * channels);
+
+        outAudio->sampleRate = sampleRate;
+        outAudio->frameCount = frameCount;
+        outAudio->left  = malloc(sizeof(float) * (frameCount ? frameCount : 1));
+        outAudio->right = malloc(sizeof(float) * (frameCount ? frameCount : 1));
+
+        for (size_t i = 0; i < frameCount; i++) {
+            const uint8_t *frame = data + (i * bytesPerSample * channels);
+
+            outAudio->left[i]  = sDecodeSample(frame, format, bitsPerSample);
+            outAudio->right[i] = channels > 1 ? sDecodeSample(frame + bytesPerSample, format, bitsPerSample) : outAudio->left[i];
+        }
+    }
+
+    free(bytes);
+
+    return ok;
+}
+
+
+void HugBenchmarkAudioMakeSynthetic(HugBenchmarkAudio *outAudio, double sampleRate, double seconds)
+{
+    size_t frameCount = (size_t)(sampleRate * seconds);
+
+    outAudio->sampleRate = sampleRate;
+    outAudio->frameCount = frameCount;
+    outAudio->left  = malloc(sizeof(float) * (frameCount ? frameCount : 1));
+    outAudio->right = malloc(sizeof(float) * (frameCount ? frameCount : 1));
+
+    uint32_t seed = 0x1234567;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        double t = i / sampleRate;
+
+        seed = (seed * 1664525u) + 1013904223u;
+        double noise = ((seed >> 8) / 8388608.0) - 1.0;
+
+        double l = 0.45 * sin(2 * M_PI * 110.0 * t) + 0.30 * sin(2 * M_PI * 440.0 * t) + 0.2 * noise;
+        double r = 0.45 * sin(2 * M_PI * 110.5 * t) + 0.30 * sin(2 * M_PI * 659.3 * t) + 0.2 * noise;
+
+        outAudio->left[i]  = l;
+        outAudio->right[i] = r;
+    }
+}
+
+
+void HugBenchmarkAudioFree(HugBenchmarkAudio *audio)
+{
+    free(audio->left);
+    free(audio->right);
+
+    audio->left  = NULL;
+    audio->right = NULL;
+    audio->frameCount = 0;
+}
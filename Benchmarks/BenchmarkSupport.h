@@ -0,0 +1,49 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Shared helpers for the offline benchmark executables: a monotonic clock,
+// block-time statistics, and a minimal WAV reader for real-world input.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint64_t HugBenchmarkGetNanoseconds(void);
+
+typedef struct HugBenchmarkStats {
+    size_t   count;
+    uint64_t total;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t max;
+} HugBenchmarkStats;
+
+// Sorts samples in place
+extern HugBenchmarkStats HugBenchmarkGetStats(uint64_t *samples, size_t count);
+
+// Non-interleaved float audio, mono files are duplicated to two channels
+typedef struct HugBenchmarkAudio {
+    double sampleRate;
+    size_t frameCount;
+    float *left;
+    float *right;
+} HugBenchmarkAudio;
+
+// Reads 16/24/32-bit integer or 32-bit float PCM WAV files
+extern bool HugBenchmarkAudioReadWAV(const char *path, HugBenchmarkAudio *outAudio);
+
+// Music-like test signal: detuned sines plus noise, peaking just under 0 dBFS
+extern void HugBenchmarkAudioMakeSynthetic(HugBenchmarkAudio *outAudio, double sampleRate, double seconds);
+
+extern void HugBenchmarkAudioFree(HugBenchmarkAudio *audio);
+
+#ifdef __cplusplus
+}
+#endif
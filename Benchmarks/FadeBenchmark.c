@@ -0,0 +1,133 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Compares HugApplyFadeWithCurve() against the original scalar,
+// double-precision exponential fade, which runs on the render thread
+// whenever the source block switches units.
+//
+// Usage: FadeBenchmark [--quick] [--csv]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugFastUtils.h"
+#include "HugVectorOps.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const size_t sFrameSizes[] = { 64, 128, 512, 1024, 4096, 8192 };
+#define sFrameSizeCount (sizeof(sFrameSizes) / sizeof(sFrameSizes[0]))
+
+static volatile float sSideEffect = 0;
+
+
+// HugApplyFade() before it was vectorized
+static void sLegacyApplyFade(float *samples, size_t frameCount, float inFromValue, float inToValue)
+{
+    const double sSilence = pow(10.0, -120.0 / 20.0);
+
+    double fromValue = inFromValue ? inFromValue : sSilence;
+    double toValue   = inToValue   ? inToValue   : sSilence;
+
+    double multiplier = pow(toValue / fromValue, 1 / (double)frameCount);
+    double env = fromValue;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] *= env;
+        env *= multiplier;
+    }
+}
+
+
+// curve < 0 measures the legacy implementation
+static double sMeasure(int curve, size_t frameCount, size_t blockCount, const float *input, float *output)
+{
+    uint64_t total = 0;
+
+    for (size_t block = 0; block < blockCount; block++) {
+        memcpy(output, input, sizeof(float) * frameCount);
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        if (curve < 0) {
+            sLegacyApplyFade(output, frameCount, 1.0, 0.0);
+        } else {
+            HugApplyFadeWithCurve(output, frameCount, 1.0, 0.0, (HugFadeCurve)curve);
+        }
+
+        total += HugBenchmarkGetNanoseconds() - start;
+    }
+
+    sSideEffect += output[frameCount / 2];
+
+    return (double)total / ((double)blockCount * frameCount);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t framesPerCase = 48000 * 20;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            framesPerCase = 48000;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t maxFrameCount = sFrameSizes[sFrameSizeCount - 1];
+
+    float *input    = malloc(sizeof(float) * maxFrameCount);
+    float *output   = malloc(sizeof(float) * maxFrameCount);
+    float *expected = malloc(sizeof(float) * maxFrameCount);
+
+    for (size_t i = 0; i < maxFrameCount; i++) {
+        input[i] = 0.5f + 0.25f * sinf(i * 0.01f);
+    }
+
+    if (csv) {
+        printf("frames,legacy_ns_per_frame,exponential_ns_per_frame,speedup,max_relative_error,equal_power_ns_per_frame,linear_ns_per_frame\n");
+    } else {
+        printf("HugApplyFade, legacy vs vectorized (backend: %s)\n\n", HugVectorGetBackendName());
+        printf("%6s %12s %12s %8s %10s %12s %12s\n", "frames", "legacy ns/f", "expo ns/f", "speedup", "max error", "eq-pow ns/f", "linear ns/f");
+    }
+
+    for (size_t f = 0; f < sFrameSizeCount; f++) {
+        size_t frameCount = sFrameSizes[f];
+        size_t blockCount = framesPerCase / frameCount;
+        if (blockCount < 16) blockCount = 16;
+
+        double legacy = sMeasure(-1, frameCount, blockCount, input, expected);
+        double expo   = sMeasure(HugFadeCurveExponential, frameCount, blockCount, input, output);
+
+        // Relative to each sample, since the tail is 120 dB down
+        double maxError = 0;
+        for (size_t i = 0; i < frameCount; i++) {
+            double error = fabs((output[i] - expected[i]) / expected[i]);
+            if (error > maxError) maxError = error;
+        }
+
+        double equalPower = sMeasure(HugFadeCurveEqualPower, frameCount, blockCount, input, output);
+        double linear     = sMeasure(HugFadeCurveLinear,     frameCount, blockCount, input, output);
+
+        if (csv) {
+            printf("%zu,%.3f,%.3f,%.2f,%g,%.3f,%.3f\n", frameCount, legacy, expo, legacy / expo, maxError, equalPower, linear);
+        } else {
+            printf("%6zu %12.3f %12.3f %7.1fx %10.2g %12.3f %12.3f\n", frameCount, legacy, expo, legacy / expo, maxError, equalPower, linear);
+        }
+    }
+
+    free(input);
+    free(output);
+    free(expected);
+
+    return 0;
+}
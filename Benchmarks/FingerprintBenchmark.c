@@ -0,0 +1,332 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures what audio fingerprints cost the Worker and what finding them
+// costs the app.
+//
+// "scan" is the Worker's loudness pass over a synthetic track in 64k-frame
+// decoder chunks, "scan + chroma" the same pass also feeding HugChroma and
+// building the fingerprint. The difference is the extra analysis time.
+//
+// The index part uses fingerprints written directly in the HugFingerprint
+// layout, since decoding thousands of tracks would dwarf what is measured:
+// each segment is a chord from the track's key, and one track in ten is a
+// copy of an earlier one with every value disturbed (cosine 0.95 and up).
+// "insert" and "remove" are single tracks arriving in and leaving a full
+// index along with the query TracksController makes, "scan" is the same
+// query by comparing against every fingerprint.
+//
+// Usage: FingerprintBenchmark [--quick] [--csv] [--seconds 300] [--tracks N]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugFingerprint.h"
+#include "LoudnessMeasurer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sChunkFrames  (4096 * 16)
+#define sThreshold    0.9
+#define sSegmentCount 45
+#define sHeaderLength 12
+#define sLength       (sHeaderLength + (sSegmentCount * 12))
+
+
+static volatile size_t sSideEffect = 0;
+
+
+static uint32_t sNextRandom(uint32_t *state)
+{
+    *state = (*state * 1664525u) + 1013904223u;
+    return *state >> 8;
+}
+
+
+static double sNextUniform(uint32_t *state)
+{
+    return (sNextRandom(state) / (double)(1 << 24)) - 0.5;
+}
+
+
+static double sScan(const HugBenchmarkAudio *audio, bool withChroma)
+{
+    uint64_t start = HugBenchmarkGetNanoseconds();
+
+    LoudnessMeasurer *measurer = LoudnessMeasurerCreate(2, audio->sampleRate, audio->frameCount);
+    HugChroma *chroma = withChroma ? HugChromaCreate(2, audio->sampleRate) : NULL;
+
+    for (size_t offset = 0; offset < audio->frameCount; offset += sChunkFrames) {
+        size_t frames = audio->frameCount - offset;
+        if (frames > sChunkFrames) frames = sChunkFrames;
+
+        const float *channels[2] = { audio->left + offset, audio->right + offset };
+        LoudnessMeasurerScanAudioBuffer(measurer, channels, frames);
+
+        if (chroma) HugChromaProcess(chroma, channels, frames);
+    }
+
+    sSideEffect += (size_t)LoudnessMeasurerGetLoudness(measurer);
+
+    if (chroma) {
+        size_t length = 0;
+        free(HugFingerprintCreateData(chroma, 0, audio->frameCount / audio->sampleRate, &length));
+        sSideEffect += length;
+    }
+
+    HugChromaFree(chroma);
+    LoudnessMeasurerFree(measurer);
+
+    return (HugBenchmarkGetNanoseconds() - start) / 1e9;
+}
+
+
+static void sWriteValues(int8_t *values, const double *segment)
+{
+    double mean = 0, squares = 0;
+
+    for (size_t c = 0; c < 12; c++) mean += segment[c] / 12;
+    for (size_t c = 0; c < 12; c++) squares += (segment[c] - mean) * (segment[c] - mean);
+
+    double scale = 127.0 / sqrt(squares);
+
+    for (size_t c = 0; c < 12; c++) {
+        values[c] = (int8_t)lround((segment[c] - mean) * scale);
+    }
+}
+
+
+static void sMakeFingerprint(uint32_t *seed, const uint8_t *original, uint8_t *outBytes)
+{
+    struct { uint32_t magic; uint16_t segmentCount; uint16_t segmentLength; float duration; } header = {
+        0x31504648, sSegmentCount, 12, sSegmentCount * 4.0f
+    };
+
+    int8_t *values = (int8_t *)(outBytes + sHeaderLength);
+
+    if (original) {
+        memcpy(outBytes, original, sLength);
+
+        for (size_t i = 0; i < sSegmentCount; i++) {
+            double segment[12];
+
+            for (size_t c = 0; c < 12; c++) {
+                segment[c] = values[(i * 12) + c] + (sNextUniform(seed) * 40);
+            }
+
+            sWriteValues(&values[i * 12], segment);
+        }
+
+        return;
+    }
+
+    memcpy(outBytes, &header, sHeaderLength);
+
+    static const int scale[7] = { 0, 2, 4, 5, 7, 9, 11 };
+    int key = sNextRandom(seed) % 12;
+
+    for (size_t i = 0; i < sSegmentCount; i++) {
+        double segment[12];
+        int degree = sNextRandom(seed) % 7;
+
+        for (size_t c = 0; c < 12; c++) {
+            segment[c] = 0.2 + (sNextUniform(seed) * 0.2);
+        }
+
+        for (size_t n = 0; n < 3; n++) {
+            segment[(key + scale[(degree + (n * 2)) % 7]) % 12] += 1.0;
+        }
+
+        sWriteValues(&values[i * 12], segment);
+    }
+}
+
+
+static size_t sInsertAndQuery(HugFingerprintIndex *index, const uint8_t *bytes)
+{
+    size_t slot = HugFingerprintIndexInsert(index, bytes, sLength);
+    size_t count = 0;
+
+    free(HugFingerprintIndexCopySimilar(index, slot, &count));
+    sSideEffect += count;
+
+    return slot;
+}
+
+
+int main(int argc, const char *argv[])
+{
+    double seconds    = 300;
+    size_t trackCount = 20000;
+    size_t editCount  = 1000;
+    size_t scanCount  = 100;
+    bool   csv        = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            seconds    = 30;
+            trackCount = 2000;
+            editCount  = 200;
+            scanCount  = 20;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[i], "--seconds") && (i + 1) < argc) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--tracks") && (i + 1) < argc) {
+            trackCount = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv] [--seconds n] [--tracks n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (trackCount < 2) trackCount = 2;
+
+    // Worker cost
+    HugBenchmarkAudio audio;
+    HugBenchmarkAudioMakeSynthetic(&audio, 44100, seconds);
+
+    // Best of a few alternating runs, the first ones pay for faulting in the audio
+    double scanOnly = INFINITY, scanChroma = INFINITY;
+
+    for (size_t r = 0; r < 3; r++) {
+        scanOnly   = fmin(scanOnly,   sScan(&audio, false));
+        scanChroma = fmin(scanChroma, sScan(&audio, true));
+    }
+
+    double overhead = (scanChroma - scanOnly) / scanOnly;
+
+    HugBenchmarkAudioFree(&audio);
+
+    // Index cost
+    size_t totalCount = trackCount + editCount;
+    uint8_t (*fingerprints)[sLength] = malloc(totalCount * sizeof(*fingerprints));
+    size_t *originals = malloc(totalCount * sizeof(size_t));
+    size_t *slots     = malloc(totalCount * sizeof(size_t));
+
+    uint32_t seed = 42;
+
+    for (size_t i = 0; i < totalCount; i++) {
+        originals[i] = SIZE_MAX;
+
+        if (i > 0 && (sNextRandom(&seed) % 10) == 0) {
+            originals[i] = sNextRandom(&seed) % i;
+
+            // Copies of copies drift too far, copy the first one instead
+            while (originals[originals[i]] != SIZE_MAX) originals[i] = originals[originals[i]];
+
+            sMakeFingerprint(&seed, fingerprints[originals[i]], fingerprints[i]);
+
+        } else {
+            sMakeFingerprint(&seed, NULL, fingerprints[i]);
+        }
+    }
+
+    HugFingerprintIndex *index = HugFingerprintIndexCreate(sThreshold);
+
+    for (size_t i = 0; i < trackCount; i++) {
+        slots[i] = HugFingerprintIndexInsert(index, fingerprints[i], sLength);
+    }
+
+    // Recall of planted copies, and matches between unrelated tracks
+    size_t plantedCount = 0, foundCount = 0, falseCount = 0;
+
+    for (size_t i = 0; i < trackCount; i++) {
+        size_t count = 0;
+        size_t *similar = HugFingerprintIndexCopySimilar(index, slots[i], &count);
+
+        if (originals[i] != SIZE_MAX) plantedCount++;
+
+        size_t root = originals[i] != SIZE_MAX ? originals[i] : i;
+
+        for (size_t s = 0; s < count; s++) {
+            size_t j = similar[s];
+            size_t otherRoot = originals[j] != SIZE_MAX ? originals[j] : j;
+
+            if (originals[i] != SIZE_MAX && j == slots[originals[i]]) foundCount++;
+            if (otherRoot != root) falseCount++;
+        }
+
+        free(similar);
+    }
+
+    uint64_t *insertSamples = malloc(editCount * sizeof(uint64_t));
+    uint64_t *removeSamples = malloc(editCount * sizeof(uint64_t));
+    uint64_t *scanSamples   = malloc(scanCount * sizeof(uint64_t));
+
+    for (size_t e = 0; e < editCount; e++) {
+        size_t i = trackCount + e;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        slots[i] = sInsertAndQuery(index, fingerprints[i]);
+        insertSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    for (size_t e = 0; e < editCount; e++) {
+        size_t i = trackCount + e;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        size_t count = 0;
+        free(HugFingerprintIndexCopySimilar(index, slots[i], &count));
+        HugFingerprintIndexRemove(index, slots[i]);
+        sSideEffect += count;
+
+        removeSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    for (size_t e = 0; e < scanCount; e++) {
+        const uint8_t *bytes = fingerprints[trackCount + e];
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        for (size_t j = 0; j < trackCount; j++) {
+            if (HugFingerprintGetSimilarity(bytes, sLength, fingerprints[j], sLength) >= sThreshold) sSideEffect++;
+        }
+
+        scanSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    HugBenchmarkStats insert = HugBenchmarkGetStats(insertSamples, editCount);
+    HugBenchmarkStats remove = HugBenchmarkGetStats(removeSamples, editCount);
+    HugBenchmarkStats scan   = HugBenchmarkGetStats(scanSamples,   scanCount);
+
+    double recall = plantedCount ? (foundCount / (double)plantedCount) : 1;
+
+    if (csv) {
+        printf("seconds,scan_s,scan_chroma_s,overhead,tracks,insert_p50_us,insert_p99_us,remove_p50_us,remove_p99_us,scan_p50_us,recall,false_matches\n");
+        printf("%.1f,%.4f,%.4f,%.4f,%zu,%.2f,%.2f,%.2f,%.2f,%.1f,%.4f,%zu\n",
+            seconds, scanOnly, scanChroma, overhead, trackCount,
+            insert.p50 / 1000.0, insert.p99 / 1000.0,
+            remove.p50 / 1000.0, remove.p99 / 1000.0,
+            scan.p50 / 1000.0, recall, falseCount
+        );
+
+    } else {
+        printf("Audio fingerprints, %.0f s of audio, %zu tracks, threshold %.2f\n\n", seconds, trackCount, sThreshold);
+
+        printf("scan:          %.4f s\n", scanOnly);
+        printf("scan + chroma: %.4f s (+%.1f%%)\n\n", scanChroma, overhead * 100);
+
+        printf("%-10s %12s %12s\n", "", "p50", "p99");
+        printf("%-10s %9.2f us %9.2f us\n", "insert", insert.p50 / 1000.0, insert.p99 / 1000.0);
+        printf("%-10s %9.2f us %9.2f us\n", "remove", remove.p50 / 1000.0, remove.p99 / 1000.0);
+        printf("%-10s %9.1f us %9.1f us\n", "scan",   scan.p50 / 1000.0,   scan.p99 / 1000.0);
+
+        printf("\nrecall: %.2f%% of %zu copies\n", recall * 100, plantedCount);
+        printf("false matches: %zu\n", falseCount);
+    }
+
+    HugFingerprintIndexFree(index);
+
+    free(fingerprints);
+    free(originals);
+    free(slots);
+    free(insertSamples);
+    free(removeSamples);
+    free(scanSamples);
+
+    return 0;
+}
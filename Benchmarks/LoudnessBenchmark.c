@@ -0,0 +1,135 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Times a whole-track LoudnessMeasurer scan the way the Worker runs it:
+// sequentially in 64k-frame decoder chunks, and as one buffer split across
+// threads. Prints the speed relative to real time and the LU difference,
+// then the cost and size of also building a version 2 overview.
+//
+// Usage: LoudnessBenchmark [--wav file.wav] [--seconds 300] [--threads n] [--rate 50] [--quick] [--csv]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugVectorOps.h"
+#include "LoudnessMeasurer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sChunkFrames (4096 * 16)
+
+
+// threadCount of 1 scans in decoder-sized chunks. A binRate other than 0
+// also builds a version 2 overview and returns its size.
+//
+static double sMeasure(const HugBenchmarkAudio *audio, size_t threadCount, size_t binRate, double *outLoudness, size_t *outOverviewLength)
+{
+    uint64_t start = HugBenchmarkGetNanoseconds();
+
+    LoudnessMeasurer *measurer = LoudnessMeasurerCreate(2, audio->sampleRate, audio->frameCount);
+
+    if (binRate) {
+        LoudnessMeasurerSetDetailedOverviewRate(measurer, binRate);
+    }
+
+    if (threadCount == 1) {
+        for (size_t offset = 0; offset < audio->frameCount; offset += sChunkFrames) {
+            size_t frames = audio->frameCount - offset;
+            if (frames > sChunkFrames) frames = sChunkFrames;
+
+            const float *channels[2] = { audio->left + offset, audio->right + offset };
+            LoudnessMeasurerScanAudioBuffer(measurer, channels, frames);
+        }
+
+    } else {
+        LoudnessMeasurerSetParallelScan(measurer, 1, threadCount);
+
+        const float *channels[2] = { audio->left, audio->right };
+        LoudnessMeasurerScanAudioBuffer(measurer, channels, audio->frameCount);
+    }
+
+    *outLoudness = LoudnessMeasurerGetLoudness(measurer);
+
+    if (binRate) {
+        free(LoudnessMeasurerCopyDetailedOverview(measurer, outOverviewLength));
+    }
+
+    LoudnessMeasurerFree(measurer);
+
+    return (HugBenchmarkGetNanoseconds() - start) / 1e9;
+}
+
+
+int main(int argc, const char *argv[])
+{
+    const char *wavPath = NULL;
+    double seconds = 300;
+    size_t threadCount = 0;
+    size_t binRate = 50;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--wav") && (i + 1) < argc) {
+            wavPath = argv[++i];
+        } else if (!strcmp(argv[i], "--seconds") && (i + 1) < argc) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--threads") && (i + 1) < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--rate") && (i + 1) < argc) {
+            binRate = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--quick")) {
+            seconds = 30;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else {
+            fprintf(stderr, "usage: %s [--wav path] [--seconds n] [--threads n] [--rate n] [--quick] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    HugBenchmarkAudio audio;
+
+    if (wavPath) {
+        if (!HugBenchmarkAudioReadWAV(wavPath, &audio) || !audio.frameCount) {
+            fprintf(stderr, "Could not read '%s' (16/24/32-bit PCM or 32-bit float WAV)\n", wavPath);
+            return 1;
+        }
+    } else {
+        HugBenchmarkAudioMakeSynthetic(&audio, 44100, seconds);
+    }
+
+    double duration = audio.frameCount / audio.sampleRate;
+
+    double sequentialLoudness, parallelLoudness, detailedLoudness;
+    size_t overviewLength = 0;
+
+    if (binRate == 0) binRate = 10;
+
+    double sequential = sMeasure(&audio, 1, 0, &sequentialLoudness, NULL);
+    double parallel   = sMeasure(&audio, threadCount, 0, &parallelLoudness, NULL);
+    double detailed   = sMeasure(&audio, 1, binRate, &detailedLoudness, &overviewLength);
+
+    // Version 2 overview size, scaled to a 10 minute track
+    double overviewKB = (overviewLength / 1024.0) * (600.0 / duration);
+
+    double difference = fabs(parallelLoudness - sequentialLoudness);
+
+    if (csv) {
+        printf("seconds,sequential_s,parallel_s,detailed_s,sequential_x_realtime,parallel_x_realtime,lufs,difference_lu,overview_v2_kb_per_10_min\n");
+        printf("%.1f,%.4f,%.4f,%.4f,%.1f,%.1f,%.4f,%g,%.1f\n", duration, sequential, parallel, detailed, duration / sequential, duration / parallel, sequentialLoudness, difference, overviewKB);
+    } else {
+        printf("LoudnessMeasurer, %.0f s of audio (backend: %s)\n\n", duration, HugVectorGetBackendName());
+        printf("%-12s %10s %12s %10s\n", "scan", "seconds", "x realtime", "LUFS");
+        printf("%-12s %10.4f %12.1f %10.4f\n", "sequential", sequential, duration / sequential, sequentialLoudness);
+        printf("%-12s %10.4f %12.1f %10.4f\n", "parallel",   parallel,   duration / parallel,   parallelLoudness);
+        printf("%-12s %10.4f %12.1f %10.4f\n", "detailed",   detailed,   duration / detailed,   detailedLoudness);
+        printf("\ndifference: %g LU\n", difference);
+        printf("version 2 overview at %zu bins/s: %.1f KB per 10 minutes\n", binRate, overviewKB);
+    }
+
+    HugBenchmarkAudioFree(&audio);
+
+    return difference <= 0.01 ? 0 : 1;
+}
@@ -0,0 +1,379 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Offline version of the block sequence built by -[HugAudioEngine _reconnectGraph]:
+//
+//     source copy -> stereo field -> pre-gain ramp -> (effect AUs) ->
+//     volume ramp -> level meters -> limiter -> loudness meter -> status snapshot
+//
+// Effect audio units only exist on macOS and are skipped here. By default the
+// fused HugRenderChainProcess() path is measured, as used when no effects are
+// loaded; --split measures the two-stage path used around effects. Meter data and
+// playback info are appended to a status snapshot that is published through a
+// HugTripleBuffer once per block, so their cost is still counted. The danger
+// peak is not; it is a single atomic. --limiter lookahead swaps the emergency
+// limiter for HugLookaheadLimiter and reports the latency it adds.
+//
+// Usage: RenderChainBenchmark [--wav path] [--seconds n] [--scenario steady|ramping|all]
+//                             [--limiter emergency|lookahead] [--split] [--quick] [--csv]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugRenderChain.h"
+#include "HugTripleBuffer.h"
+#include "HugVectorOps.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Mirrors StatusSnapshot in HugAudioEngine.m
+#define kSnapshotCapacity 32
+
+typedef struct {
+    int64_t status;
+    double  timeElapsed;
+    double  timeRemaining;
+} BenchmarkPlaybackInfo;
+
+typedef struct {
+    uint64_t timestamp;
+    HugMeterDataStruct leftMeterData;
+    HugMeterDataStruct rightMeterData;
+} BenchmarkSnapshotMeter;
+
+typedef struct {
+    uint64_t timestamp;
+    BenchmarkPlaybackInfo info;
+} BenchmarkSnapshotPlayback;
+
+typedef struct {
+    uint32_t generation;
+    uint32_t meterCount;
+    uint32_t playbackCount;
+    BenchmarkSnapshotMeter    meters[kSnapshotCapacity];
+    BenchmarkSnapshotPlayback playback[kSnapshotCapacity];
+} BenchmarkSnapshot;
+
+typedef struct {
+    BenchmarkSnapshot *snapshot;
+    uint64_t timestamp;
+    uint64_t spacing;
+} BenchmarkMeterContext;
+
+
+typedef enum {
+    BenchmarkScenarioSteady,
+    BenchmarkScenarioRamping
+} BenchmarkScenario;
+
+
+static const size_t sFrameSizes[] = { 32, 64, 128, 256, 512, 1024, 2048, 4096, 6144, 8192 };
+static const double sDeadlineRates[] = { 44100, 48000, 96000 };
+
+#define sFrameSizeCount    (sizeof(sFrameSizes)    / sizeof(sFrameSizes[0]))
+#define sDeadlineRateCount (sizeof(sDeadlineRates) / sizeof(sDeadlineRates[0]))
+
+static volatile uint64_t sSideEffect = 0;
+static bool sUseSplitPath = false;
+static HugLimiterMode sLimiterMode = HugLimiterModeEmergency;
+static size_t sLatency = 0;
+
+
+static uint32_t sGetSnapshotIndex(uint32_t *ioCount, uint64_t previousTimestamp, uint64_t timestamp, uint64_t spacing)
+{
+    uint32_t count = *ioCount;
+
+    if (count >= 2 && (timestamp - previousTimestamp) < spacing) {
+        return count - 1;
+    }
+
+    *ioCount = count + 1;
+    return count;
+}
+
+
+static void sAppendMeterData(
+    void *inContext,
+    size_t frameOffset,
+    const HugMeterDataStruct *leftMeterData,
+    const HugMeterDataStruct *rightMeterData
+) {
+    BenchmarkMeterContext *context = inContext;
+    BenchmarkSnapshot *snapshot = context->snapshot;
+
+    if (snapshot->meterCount == kSnapshotCapacity) {
+        memmove(&snapshot->meters[0], &snapshot->meters[1], sizeof(BenchmarkSnapshotMeter) * (kSnapshotCapacity - 1));
+        snapshot->meterCount--;
+    }
+
+    uint32_t count = snapshot->meterCount;
+    uint64_t previousTimestamp = count >= 2 ? snapshot->meters[count - 2].timestamp : 0;
+    uint64_t timestamp = context->timestamp + frameOffset;
+
+    uint32_t index = sGetSnapshotIndex(&snapshot->meterCount, previousTimestamp, timestamp, context->spacing);
+
+    snapshot->meters[index].timestamp = timestamp;
+    snapshot->meters[index].leftMeterData  = *leftMeterData;
+    snapshot->meters[index].rightMeterData = *rightMeterData;
+}
+
+
+static void sAppendPlayback(BenchmarkSnapshot *snapshot, uint64_t timestamp, uint64_t spacing)
+{
+    if (snapshot->playbackCount == kSnapshotCapacity) {
+        memmove(&snapshot->playback[0], &snapshot->playback[1], sizeof(BenchmarkSnapshotPlayback) * (kSnapshotCapacity - 1));
+        snapshot->playbackCount--;
+    }
+
+    uint32_t count = snapshot->playbackCount;
+    uint64_t previousTimestamp = count >= 2 ? snapshot->playback[count - 2].timestamp : 0;
+
+    uint32_t index = sGetSnapshotIndex(&snapshot->playbackCount, previousTimestamp, timestamp, spacing);
+
+    BenchmarkSnapshotPlayback playback = { timestamp, { 3, 0, 0 } };
+    snapshot->playback[index] = playback;
+}
+
+
+static void sGetParameters(BenchmarkScenario scenario, size_t blockIndex, float *preGain, float *volume, float *balance, float *width)
+{
+    *preGain = 0.7f;
+    *volume  = 0.9f;
+    *balance = 0.0f;
+    *width   = 1.0f;
+
+    // Every block moves every parameter, so the ramps and the
+    // stereo field transition path run on each render cycle.
+    if (scenario == BenchmarkScenarioRamping) {
+        float t = (blockIndex & 1) ? 1.0f : 0.0f;
+
+        *preGain = 0.5f + (0.3f * t);
+        *volume  = 0.6f + (0.3f * t);
+        *balance = -0.25f + (0.5f * t);
+        *width   = 0.5f + (0.75f * t);
+    }
+}
+
+
+static HugBenchmarkStats sRunFrameSize(
+    const HugBenchmarkAudio *audio,
+    BenchmarkScenario scenario,
+    size_t frameCount,
+    size_t blockCount,
+    uint64_t *samples
+) {
+    HugRenderChain *chain = HugRenderChainCreate();
+    HugRenderChainConfigure(chain, audio->sampleRate, frameCount);
+    HugRenderChainSetLimiterMode(chain, sLimiterMode);
+    HugRenderChainReset(chain, 0.7f, 0.9f, 0.0f, 1.0f);
+
+    float *left  = malloc(sizeof(float) * frameCount);
+    float *right = malloc(sizeof(float) * frameCount);
+
+    // Timestamps are in frames here
+    BenchmarkSnapshot *snapshot = calloc(1, sizeof(BenchmarkSnapshot));
+    HugTripleBuffer *snapshotBuffer = HugTripleBufferCreate(sizeof(BenchmarkSnapshot));
+    uint64_t spacing = (uint64_t)(audio->sampleRate / 60.0);
+    uint64_t renderedFrames = 0;
+
+    size_t warmupCount = blockCount / 10;
+    if (warmupCount < 16) warmupCount = 16;
+
+    size_t readOffset = 0;
+
+    for (size_t block = 0; block < warmupCount + blockCount; block++) {
+        float preGain, volume, balance, width;
+        sGetParameters(scenario, block, &preGain, &volume, &balance, &width);
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        // Stands in for HugAudioSource's input block
+        for (size_t copied = 0; copied < frameCount; ) {
+            size_t available = audio->frameCount - readOffset;
+            size_t toCopy = frameCount - copied;
+            if (toCopy > available) toCopy = available;
+
+            memcpy(left  + copied, audio->left  + readOffset, sizeof(float) * toCopy);
+            memcpy(right + copied, audio->right + readOffset, sizeof(float) * toCopy);
+
+            copied += toCopy;
+            readOffset += toCopy;
+            if (readOffset == audio->frameCount) readOffset = 0;
+        }
+
+        BenchmarkMeterContext context = { snapshot, renderedFrames, spacing };
+
+        if (sUseSplitPath) {
+            HugRenderChainProcessSource(chain, left, right, frameCount, preGain, balance, width, false);
+            HugRenderChainProcessOutput(chain, left, right, frameCount, volume, sAppendMeterData, &context);
+        } else {
+            HugRenderChainProcess(chain, left, right, frameCount, preGain, balance, width, volume, sAppendMeterData, &context);
+        }
+
+        sAppendPlayback(snapshot, renderedFrames, spacing);
+        HugTripleBufferWrite(snapshotBuffer, snapshot, sizeof(BenchmarkSnapshot));
+
+        renderedFrames += frameCount;
+
+        uint64_t end = HugBenchmarkGetNanoseconds();
+
+        if (block >= warmupCount) {
+            samples[block - warmupCount] = end - start;
+        }
+    }
+
+    sSideEffect += snapshot->meterCount + (uint64_t)(left[0] * 1000.0f);
+
+    HugTripleBufferFree(snapshotBuffer);
+    free(snapshot);
+    free(left);
+    free(right);
+
+    HugRenderChainFree(chain);
+
+    return HugBenchmarkGetStats(samples, blockCount);
+}
+
+
+static void sRunScenario(const HugBenchmarkAudio *audio, BenchmarkScenario scenario, double seconds, size_t minimumBlockCount, bool csv)
+{
+    const char *scenarioName = (scenario == BenchmarkScenarioRamping) ? "ramping" : "steady";
+
+    if (!csv) {
+        printf("\nscenario: %s\n", scenarioName);
+        printf("%6s %9s %9s %9s %9s", "frames", "ns/frame", "p50 us", "p99 us", "max us");
+
+        for (size_t r = 0; r < sDeadlineRateCount; r++) {
+            printf("  p99%%@%-5g", sDeadlineRates[r] / 1000.0);
+        }
+
+        printf("\n");
+    }
+
+    for (size_t f = 0; f < sFrameSizeCount; f++) {
+        size_t frameCount = sFrameSizes[f];
+
+        size_t blockCount = (size_t)((seconds * audio->sampleRate) / frameCount);
+        if (blockCount < minimumBlockCount) blockCount = minimumBlockCount;
+
+        uint64_t *samples = malloc(sizeof(uint64_t) * blockCount);
+        HugBenchmarkStats stats = sRunFrameSize(audio, scenario, frameCount, blockCount, samples);
+        free(samples);
+
+        double nsPerFrame = (double)stats.total / ((double)stats.count * frameCount);
+
+        if (csv) {
+            printf("%s,%zu,%.3f,%.3f,%.3f,%.3f", scenarioName, frameCount, nsPerFrame, stats.p50 / 1000.0, stats.p99 / 1000.0, stats.max / 1000.0);
+        } else {
+            printf("%6zu %9.2f %9.2f %9.2f %9.2f", frameCount, nsPerFrame, stats.p50 / 1000.0, stats.p99 / 1000.0, stats.max / 1000.0);
+        }
+
+        for (size_t r = 0; r < sDeadlineRateCount; r++) {
+            double deadline = (frameCount / sDeadlineRates[r]) * 1e9;
+            double p99Share = (stats.p99 / deadline) * 100.0;
+            double maxShare = (stats.max / deadline) * 100.0;
+
+            if (csv) {
+                printf(",%.4f,%.4f", p99Share, maxShare);
+            } else {
+                printf("  %9.4f%%", p99Share);
+            }
+        }
+
+        if (csv) {
+            printf(",%s,%zu", (sLimiterMode == HugLimiterModeLookahead) ? "lookahead" : "emergency", sLatency);
+        }
+
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+
+int main(int argc, const char *argv[])
+{
+    const char *wavPath = NULL;
+    const char *scenarioName = "all";
+    double seconds = 10.0;
+    size_t minimumBlockCount = 2000;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--wav") && (i + 1) < argc) {
+            wavPath = argv[++i];
+        } else if (!strcmp(argv[i], "--seconds") && (i + 1) < argc) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--scenario") && (i + 1) < argc) {
+            scenarioName = argv[++i];
+        } else if (!strcmp(argv[i], "--limiter") && (i + 1) < argc) {
+            const char *limiterName = argv[++i];
+
+            if (!strcmp(limiterName, "lookahead")) {
+                sLimiterMode = HugLimiterModeLookahead;
+            } else if (strcmp(limiterName, "emergency")) {
+                fprintf(stderr, "Unknown limiter '%s'\n", limiterName);
+                return 2;
+            }
+
+        } else if (!strcmp(argv[i], "--split")) {
+            sUseSplitPath = true;
+        } else if (!strcmp(argv[i], "--quick")) {
+            seconds = 0.25;
+            minimumBlockCount = 64;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else {
+            fprintf(stderr, "usage: %s [--wav path] [--seconds n] [--scenario steady|ramping|all] [--limiter emergency|lookahead] [--split] [--quick] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    HugBenchmarkAudio audio = {0};
+
+    if (wavPath) {
+        if (!HugBenchmarkAudioReadWAV(wavPath, &audio) || !audio.frameCount) {
+            fprintf(stderr, "Could not read '%s' (16/24/32-bit PCM or 32-bit float WAV)\n", wavPath);
+            return 1;
+        }
+    } else {
+        HugBenchmarkAudioMakeSynthetic(&audio, 48000, 10.0);
+    }
+
+    {
+        HugRenderChain *chain = HugRenderChainCreate();
+        HugRenderChainConfigure(chain, audio.sampleRate, sFrameSizes[0]);
+        HugRenderChainSetLimiterMode(chain, sLimiterMode);
+        sLatency = HugRenderChainGetLatency(chain);
+        HugRenderChainFree(chain);
+    }
+
+    if (csv) {
+        printf("scenario,frames,ns_per_frame,p50_us,p99_us,max_us");
+
+        for (size_t r = 0; r < sDeadlineRateCount; r++) {
+            printf(",p99_pct_%g,max_pct_%g", sDeadlineRates[r], sDeadlineRates[r]);
+        }
+
+        printf(",limiter,latency_frames\n");
+
+    } else {
+        printf("HugRenderChain benchmark\n");
+        printf("backend: %s\n", HugVectorGetBackendName());
+        printf("input: %s, %g Hz, %zu frames\n", wavPath ? wavPath : "synthetic", audio.sampleRate, audio.frameCount);
+        printf("path: %s\n", sUseSplitPath ? "split (source, output)" : "fused");
+        printf("limiter: %s, %zu frames (%.2f ms) added latency\n", (sLimiterMode == HugLimiterModeLookahead) ? "lookahead" : "emergency", sLatency, (sLatency / audio.sampleRate) * 1000.0);
+        printf("effect audio units: not available offline, omitted\n");
+    }
+
+    bool runSteady  = !strcmp(scenarioName, "all") || !strcmp(scenarioName, "steady");
+    bool runRamping = !strcmp(scenarioName, "all") || !strcmp(scenarioName, "ramping");
+
+    if (runSteady)  sRunScenario(&audio, BenchmarkScenarioSteady,  seconds, minimumBlockCount, csv);
+    if (runRamping) sRunScenario(&audio, BenchmarkScenarioRamping, seconds, minimumBlockCount, csv);
+
+    HugBenchmarkAudioFree(&audio);
+
+    return (runSteady || runRamping) ? 0 : 2;
+}
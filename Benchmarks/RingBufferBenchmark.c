@@ -0,0 +1,319 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures HugRingBuffer against the original implementation (byte-wise
+// copies, one shared atomic fill count) using packets the size of
+// PacketDataPlayback and of the meter packets the status ring used to carry.
+//
+// "single" fills and drains the buffer on one thread and reports the cost of
+// each write and read. "threaded" runs a producer and a consumer thread; each
+// packet carries its send time so the consumer can report its latency.
+//
+// Usage: RingBufferBenchmark [--quick] [--csv]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugRenderChain.h"
+#include "HugRingBuffer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Same size as PacketDataPlayback in HugAudioEngine.m
+typedef struct {
+    uint64_t timestamp;
+    uint16_t type;
+    uint32_t generation;
+    struct {
+        int64_t status;
+        double  timeElapsed;
+        double  timeRemaining;
+    } info;
+} BenchmarkPacketPlayback;
+
+// The meter packet the status ring carried before meters moved to the
+// snapshot history, kept as a larger packet size
+typedef struct {
+    uint64_t timestamp;
+    uint16_t type;
+    HugMeterDataStruct leftMeterData;
+    HugMeterDataStruct rightMeterData;
+} BenchmarkPacketMeter;
+
+
+// HugRingBuffer before the port. Capacity is a multiple of the packet
+// size so that packets never straddle the end without mirrored memory.
+//
+typedef struct {
+    uint8_t *bytes;
+    size_t   capacity;
+    size_t   tailIndex __attribute__((aligned(128)));
+    size_t   headIndex __attribute__((aligned(128)));
+    volatile atomic_int fillCount __attribute__((aligned(128)));
+} LegacyRingBuffer;
+
+
+typedef struct {
+    bool   legacy;
+    void  *buffer;
+    size_t packetSize;
+    size_t packetCount;
+
+    uint64_t *latencies;
+} ThreadedRun;
+
+
+static const size_t sRingBufferCapacity = 8196;
+
+static volatile uint64_t sSideEffect = 0;
+
+
+static void sLegacySafeCopy(void *dst, const void *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        ((uint8_t *)dst)[i] = ((uint8_t *)src)[i];
+    }
+}
+
+
+static bool sLegacyWrite(LegacyRingBuffer *self, const void *buffer, size_t length)
+{
+    size_t availableLength = self->capacity - self->fillCount;
+    if (availableLength < length) return false;
+
+    sLegacySafeCopy(self->bytes + self->headIndex, buffer, length);
+
+    self->headIndex = (self->headIndex + length) % self->capacity;
+    atomic_fetch_add(&self->fillCount, (int)length);
+
+    return true;
+}
+
+
+static bool sLegacyRead(LegacyRingBuffer *self, void *buffer, size_t length)
+{
+    size_t availableLength = self->fillCount;
+    if (availableLength < length) return false;
+
+    sLegacySafeCopy(buffer, self->bytes + self->tailIndex, length);
+
+    self->tailIndex = (self->tailIndex + length) % self->capacity;
+    atomic_fetch_add(&self->fillCount, -(int)length);
+
+    return true;
+}
+
+
+static void *sCreateBuffer(bool legacy, size_t packetSize)
+{
+    if (legacy) {
+        LegacyRingBuffer *buffer = calloc(1, sizeof(LegacyRingBuffer));
+
+        buffer->capacity = (sRingBufferCapacity / packetSize) * packetSize;
+        buffer->bytes    = malloc(buffer->capacity);
+
+        return buffer;
+    }
+
+    return HugRingBufferCreate(sRingBufferCapacity);
+}
+
+
+static void sFreeBuffer(bool legacy, void *buffer)
+{
+    if (legacy) {
+        free(((LegacyRingBuffer *)buffer)->bytes);
+        free(buffer);
+    } else {
+        HugRingBufferFree(buffer);
+    }
+}
+
+
+static inline bool sWrite(bool legacy, void *buffer, const void *packet, size_t packetSize)
+{
+    return legacy ? sLegacyWrite(buffer, packet, packetSize) : HugRingBufferWrite(buffer, packet, packetSize);
+}
+
+
+static inline bool sRead(bool legacy, void *buffer, void *packet, size_t packetSize)
+{
+    return legacy ? sLegacyRead(buffer, packet, packetSize) : HugRingBufferRead(buffer, packet, packetSize);
+}
+
+
+static void sRunSingle(bool legacy, size_t packetSize, size_t packetCount, double *outWriteNs, double *outReadNs)
+{
+    void *buffer = sCreateBuffer(legacy, packetSize);
+
+    uint8_t packet[64] = {0};
+    uint64_t writeTotal = 0, readTotal = 0;
+    size_t written = 0, read = 0;
+
+    while (read < packetCount) {
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        size_t batch = 0;
+        while (sWrite(legacy, buffer, packet, packetSize)) {
+            packet[0]++;
+            batch++;
+        }
+
+        uint64_t middle = HugBenchmarkGetNanoseconds();
+
+        for (size_t i = 0; i < batch; i++) {
+            sRead(legacy, buffer, packet, packetSize);
+        }
+
+        uint64_t end = HugBenchmarkGetNanoseconds();
+
+        writeTotal += middle - start;
+        readTotal  += end - middle;
+        written += batch;
+        read    += batch;
+    }
+
+    sSideEffect += packet[0];
+    sFreeBuffer(legacy, buffer);
+
+    *outWriteNs = (double)writeTotal / written;
+    *outReadNs  = (double)readTotal  / read;
+}
+
+
+static void *sProducerMain(void *context)
+{
+    ThreadedRun *run = context;
+    uint8_t packet[64] = {0};
+
+    for (size_t i = 0; i < run->packetCount; i++) {
+        uint64_t timestamp = HugBenchmarkGetNanoseconds();
+        memcpy(packet, &timestamp, sizeof(timestamp));
+
+        while (!sWrite(run->legacy, run->buffer, packet, run->packetSize)) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+
+static void *sConsumerMain(void *context)
+{
+    ThreadedRun *run = context;
+    uint8_t packet[64];
+
+    for (size_t i = 0; i < run->packetCount; ) {
+        if (sRead(run->legacy, run->buffer, packet, run->packetSize)) {
+            uint64_t timestamp;
+            memcpy(&timestamp, packet, sizeof(timestamp));
+
+            run->latencies[i++] = HugBenchmarkGetNanoseconds() - timestamp;
+
+        } else {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+
+static HugBenchmarkStats sRunThreaded(bool legacy, size_t packetSize, size_t packetCount, double *outPacketsPerSecond)
+{
+    ThreadedRun run = {
+        legacy,
+        sCreateBuffer(legacy, packetSize),
+        packetSize,
+        packetCount,
+        malloc(sizeof(uint64_t) * packetCount)
+    };
+
+    pthread_t producer, consumer;
+
+    uint64_t start = HugBenchmarkGetNanoseconds();
+
+    pthread_create(&consumer, NULL, sConsumerMain, &run);
+    pthread_create(&producer, NULL, sProducerMain, &run);
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    uint64_t end = HugBenchmarkGetNanoseconds();
+
+    *outPacketsPerSecond = packetCount / ((end - start) / 1e9);
+
+    HugBenchmarkStats stats = HugBenchmarkGetStats(run.latencies, packetCount);
+
+    free(run.latencies);
+    sFreeBuffer(legacy, run.buffer);
+
+    return stats;
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t singleCount   = 2000000;
+    size_t threadedCount = 1000000;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            singleCount   = 20000;
+            threadedCount = 5000;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    struct {
+        const char *name;
+        size_t size;
+    } packets[] = {
+        { "meter",    sizeof(BenchmarkPacketMeter)    },
+        { "playback", sizeof(BenchmarkPacketPlayback) }
+    };
+
+    if (csv) {
+        printf("packet,bytes,implementation,write_ns,read_ns,threaded_packets_per_sec,latency_p50_us,latency_p99_us,latency_max_us\n");
+    } else {
+        printf("HugRingBuffer, legacy vs ported\n\n");
+        printf("%-9s %5s %-7s %9s %9s %12s %9s %9s %9s\n", "packet", "bytes", "impl", "write ns", "read ns", "threaded/s", "p50 us", "p99 us", "max us");
+    }
+
+    for (size_t p = 0; p < sizeof(packets) / sizeof(packets[0]); p++) {
+        for (int legacy = 1; legacy >= 0; legacy--) {
+            const char *implementation = legacy ? "legacy" : "ported";
+
+            double writeNs, readNs, packetsPerSecond;
+            sRunSingle(legacy, packets[p].size, singleCount, &writeNs, &readNs);
+            HugBenchmarkStats latency = sRunThreaded(legacy, packets[p].size, threadedCount, &packetsPerSecond);
+
+            if (csv) {
+                printf("%s,%zu,%s,%.2f,%.2f,%.0f,%.3f,%.3f,%.3f\n",
+                    packets[p].name, packets[p].size, implementation, writeNs, readNs, packetsPerSecond,
+                    latency.p50 / 1000.0, latency.p99 / 1000.0, latency.max / 1000.0
+                );
+            } else {
+                printf("%-9s %5zu %-7s %9.2f %9.2f %12.0f %9.2f %9.2f %9.2f\n",
+                    packets[p].name, packets[p].size, implementation, writeNs, readNs, packetsPerSecond,
+                    latency.p50 / 1000.0, latency.p99 / 1000.0, latency.max / 1000.0
+                );
+            }
+
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures the cost of one track's duration changing in a long setlist, as
+// happens for every track while a new set is analyzed.
+//
+// "full" is the former -_calculateStartAndEndTimes loop: every track's
+// duration and both neighbours' silence feed the auto-gap padding, and every
+// end time is written. Here those are plain arrays rather than Objective-C
+// messages, so it is a lower bound. "suffix" updates the two affected spans
+// in HugSetlistTiming and rewrites the end times from the changed track on.
+// "visible" updates the spans and then reads the end times of 40 rows, which
+// is what SetlistController and the rows on screen do.
+//
+// Usage: SetlistTimingBenchmark [--quick] [--csv] [--tracks N] [--edits N]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugSetlistTiming.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sMinimumSilence 4
+#define sVisibleRows    40
+
+
+typedef struct {
+    double *durations;
+    double *silenceAtStart;
+    double *silenceAtEnd;
+    double *endTimes;
+    size_t  count;
+} BenchmarkSetlist;
+
+
+static volatile double sSideEffect = 0;
+
+
+static uint32_t sNextRandom(uint32_t *state)
+{
+    *state = (*state * 1664525u) + 1013904223u;
+    return *state >> 8;
+}
+
+
+static double sGetPadding(const BenchmarkSetlist *setlist, size_t index)
+{
+    if (index == 0) return 0;
+
+    double padding = sMinimumSilence - (setlist->silenceAtEnd[index - 1] + setlist->silenceAtStart[index]);
+    return padding > 0 ? padding : 1.0;
+}
+
+
+static double sGetSpan(const BenchmarkSetlist *setlist, size_t index)
+{
+    return sGetPadding(setlist, index) + setlist->durations[index];
+}
+
+
+static void sCalculateFull(BenchmarkSetlist *setlist)
+{
+    double time = 0;
+
+    for (size_t i = 0; i < setlist->count; i++) {
+        time += sGetSpan(setlist, i);
+        setlist->endTimes[i] = time;
+    }
+
+    sSideEffect += setlist->endTimes[setlist->count - 1];
+}
+
+
+static void sUpdateSpans(HugSetlistTiming *timing, const BenchmarkSetlist *setlist, size_t index)
+{
+    HugSetlistTimingSetSpan(timing, index, sGetSpan(setlist, index));
+
+    if (index + 1 < setlist->count) {
+        HugSetlistTimingSetSpan(timing, index + 1, sGetSpan(setlist, index + 1));
+    }
+}
+
+
+static void sCalculateSuffix(HugSetlistTiming *timing, BenchmarkSetlist *setlist, size_t index)
+{
+    sUpdateSpans(timing, setlist, index);
+
+    double time = index ? HugSetlistTimingGetEndTime(timing, index - 1) : 0;
+
+    for (size_t i = index; i < setlist->count; i++) {
+        time += HugSetlistTimingGetSpan(timing, i);
+        setlist->endTimes[i] = time;
+    }
+
+    sSideEffect += setlist->endTimes[setlist->count - 1];
+}
+
+
+static void sCalculateVisible(HugSetlistTiming *timing, BenchmarkSetlist *setlist, size_t index, size_t firstRow)
+{
+    sUpdateSpans(timing, setlist, index);
+
+    for (size_t row = firstRow; row < firstRow + sVisibleRows && row < setlist->count; row++) {
+        sSideEffect += HugSetlistTimingGetEndTime(timing, row);
+    }
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t trackCount = 10000;
+    size_t editCount  = 2000;
+    bool   csv        = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            editCount = 200;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[i], "--tracks") && (i + 1) < argc) {
+            trackCount = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--edits") && (i + 1) < argc) {
+            editCount = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv] [--tracks N] [--edits N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (trackCount == 0) trackCount = 1;
+    if (editCount == 0)  editCount = 1;
+
+    BenchmarkSetlist setlist = {
+        malloc(trackCount * sizeof(double)),
+        malloc(trackCount * sizeof(double)),
+        malloc(trackCount * sizeof(double)),
+        malloc(trackCount * sizeof(double)),
+        trackCount
+    };
+
+    uint32_t seed = 42;
+
+    for (size_t i = 0; i < trackCount; i++) {
+        setlist.durations[i]      = 120 + (sNextRandom(&seed) % 480);
+        setlist.silenceAtStart[i] = (sNextRandom(&seed) % 3000) / 1000.0;
+        setlist.silenceAtEnd[i]   = (sNextRandom(&seed) % 3000) / 1000.0;
+    }
+
+    double *spans = malloc(trackCount * sizeof(double));
+
+    for (size_t i = 0; i < trackCount; i++) {
+        spans[i] = sGetSpan(&setlist, i);
+    }
+
+    HugSetlistTiming *timing = HugSetlistTimingCreate();
+
+    uint64_t resetStart = HugBenchmarkGetNanoseconds();
+    HugSetlistTimingReset(timing, spans, trackCount);
+    double resetUs = (HugBenchmarkGetNanoseconds() - resetStart) / 1000.0;
+
+    size_t *edits  = malloc(editCount * sizeof(size_t));
+    double *values = malloc(editCount * sizeof(double));
+
+    for (size_t e = 0; e < editCount; e++) {
+        edits[e]  = sNextRandom(&seed) % trackCount;
+        values[e] = 120 + (sNextRandom(&seed) % 480);
+    }
+
+    uint64_t *fullSamples    = malloc(editCount * sizeof(uint64_t));
+    uint64_t *suffixSamples  = malloc(editCount * sizeof(uint64_t));
+    uint64_t *visibleSamples = malloc(editCount * sizeof(uint64_t));
+
+    for (size_t e = 0; e < editCount; e++) {
+        setlist.durations[edits[e]] = values[e];
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        sCalculateFull(&setlist);
+        fullSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    for (size_t e = 0; e < editCount; e++) {
+        setlist.durations[edits[e]] = values[(e + 1) % editCount];
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        sCalculateSuffix(timing, &setlist, edits[e]);
+        suffixSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    for (size_t e = 0; e < editCount; e++) {
+        setlist.durations[edits[e]] = values[e];
+        size_t firstRow = edits[(e + 1) % editCount];
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        sCalculateVisible(timing, &setlist, edits[e], firstRow);
+        visibleSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    // Every path agrees with a full pass at the end
+    sCalculateFull(&setlist);
+    double difference = setlist.endTimes[trackCount - 1] - HugSetlistTimingGetEndTime(timing, trackCount - 1);
+
+    HugBenchmarkStats full    = HugBenchmarkGetStats(fullSamples,    editCount);
+    HugBenchmarkStats suffix  = HugBenchmarkGetStats(suffixSamples,  editCount);
+    HugBenchmarkStats visible = HugBenchmarkGetStats(visibleSamples, editCount);
+
+    if (csv) {
+        printf("tracks,edits,full_p50_us,full_p99_us,suffix_p50_us,suffix_p99_us,visible_p50_us,visible_p99_us,reset_us,difference_s\n");
+        printf("%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.3f,%.3f,%.2f,%g\n",
+            trackCount, editCount,
+            full.p50 / 1000.0,    full.p99 / 1000.0,
+            suffix.p50 / 1000.0,  suffix.p99 / 1000.0,
+            visible.p50 / 1000.0, visible.p99 / 1000.0,
+            resetUs, difference
+        );
+
+    } else {
+        printf("Setlist timing, %zu tracks, %zu edits\n\n", trackCount, editCount);
+
+        printf("%-10s %12s %12s\n", "", "edit p50", "edit p99");
+        printf("%-10s %9.2f us %9.2f us\n", "full",    full.p50 / 1000.0,    full.p99 / 1000.0);
+        printf("%-10s %9.2f us %9.2f us\n", "suffix",  suffix.p50 / 1000.0,  suffix.p99 / 1000.0);
+        printf("%-10s %9.3f us %9.3f us\n", "visible", visible.p50 / 1000.0, visible.p99 / 1000.0);
+
+        printf("\nreset: %.2f us, difference: %g s\n", resetUs, difference);
+    }
+
+    HugSetlistTimingFree(timing);
+
+    free(setlist.durations);
+    free(setlist.silenceAtStart);
+    free(setlist.silenceAtEnd);
+    free(setlist.endTimes);
+    free(spans);
+    free(edits);
+    free(values);
+    free(fullSamples);
+    free(suffixSamples);
+    free(visibleSamples);
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Compares HugStereoFieldProcess() against the original per-sample pow()
+// implementation for each combination of steady and ramping width/balance.
+//
+// Usage: StereoFieldBenchmark [--quick] [--csv]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugStereoField.h"
+#include "HugVectorOps.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct {
+    float  previousBalance;
+    float  previousWidth;
+} LegacyStereoField;
+
+
+static const size_t sFrameSizes[] = { 64, 128, 512, 1024, 4096 };
+#define sFrameSizeCount (sizeof(sFrameSizes) / sizeof(sFrameSizes[0]))
+
+static volatile float sSideEffect = 0;
+
+
+// HugStereoFieldProcess() before it was specialized
+static void sLegacyProcess(LegacyStereoField *self, float *left, float *right, size_t frameCount, float balance, float width)
+{
+    float previousWidth = self->previousWidth;
+
+    if (previousWidth != 1.0 || width != 1.0) {
+        if (previousWidth == width) {
+            const float myWidth    = (width + 1.0f) *  0.5f;
+            const float otherWidth = (width - 1.0f) * -0.5f;
+
+            for (size_t i = 0; i < frameCount; i++) {
+                const float l = left[i];
+                const float r = right[i];
+
+                left[i]  = (l * myWidth) + (r * otherWidth);
+                right[i] = (r * myWidth) + (l * otherWidth);
+            }
+
+        } else {
+            for (size_t i = 0; i < frameCount; i++) {
+                float t = (float)i / ((float)frameCount - 1);
+                float stereoLevel = (previousWidth * (1.0f - t)) + (width * t);
+
+                float l = left[i];
+                float r = right[i];
+
+                const float myWidth    = (stereoLevel + 1.0f) *  0.5f;
+                const float otherWidth = (stereoLevel - 1.0f) * -0.5f;
+
+                left[i]  = (l * myWidth) + (r * otherWidth);
+                right[i] = (r * myWidth) + (l * otherWidth);
+            }
+        }
+    }
+
+    float previousBalance = self->previousBalance;
+
+    if (previousBalance != 0.0 || balance != 0.0) {
+        if (previousBalance == balance) {
+            float m;
+
+            m = pow(1.0 - balance, 3);
+            if (m < 1.0) HugVectorMultiplyScalar(left, m, left, frameCount);
+
+            m = pow(1.0 + balance, 3);
+            if (m < 1.0) HugVectorMultiplyScalar(right, m, right, frameCount);
+
+        } else {
+            for (size_t i = 0; i < frameCount; i++) {
+                float t = (float)i / ((float)frameCount - 1);
+                float b = (previousBalance * (1.0f - t)) + (balance * t);
+                float m;
+
+                m = pow(1.0 - b, 3);
+                if (m < 1.0) left[i] *= m;
+
+                m = pow(1.0 + b, 3);
+                if (m < 1.0) right[i] *= m;
+            }
+        }
+    }
+
+    self->previousWidth   = width;
+    self->previousBalance = balance;
+}
+
+
+// Alternates between two settings per block when ramping
+static void sGetParameters(bool rampWidth, bool rampBalance, size_t block, float *outBalance, float *outWidth)
+{
+    *outWidth   = rampWidth   ? ((block & 1) ? 0.25f : 0.75f) : 0.5f;
+    *outBalance = rampBalance ? ((block & 1) ? -0.3f : 0.4f)  : 0.2f;
+}
+
+
+static double sMeasure(bool legacy, bool rampWidth, bool rampBalance, size_t frameCount, size_t blockCount, const float *input, float *outMaxError)
+{
+    float *left  = malloc(sizeof(float) * frameCount);
+    float *right = malloc(sizeof(float) * frameCount);
+
+    LegacyStereoField legacyField = { 0 };
+    HugStereoField *field = HugStereoFieldCreate();
+
+    float balance, width;
+    sGetParameters(rampWidth, rampBalance, 0, &balance, &width);
+
+    legacyField.previousBalance = balance;
+    legacyField.previousWidth   = width;
+    HugStereoFieldReset(field, balance, width);
+
+    uint64_t total = 0;
+
+    for (size_t block = 1; block <= blockCount; block++) {
+        memcpy(left,  input, sizeof(float) * frameCount);
+        memcpy(right, input + frameCount, sizeof(float) * frameCount);
+
+        sGetParameters(rampWidth, rampBalance, block, &balance, &width);
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        if (legacy) {
+            sLegacyProcess(&legacyField, left, right, frameCount, balance, width);
+        } else {
+            HugStereoFieldProcess(field, left, right, frameCount, balance, width);
+        }
+
+        total += HugBenchmarkGetNanoseconds() - start;
+    }
+
+    // Compare one more block from identical state against the legacy path
+    if (outMaxError) {
+        float *expectedLeft  = malloc(sizeof(float) * frameCount);
+        float *expectedRight = malloc(sizeof(float) * frameCount);
+
+        memcpy(left,  input, sizeof(float) * frameCount);
+        memcpy(right, input + frameCount, sizeof(float) * frameCount);
+        memcpy(expectedLeft,  left,  sizeof(float) * frameCount);
+        memcpy(expectedRight, right, sizeof(float) * frameCount);
+
+        sGetParameters(rampWidth, rampBalance, 0, &balance, &width);
+        legacyField.previousBalance = balance;
+        legacyField.previousWidth   = width;
+        HugStereoFieldReset(field, balance, width);
+
+        sGetParameters(rampWidth, rampBalance, 1, &balance, &width);
+        sLegacyProcess(&legacyField, expectedLeft, expectedRight, frameCount, balance, width);
+        HugStereoFieldProcess(field, left, right, frameCount, balance, width);
+
+        float maxError = 0;
+
+        for (size_t i = 0; i < frameCount; i++) {
+            float errorL = fabsf(left[i]  - expectedLeft[i]);
+            float errorR = fabsf(right[i] - expectedRight[i]);
+
+            if (errorL > maxError) maxError = errorL;
+            if (errorR > maxError) maxError = errorR;
+        }
+
+        *outMaxError = maxError;
+
+        free(expectedLeft);
+        free(expectedRight);
+    }
+
+    sSideEffect += left[0] + right[frameCount - 1];
+
+    HugStereoFieldFree(field);
+    free(left);
+    free(right);
+
+    return (double)total / ((double)blockCount * frameCount);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t framesPerCase = 48000 * 20;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            framesPerCase = 48000;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t maxFrameCount = sFrameSizes[sFrameSizeCount - 1];
+    float *input = malloc(sizeof(float) * maxFrameCount * 2);
+
+    uint32_t seed = 1;
+    for (size_t i = 0; i < maxFrameCount * 2; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        input[i] = ((seed >> 8) / 8388608.0f) - 1.0f;
+    }
+
+    if (csv) {
+        printf("width,balance,frames,legacy_ns_per_frame,ns_per_frame,speedup,max_error\n");
+    } else {
+        printf("HugStereoFieldProcess, legacy vs specialized (backend: %s)\n\n", HugVectorGetBackendName());
+        printf("%-7s %-7s %6s %12s %12s %8s %10s\n", "width", "balance", "frames", "legacy ns/f", "new ns/f", "speedup", "max error");
+    }
+
+    for (size_t combination = 0; combination < 4; combination++) {
+        bool rampWidth   = (combination & 2) != 0;
+        bool rampBalance = (combination & 1) != 0;
+
+        for (size_t f = 0; f < sFrameSizeCount; f++) {
+            size_t frameCount = sFrameSizes[f];
+            size_t blockCount = framesPerCase / frameCount;
+            if (blockCount < 16) blockCount = 16;
+
+            float maxError = 0;
+            double legacy = sMeasure(true,  rampWidth, rampBalance, frameCount, blockCount, input, NULL);
+            double fast   = sMeasure(false, rampWidth, rampBalance, frameCount, blockCount, input, &maxError);
+
+            const char *widthName   = rampWidth   ? "ramp" : "steady";
+            const char *balanceName = rampBalance ? "ramp" : "steady";
+
+            if (csv) {
+                printf("%s,%s,%zu,%.3f,%.3f,%.2f,%g\n", widthName, balanceName, frameCount, legacy, fast, legacy / fast, maxError);
+            } else {
+                printf("%-7s %-7s %6zu %12.3f %12.3f %7.1fx %10.2g\n", widthName, balanceName, frameCount, legacy, fast, legacy / fast, maxError);
+            }
+        }
+    }
+
+    free(input);
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures how fast and how well HugTempo estimates BPM.
+//
+// "cpu" is the processor time HugTempo adds to the Worker's loudness pass,
+// feeding it a synthetic track in 64k-frame decoder chunks and taking the
+// estimate, scaled to a five-minute track. The budget is one second.
+//
+// Accuracy uses synthetic click tracks from 70 to 180 BPM in four styles:
+// a metronome accenting the first of four beats, the same with quieter
+// off-beats, a kick/snare/hi-hat pattern, and clicks with up to 8 ms of
+// timing jitter under loud noise. "exact" counts estimates within 0.5 BPM,
+// "acc1" within 4%, and "acc2" within 4% of the tempo or of a half, double,
+// third or triple of it. "noise" is the confidence for noise alone.
+//
+// Usage: TempoBenchmark [--quick] [--csv] [--seconds 300]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugTempo.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define sChunkFrames (4096 * 16)
+#define sSampleRate  44100.0
+#define sStyleCount  4
+
+
+static const char *sStyleNames[sStyleCount] = { "clicks", "off-beats", "drums", "jitter" };
+
+
+static uint32_t sNextRandom(uint32_t *state)
+{
+    *state = (*state * 1664525u) + 1013904223u;
+    return *state >> 8;
+}
+
+
+static double sNextUniform(uint32_t *state)
+{
+    return (sNextRandom(state) / (double)(1 << 23)) - 1.0;
+}
+
+
+// Decaying noise burst, or a sine dropping in pitch when frequency is set
+static void sAddHit(float *samples, size_t frameCount, double time, double amplitude, double decay, double frequency, uint32_t *seed)
+{
+    size_t first = (size_t)(time * sSampleRate);
+    size_t length = (size_t)(decay * 6 * sSampleRate);
+    double phase = 0;
+
+    for (size_t i = 0; i < length && (first + i) < frameCount; i++) {
+        double envelope = amplitude * exp(-(double)i / (decay * sSampleRate));
+        double value;
+
+        if (frequency) {
+            phase += (2.0 * M_PI * frequency * (1.0 + exp(-(double)i / (0.01 * sSampleRate)))) / sSampleRate;
+            value = sin(phase);
+        } else {
+            value = sNextUniform(seed);
+        }
+
+        samples[first + i] += envelope * value;
+    }
+}
+
+
+static float *sCopyTrack(size_t style, double bpm, double seconds, uint32_t *seed)
+{
+    size_t frameCount = (size_t)(seconds * sSampleRate);
+    float *samples = calloc(frameCount, sizeof(float));
+
+    double period = 60.0 / bpm;
+    size_t beatCount = (size_t)(seconds / period) + 1;
+
+    for (size_t beat = 0; beat < beatCount; beat++) {
+        double time = beat * period;
+
+        if (style == 0 || style == 1) {
+            sAddHit(samples, frameCount, time, (beat % 4) ? 0.5 : 0.8, 0.004, 0, seed);
+            if (style == 1) sAddHit(samples, frameCount, time + (period / 2), 0.15, 0.004, 0, seed);
+
+        } else if (style == 2) {
+            if (beat % 2) {
+                sAddHit(samples, frameCount, time, 0.4, 0.03, 0, seed);
+            } else {
+                sAddHit(samples, frameCount, time, 0.8, 0.05, 55, seed);
+            }
+
+            sAddHit(samples, frameCount, time,                0.1, 0.003, 0, seed);
+            sAddHit(samples, frameCount, time + (period / 2), 0.1, 0.003, 0, seed);
+
+        } else {
+            sAddHit(samples, frameCount, time + (0.008 * sNextUniform(seed)), 0.5, 0.004, 0, seed);
+        }
+    }
+
+    double noise = (style == 3) ? 0.1 : 0.005;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] += noise * sNextUniform(seed);
+    }
+
+    return samples;
+}
+
+
+static bool sEstimate(const float *left, const float *right, size_t frameCount, double sampleRate, double *outBPM, double *outConfidence)
+{
+    HugTempo *tempo = HugTempoCreate(2, sampleRate);
+
+    for (size_t offset = 0; offset < frameCount; offset += sChunkFrames) {
+        size_t frames = frameCount - offset;
+        if (frames > sChunkFrames) frames = sChunkFrames;
+
+        const float *channels[2] = { left + offset, right + offset };
+        HugTempoProcess(tempo, channels, frames);
+    }
+
+    bool result = HugTempoGetEstimate(tempo, outBPM, outConfidence);
+    HugTempoFree(tempo);
+
+    return result;
+}
+
+
+static bool sIsWithin(double estimate, double bpm, double tolerance)
+{
+    return fabs(estimate - bpm) <= (bpm * tolerance);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    double seconds     = 300;
+    double trackLength = 60;
+    double tempoStep   = 2.5;
+    bool   csv         = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            seconds     = 60;
+            trackLength = 30;
+            tempoStep   = 10;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[i], "--seconds") && (i + 1) < argc) {
+            seconds = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv] [--seconds n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Speed, best of three
+    HugBenchmarkAudio audio;
+    HugBenchmarkAudioMakeSynthetic(&audio, sSampleRate, seconds);
+
+    double cpu = INFINITY;
+
+    for (size_t r = 0; r < 3; r++) {
+        clock_t start = clock();
+
+        double bpm, confidence;
+        sEstimate(audio.left, audio.right, audio.frameCount, audio.sampleRate, &bpm, &confidence);
+
+        cpu = fmin(cpu, (double)(clock() - start) / CLOCKS_PER_SEC);
+    }
+
+    double cpuPerTrack = cpu * (300.0 / seconds);
+
+    HugBenchmarkAudioFree(&audio);
+
+    // Accuracy
+    size_t trackCount[sStyleCount] = { 0 };
+    size_t exactCount[sStyleCount] = { 0 };
+    size_t acc1Count[sStyleCount]  = { 0 };
+    size_t acc2Count[sStyleCount]  = { 0 };
+    double confidences[sStyleCount] = { 0 };
+
+    uint32_t seed = 42;
+
+    for (size_t style = 0; style < sStyleCount; style++) {
+        for (double tempo = 70; tempo <= 180; tempo += tempoStep) {
+            // Off the grid, tempos in the wild are rarely whole numbers
+            double bpm = tempo + (0.5 * (sNextUniform(&seed) + 1));
+
+            float *samples = sCopyTrack(style, bpm, trackLength, &seed);
+            size_t frameCount = (size_t)(trackLength * sSampleRate);
+
+            double estimate = 0, confidence = 0;
+            sEstimate(samples, samples, frameCount, sSampleRate, &estimate, &confidence);
+
+            trackCount[style]++;
+            confidences[style] += confidence;
+
+            if (fabs(estimate - bpm) <= 0.5) exactCount[style]++;
+            if (sIsWithin(estimate, bpm, 0.04)) acc1Count[style]++;
+
+            if (sIsWithin(estimate, bpm,     0.04) ||
+                sIsWithin(estimate, bpm * 2, 0.04) || sIsWithin(estimate, bpm / 2, 0.04) ||
+                sIsWithin(estimate, bpm * 3, 0.04) || sIsWithin(estimate, bpm / 3, 0.04)
+            ) {
+                acc2Count[style]++;
+            }
+
+            free(samples);
+        }
+    }
+
+    // Noise alone
+    size_t noiseFrames = (size_t)(trackLength * sSampleRate);
+    float *noise = malloc(noiseFrames * sizeof(float));
+
+    for (size_t i = 0; i < noiseFrames; i++) {
+        noise[i] = 0.3 * sNextUniform(&seed);
+    }
+
+    double noiseBPM = 0, noiseConfidence = 0;
+    sEstimate(noise, noise, noiseFrames, sSampleRate, &noiseBPM, &noiseConfidence);
+    free(noise);
+
+    if (csv) {
+        printf("style,tracks,exact,acc1,acc2,confidence,cpu_s_per_5min,noise_confidence\n");
+
+        for (size_t style = 0; style < sStyleCount; style++) {
+            double count = trackCount[style];
+
+            printf("%s,%zu,%.4f,%.4f,%.4f,%.3f,%.4f,%.3f\n",
+                sStyleNames[style], trackCount[style],
+                exactCount[style] / count, acc1Count[style] / count, acc2Count[style] / count,
+                confidences[style] / count, cpuPerTrack, noiseConfidence
+            );
+        }
+
+    } else {
+        printf("Tempo estimation, %.0f s tracks from 70 to 180 BPM\n\n", trackLength);
+
+        printf("cpu: %.4f s per 5-minute track (measured on %.0f s)\n\n", cpuPerTrack, seconds);
+
+        printf("%-10s %7s %8s %8s %8s %11s\n", "", "tracks", "exact", "acc1", "acc2", "confidence");
+
+        for (size_t style = 0; style < sStyleCount; style++) {
+            double count = trackCount[style];
+
+            printf("%-10s %7zu %7.1f%% %7.1f%% %7.1f%% %11.3f\n",
+                sStyleNames[style], trackCount[style],
+                (exactCount[style] * 100) / count, (acc1Count[style] * 100) / count, (acc2Count[style] * 100) / count,
+                confidences[style] / count
+            );
+        }
+
+        printf("\nnoise confidence: %.3f\n", noiseConfidence);
+    }
+
+    return 0;
+}
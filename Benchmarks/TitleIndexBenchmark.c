@@ -0,0 +1,283 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures similar-title detection over a synthetic corpus: titles of two to
+// five words from a 400-word vocabulary, one in ten a variant of an earlier
+// title ("feat." clause, remix or edit suffix, or a one-letter typo).
+//
+// "build" inserts the whole corpus and queries every title, as the first
+// duplicate pass after loading does. "insert" and "remove" are single tracks
+// arriving in and leaving a full index, each followed by the queries that
+// TracksController makes. "scan" is what the same matching costs per insert
+// without the LSH tables: the new title against every other title. "recall"
+// is the share of planted variants found similar to their original, first of
+// all of them, then of those whose similarity reaches the threshold (typos in
+// short titles often do not).
+//
+// Usage: TitleIndexBenchmark [--quick] [--csv] [--titles N]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugTitleIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sThreshold       0.6
+#define sVocabularyCount 400
+#define sMaximumLength   128
+
+
+static volatile size_t sSideEffect = 0;
+
+
+static uint32_t sNextRandom(uint32_t *state)
+{
+    *state = (*state * 1664525u) + 1013904223u;
+    return *state >> 8;
+}
+
+
+static void sMakeWord(uint32_t *seed, char *outWord)
+{
+    static const char consonants[] = "bcdfghjklmnprstvwyz";
+    static const char vowels[]     = "aeiou";
+
+    size_t syllables = 1 + (sNextRandom(seed) % 3);
+    char *o = outWord;
+
+    for (size_t s = 0; s < syllables; s++) {
+        *o++ = consonants[sNextRandom(seed) % (sizeof(consonants) - 1)];
+        *o++ = vowels[sNextRandom(seed) % (sizeof(vowels) - 1)];
+    }
+
+    *o = 0;
+}
+
+
+static void sMakeVariant(uint32_t *seed, char vocabulary[][8], const char *original, char *outTitle)
+{
+    static const char * const suffixes[] = { "radio edit", "extended mix", "remix", "club mix", "original mix" };
+
+    uint32_t kind = sNextRandom(seed) % 3;
+
+    if (kind == 0) {
+        snprintf(outTitle, sMaximumLength, "%s feat %s %s", original,
+            vocabulary[sNextRandom(seed) % sVocabularyCount],
+            vocabulary[sNextRandom(seed) % sVocabularyCount]
+        );
+
+    } else if (kind == 1) {
+        snprintf(outTitle, sMaximumLength, "%s %s %s", original,
+            vocabulary[sNextRandom(seed) % sVocabularyCount],
+            suffixes[sNextRandom(seed) % 5]
+        );
+
+    } else {
+        strcpy(outTitle, original);
+
+        size_t length = strlen(outTitle);
+        size_t at = sNextRandom(seed) % length;
+
+        if (outTitle[at] != ' ') outTitle[at] = 'a' + (sNextRandom(seed) % 26);
+    }
+}
+
+
+static size_t sInsertAndQuery(HugTitleIndex *index, const char *title)
+{
+    size_t slot = HugTitleIndexInsert(index, title);
+    size_t count = 0;
+
+    free(HugTitleIndexCopySimilar(index, slot, &count));
+    sSideEffect += count;
+
+    return slot;
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t titleCount = 50000;
+    size_t editCount  = 1000;
+    size_t scanCount  = 100;
+    bool   csv        = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            titleCount = 5000;
+            editCount  = 200;
+            scanCount  = 20;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[i], "--titles") && (i + 1) < argc) {
+            titleCount = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv] [--titles N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (titleCount < 2) titleCount = 2;
+
+    uint32_t seed = 42;
+
+    char (*vocabulary)[8] = malloc(sVocabularyCount * sizeof(*vocabulary));
+
+    for (size_t i = 0; i < sVocabularyCount; i++) {
+        sMakeWord(&seed, vocabulary[i]);
+    }
+
+    size_t totalCount = titleCount + editCount;
+
+    char (*titles)[sMaximumLength] = malloc(totalCount * sizeof(*titles));
+    size_t *originals = malloc(totalCount * sizeof(size_t));
+
+    for (size_t i = 0; i < totalCount; i++) {
+        originals[i] = SIZE_MAX;
+
+        if (i > 0 && (sNextRandom(&seed) % 10) == 0) {
+            originals[i] = sNextRandom(&seed) % i;
+            sMakeVariant(&seed, vocabulary, titles[originals[i]], titles[i]);
+            continue;
+        }
+
+        size_t wordCount = 2 + (sNextRandom(&seed) % 4);
+        titles[i][0] = 0;
+
+        for (size_t w = 0; w < wordCount; w++) {
+            if (w) strcat(titles[i], " ");
+            strcat(titles[i], vocabulary[sNextRandom(&seed) % sVocabularyCount]);
+        }
+    }
+
+    // Build
+    HugTitleIndex *index = HugTitleIndexCreate(sThreshold);
+    size_t *slots = malloc(totalCount * sizeof(size_t));
+
+    uint64_t buildStart = HugBenchmarkGetNanoseconds();
+
+    for (size_t i = 0; i < titleCount; i++) {
+        slots[i] = HugTitleIndexInsert(index, titles[i]);
+    }
+
+    for (size_t i = 0; i < titleCount; i++) {
+        size_t count = 0;
+        free(HugTitleIndexCopySimilar(index, slots[i], &count));
+        sSideEffect += count;
+    }
+
+    double buildMs = (HugBenchmarkGetNanoseconds() - buildStart) / 1000000.0;
+
+    // Recall of planted variants whose original is in the index
+    size_t plantedCount = 0, foundCount = 0, eligibleCount = 0;
+
+    for (size_t i = 0; i < titleCount; i++) {
+        if (originals[i] == SIZE_MAX) continue;
+
+        size_t count = 0;
+        size_t *similar = HugTitleIndexCopySimilar(index, slots[i], &count);
+
+        plantedCount++;
+
+        if (HugTitleIndexGetSimilarity(index, slots[i], slots[originals[i]]) >= sThreshold) {
+            eligibleCount++;
+        }
+
+        for (size_t s = 0; s < count; s++) {
+            if (similar[s] == slots[originals[i]]) {
+                foundCount++;
+                break;
+            }
+        }
+
+        free(similar);
+    }
+
+    // Single inserts and removes into the full index
+    uint64_t *insertSamples = malloc(editCount * sizeof(uint64_t));
+    uint64_t *removeSamples = malloc(editCount * sizeof(uint64_t));
+
+    for (size_t e = 0; e < editCount; e++) {
+        size_t i = titleCount + e;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        slots[i] = sInsertAndQuery(index, titles[i]);
+        insertSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    for (size_t e = 0; e < editCount; e++) {
+        size_t i = titleCount + e;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        size_t count = 0;
+        free(HugTitleIndexCopySimilar(index, slots[i], &count));
+        HugTitleIndexRemove(index, slots[i]);
+        sSideEffect += count;
+
+        removeSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    // The same matching by scanning every title
+    uint64_t *scanSamples = malloc(scanCount * sizeof(uint64_t));
+
+    for (size_t e = 0; e < scanCount; e++) {
+        size_t i = titleCount + e;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+
+        size_t slot = HugTitleIndexInsert(index, titles[i]);
+
+        for (size_t j = 0; j < titleCount; j++) {
+            if (HugTitleIndexGetSimilarity(index, slot, slots[j]) >= sThreshold) sSideEffect++;
+        }
+
+        HugTitleIndexRemove(index, slot);
+
+        scanSamples[e] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    HugBenchmarkStats insert = HugBenchmarkGetStats(insertSamples, editCount);
+    HugBenchmarkStats remove = HugBenchmarkGetStats(removeSamples, editCount);
+    HugBenchmarkStats scan   = HugBenchmarkGetStats(scanSamples,   scanCount);
+
+    double recall         = plantedCount  ? (foundCount / (double)plantedCount)  : 1;
+    double eligibleRecall = eligibleCount ? (foundCount / (double)eligibleCount) : 1;
+
+    if (csv) {
+        printf("titles,build_ms,insert_p50_us,insert_p99_us,remove_p50_us,remove_p99_us,scan_p50_us,recall,eligible_recall\n");
+        printf("%zu,%.1f,%.2f,%.2f,%.2f,%.2f,%.1f,%.4f,%.4f\n",
+            titleCount, buildMs,
+            insert.p50 / 1000.0, insert.p99 / 1000.0,
+            remove.p50 / 1000.0, remove.p99 / 1000.0,
+            scan.p50 / 1000.0, recall, eligibleRecall
+        );
+
+    } else {
+        printf("Similar titles, %zu titles, threshold %.2f\n\n", titleCount, sThreshold);
+
+        printf("%-10s %12s %12s\n", "", "p50", "p99");
+        printf("%-10s %9.2f us %9.2f us\n", "insert", insert.p50 / 1000.0, insert.p99 / 1000.0);
+        printf("%-10s %9.2f us %9.2f us\n", "remove", remove.p50 / 1000.0, remove.p99 / 1000.0);
+        printf("%-10s %9.1f us %9.1f us\n", "scan",   scan.p50 / 1000.0,   scan.p99 / 1000.0);
+
+        printf("\nbuild: %.1f ms\n", buildMs);
+        printf("recall: %.2f%% of %zu variants, %.2f%% of the %zu at the threshold\n",
+            recall * 100, plantedCount, eligibleRecall * 100, eligibleCount
+        );
+    }
+
+    HugTitleIndexFree(index);
+
+    free(vocabulary);
+    free(titles);
+    free(originals);
+    free(slots);
+    free(insertSamples);
+    free(removeSamples);
+    free(scanSamples);
+
+    return 0;
+}
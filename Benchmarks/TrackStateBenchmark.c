@@ -0,0 +1,331 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures loading and saving track state with HugStateStore against one
+// file per track, which is how Track used to persist (a plist per UUID,
+// written atomically). The per-file side only reads and writes raw bytes;
+// the real plists also had to be parsed, so it is a lower bound.
+//
+// Each track has the numeric fields and strings Track saves, a 700 byte
+// bookmark and a 24 KB overview (four minutes at 100 Hz). "load" opens the
+// history and reads every field but the overview, "load+overview" also
+// copies every overview. "update" saves one changed numeric field, and
+// "compact" rewrites the store after every overview has been replaced.
+//
+// Timings are with a warm page cache.
+//
+// Usage: TrackStateBenchmark [--quick] [--csv] [--tracks N]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugStateStore.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Same shape as Track's state
+#define sNumberCount   19
+#define sStringCount   10
+#define sBookmarkField sStringCount
+#define sOverviewField (sStringCount + 1)
+#define sBlobCount     (sStringCount + 2)
+
+#define sStringLength   32
+#define sBookmarkLength 700
+#define sOverviewLength (240 * 100)
+
+#define sUpdateCount 1000
+
+
+static char sDirectoryPath[PATH_MAX];
+static char sStorePath[PATH_MAX];
+
+static volatile uint64_t sSideEffect = 0;
+
+
+static HugStateStoreID sMakeID(size_t index)
+{
+    HugStateStoreID itemID;
+    uint32_t seed = (uint32_t)index * 2654435761u + 1;
+
+    for (size_t i = 0; i < sizeof(itemID.bytes); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        itemID.bytes[i] = seed >> 24;
+    }
+
+    return itemID;
+}
+
+
+static size_t sGetBlobLength(size_t field)
+{
+    if (field == sBookmarkField) return sBookmarkLength;
+    if (field == sOverviewField) return sOverviewLength;
+    return sStringLength;
+}
+
+
+static void sMakeTrackPath(size_t index, char *outPath, size_t outLength)
+{
+    snprintf(outPath, outLength, "%s/track-%zu.state", sDirectoryPath, index);
+}
+
+
+static size_t sGetTrackFileLength(void)
+{
+    size_t result = sNumberCount * sizeof(double);
+
+    for (size_t f = 0; f < sBlobCount; f++) {
+        result += sizeof(uint32_t) + sGetBlobLength(f);
+    }
+
+    return result;
+}
+
+
+// Writes atomically, as -[NSDictionary writeToURL:atomically:YES] does
+static void sWriteTrackFile(size_t index, const uint8_t *bytes, size_t length)
+{
+    char path[PATH_MAX], temporaryPath[PATH_MAX + 4];
+
+    sMakeTrackPath(index, path, sizeof(path));
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+
+    int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+
+    if (write(fd, bytes, length) != (ssize_t)length) {
+        fprintf(stderr, "Could not write '%s'\n", temporaryPath);
+    }
+
+    close(fd);
+    rename(temporaryPath, path);
+}
+
+
+static void sFillStore(HugStateStore *store, size_t trackCount, uint8_t *blob)
+{
+    double numbers[sNumberCount];
+
+    for (size_t t = 0; t < trackCount; t++) {
+        HugStateStoreID itemID = sMakeID(t);
+
+        for (size_t i = 0; i < sNumberCount; i++) {
+            numbers[i] = t + i;
+        }
+
+        HugStateStoreWriteNumbers(store, itemID, (1ull << sNumberCount) - 1, numbers);
+
+        for (size_t f = 0; f < sBlobCount; f++) {
+            blob[0] = (uint8_t)t;
+            HugStateStoreWriteBlob(store, itemID, f, blob, sGetBlobLength(f));
+        }
+    }
+}
+
+
+static double sLoadStore(size_t trackCount, bool includeOverview)
+{
+    uint64_t start = HugBenchmarkGetNanoseconds();
+
+    HugStateStore *store = HugStateStoreOpen(sStorePath, sNumberCount, sBlobCount);
+    double numbers[sNumberCount];
+
+    for (size_t t = 0; t < trackCount; t++) {
+        HugStateStoreID itemID = sMakeID(t);
+
+        HugStateStoreReadNumbers(store, itemID, NULL, numbers);
+        sSideEffect += numbers[0];
+
+        size_t blobCount = includeOverview ? sBlobCount : sOverviewField;
+
+        for (size_t f = 0; f < blobCount; f++) {
+            size_t length = 0;
+            uint8_t *bytes = HugStateStoreCopyBlob(store, itemID, f, &length);
+
+            sSideEffect += bytes ? bytes[0] : 0;
+            free(bytes);
+        }
+    }
+
+    HugStateStoreFree(store);
+
+    return (HugBenchmarkGetNanoseconds() - start) / 1e6;
+}
+
+
+// A whole file has to be read either way
+static double sLoadFiles(size_t trackCount)
+{
+    uint64_t start = HugBenchmarkGetNanoseconds();
+
+    for (size_t t = 0; t < trackCount; t++) {
+        char path[PATH_MAX];
+        sMakeTrackPath(t, path, sizeof(path));
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) continue;
+
+        struct stat st;
+        fstat(fd, &st);
+
+        uint8_t *bytes = malloc(st.st_size);
+
+        if (read(fd, bytes, st.st_size) == st.st_size) {
+            sSideEffect += bytes[0];
+        }
+
+        free(bytes);
+        close(fd);
+    }
+
+    return (HugBenchmarkGetNanoseconds() - start) / 1e6;
+}
+
+
+static HugBenchmarkStats sUpdateStore(HugStateStore *store, size_t trackCount, uint64_t *samples)
+{
+    double numbers[sNumberCount] = {0};
+
+    for (size_t i = 0; i < sUpdateCount; i++) {
+        numbers[1] = i;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        HugStateStoreWriteNumbers(store, sMakeID(i % trackCount), 1ull << 1, numbers);
+        samples[i] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    return HugBenchmarkGetStats(samples, sUpdateCount);
+}
+
+
+static HugBenchmarkStats sUpdateFiles(size_t trackCount, uint8_t *file, size_t fileLength, uint64_t *samples)
+{
+    for (size_t i = 0; i < sUpdateCount; i++) {
+        file[0] = (uint8_t)i;
+
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        sWriteTrackFile(i % trackCount, file, fileLength);
+        samples[i] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    return HugBenchmarkGetStats(samples, sUpdateCount);
+}
+
+
+static void sRemoveFiles(size_t trackCount)
+{
+    for (size_t t = 0; t < trackCount; t++) {
+        char path[PATH_MAX];
+        sMakeTrackPath(t, path, sizeof(path));
+        unlink(path);
+    }
+
+    unlink(sStorePath);
+    rmdir(sDirectoryPath);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t trackCount = 5000;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            trackCount = 200;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[i], "--tracks") && (i + 1) < argc) {
+            trackCount = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv] [--tracks N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (trackCount == 0) trackCount = 1;
+
+    snprintf(sDirectoryPath, sizeof(sDirectoryPath), "%s/TrackStateBenchmark.XXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+
+    if (!mkdtemp(sDirectoryPath)) {
+        fprintf(stderr, "Could not create '%s'\n", sDirectoryPath);
+        return 1;
+    }
+
+    snprintf(sStorePath, sizeof(sStorePath), "%s/Tracks.store", sDirectoryPath);
+
+    uint8_t  *blob       = calloc(1, sOverviewLength);
+    size_t    fileLength = sGetTrackFileLength();
+    uint8_t  *file       = calloc(1, fileLength);
+    uint64_t *samples    = malloc(sUpdateCount * sizeof(uint64_t));
+
+    HugStateStore *store = HugStateStoreOpen(sStorePath, sNumberCount, sBlobCount);
+    sFillStore(store, trackCount, blob);
+    HugStateStoreFree(store);
+
+    for (size_t t = 0; t < trackCount; t++) {
+        sWriteTrackFile(t, file, fileLength);
+    }
+
+    // Warm the page cache for both
+    sLoadStore(trackCount, true);
+    sLoadFiles(trackCount);
+
+    double storeLoad     = sLoadStore(trackCount, false);
+    double storeLoadFull = sLoadStore(trackCount, true);
+    double filesLoad     = sLoadFiles(trackCount);
+
+    store = HugStateStoreOpen(sStorePath, sNumberCount, sBlobCount);
+
+    HugBenchmarkStats storeUpdate = sUpdateStore(store, trackCount, samples);
+    HugBenchmarkStats filesUpdate = sUpdateFiles(trackCount, file, fileLength, samples);
+
+    // Replace every overview, then measure the rewrite
+    for (size_t t = 0; t < trackCount; t++) {
+        HugStateStoreWriteBlob(store, sMakeID(t), sOverviewField, blob, sOverviewLength);
+    }
+
+    HugStateStoreStats beforeCompaction = HugStateStoreGetStats(store);
+
+    uint64_t compactStart = HugBenchmarkGetNanoseconds();
+    HugStateStoreCompact(store);
+    double compactMs = (HugBenchmarkGetNanoseconds() - compactStart) / 1e6;
+
+    HugStateStoreStats afterCompaction = HugStateStoreGetStats(store);
+    HugStateStoreFree(store);
+
+    if (csv) {
+        printf("tracks,store_load_ms,store_load_overview_ms,files_load_ms,store_update_p50_us,store_update_p99_us,files_update_p50_us,files_update_p99_us,compact_ms,compact_before_mb,compact_after_mb\n");
+        printf("%zu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+            trackCount, storeLoad, storeLoadFull, filesLoad,
+            storeUpdate.p50 / 1000.0, storeUpdate.p99 / 1000.0,
+            filesUpdate.p50 / 1000.0, filesUpdate.p99 / 1000.0,
+            compactMs, beforeCompaction.fileBytes / 1e6, afterCompaction.fileBytes / 1e6
+        );
+
+    } else {
+        printf("Track state, %zu tracks, HugStateStore vs one file per track\n\n", trackCount);
+
+        printf("%-14s %12s %12s\n", "", "store", "files");
+        printf("%-14s %9.2f ms %12s\n", "load", storeLoad, "");
+        printf("%-14s %9.2f ms %9.2f ms\n", "load+overview", storeLoadFull, filesLoad);
+        printf("%-14s %9.2f us %9.2f us\n", "update p50", storeUpdate.p50 / 1000.0, filesUpdate.p50 / 1000.0);
+        printf("%-14s %9.2f us %9.2f us\n", "update p99", storeUpdate.p99 / 1000.0, filesUpdate.p99 / 1000.0);
+
+        printf("\ncompact: %.2f ms, %.1f MB -> %.1f MB\n", compactMs, beforeCompaction.fileBytes / 1e6, afterCompaction.fileBytes / 1e6);
+    }
+
+    sRemoveFiles(trackCount);
+
+    free(blob);
+    free(file);
+    free(samples);
+
+    return 0;
+}
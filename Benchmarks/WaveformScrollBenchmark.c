@@ -0,0 +1,229 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Measures the per-row cost of drawing waveforms while scrolling a long
+// setlist. Each row that scrolls into view reduces its track's overview to
+// the view's width in pixels twice, once for each of WaveformView's layers.
+//
+// "scan" is the former -_reduceOverviewDataForTrack:toCount: path: copy the
+// cropped overview into a new buffer, allocate the output and take the
+// maximum of every window. It ran the windows with dispatch_apply(), which
+// is serial here. "pyramid" reduces through HugOverviewPyramid into buffers
+// that are reused between rows; building the pyramids is timed separately,
+// it happens once when each overview arrives.
+//
+// Usage: WaveformScrollBenchmark [--quick] [--csv] [--rows N] [--width px]
+//
+
+#include "BenchmarkSupport.h"
+#include "HugOverviewPyramid.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sOverviewRate 100
+
+
+typedef struct {
+    uint8_t *samples;
+    size_t   count;
+    void    *pyramid;
+    double   start;
+    double   stop;
+} BenchmarkRow;
+
+
+static volatile uint64_t sSideEffect = 0;
+
+
+static uint32_t sNextRandom(uint32_t *state)
+{
+    *state = (*state * 1664525u) + 1013904223u;
+    return *state >> 8;
+}
+
+
+// Two to ten minutes of loud-ish envelope, a fifth of them cropped
+static void sMakeRow(BenchmarkRow *row, uint32_t *seed)
+{
+    size_t seconds = 120 + (sNextRandom(seed) % 480);
+
+    row->count   = seconds * sOverviewRate;
+    row->samples = malloc(row->count);
+
+    uint8_t level = 128;
+
+    for (size_t i = 0; i < row->count; i++) {
+        level = (uint8_t)((level * 7 + (sNextRandom(seed) & 0xff)) / 8);
+        row->samples[i] = level;
+    }
+
+    row->start = 0;
+    row->stop  = row->count;
+
+    if ((sNextRandom(seed) % 5) == 0) {
+        row->start = sOverviewRate * 5;
+        row->stop  = row->count - (sOverviewRate * 10);
+    }
+}
+
+
+static void sReduceByScan(const BenchmarkRow *row, size_t outCount)
+{
+    size_t startOffset = (size_t)round(row->start);
+    size_t stopOffset  = (size_t)round(row->stop);
+    size_t inCount     = stopOffset - startOffset;
+
+    uint8_t *inBytes = malloc(inCount);
+    memcpy(inBytes, row->samples + startOffset, inCount);
+
+    if (inCount < outCount) {
+        sSideEffect += inBytes[0];
+        free(inBytes);
+        return;
+    }
+
+    uint8_t *outBytes = malloc(outCount);
+    double stride = inCount / (double)outCount;
+
+    for (size_t o = 0; o < outCount; o++) {
+        size_t i = llrintf(o * stride);
+        size_t length = (size_t)stride;
+
+        if (i + length > inCount) {
+            length = inCount - i;
+        }
+
+        uint8_t max = 0;
+
+        for (size_t j = 0; j < length; j++) {
+            uint8_t m = inBytes[i + j];
+            if (m > max) max = m;
+        }
+
+        outBytes[o] = max;
+    }
+
+    sSideEffect += outBytes[outCount / 2];
+
+    free(outBytes);
+    free(inBytes);
+}
+
+
+static void sReduceByPyramid(const BenchmarkRow *row, size_t outCount, uint8_t *outBytes)
+{
+    HugOverviewPyramidReduce(row->pyramid, row->samples, row->count, row->start, row->stop, outCount, NULL, outBytes);
+    sSideEffect += outBytes[outCount / 2];
+}
+
+
+int main(int argc, const char *argv[])
+{
+    size_t rowCount = 1000;
+    size_t width    = 800;
+    bool   csv      = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            rowCount = 50;
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[i], "--rows") && (i + 1) < argc) {
+            rowCount = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--width") && (i + 1) < argc) {
+            width = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--csv] [--rows N] [--width px]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (rowCount == 0) rowCount = 1;
+    if (width == 0) width = 1;
+
+    BenchmarkRow *rows = calloc(rowCount, sizeof(BenchmarkRow));
+    uint32_t seed = 42;
+
+    size_t overviewBytes = 0;
+    size_t pyramidBytes  = 0;
+
+    for (size_t r = 0; r < rowCount; r++) {
+        sMakeRow(&rows[r], &seed);
+        overviewBytes += rows[r].count;
+    }
+
+    uint64_t buildStart = HugBenchmarkGetNanoseconds();
+
+    for (size_t r = 0; r < rowCount; r++) {
+        size_t size = HugOverviewPyramidGetSize(rows[r].count);
+
+        rows[r].pyramid = malloc(size);
+        HugOverviewPyramidBuild(rows[r].samples, rows[r].count, rows[r].pyramid);
+
+        pyramidBytes += size;
+    }
+
+    double buildMs = (HugBenchmarkGetNanoseconds() - buildStart) / 1e6;
+
+    uint64_t *scanSamples    = malloc(rowCount * sizeof(uint64_t));
+    uint64_t *pyramidSamples = malloc(rowCount * sizeof(uint64_t));
+    uint8_t  *outBytes       = malloc(width);
+
+    // Warm up both paths
+    for (size_t r = 0; r < rowCount && r < 20; r++) {
+        sReduceByScan(&rows[r], width);
+        sReduceByPyramid(&rows[r], width, outBytes);
+    }
+
+    // One pass from top to bottom, each row drawn into both layers
+    for (size_t r = 0; r < rowCount; r++) {
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        sReduceByScan(&rows[r], width);
+        sReduceByScan(&rows[r], width);
+        scanSamples[r] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    for (size_t r = 0; r < rowCount; r++) {
+        uint64_t start = HugBenchmarkGetNanoseconds();
+        sReduceByPyramid(&rows[r], width, outBytes);
+        sReduceByPyramid(&rows[r], width, outBytes);
+        pyramidSamples[r] = HugBenchmarkGetNanoseconds() - start;
+    }
+
+    HugBenchmarkStats scan    = HugBenchmarkGetStats(scanSamples, rowCount);
+    HugBenchmarkStats pyramid = HugBenchmarkGetStats(pyramidSamples, rowCount);
+
+    if (csv) {
+        printf("rows,width,scan_p50_us,scan_p99_us,scan_total_ms,pyramid_p50_us,pyramid_p99_us,pyramid_total_ms,build_ms,overview_mb,pyramid_mb\n");
+        printf("%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+            rowCount, width,
+            scan.p50 / 1000.0, scan.p99 / 1000.0, scan.total / 1e6,
+            pyramid.p50 / 1000.0, pyramid.p99 / 1000.0, pyramid.total / 1e6,
+            buildMs, overviewBytes / 1e6, pyramidBytes / 1e6
+        );
+
+    } else {
+        printf("Waveform rows, %zu rows at %zu px\n\n", rowCount, width);
+
+        printf("%-10s %12s %12s %12s\n", "", "row p50", "row p99", "scroll");
+        printf("%-10s %9.2f us %9.2f us %9.2f ms\n", "scan",    scan.p50 / 1000.0,    scan.p99 / 1000.0,    scan.total / 1e6);
+        printf("%-10s %9.2f us %9.2f us %9.2f ms\n", "pyramid", pyramid.p50 / 1000.0, pyramid.p99 / 1000.0, pyramid.total / 1e6);
+
+        printf("\nbuild: %.2f ms, %.1f MB of pyramids for %.1f MB of overviews\n", buildMs, pyramidBytes / 1e6, overviewBytes / 1e6);
+    }
+
+    for (size_t r = 0; r < rowCount; r++) {
+        free(rows[r].samples);
+        free(rows[r].pyramid);
+    }
+
+    free(rows);
+    free(scanSamples);
+    free(pyramidSamples);
+    free(outBytes);
+
+    return 0;
+}
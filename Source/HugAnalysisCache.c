@@ -0,0 +1,502 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugAnalysisCache.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Hashed from each end of the file
+#define sFingerprintLength (64 * 1024)
+
+#define sEntryMagic  0x45434148
+#define sEntrySuffix ".entry"
+
+// Hex digits in an entry's file name
+#define sKeyNameLength (sizeof(HugAnalysisCacheKey) * 2)
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t length;
+} HugAnalysisCacheHeader;
+
+
+typedef struct {
+    HugAnalysisCacheKey key;
+
+    // On disk, including the header
+    uint64_t size;
+
+    // Nanoseconds since 1970, also the entry's modification time
+    uint64_t lastUsed;
+} HugAnalysisCacheEntry;
+
+
+struct HugAnalysisCache {
+    pthread_mutex_t _mutex;
+
+    char    *_directoryPath;
+    uint64_t _maxBytes;
+
+    HugAnalysisCacheEntry *_entries;
+    size_t   _entryCount;
+    size_t   _entryCapacity;
+    uint64_t _byteCount;
+
+    uint64_t _hits;
+    uint64_t _misses;
+    uint64_t _evictions;
+
+    uint64_t _temporaryCount;
+};
+
+
+static uint64_t sGetModificationTime(const struct stat *st)
+{
+#if defined(__APPLE__)
+    return ((uint64_t)st->st_mtimespec.tv_sec * 1000000000ull) + (uint64_t)st->st_mtimespec.tv_nsec;
+#else
+    return ((uint64_t)st->st_mtim.tv_sec * 1000000000ull) + (uint64_t)st->st_mtim.tv_nsec;
+#endif
+}
+
+
+static uint64_t sGetCurrentTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+// 64-bit FNV-1a
+static uint64_t sHash(uint64_t hash, const void *bytes, size_t length)
+{
+    const uint8_t *b = bytes;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= b[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+
+static bool sReadFully(int fd, void *buffer, size_t length, off_t offset)
+{
+    uint8_t *b = buffer;
+
+    while (length > 0) {
+        ssize_t result = pread(fd, b, length, offset);
+
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) return false;
+
+        b      += result;
+        offset += result;
+        length -= result;
+    }
+
+    return true;
+}
+
+
+static bool sWriteFully(int fd, const void *buffer, size_t length)
+{
+    const uint8_t *b = buffer;
+
+    while (length > 0) {
+        ssize_t result = write(fd, b, length);
+
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) return false;
+
+        b      += result;
+        length -= result;
+    }
+
+    return true;
+}
+
+
+static bool sMakeDirectory(const char *path)
+{
+    char buffer[PATH_MAX];
+
+    size_t length = strlen(path);
+    if (length >= sizeof(buffer)) return false;
+
+    memcpy(buffer, path, length + 1);
+
+    for (size_t i = 1; i <= length; i++) {
+        if (buffer[i] == '/' || buffer[i] == 0) {
+            char c = buffer[i];
+            buffer[i] = 0;
+
+            if (mkdir(buffer, 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+
+            buffer[i] = c;
+        }
+    }
+
+    return true;
+}
+
+
+static void sMakeEntryPath(const HugAnalysisCache *self, HugAnalysisCacheKey key, char *outPath, size_t outLength)
+{
+    char name[sKeyNameLength + 1];
+
+    for (size_t i = 0; i < sizeof(key.bytes); i++) {
+        snprintf(&name[i * 2], 3, "%02x", key.bytes[i]);
+    }
+
+    snprintf(outPath, outLength, "%s/%s%s", self->_directoryPath, name, sEntrySuffix);
+}
+
+
+static bool sParseEntryName(const char *name, HugAnalysisCacheKey *outKey)
+{
+    if (strlen(name) != sKeyNameLength + strlen(sEntrySuffix)) return false;
+    if (strcmp(name + sKeyNameLength, sEntrySuffix) != 0) return false;
+
+    for (size_t i = 0; i < sizeof(outKey->bytes); i++) {
+        unsigned int byte;
+        char digits[3] = { name[i * 2], name[(i * 2) + 1], 0 };
+
+        if (!isxdigit((unsigned char)digits[0]) || !isxdigit((unsigned char)digits[1])) return false;
+        if (sscanf(digits, "%2x", &byte) != 1) return false;
+
+        outKey->bytes[i] = byte;
+    }
+
+    return true;
+}
+
+
+// Called with _mutex held
+static size_t sFindEntry(const HugAnalysisCache *self, HugAnalysisCacheKey key)
+{
+    for (size_t i = 0; i < self->_entryCount; i++) {
+        if (!memcmp(&self->_entries[i].key, &key, sizeof(HugAnalysisCacheKey))) {
+            return i;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+
+// Called with _mutex held
+static void sRemoveEntry(HugAnalysisCache *self, size_t index)
+{
+    self->_byteCount -= self->_entries[index].size;
+
+    self->_entryCount--;
+    self->_entries[index] = self->_entries[self->_entryCount];
+}
+
+
+// Called with _mutex held
+static bool sAddEntry(HugAnalysisCache *self, HugAnalysisCacheKey key, uint64_t size, uint64_t lastUsed)
+{
+    if (self->_entryCount == self->_entryCapacity) {
+        size_t capacity = self->_entryCapacity ? (self->_entryCapacity * 2) : 256;
+        HugAnalysisCacheEntry *entries = realloc(self->_entries, capacity * sizeof(HugAnalysisCacheEntry));
+
+        if (!entries) return false;
+
+        self->_entries       = entries;
+        self->_entryCapacity = capacity;
+    }
+
+    HugAnalysisCacheEntry *entry = &self->_entries[self->_entryCount++];
+
+    entry->key      = key;
+    entry->size     = size;
+    entry->lastUsed = lastUsed;
+
+    self->_byteCount += size;
+
+    return true;
+}
+
+
+// Called with _mutex held
+static void sUnlinkEntry(HugAnalysisCache *self, size_t index)
+{
+    char path[PATH_MAX];
+    sMakeEntryPath(self, self->_entries[index].key, path, sizeof(path));
+
+    unlink(path);
+    sRemoveEntry(self, index);
+}
+
+
+// Called with _mutex held
+static void sEvict(HugAnalysisCache *self)
+{
+    while (self->_byteCount > self->_maxBytes && self->_entryCount > 0) {
+        size_t oldest = 0;
+
+        for (size_t i = 1; i < self->_entryCount; i++) {
+            if (self->_entries[i].lastUsed < self->_entries[oldest].lastUsed) {
+                oldest = i;
+            }
+        }
+
+        sUnlinkEntry(self, oldest);
+        self->_evictions++;
+    }
+}
+
+
+static void sLoadEntries(HugAnalysisCache *self)
+{
+    DIR *directory = opendir(self->_directoryPath);
+    if (!directory) return;
+
+    struct dirent *item;
+
+    while ((item = readdir(directory))) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", self->_directoryPath, item->d_name);
+
+        HugAnalysisCacheKey key;
+
+        if (sParseEntryName(item->d_name, &key)) {
+            struct stat st;
+
+            if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+                sAddEntry(self, key, st.st_size, sGetModificationTime(&st));
+            }
+
+        // Left over from a store that was interrupted
+        } else if (strstr(item->d_name, sEntrySuffix ".tmp")) {
+            unlink(path);
+        }
+    }
+
+    closedir(directory);
+}
+
+
+#pragma mark - Keys
+
+bool HugAnalysisCacheMakeKey(const char *path, HugAnalysisCacheKey *outKey)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    uint8_t *buffer = malloc(sFingerprintLength);
+    bool ok = buffer && (fstat(fd, &st) == 0);
+
+    uint64_t size = ok ? (uint64_t)st.st_size : 0;
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    if (ok) {
+        uint64_t modificationTime = sGetModificationTime(&st);
+        hash = sHash(hash, &modificationTime, sizeof(modificationTime));
+
+        size_t headLength = size < sFingerprintLength ? size : sFingerprintLength;
+        ok = sReadFully(fd, buffer, headLength, 0);
+        if (ok) hash = sHash(hash, buffer, headLength);
+    }
+
+    if (ok && size > sFingerprintLength) {
+        uint64_t tailOffset = size - sFingerprintLength;
+        if (tailOffset < sFingerprintLength) tailOffset = sFingerprintLength;
+
+        size_t tailLength = size - tailOffset;
+        ok = sReadFully(fd, buffer, tailLength, tailOffset);
+        if (ok) hash = sHash(hash, buffer, tailLength);
+    }
+
+    free(buffer);
+    close(fd);
+
+    if (ok) {
+        memcpy(&outKey->bytes[0], &size, sizeof(size));
+        memcpy(&outKey->bytes[8], &hash, sizeof(hash));
+    }
+
+    return ok;
+}
+
+
+#pragma mark - Lifecycle
+
+HugAnalysisCache *HugAnalysisCacheCreate(const char *directoryPath, uint64_t maxBytes)
+{
+    if (!sMakeDirectory(directoryPath)) return NULL;
+
+    HugAnalysisCache *self = calloc(1, sizeof(HugAnalysisCache));
+
+    pthread_mutex_init(&self->_mutex, NULL);
+
+    self->_directoryPath = strdup(directoryPath);
+    self->_maxBytes      = maxBytes;
+
+    sLoadEntries(self);
+    sEvict(self);
+
+    return self;
+}
+
+
+void HugAnalysisCacheFree(HugAnalysisCache *self)
+{
+    if (!self) return;
+
+    pthread_mutex_destroy(&self->_mutex);
+
+    free(self->_directoryPath);
+    free(self->_entries);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+void *HugAnalysisCacheCopyEntry(HugAnalysisCache *self, HugAnalysisCacheKey key, size_t *outLength)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    size_t index = sFindEntry(self, key);
+    void *result = NULL;
+
+    if (index != SIZE_MAX) {
+        char path[PATH_MAX];
+        sMakeEntryPath(self, key, path, sizeof(path));
+
+        HugAnalysisCacheEntry *entry = &self->_entries[index];
+        HugAnalysisCacheHeader header;
+
+        int fd = open(path, O_RDONLY);
+        bool ok = (fd >= 0) && sReadFully(fd, &header, sizeof(header), 0);
+
+        ok = ok &&
+            (header.magic == sEntryMagic) &&
+            (header.length == entry->size - sizeof(header));
+
+        if (ok) {
+            result = malloc(header.length ? header.length : 1);
+            ok = result && sReadFully(fd, result, header.length, sizeof(header));
+        }
+
+        if (ok) {
+            entry->lastUsed = sGetCurrentTime();
+
+            struct timespec times[2];
+            times[0].tv_sec  = entry->lastUsed / 1000000000ull;
+            times[0].tv_nsec = entry->lastUsed % 1000000000ull;
+            times[1] = times[0];
+
+            futimens(fd, times);
+
+            *outLength = header.length;
+
+        } else {
+            free(result);
+            result = NULL;
+
+            // Truncated or overwritten, it can only be rebuilt
+            sUnlinkEntry(self, index);
+        }
+
+        if (fd >= 0) close(fd);
+    }
+
+    if (result) {
+        self->_hits++;
+    } else {
+        self->_misses++;
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugAnalysisCacheStoreEntry(HugAnalysisCache *self, HugAnalysisCacheKey key, const void *bytes, size_t length)
+{
+    char path[PATH_MAX];
+    char temporaryPath[PATH_MAX];
+
+    sMakeEntryPath(self, key, path, sizeof(path));
+
+    pthread_mutex_lock(&self->_mutex);
+    uint64_t temporaryIndex = self->_temporaryCount++;
+    pthread_mutex_unlock(&self->_mutex);
+
+    int temporaryLength = snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp.%ld.%llu", path, (long)getpid(), (unsigned long long)temporaryIndex);
+    if (temporaryLength < 0 || temporaryLength >= (int)sizeof(temporaryPath)) return false;
+
+    int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    HugAnalysisCacheHeader header = { sEntryMagic, 0, length };
+
+    bool ok = sWriteFully(fd, &header, sizeof(header)) && sWriteFully(fd, bytes, length);
+    ok = (close(fd) == 0) && ok;
+
+    if (!ok) {
+        unlink(temporaryPath);
+        return false;
+    }
+
+    pthread_mutex_lock(&self->_mutex);
+
+    ok = (rename(temporaryPath, path) == 0);
+
+    if (ok) {
+        size_t index = sFindEntry(self, key);
+        if (index != SIZE_MAX) sRemoveEntry(self, index);
+
+        ok = sAddEntry(self, key, sizeof(header) + length, sGetCurrentTime());
+        sEvict(self);
+
+    } else {
+        unlink(temporaryPath);
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return ok;
+}
+
+
+HugAnalysisCacheStats HugAnalysisCacheGetStats(HugAnalysisCache *self)
+{
+    HugAnalysisCacheStats stats;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    stats.entryCount = self->_entryCount;
+    stats.byteCount  = self->_byteCount;
+    stats.hits       = self->_hits;
+    stats.misses     = self->_misses;
+    stats.evictions  = self->_evictions;
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return stats;
+}
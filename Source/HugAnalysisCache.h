@@ -0,0 +1,60 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Persistent cache of analysis results, keyed by a cheap fingerprint of the
+// audio file rather than by track, so that adding the same file again skips
+// the decode. Each entry is one file in the cache directory; writes go
+// through a temporary file and rename(), so a crash never leaves a partial
+// entry. Once the entries exceed maxBytes, the least recently used ones are
+// removed. Recency survives relaunches through the entry's modification time.
+//
+// All functions are thread-safe.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugAnalysisCache HugAnalysisCache;
+
+typedef struct {
+    uint8_t bytes[16];
+} HugAnalysisCacheKey;
+
+typedef struct {
+    size_t   entryCount;
+    uint64_t byteCount;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} HugAnalysisCacheStats;
+
+// File size, plus a hash of the modification time and the first and last
+// 64 KB. Returns false if the file can't be read.
+//
+extern bool HugAnalysisCacheMakeKey(const char *path, HugAnalysisCacheKey *outKey);
+
+// Creates directoryPath if needed and indexes the entries already in it
+extern HugAnalysisCache *HugAnalysisCacheCreate(const char *directoryPath, uint64_t maxBytes);
+extern void HugAnalysisCacheFree(HugAnalysisCache *cache);
+
+// Returns a malloc()'d copy of the entry, or NULL on a miss. A hit makes the
+// entry the most recently used.
+//
+extern void *HugAnalysisCacheCopyEntry(HugAnalysisCache *cache, HugAnalysisCacheKey key, size_t *outLength);
+
+// Replaces any existing entry for key, then evicts down to maxBytes
+extern bool HugAnalysisCacheStoreEntry(HugAnalysisCache *cache, HugAnalysisCacheKey key, const void *bytes, size_t length);
+
+extern HugAnalysisCacheStats HugAnalysisCacheGetStats(HugAnalysisCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,288 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugAnalysisPipeline.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+typedef enum {
+    sStateAdding = 0,
+    sStateRunning,
+    sStateFinished
+} sState;
+
+
+struct HugAnalysisPipeline {
+    pthread_mutex_t _mutex;
+    pthread_cond_t  _workCondition;
+    pthread_cond_t  _doneCondition;
+
+    pthread_t *_threads;
+    size_t     _threadCount;
+    bool       _stopping;
+
+    sState _state;
+
+    HugAnalyzer      _analyzers[HugAnalysisPipelineMaxAnalyzers];
+    HugAnalyzerStats _stats[HugAnalysisPipelineMaxAnalyzers];
+    size_t           _analyzerCount;
+
+    // Indices of the analyzers whose begin() succeeded
+    size_t _active[HugAnalysisPipelineMaxAnalyzers];
+    size_t _activeCount;
+
+    // The block in flight. _next is the next entry of _active to hand out,
+    // _done counts the ones that returned.
+    //
+    const float **_channels;
+    unsigned int  _channelCount;
+    size_t        _frames;
+    size_t        _next;
+    size_t        _done;
+    bool          _busy;
+};
+
+
+static uint64_t sGetNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+static void sConsume(HugAnalysisPipeline *self, size_t index, const float * const *channels, size_t frames)
+{
+    HugAnalyzer *analyzer = &self->_analyzers[index];
+
+    uint64_t start = sGetNanoseconds();
+    analyzer->consume(analyzer->context, channels, frames);
+
+    self->_stats[index].nanoseconds += sGetNanoseconds() - start;
+    self->_stats[index].frames      += frames;
+}
+
+
+static void *sThreadMain(void *context)
+{
+    HugAnalysisPipeline *self = context;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    while (1) {
+        while (!self->_stopping && (!self->_busy || self->_next == self->_activeCount)) {
+            pthread_cond_wait(&self->_workCondition, &self->_mutex);
+        }
+
+        if (self->_stopping) break;
+
+        size_t index = self->_active[self->_next++];
+        const float * const *channels = self->_channels;
+        size_t frames = self->_frames;
+
+        pthread_mutex_unlock(&self->_mutex);
+        sConsume(self, index, channels, frames);
+        pthread_mutex_lock(&self->_mutex);
+
+        if (++self->_done == self->_activeCount) {
+            self->_busy = false;
+            pthread_cond_broadcast(&self->_doneCondition);
+        }
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return NULL;
+}
+
+
+static void sWaitUntilDone(HugAnalysisPipeline *self)
+{
+    if (!self->_threadCount) return;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    while (self->_busy) {
+        pthread_cond_wait(&self->_doneCondition, &self->_mutex);
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+}
+
+
+// Called once the team is idle
+static void sFinish(HugAnalysisPipeline *self, void *result)
+{
+    for (size_t a = 0; a < self->_activeCount; a++) {
+        size_t index = self->_active[a];
+        HugAnalyzer *analyzer = &self->_analyzers[index];
+
+        uint64_t start = sGetNanoseconds();
+        analyzer->finish(analyzer->context, result);
+        self->_stats[index].nanoseconds += sGetNanoseconds() - start;
+    }
+
+    self->_state = sStateFinished;
+}
+
+
+#pragma mark - Lifecycle
+
+HugAnalysisPipeline *HugAnalysisPipelineCreate(size_t threadCount)
+{
+    HugAnalysisPipeline *self = calloc(1, sizeof(HugAnalysisPipeline));
+    if (!self) return NULL;
+
+    pthread_mutex_init(&self->_mutex, NULL);
+    pthread_cond_init(&self->_workCondition, NULL);
+    pthread_cond_init(&self->_doneCondition, NULL);
+
+    if (threadCount) {
+        self->_threads = calloc(threadCount, sizeof(pthread_t));
+
+        if (!self->_threads) {
+            HugAnalysisPipelineFree(self);
+            return NULL;
+        }
+    }
+
+    // Runs the analyzers inline if no thread starts
+    for (size_t i = 0; i < threadCount; i++) {
+        if (pthread_create(&self->_threads[i], NULL, sThreadMain, self) != 0) break;
+        self->_threadCount++;
+    }
+
+    return self;
+}
+
+
+void HugAnalysisPipelineFree(HugAnalysisPipeline *self)
+{
+    if (!self) return;
+
+    sWaitUntilDone(self);
+
+    if (self->_state == sStateRunning) {
+        sFinish(self, NULL);
+    }
+
+    pthread_mutex_lock(&self->_mutex);
+    self->_stopping = true;
+    pthread_cond_broadcast(&self->_workCondition);
+    pthread_mutex_unlock(&self->_mutex);
+
+    for (size_t i = 0; i < self->_threadCount; i++) {
+        pthread_join(self->_threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&self->_workCondition);
+    pthread_cond_destroy(&self->_doneCondition);
+    pthread_mutex_destroy(&self->_mutex);
+
+    free(self->_threads);
+    free(self->_channels);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+bool HugAnalysisPipelineAddAnalyzer(HugAnalysisPipeline *self, HugAnalyzer analyzer)
+{
+    if (self->_state != sStateAdding) return false;
+    if (self->_analyzerCount == HugAnalysisPipelineMaxAnalyzers) return false;
+
+    size_t index = self->_analyzerCount++;
+
+    self->_analyzers[index] = analyzer;
+    self->_stats[index].name = analyzer.name;
+
+    return true;
+}
+
+
+bool HugAnalysisPipelineBegin(HugAnalysisPipeline *self, unsigned int channels, double sampleRate, uint64_t totalFrames)
+{
+    if (self->_state != sStateAdding || !channels) return false;
+
+    self->_channels = calloc(channels, sizeof(float *));
+    if (!self->_channels) return false;
+
+    self->_channelCount = channels;
+    self->_state = sStateRunning;
+
+    for (size_t index = 0; index < self->_analyzerCount; index++) {
+        HugAnalyzer *analyzer = &self->_analyzers[index];
+
+        uint64_t start = sGetNanoseconds();
+        bool active = analyzer->begin(analyzer->context, channels, sampleRate, totalFrames);
+        self->_stats[index].nanoseconds += sGetNanoseconds() - start;
+
+        if (active) {
+            self->_stats[index].active = true;
+            self->_active[self->_activeCount++] = index;
+        }
+    }
+
+    return self->_activeCount > 0;
+}
+
+
+void HugAnalysisPipelineConsume(HugAnalysisPipeline *self, const float * const *channels, size_t frames)
+{
+    if (self->_state != sStateRunning || !self->_activeCount || !frames) return;
+
+    if (!self->_threadCount) {
+        for (size_t a = 0; a < self->_activeCount; a++) {
+            sConsume(self, self->_active[a], channels, frames);
+        }
+
+        return;
+    }
+
+    pthread_mutex_lock(&self->_mutex);
+
+    while (self->_busy) {
+        pthread_cond_wait(&self->_doneCondition, &self->_mutex);
+    }
+
+    memcpy(self->_channels, channels, self->_channelCount * sizeof(float *));
+
+    self->_frames = frames;
+    self->_next   = 0;
+    self->_done   = 0;
+    self->_busy   = true;
+
+    pthread_cond_broadcast(&self->_workCondition);
+    pthread_mutex_unlock(&self->_mutex);
+}
+
+
+void HugAnalysisPipelineFinish(HugAnalysisPipeline *self, void *result)
+{
+    if (self->_state != sStateRunning) return;
+
+    sWaitUntilDone(self);
+    sFinish(self, result);
+}
+
+
+size_t HugAnalysisPipelineGetAnalyzerCount(const HugAnalysisPipeline *self)
+{
+    return self->_analyzerCount;
+}
+
+
+HugAnalyzerStats HugAnalysisPipelineGetAnalyzerStats(HugAnalysisPipeline *self, size_t index)
+{
+    if (index >= self->_analyzerCount) return (HugAnalyzerStats){0};
+
+    sWaitUntilDone(self);
+
+    return self->_stats[index];
+}
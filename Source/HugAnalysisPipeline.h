@@ -0,0 +1,94 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Fans each decoded block of a track out to every registered analyzer, so
+// a new analysis costs processor time but never another decode.
+//
+// An analyzer is three functions around a context of its own. begin() sets
+// it up for the track's format, consume() sees every block in order, and
+// finish() writes what it found into a result the caller provides (the
+// Worker passes an NSMutableDictionary).
+//
+// With threads, each block is handed to a small team that runs the
+// analyzers concurrently, one thread per analyzer at a time, while the
+// caller decodes the next block. Without threads, the analyzers run one
+// after another on the calling thread.
+//
+// Not thread-safe: one thread drives a pipeline.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HugAnalysisPipelineMaxAnalyzers 16
+
+typedef struct HugAnalysisPipeline HugAnalysisPipeline;
+
+// Returns false if the analyzer can't handle the track, it is then left out
+typedef bool (*HugAnalyzerBeginFunction)(void *context, unsigned int channels, double sampleRate, uint64_t totalFrames);
+
+typedef void (*HugAnalyzerConsumeFunction)(void *context, const float * const *channels, size_t frames);
+
+// Called once after a successful begin(), on the thread that calls
+// HugAnalysisPipelineFinish() or HugAnalysisPipelineFree(), in the order the
+// analyzers were added. Later analyzers may read what earlier ones wrote.
+// result is NULL when the track was abandoned; release the context only.
+//
+typedef void (*HugAnalyzerFinishFunction)(void *context, void *result);
+
+typedef struct {
+    const char *name;
+
+    HugAnalyzerBeginFunction   begin;
+    HugAnalyzerConsumeFunction consume;
+    HugAnalyzerFinishFunction  finish;
+
+    void *context;
+} HugAnalyzer;
+
+typedef struct {
+    const char *name;
+    bool        active;
+
+    // Time in begin(), consume() and finish()
+    uint64_t nanoseconds;
+    uint64_t frames;
+} HugAnalyzerStats;
+
+// A threadCount of 0 runs the analyzers on the calling thread
+extern HugAnalysisPipeline *HugAnalysisPipelineCreate(size_t threadCount);
+
+// Waits for the block in flight, and calls finish() with a NULL result for
+// analyzers that weren't finished
+extern void HugAnalysisPipelineFree(HugAnalysisPipeline *pipeline);
+
+// Only before HugAnalysisPipelineBegin(). Returns false when full.
+extern bool HugAnalysisPipelineAddAnalyzer(HugAnalysisPipeline *pipeline, HugAnalyzer analyzer);
+
+// Returns false if no analyzer could begin
+extern bool HugAnalysisPipelineBegin(HugAnalysisPipeline *pipeline, unsigned int channels, double sampleRate, uint64_t totalFrames);
+
+// Waits for the previous block, then starts this one. With threads, it may
+// return before the analyzers are done: leave the samples untouched until
+// the next call to Consume, Finish or Free.
+//
+extern void HugAnalysisPipelineConsume(HugAnalysisPipeline *pipeline, const float * const *channels, size_t frames);
+
+// Waits for the last block, then calls every finish()
+extern void HugAnalysisPipelineFinish(HugAnalysisPipeline *pipeline, void *result);
+
+extern size_t HugAnalysisPipelineGetAnalyzerCount(const HugAnalysisPipeline *pipeline);
+
+// Waits for the block in flight
+extern HugAnalyzerStats HugAnalysisPipelineGetAnalyzerStats(HugAnalysisPipeline *pipeline, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,14 +4,12 @@
 #import "HugAudioEngine.h"
 
 #import "HugCrashPad.h"
-#import "HugLimiter.h"
-#import "HugLinearRamper.h"
-#import "HugStereoField.h"
 #import "HugFastUtils.h"
-#import "HugLevelMeter.h"
 #import "HugMeterData.h"
+#import "HugRenderChain.h"
 #import "HugSimpleGraph.h"
 #import "HugRingBuffer.h"
+#import "HugTripleBuffer.h"
 #import "HugUtils.h"
 #import "HugAudioSettings.h"
 #import "HugAudioSource.h"
@@ -29,8 +27,6 @@ typedef NS_ENUM(NSInteger, PacketType) {
 
     // Transmitted via _statusRingBuffer
     PacketTypePlayback = 1,
-    PacketTypeMeter    = 2,
-    PacketTypeDanger   = 3,
     
     // Transmitted via _errorRingBuffer
     PacketTypeStatusBufferFull = 101, // Uses PacketDataUnknown
@@ -43,32 +39,57 @@ typedef struct {
     UInt16 type;
 } PacketDataUnknown;
 
+// Only sent when the status changes
 typedef struct {
     uint64_t timestamp;
     UInt16 type;
+    UInt32 generation;
     HugPlaybackInfo info;
 } PacketDataPlayback;
 
 typedef struct {
     uint64_t timestamp;
     UInt16 type;
-    UInt16 frameCount;
-    uint64_t renderTime;
-} PacketDataDanger;
+    UInt16 index;
+    OSStatus err;
+} PacketDataRenderError;
+
+
+// Meters and playback times only need their latest values. The render thread
+// keeps a short history of them, timestamped with when they will be heard and
+// spaced at least kStatusSnapshotSpacing apart, and publishes it through
+// _snapshotBuffer once per render cycle. The main thread picks the newest
+// entry that is due, so a stalled main thread can never back anything up.
+//
+#define kStatusSnapshotCapacity 32
+#define kStatusSnapshotSpacing  (1.0 / 60.0)
 
 typedef struct {
     uint64_t timestamp;
-    UInt16 type;
     HugMeterDataStruct leftMeterData;
     HugMeterDataStruct rightMeterData;
-} PacketDataMeter;
+} StatusSnapshotMeter;
 
 typedef struct {
     uint64_t timestamp;
-    UInt16 type;
-    UInt16 index;
-    OSStatus err;
-} PacketDataRenderError;
+    HugPlaybackInfo info;
+} StatusSnapshotPlayback;
+
+// Entries are oldest first
+typedef struct {
+    UInt32 generation;
+    UInt32 meterCount;
+    UInt32 playbackCount;
+    StatusSnapshotMeter    meters[kStatusSnapshotCapacity];
+    StatusSnapshotPlayback playback[kStatusSnapshotCapacity];
+} StatusSnapshot;
+
+typedef struct {
+    StatusSnapshot *snapshot;
+    uint64_t snapshotSpacing;
+    uint64_t currentTime;
+    double sampleRate;
+} MeterCallbackContext;
 
 typedef struct {
     _Atomic HugAudioSourceInputBlock inputBlock;
@@ -83,6 +104,16 @@ typedef struct {
     volatile float preGain;
 
     volatile UInt64 renderStart;
+
+    // Incremented by the render thread each time it switches input blocks
+    _Atomic UInt32 generation;
+
+    // Running maximum since the main thread last took it
+    _Atomic float dangerPeak;
+
+    // Owned by the render thread
+    StatusSnapshot snapshot;
+    HugPlaybackStatus sentStatus;
 } RenderUserInfo;
 
 
@@ -111,6 +142,95 @@ static OSStatus sOutputUnitRenderCallback(
 }
 
 
+static BOOL sSendStatusPacket(HugRingBuffer *statusRingBuffer, HugRingBuffer *errorRingBuffer, void *buffer, CFIndex length)
+{
+    if (!HugRingBufferWrite(statusRingBuffer, buffer, length)) {
+        PacketDataUnknown packet = { 0, PacketTypeStatusBufferFull };
+        HugRingBufferWrite(errorRingBuffer, &packet, sizeof(packet));
+
+        return NO;
+    }
+    
+    return YES;
+}
+
+
+// Returns the index to store an entry at. The last entry is always the newest
+// one; it is replaced until it is kStatusSnapshotSpacing past the one before.
+//
+static UInt32 sGetSnapshotIndex(UInt32 *ioCount, uint64_t previousTimestamp, uint64_t timestamp, uint64_t spacing)
+{
+    UInt32 count = *ioCount;
+
+    if (count >= 2 && (timestamp - previousTimestamp) < spacing) {
+        return count - 1;
+    }
+    
+    *ioCount = count + 1;
+    return count;
+}
+
+
+static void sAppendSnapshotMeter(StatusSnapshot *snapshot, uint64_t spacing, const StatusSnapshotMeter *meter)
+{
+    if (snapshot->meterCount == kStatusSnapshotCapacity) {
+        memmove(&snapshot->meters[0], &snapshot->meters[1], sizeof(StatusSnapshotMeter) * (kStatusSnapshotCapacity - 1));
+        snapshot->meterCount--;
+    }
+
+    UInt32 count = snapshot->meterCount;
+    uint64_t previousTimestamp = count >= 2 ? snapshot->meters[count - 2].timestamp : 0;
+
+    UInt32 index = sGetSnapshotIndex(&snapshot->meterCount, previousTimestamp, meter->timestamp, spacing);
+    snapshot->meters[index] = *meter;
+}
+
+
+static void sAppendSnapshotPlayback(StatusSnapshot *snapshot, uint64_t spacing, const StatusSnapshotPlayback *playback)
+{
+    if (snapshot->playbackCount == kStatusSnapshotCapacity) {
+        memmove(&snapshot->playback[0], &snapshot->playback[1], sizeof(StatusSnapshotPlayback) * (kStatusSnapshotCapacity - 1));
+        snapshot->playbackCount--;
+    }
+
+    UInt32 count = snapshot->playbackCount;
+    uint64_t previousTimestamp = count >= 2 ? snapshot->playback[count - 2].timestamp : 0;
+
+    UInt32 index = sGetSnapshotIndex(&snapshot->playbackCount, previousTimestamp, playback->timestamp, spacing);
+    snapshot->playback[index] = *playback;
+}
+
+
+static void sUpdateDangerPeak(RenderUserInfo *userInfo, float dangerLevel)
+{
+    float peak = atomic_load_explicit(&userInfo->dangerPeak, memory_order_relaxed);
+
+    while (dangerLevel > peak) {
+        if (atomic_compare_exchange_weak(&userInfo->dangerPeak, &peak, dangerLevel)) {
+            break;
+        }
+    }
+}
+
+
+static void sAppendMeterData(
+    void *inContext,
+    size_t frameOffset,
+    const HugMeterDataStruct *leftMeterData,
+    const HugMeterDataStruct *rightMeterData
+) {
+    MeterCallbackContext *context = (MeterCallbackContext *)inContext;
+
+    StatusSnapshotMeter meter = {
+        context->currentTime + HugGetHostTimeWithSeconds(frameOffset / context->sampleRate),
+        *leftMeterData,
+        *rightMeterData
+    };
+
+    sAppendSnapshotMeter(context->snapshot, context->snapshotSpacing, &meter);
+}
+
+
 static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[], void *inClientData)
 {
     PacketDataUnknown packet = { 0, PacketTypeOverload };
@@ -137,15 +257,13 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 
     NSTimer *_updateTimer;
 
-    HugLimiter      *_emergencyLimiter;
-    HugStereoField  *_stereoField;
-    HugLevelMeter   *_leftLevelMeter;
-    HugLevelMeter   *_rightLevelMeter;
-    HugLinearRamper *_preGainRamper;
-    HugLinearRamper *_volumeRamper;
+    HugRenderChain  *_renderChain;
 
     HugRingBuffer   *_errorRingBuffer;
     HugRingBuffer   *_statusRingBuffer;
+    HugTripleBuffer *_snapshotBuffer;
+    UInt32           _snapshotGeneration;
+    uint64_t         _meterTimestamp;
 
     HugPlaybackStatus _playbackStatus;
     NSTimeInterval    _timeElapsed;
@@ -179,15 +297,11 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
             @"HugAudioEngine", @"AudioComponentInstanceNew[ Output ]"
         );
 
-        _stereoField      = HugStereoFieldCreate();
-        _preGainRamper    = HugLinearRamperCreate();
-        _volumeRamper     = HugLinearRamperCreate();
-        _leftLevelMeter   = HugLevelMeterCreate();
-        _rightLevelMeter  = HugLevelMeterCreate();
-        _emergencyLimiter = HugLimiterCreate();
+        _renderChain = HugRenderChainCreate();
         
         _statusRingBuffer = HugRingBufferCreate(8196);
         _errorRingBuffer  = HugRingBufferCreate(8196);
+        _snapshotBuffer   = HugTripleBufferCreate(sizeof(StatusSnapshot));
     }
 
     return self;
@@ -220,8 +334,6 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 
         NSInteger loopGuard = 0;
         while (1) {
-            HugRingBufferConfirmReadAll(_statusRingBuffer);
-
             if (blockToSend == atomic_load(&_renderUserInfo.inputBlock)) {
                 break;
             }
@@ -245,7 +357,13 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
     _currentSource = source;
     _currentInputBlock = blockToSend;
 
-    HugRingBufferConfirmReadAll(_statusRingBuffer);
+    // Ignore status from earlier sources. If the render thread hasn't
+    // switched yet, it will increment the generation when it does.
+    //
+    UInt32 generation = atomic_load(&_renderUserInfo.generation);
+    BOOL didSwitch = (blockToSend == atomic_load(&_renderUserInfo.inputBlock));
+    _snapshotGeneration = didSwitch ? generation : (generation + 1);
+
     _switchingSources = NO;
 }
 
@@ -266,6 +384,59 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 }
 
 
+- (void) _readSnapshotWithCurrentTime:(uint64_t)current tooFar:(uint64_t)tooFar
+{
+    const StatusSnapshot *snapshot = HugTripleBufferGetReadPtr(_snapshotBuffer, NULL);
+
+    _dangerLevel = atomic_exchange(&_renderUserInfo.dangerPeak, 0);
+
+    if (_switchingSources || (snapshot->generation < _snapshotGeneration)) {
+        return;
+    }
+
+    // Use the newest entry that is due. If none are, the history is shorter
+    // than the output latency and the oldest entry is the closest one.
+    //
+    #define isDue(timestamp) (((timestamp) < current) || ((timestamp) >= tooFar))
+
+    if (snapshot->meterCount > 0) {
+        const StatusSnapshotMeter *meter = &snapshot->meters[0];
+
+        for (UInt32 i = snapshot->meterCount; i > 0; i--) {
+            if (isDue(snapshot->meters[i - 1].timestamp)) {
+                meter = &snapshot->meters[i - 1];
+                break;
+            }
+        }
+
+        if (meter->timestamp != _meterTimestamp) {
+            _leftMeterData  = [[HugMeterData alloc] initWithStruct:meter->leftMeterData];
+            _rightMeterData = [[HugMeterData alloc] initWithStruct:meter->rightMeterData];
+            _meterTimestamp = meter->timestamp;
+        }
+    }
+
+    if (snapshot->playbackCount > 0) {
+        const StatusSnapshotPlayback *playback = &snapshot->playback[0];
+
+        for (UInt32 i = snapshot->playbackCount; i > 0; i--) {
+            if (isDue(snapshot->playback[i - 1].timestamp)) {
+                playback = &snapshot->playback[i - 1];
+                break;
+            }
+        }
+
+        // Status changes arrive in order through _statusRingBuffer
+        if (playback->info.status == _playbackStatus) {
+            _timeElapsed   = playback->info.timeElapsed;
+            _timeRemaining = playback->info.timeRemaining;
+        }
+    }
+
+    #undef isDue
+}
+
+
 - (void) _readRingBuffers
 {
     uint64_t current = HugGetCurrentHostTime();
@@ -276,7 +447,7 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
     NSInteger overloadCount   = 0;
     NSInteger statusFullCount = 0;
 
-    // Process status
+    // Process status changes
     for (NSInteger i = 0; i < loopGuard; i++) {
         // If we are switching sources, clear the entire _statusRingBuffer
         if (_switchingSources) {
@@ -286,44 +457,32 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 
         PacketDataUnknown *unknown = HugRingBufferGetReadPtr(_statusRingBuffer, sizeof(PacketDataUnknown));
         if (!unknown) break;
-               
-        if ((unknown->timestamp >= current) && (unknown->timestamp < tooFar)) {
-            break;
-        }
-        
+
         if (unknown->type == PacketTypePlayback) {
+            PacketDataPlayback *peek = HugRingBufferGetReadPtr(_statusRingBuffer, sizeof(PacketDataPlayback));
+            if (!peek) break;
+
+            BOOL isStale = (peek->generation < _snapshotGeneration);
+
+            if (!isStale && (peek->timestamp >= current) && (peek->timestamp < tooFar)) {
+                break;
+            }
+
             PacketDataPlayback packet;
             if (!HugRingBufferRead(_statusRingBuffer, &packet, sizeof(PacketDataPlayback))) return;
+            if (isStale) continue;
 
             _playbackStatus = packet.info.status;
             _timeElapsed    = packet.info.timeElapsed;
             _timeRemaining  = packet.info.timeRemaining;
 
-        } else if (unknown->type == PacketTypeMeter) {
-            PacketDataMeter packet;
-            if (!HugRingBufferRead(_statusRingBuffer, &packet, sizeof(PacketDataMeter))) return;
-            
-            _leftMeterData  = [[HugMeterData alloc] initWithStruct:packet.leftMeterData];
-            _rightMeterData = [[HugMeterData alloc] initWithStruct:packet.rightMeterData];
-
-        } else if (unknown->type == PacketTypeDanger) {
-            PacketDataDanger packet;
-            if (!HugRingBufferRead(_statusRingBuffer, &packet, sizeof(PacketDataDanger))) return;
-            
-            uint64_t renderTime = packet.renderTime;
-
-            double outputSampleRate = [[_outputSettings objectForKey:HugAudioSettingSampleRate] doubleValue];
-            
-            double callbackDuration = packet.frameCount / outputSampleRate;
-            double elapsedDuration  = HugGetSecondsWithHostTime(renderTime);
-            
-            _dangerLevel = elapsedDuration / callbackDuration;
-
         } else {
             NSAssert(NO, @"Unknown packet type: %ld", (long)unknown->type);
         }
     }
     
+    [self _readSnapshotWithCurrentTime:current tooFar:tooFar];
+
     // Process error buffer
     for (NSInteger i = 0; i < loopGuard; i++) {
         PacketDataUnknown *unknown = HugRingBufferGetReadPtr(_errorRingBuffer, sizeof(PacketDataUnknown));
@@ -374,14 +533,10 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 {
     HugLogMethod();
 
-    HugLimiter      *limiter          = _emergencyLimiter;
-    HugStereoField  *stereoField      = _stereoField;
-    HugLevelMeter   *leftLevelMeter   = _leftLevelMeter;
-    HugLevelMeter   *rightLevelMeter  = _rightLevelMeter;
-    HugLinearRamper *preGainRamper    = _preGainRamper;
-    HugLinearRamper *volumeRamper     = _volumeRamper;
+    HugRenderChain  *renderChain      = _renderChain;
     HugRingBuffer   *statusRingBuffer = _statusRingBuffer;
     HugRingBuffer   *errorRingBuffer  = _errorRingBuffer;
+    HugTripleBuffer *snapshotBuffer   = _snapshotBuffer;
 
     RenderUserInfo *userInfo = &_renderUserInfo;
 
@@ -390,14 +545,49 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
         HugRingBufferWrite(errorRingBuffer, &packet, sizeof(packet));
     }];
      
-    void (^__sendStatusPacket)(void *, CFIndex) = ^(void *buffer, CFIndex length) {
-        if (!HugRingBufferWrite(statusRingBuffer, buffer, length)) {
-            PacketDataUnknown packet = { 0, PacketTypeStatusBufferFull };
-            HugRingBufferWrite(errorRingBuffer, &packet, sizeof(packet));
-        }
-    };
-    #define sendStatusPacket(packet) __sendStatusPacket(&(packet), sizeof((packet)));
+    #define sendStatusPacket(packet) sSendStatusPacket(statusRingBuffer, errorRingBuffer, &(packet), sizeof((packet)))
      
+    double sampleRate = [[_outputSettings objectForKey:HugAudioSettingSampleRate] doubleValue];
+    UInt32 frameSize  = [[_outputSettings objectForKey:HugAudioSettingFrameSize] unsignedIntValue];
+
+    uint64_t snapshotSpacing = HugGetHostTimeWithSeconds(kStatusSnapshotSpacing);
+
+    NSMutableArray<AUAudioUnit *> *unitsToAdd = [NSMutableArray array];
+    
+    if (sampleRate && frameSize) {
+        AVAudioFormat *format = [[AVAudioFormat alloc] initStandardFormatWithSampleRate:sampleRate channels:2];
+        
+        for (AUAudioUnit *unit in _effectAudioUnits) {
+            NSError *error = nil;
+
+            if (![unit renderResourcesAllocated] || ([unit maximumFramesToRender] != frameSize)) {
+                [unit deallocateRenderResources];
+                
+                [unit setMaximumFramesToRender:frameSize];
+
+                AUAudioUnitBus *inputBus  = [[unit inputBusses]  objectAtIndexedSubscript:0];
+                AUAudioUnitBus *outputBus = [[unit outputBusses] objectAtIndexedSubscript:0];
+                
+                if (!error) [inputBus  setFormat:format error:&error];
+                if (!error) [outputBus setFormat:format error:&error];
+                if (!error) [unit allocateRenderResourcesAndReturnError:&error];
+                
+                [inputBus setEnabled:YES];
+                [outputBus setEnabled:YES];
+            }
+           
+            if (error) {
+                HugLog(@"HugAudioEngine", @"Error when configuring %@: %@", unit, error);
+            } else  {
+                [unitsToAdd addObject:unit];
+            }
+        }
+    }
+
+    // With no effects between the source and output stages, the first block
+    // also runs the output stage, fused into a single pass when possible.
+    BOOL fuseStages = ([unitsToAdd count] == 0);
+
     [graph addBlock:^(
         AudioUnitRenderActionFlags *ioActionFlags,
         const AudioTimeStamp *timestamp,
@@ -418,6 +608,13 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
         float *leftData  = ioData->mNumberBuffers > 0 ? ioData->mBuffers[0].mData : NULL;
         float *rightData = ioData->mNumberBuffers > 1 ? ioData->mBuffers[1].mData : NULL;
 
+        uint64_t currentTime = (timestamp->mFlags & kAudioTimeStampHostTimeValid) ?
+            timestamp->mHostTime :
+            HugGetCurrentHostTime();
+
+        MeterCallbackContext context = { &userInfo->snapshot, snapshotSpacing, currentTime, sampleRate };
+        BOOL didProcessOutput = NO;
+
         if (!inputBlock) {
             *ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence;
             HugApplySilence(leftData, inNumberFrames);
@@ -425,66 +622,67 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 
         } else {
             err = inputBlock(inNumberFrames, ioData, &info);
-            
-            HugStereoFieldProcess(stereoField, leftData, rightData, inNumberFrames, userInfo->stereoBalance, userInfo->stereoWidth);
-            HugLinearRamperProcess(preGainRamper, leftData, rightData, inNumberFrames, userInfo->preGain);
 
-            if (willChangeUnits) {
-                HugApplyFade(leftData,  inNumberFrames, 1.0, 0.0);
-                HugApplyFade(rightData, inNumberFrames, 1.0, 0.0);
+            if (fuseStages && !willChangeUnits) {
+                HugRenderChainProcess(
+                    renderChain, leftData, rightData, inNumberFrames,
+                    userInfo->preGain, userInfo->stereoBalance, userInfo->stereoWidth,
+                    userInfo->volume,
+                    sAppendMeterData, &context
+                );
+
+                didProcessOutput = YES;
+
+            } else {
+                HugRenderChainProcessSource(
+                    renderChain, leftData, rightData, inNumberFrames,
+                    userInfo->preGain, userInfo->stereoBalance, userInfo->stereoWidth,
+                    willChangeUnits
+                );
             }
         }
 
         if (willChangeUnits) {
-            HugLinearRamperReset(preGainRamper, userInfo->preGain);
-            HugLinearRamperReset(volumeRamper,  userInfo->volume);
-            HugStereoFieldReset(stereoField, userInfo->stereoBalance, userInfo->stereoWidth);
+            HugRenderChainReset(renderChain, userInfo->preGain, userInfo->volume, userInfo->stereoBalance, userInfo->stereoWidth);
 
+            StatusSnapshot *snapshot = &userInfo->snapshot;
+            snapshot->generation++;
+            snapshot->meterCount = 0;
+            snapshot->playbackCount = 0;
+
+            userInfo->sentStatus = -1;
+
+            atomic_store(&userInfo->generation, snapshot->generation);
             atomic_store(&userInfo->inputBlock, nextInputBlock);
 
         } else {
             if (inputBlock && (timestamp->mFlags & kAudioTimeStampHostTimeValid)) {
-                PacketDataPlayback packet = { timestamp->mHostTime, PacketTypePlayback, info };
-                sendStatusPacket(packet);
+                StatusSnapshot *snapshot = &userInfo->snapshot;
+
+                StatusSnapshotPlayback playback = { timestamp->mHostTime, info };
+                sAppendSnapshotPlayback(snapshot, snapshotSpacing, &playback);
+
+                // Only changes go through the ring. If it is full, try again next cycle
+                if (info.status != userInfo->sentStatus) {
+                    PacketDataPlayback packet = { timestamp->mHostTime, PacketTypePlayback, snapshot->generation, info };
+                    if (sendStatusPacket(packet)) userInfo->sentStatus = info.status;
+                }
             }
         }
 
+        if (fuseStages && !didProcessOutput) {
+            HugRenderChainProcessOutput(
+                renderChain, leftData, rightData, inNumberFrames,
+                userInfo->volume,
+                sAppendMeterData, &context
+            );
+        }
+
         return err;
     }];
 
-    double sampleRate = [[_outputSettings objectForKey:HugAudioSettingSampleRate] doubleValue];
-    UInt32 frameSize  = [[_outputSettings objectForKey:HugAudioSettingFrameSize] unsignedIntValue];
-    
-    if (sampleRate && frameSize) {
-        AVAudioFormat *format = [[AVAudioFormat alloc] initStandardFormatWithSampleRate:sampleRate channels:2];
-        
-        [_outputSettings objectForKey:HugAudioSettingFrameSize];
-        
-        for (AUAudioUnit *unit in _effectAudioUnits) {
-            NSError *error = nil;
-
-            if (![unit renderResourcesAllocated] || ([unit maximumFramesToRender] != frameSize)) {
-                [unit deallocateRenderResources];
-                
-                [unit setMaximumFramesToRender:frameSize];
-
-                AUAudioUnitBus *inputBus  = [[unit inputBusses]  objectAtIndexedSubscript:0];
-                AUAudioUnitBus *outputBus = [[unit outputBusses] objectAtIndexedSubscript:0];
-                
-                if (!error) [inputBus  setFormat:format error:&error];
-                if (!error) [outputBus setFormat:format error:&error];
-                if (!error) [unit allocateRenderResourcesAndReturnError:&error];
-                
-                [inputBus setEnabled:YES];
-                [outputBus setEnabled:YES];
-            }
-           
-            if (error) {
-                HugLog(@"HugAudioEngine", @"Error when configuring %@: %@", unit, error);
-            } else  {
-                [graph addAudioUnit:unit];
-            }
-        }
+    for (AUAudioUnit *unit in unitsToAdd) {
+        [graph addAudioUnit:unit];
     }
 
     [graph addBlock:^(
@@ -498,53 +696,29 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
             timestamp->mHostTime :
             HugGetCurrentHostTime();
         
-        size_t meterFrameCount = HugLevelMeterGetMaxFrameCount(_leftLevelMeter);
-        
-        NSInteger offset = 0;
-        NSInteger framesRemaining = inNumberFrames;
-
-        float *leftData  = ioData->mNumberBuffers > 0 ? ioData->mBuffers[0].mData : NULL;
-        float *rightData = ioData->mNumberBuffers > 1 ? ioData->mBuffers[1].mData : NULL;
-
-        float volume = userInfo->volume;
-        HugLinearRamperProcess(volumeRamper, leftData, rightData, inNumberFrames, volume);
-        
-        while (framesRemaining > 0) {
-            NSInteger framesToProcess = MIN(framesRemaining, meterFrameCount);
-
-            PacketDataMeter packet = {0};
-            packet.timestamp = currentTime + HugGetHostTimeWithSeconds(offset / sampleRate);
-            packet.type = PacketTypeMeter;
-
-            if (leftData) {
-                HugLevelMeterProcess(leftLevelMeter, leftData + offset, framesToProcess);
+        if (!fuseStages) {
+            float *leftData  = ioData->mNumberBuffers > 0 ? ioData->mBuffers[0].mData : NULL;
+            float *rightData = ioData->mNumberBuffers > 1 ? ioData->mBuffers[1].mData : NULL;
 
-                packet.leftMeterData.peakLevel = HugLevelMeterGetPeakLevel(leftLevelMeter);
-                packet.leftMeterData.heldLevel = HugLevelMeterGetHeldLevel(leftLevelMeter);
-            }
-
-            if (rightData) {
-                HugLevelMeterProcess(rightLevelMeter, rightData + offset, framesToProcess);
-
-                packet.rightMeterData.peakLevel = HugLevelMeterGetPeakLevel(rightLevelMeter);
-                packet.rightMeterData.heldLevel = HugLevelMeterGetHeldLevel(rightLevelMeter);
-            }
+            MeterCallbackContext context = { &userInfo->snapshot, snapshotSpacing, currentTime, sampleRate };
 
-            HugLimiterProcess(limiter, leftData + offset, rightData + offset, framesToProcess);
-            packet.leftMeterData.limiterActive = HugLimiterIsActive(limiter);
-            packet.rightMeterData.limiterActive = packet.leftMeterData.limiterActive;
-
-            sendStatusPacket(packet);
-
-            framesRemaining -= meterFrameCount;
-            offset += meterFrameCount;
+            HugRenderChainProcessOutput(
+                renderChain, leftData, rightData, inNumberFrames,
+                userInfo->volume,
+                sAppendMeterData, &context
+            );
         }
         
-        // Calculate danger level and send packet
+        // Calculate danger level and publish the snapshot
         {
             uint64_t renderTime = HugGetCurrentHostTime() - userInfo->renderStart;
-            PacketDataDanger packet = { currentTime, PacketTypeDanger, inNumberFrames, renderTime };
-            sendStatusPacket(packet);
+
+            double callbackDuration = inNumberFrames / sampleRate;
+            double elapsedDuration  = HugGetSecondsWithHostTime(renderTime);
+
+            sUpdateDangerPeak(userInfo, elapsedDuration / callbackDuration);
+
+            HugTripleBufferWrite(snapshotBuffer, &userInfo->snapshot, sizeof(StatusSnapshot));
         }
         
         return noErr;
@@ -557,8 +731,6 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 
         NSInteger loopGuard = 0;
         while (1) {
-            HugRingBufferConfirmReadAll(_statusRingBuffer);
-
             if (blockToSend == atomic_load(&_renderUserInfo.renderBlock)) {
                 break;
             }
@@ -692,17 +864,12 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
         @"HugAudioEngine", @"AudioUnitInitialize[ Output ]"
     );
 
-    HugLevelMeterSetSampleRate(_leftLevelMeter, sampleRate);
-    HugLevelMeterSetSampleRate(_rightLevelMeter, sampleRate);
-    HugLimiterSetSampleRate(_emergencyLimiter, sampleRate);
+    HugLimiterMode limiterMode = [[settings objectForKey:HugAudioSettingLimiterMode] integerValue];
 
-    HugLinearRamperSetMaxFrameCount(_preGainRamper, frames);
-    HugLinearRamperSetMaxFrameCount(_volumeRamper, frames);
-    HugStereoFieldSetMaxFrameCount(_stereoField, frames);
+    HugRenderChainConfigure(_renderChain, sampleRate, frames);
+    HugRenderChainSetLimiterMode(_renderChain, limiterMode);
 
-    size_t meterFrame = MIN(frames, 1024);
-    HugLevelMeterSetMaxFrameCount(_leftLevelMeter, meterFrame);
-    HugLevelMeterSetMaxFrameCount(_rightLevelMeter, meterFrame);
+    HugLog(@"HugAudioEngine", @"Limiter mode %ld, %ld frames of added latency", (long)limiterMode, (long)HugRenderChainGetLatency(_renderChain));
 
     [self _reconnectGraph];
 
@@ -772,14 +939,14 @@ static OSStatus sHandleAudioDeviceOverload(AudioObjectID inObjectID, UInt32 inNu
 
     HugRingBufferConfirmReadAll(_statusRingBuffer);
 
-    HugLevelMeterReset(_leftLevelMeter);
-    HugLevelMeterReset(_rightLevelMeter);
+    HugRenderChainResetMeters(_renderChain);
     
     _playbackStatus = HugPlaybackStatusStopped;
     _timeElapsed    = 0;
     _timeRemaining  = 0;
     _leftMeterData  = nil;
     _rightMeterData = nil;
+    _meterTimestamp = 0;
     _dangerLevel    = 0;
 }
 
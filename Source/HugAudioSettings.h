@@ -17,4 +17,7 @@ extern HugAudioSettings const HugAudioSettingTakeExclusiveAccess;
 // If @YES, the device is reset to the maximum volume upon playback.
 extern HugAudioSettings const HugAudioSettingResetDeviceVolume;
 
+// NSNumber, a HugLimiterMode. Defaults to HugLimiterModeEmergency.
+extern HugAudioSettings const HugAudioSettingLimiterMode;
+
 
@@ -7,4 +7,5 @@ HugAudioSettings const HugAudioSettingSampleRate = @"SampleRate";
 HugAudioSettings const HugAudioSettingFrameSize = @"FrameSize";
 HugAudioSettings const HugAudioSettingTakeExclusiveAccess = @"TakeExclusiveAccess";
 HugAudioSettings const HugAudioSettingResetDeviceVolume = @"ResetDeviceVolume";
+HugAudioSettings const HugAudioSettingLimiterMode = @"LimiterMode";
 
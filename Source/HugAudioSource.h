@@ -35,7 +35,8 @@ typedef void (^HugAudioSourceCompletionHandler)(HugAudioSource *source);
                           settings: (NSDictionary *) settings;
 
 // Primes the audio buffer. If this returns YES, completionHandler will be invoked
-// after the buffer is completely prepared.
+// after the buffer is completely prepared (for streamed tracks, once the last
+// frame has been decoded).
 //
 - (BOOL) prepareWithStartTime: (NSTimeInterval) startTime
                      stopTime: (NSTimeInterval) stopTime
@@ -49,5 +50,13 @@ typedef void (^HugAudioSourceCompletionHandler)(HugAudioSource *source);
 
 @property (nonatomic, readonly) HugAudioSourceInputBlock inputBlock;
 
+// YES if the track is too long to buffer whole and is decoded into
+// a bounded, locked ring of chunks ahead of the play head instead.
+@property (nonatomic, readonly, getter=isStreaming) BOOL streaming;
+
+// Render cycles that found the stream empty, and the frames they missed
+@property (nonatomic, readonly) NSUInteger underrunCount;
+@property (nonatomic, readonly) NSUInteger underrunFrames;
+
 @end
 
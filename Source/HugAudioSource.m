@@ -4,6 +4,7 @@
 #import "HugAudioSource.h"
 
 #import "HugAudioFile.h"
+#import "HugChunkRing.h"
 #import "HugProtectedBuffer.h"
 #import "HugError.h"
 #import "HugUtils.h"
@@ -12,11 +13,23 @@
 
 #define DEBUG_AUDIO_SOURCE_BUFFERS 0
 
+// Tracks that would take more than this to buffer whole are streamed
+// through a HugChunkRing instead, which never uses more than
+// sStreamingMemoryBudget (or two chunks, if that is larger).
+//
+static const NSInteger sWholeTrackMemoryLimit = 512 * 1024 * 1024;
+static const NSInteger sStreamingMemoryBudget =  64 * 1024 * 1024;
+static const NSInteger sStreamingChunkFrames  = 32768;
+
 typedef struct {
     NSInteger frameIndex;
     NSInteger totalFrames;
     double sampleRate;
+    UInt32 channelCount;
+
+    // Exactly one of these is set
     AudioBufferList *bufferList;
+    HugChunkRing    *chunkRing;
 
     AudioBufferList *inputScratch;
     UInt32           inputScratchFrameSize;
@@ -46,6 +59,38 @@ static void sFillBufferList(RenderContext *context, UInt32 rawFrameCount, AudioB
         context->frameIndex += framesToCopy;
     }
 
+    // Copy streamed track data. On an underrun, play silence and
+    // leave frameIndex where the missing audio should have been.
+    //
+    if (context->chunkRing && context->frameIndex < context->totalFrames) {
+        NSUInteger framesToCopy = MIN(frameCount - offset, context->totalFrames - context->frameIndex);
+
+        float *outChannels[bufferCount];
+        for (NSInteger b = 0; b < bufferCount; b++) {
+            outChannels[b] = (float *)ioData->mBuffers[b].mData + offset;
+        }
+
+        NSUInteger framesCopied = HugChunkRingRead(context->chunkRing, outChannels, framesToCopy);
+
+        // If the file came up short, treat the rest as silence like the whole-track path
+        if (HugChunkRingIsDrained(context->chunkRing)) {
+            context->frameIndex += framesToCopy;
+        } else {
+            context->frameIndex += framesCopied;
+        }
+
+        offset += framesCopied;
+    }
+
+    if (context->chunkRing) {
+        for (NSInteger b = 0; b < bufferCount; b++) {
+            float *outSamples = (float *)ioData->mBuffers[b].mData;
+            memset(&outSamples[offset], 0, sizeof(float) * (frameCount - offset));
+        }
+
+        return;
+    }
+
     // Copy track data
     {
         NSUInteger framesToCopy = MIN(frameCount - offset, context->totalFrames - context->frameIndex);
@@ -133,6 +178,9 @@ static OSStatus sConverterInputCallback(
         HugAudioBufferListFree(_context->bufferList, NO);
         _context->bufferList = NULL;
 
+        HugChunkRingFree(_context->chunkRing);
+        _context->chunkRing = NULL;
+
         HugAudioBufferListFree(_context->converterScratch, YES);
         _context->converterScratch = NULL;
 
@@ -192,16 +240,52 @@ static OSStatus sConverterInputCallback(
             }
         }
         
-        if ((totalFrames < 0) || (totalFrames > UINT32_MAX)) {
+        if (totalFrames < 0) {
             _error = [NSError errorWithDomain:HugErrorDomain code:HugErrorInvalidFrameCount userInfo:nil];
             return NO;
         }
     }
 
-    // Setup _context and _protectedBuffers
+    UInt32 channelCount = format.mChannelsPerFrame;
+
+    UInt32 outputFrameSize = [[_settings objectForKey:HugAudioSettingFrameSize] unsignedIntValue];
+    AudioBufferList *inputScratch = HugAudioBufferListCreate(channelCount, outputFrameSize, YES);
+
+    _context = calloc(1, sizeof(RenderContext));
+    _context->sampleRate   = format.mSampleRate;
+    _context->channelCount = channelCount;
+    _context->frameIndex   = format.mSampleRate * -padding;
+    _context->totalFrames  = totalFrames;
+    _context->inputScratch = inputScratch;
+
+    // format is deinterleaved, mBytesPerFrame is per channel
+    NSInteger wholeTrackBytes = totalFrames * format.mBytesPerFrame * channelCount;
+
+    if ((wholeTrackBytes > sWholeTrackMemoryLimit) || (totalFrames > UINT32_MAX)) {
+        NSInteger chunkBytes = sStreamingChunkFrames * sizeof(float) * channelCount;
+        NSInteger chunkCount = MAX(2, sStreamingMemoryBudget / chunkBytes);
+
+        HugChunkRing *chunkRing = HugChunkRingCreate(channelCount, sStreamingChunkFrames, chunkCount);
+
+        if (!chunkRing) {
+            _error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+            return NO;
+        }
+
+        BOOL locked = HugChunkRingLock(chunkRing);
+
+        HugLog(@"HugAudioSource", @"%@ streaming, %ld bytes in %ld chunks, locked: %ld",
+            _audioFile, (long)HugChunkRingGetMemorySize(chunkRing), (long)chunkCount, (long)locked
+        );
+
+        _context->chunkRing = chunkRing;
+
+        return YES;
+    }
+
+    // Setup bufferList and _protectedBuffers
     {
-        UInt32 channelCount = format.mChannelsPerFrame;
-        UInt32 totalBytes   = (UInt32)totalFrames * format.mBytesPerFrame;
+        UInt32 totalBytes = (UInt32)totalFrames * format.mBytesPerFrame;
 
         AudioBufferList *list = HugAudioBufferListCreate(channelCount, 0, NO);
         
@@ -217,15 +301,7 @@ static OSStatus sConverterInputCallback(
             [protectedBuffers addObject:protectedBuffer];
         }
 
-        UInt32 outputFrameSize = [[_settings objectForKey:HugAudioSettingFrameSize] unsignedIntValue];
-        AudioBufferList *inputScratch = HugAudioBufferListCreate(channelCount, outputFrameSize, YES);
-
-        _context = calloc(1, sizeof(RenderContext));
-        _context->sampleRate   = format.mSampleRate;
-        _context->frameIndex   = format.mSampleRate * -padding;
-        _context->totalFrames  = (UInt32)totalFrames;
-        _context->bufferList   = list;
-        _context->inputScratch = inputScratch;
+        _context->bufferList = list;
 
         _protectedBuffers = protectedBuffers;
     }
@@ -247,7 +323,7 @@ static OSStatus sConverterInputCallback(
     }
 
 #if DEBUG_AUDIO_SOURCE_BUFFERS
-    [HugDebugFile writeWithSampleRate: _context->sampleRate
+    if (_context->bufferList) [HugDebugFile writeWithSampleRate: _context->sampleRate
                           totalFrames: _context->totalFrames
                            bufferList: _context->bufferList];
 #endif
@@ -363,6 +439,134 @@ static OSStatus sConverterInputCallback(
 }
 
 
+// Streaming counterpart of -_fillBuffer. The decoder only holds a strong
+// reference to self while it touches the file or the ring, and sleeps
+// while the ring is full, so it stops soon after the source goes away.
+//
+- (BOOL) _fillChunkRing
+{
+    HugChunkRing *chunkRing = _context->chunkRing;
+
+    AudioStreamBasicDescription format = [_audioFile format];
+
+    NSInteger channelCount = _context->channelCount;
+    NSInteger totalFrames  = _context->totalFrames;
+    NSInteger primeAmount  = (format.mSampleRate * 10);
+    if (primeAmount > HugChunkRingGetCapacity(chunkRing)) primeAmount = HugChunkRingGetCapacity(chunkRing);
+    if (totalFrames < primeAmount) primeAmount = totalFrames;
+
+    // Check back a few times per chunk played while the ring is full
+    useconds_t pollInterval = (sStreamingChunkFrames / format.mSampleRate) * (USEC_PER_SEC / 4);
+
+    dispatch_semaphore_t primeSemaphore = dispatch_semaphore_create(0);
+
+    __block BOOL shouldCancel = NO;
+    __weak HugAudioSource *weakSelf = self;
+
+    NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
+
+    dispatch_async(dispatch_get_global_queue(0, 0), ^{
+        NSInteger framesRemaining = totalFrames;
+        NSInteger framesAvailable = 0;
+        NSInteger underrunCount   = 0;
+
+        AudioBufferList *fillBufferList = HugAudioBufferListCreate((UInt32)channelCount, 0, NO);
+        float *channels[channelCount];
+
+        BOOL ok = YES;
+        BOOL needsSignal = YES;
+
+        while (ok) {
+            if (shouldCancel) break;
+
+            HugAudioSource *strongSelf = weakSelf;
+            if (!strongSelf) break;
+
+            NSInteger underruns = HugChunkRingGetUnderrunCount(chunkRing);
+            
+            if (underruns != underrunCount) {
+                NSInteger underrunFrames = HugChunkRingGetUnderrunFrames(chunkRing);
+
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    HugLog(@"HugAudioSource", @"Streaming underrun (%ld total, %ld frames)", (long)underruns, (long)underrunFrames);
+                });
+
+                underrunCount = underruns;
+            }
+
+            UInt32 frameCount = (UInt32)MIN(framesRemaining, (NSInteger)HugChunkRingGetWriteFrames(chunkRing, channels));
+
+            if ((frameCount == 0) && (framesRemaining > 0)) {
+                strongSelf = nil;
+                usleep(pollInterval);
+                continue;
+            }
+
+            for (NSInteger i = 0; i < channelCount; i++) {
+                fillBufferList->mBuffers[i].mNumberChannels = 1;
+                fillBufferList->mBuffers[i].mDataByteSize = frameCount * sizeof(float);
+                fillBufferList->mBuffers[i].mData = channels[i];
+            }
+
+            if (frameCount > 0) {
+                ok = [strongSelf->_audioFile readFrames:&frameCount intoBufferList:fillBufferList];
+            }
+
+            // ExtAudioFileRead() is documented to return 0 when the end of the file is reached.
+            //
+            if (!ok || (frameCount == 0) || (framesRemaining == 0)) {
+                break;
+            }
+
+            HugChunkRingConfirmWrite(chunkRing, frameCount);
+
+            framesAvailable += frameCount;
+            framesRemaining -= frameCount;
+
+            if ((framesAvailable >= primeAmount) && needsSignal) {
+                dispatch_semaphore_signal(primeSemaphore);
+                needsSignal = NO;
+            }
+        }
+
+        // Anything left unread plays as silence
+        {
+            HugAudioSource *strongSelf = weakSelf;
+            if (strongSelf) HugChunkRingFinish(chunkRing);
+        }
+
+        if (needsSignal) {
+            dispatch_semaphore_signal(primeSemaphore);
+        }
+
+        HugAudioBufferListFree(fillBufferList, NO);
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+            
+            HugLog(@"HugAudioSource", @"Stream finished in %ldms", (long)((now - startTime) * 1000));
+        
+            [weakSelf _finishFillBuffer];
+        });
+    });
+
+    // Same deadline as -_fillBuffer
+    int64_t fiveSecondsInNs = 5l * 1000 * 1000 * 1000;
+    if (dispatch_semaphore_wait(primeSemaphore, dispatch_time(0, fiveSecondsInNs))) {
+        HugLog(@"HugAudioSource", @"dispatch_semaphore_wait() timed out for %@", _audioFile);
+        _error = [NSError errorWithDomain:HugErrorDomain code:HugErrorReadTooSlow userInfo:nil];
+        shouldCancel = YES;
+
+        return NO;
+
+    } else {
+        HugLog(@"HugAudioSource", @"%@ primed!", _audioFile);
+        
+        return YES;
+    }
+}
+
+
 - (BOOL) _makeConverter
 {
     AudioStreamBasicDescription inputFormat = [_audioFile format];
@@ -422,7 +626,9 @@ static OSStatus sConverterInputCallback(
         return NO;
     }
     
-    if (![self _fillBuffer]) {
+    BOOL primed = _context->chunkRing ? [self _fillChunkRing] : [self _fillBuffer];
+
+    if (!primed) {
         return NO;
     }
     
@@ -440,7 +646,7 @@ static OSStatus sConverterInputCallback(
     ) {
         OSStatus result = noErr;
 
-        UInt32 sourceChannelCount = context->bufferList->mNumberBuffers;
+        UInt32 sourceChannelCount = context->channelCount;
         UInt32 outputChannelCount = ioData->mNumberBuffers;
 
         AudioBufferList *bufferToFill = (sourceChannelCount == outputChannelCount) ? ioData : context->inputScratch;
@@ -488,4 +694,24 @@ static OSStatus sConverterInputCallback(
 }
 
 
+#pragma mark - Accessors
+
+- (BOOL) isStreaming
+{
+    return _context && _context->chunkRing;
+}
+
+
+- (NSUInteger) underrunCount
+{
+    return [self isStreaming] ? HugChunkRingGetUnderrunCount(_context->chunkRing) : 0;
+}
+
+
+- (NSUInteger) underrunFrames
+{
+    return [self isStreaming] ? HugChunkRingGetUnderrunFrames(_context->chunkRing) : 0;
+}
+
+
 @end
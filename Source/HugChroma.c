@@ -0,0 +1,243 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugChroma.h"
+#include "HugFFT.h"
+#include "HugVectorOps.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sTargetRate       11025.0
+#define sMinimumFrequency 65.0
+#define sMaximumFrequency 2100.0
+#define sMixLength        4096
+
+
+struct HugChroma {
+    unsigned int _channels;
+    size_t _decimation;
+    double _decimatedRate;
+
+    // Mono mix of the input, starting with the samples left over from the
+    // previous call that didn't make up a whole decimated sample
+    float *_mixed;
+    size_t _carried;
+
+    float *_decimated;
+
+    float *_buffer;
+    size_t _filled;
+
+    float  *_window;
+    float  *_windowed;
+    float  *_power;
+    HugFFT *_fft;
+
+    // Transform bins inside the pitch range, and their pitch classes
+    uint32_t *_bins;
+    uint8_t  *_classes;
+    size_t    _binCount;
+
+    float  *_frames;
+    size_t  _frameCount;
+    size_t  _frameCapacity;
+};
+
+
+static bool sAddFrame(HugChroma *self)
+{
+    if (self->_frameCount == self->_frameCapacity) {
+        size_t capacity = self->_frameCapacity ? (self->_frameCapacity * 2) : 1024;
+        float *frames = realloc(self->_frames, capacity * HugChromaBinCount * sizeof(float));
+
+        if (!frames) return false;
+
+        self->_frames        = frames;
+        self->_frameCapacity = capacity;
+    }
+
+    HugVectorMultiply(self->_buffer, self->_window, self->_windowed, HugChromaFrameLength);
+    HugFFTGetPower(self->_fft, self->_windowed, self->_power);
+
+    float *chroma = &self->_frames[self->_frameCount * HugChromaBinCount];
+    memset(chroma, 0, HugChromaBinCount * sizeof(float));
+
+    for (size_t i = 0; i < self->_binCount; i++) {
+        chroma[self->_classes[i]] += self->_power[self->_bins[i]];
+    }
+
+    self->_frameCount++;
+
+    return true;
+}
+
+
+#pragma mark - Lifecycle
+
+HugChroma *HugChromaCreate(unsigned int channels, double sampleRate)
+{
+    if (!channels || !(sampleRate > 0)) return NULL;
+
+    HugChroma *self = calloc(1, sizeof(HugChroma));
+    if (!self) return NULL;
+
+    long decimation = lround(sampleRate / sTargetRate);
+
+    self->_channels      = channels;
+    self->_decimation    = decimation > 1 ? decimation : 1;
+    self->_decimatedRate = sampleRate / self->_decimation;
+
+    size_t binLimit = (HugChromaFrameLength / 2) + 1;
+
+    self->_mixed     = malloc((sMixLength + self->_decimation) * sizeof(float));
+    self->_decimated = malloc(((sMixLength / self->_decimation) + 1) * sizeof(float));
+    self->_buffer   = malloc(HugChromaFrameLength * sizeof(float));
+    self->_window   = malloc(HugChromaFrameLength * sizeof(float));
+    self->_windowed = malloc(HugChromaFrameLength * sizeof(float));
+    self->_power    = malloc(binLimit * sizeof(float));
+    self->_bins     = malloc(binLimit * sizeof(uint32_t));
+    self->_classes  = malloc(binLimit * sizeof(uint8_t));
+    self->_fft      = HugFFTCreate(HugChromaFrameLength);
+
+    if (!self->_mixed || !self->_decimated || !self->_buffer || !self->_window || !self->_windowed ||
+        !self->_power || !self->_bins || !self->_classes || !self->_fft
+    ) {
+        HugChromaFree(self);
+        return NULL;
+    }
+
+    // The window also averages the mixed and decimated samples
+    double scale = 1.0 / (channels * self->_decimation);
+
+    for (size_t i = 0; i < HugChromaFrameLength; i++) {
+        self->_window[i] = scale * (0.5 - (0.5 * cos((2.0 * M_PI * i) / HugChromaFrameLength)));
+    }
+
+    for (size_t k = 1; k < binLimit; k++) {
+        double frequency = (k * self->_decimatedRate) / HugChromaFrameLength;
+        if (frequency < sMinimumFrequency || frequency > sMaximumFrequency) continue;
+
+        // MIDI note 60 is C
+        long note = lround(69 + (12 * log2(frequency / 440.0)));
+
+        self->_bins[self->_binCount]    = (uint32_t)k;
+        self->_classes[self->_binCount] = (uint8_t)(note % 12);
+        self->_binCount++;
+    }
+
+    return self;
+}
+
+
+void HugChromaFree(HugChroma *self)
+{
+    if (!self) return;
+
+    HugFFTFree(self->_fft);
+
+    free(self->_mixed);
+    free(self->_decimated);
+    free(self->_buffer);
+    free(self->_window);
+    free(self->_windowed);
+    free(self->_power);
+    free(self->_bins);
+    free(self->_classes);
+    free(self->_frames);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+bool HugChromaProcess(HugChroma *self, const float * const *channels, size_t frames)
+{
+    unsigned int channelCount = self->_channels;
+    size_t decimation = self->_decimation;
+
+    float *mixed     = self->_mixed;
+    float *decimated = self->_decimated;
+
+    for (size_t offset = 0; offset < frames; offset += sMixLength) {
+        size_t count = frames - offset;
+        if (count > sMixLength) count = sMixLength;
+
+        float *destination = mixed + self->_carried;
+
+        memcpy(destination, channels[0] + offset, count * sizeof(float));
+
+        for (unsigned int c = 1; c < channelCount; c++) {
+            const float *samples = channels[c] + offset;
+
+            for (size_t i = 0; i < count; i++) {
+                destination[i] += samples[i];
+            }
+        }
+
+        size_t total = self->_carried + count;
+        size_t decimatedCount = total / decimation;
+
+        // Sums of each run of decimation samples. Striding through the runs
+        // keeps the additions independent of each other.
+        for (size_t i = 0; i < decimatedCount; i++) {
+            decimated[i] = mixed[i * decimation];
+        }
+
+        for (size_t j = 1; j < decimation; j++) {
+            for (size_t i = 0; i < decimatedCount; i++) {
+                decimated[i] += mixed[(i * decimation) + j];
+            }
+        }
+
+        self->_carried = total - (decimatedCount * decimation);
+        memmove(mixed, mixed + (decimatedCount * decimation), self->_carried * sizeof(float));
+
+        for (size_t i = 0; i < decimatedCount; ) {
+            size_t available = HugChromaFrameLength - self->_filled;
+            size_t copied = decimatedCount - i;
+            if (copied > available) copied = available;
+
+            memcpy(self->_buffer + self->_filled, decimated + i, copied * sizeof(float));
+
+            self->_filled += copied;
+            i += copied;
+
+            if (self->_filled == HugChromaFrameLength) {
+                if (!sAddFrame(self)) return false;
+
+                size_t kept = HugChromaFrameLength - HugChromaHopLength;
+                memmove(self->_buffer, self->_buffer + HugChromaHopLength, kept * sizeof(float));
+                self->_filled = kept;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+double HugChromaGetFrameRate(const HugChroma *self)
+{
+    return self->_decimatedRate / HugChromaHopLength;
+}
+
+
+size_t HugChromaGetFrameCount(const HugChroma *self)
+{
+    return self->_frameCount;
+}
+
+
+const float *HugChromaGetFrames(const HugChroma *self)
+{
+    return self->_frames;
+}
+
+
+size_t HugChromaGetFrameStep(const HugChroma *self)
+{
+    return HugChromaHopLength * self->_decimation;
+}
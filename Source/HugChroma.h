@@ -0,0 +1,52 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Twelve-bin pitch-class profiles (chroma) of a track, collected while it is
+// decoded for loudness. The audio is mixed to mono and decimated to about
+// 11 kHz. Every HugChromaHopLength decimated samples, a Hann-windowed frame of
+// HugChromaFrameLength samples is transformed, and its power from 65 Hz to
+// 2.1 kHz is folded into pitch classes, C first.
+//
+// The frames don't overlap. Everything that reads them averages over seconds,
+// where the samples at the tapered ends of each window matter little, and it
+// halves the transforms.
+//
+// The frames feed both the audio fingerprint and key detection, so the
+// transform runs once for both.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HugChromaBinCount    12
+#define HugChromaFrameLength 4096
+#define HugChromaHopLength   4096
+
+typedef struct HugChroma HugChroma;
+
+extern HugChroma *HugChromaCreate(unsigned int channels, double sampleRate);
+extern void HugChromaFree(HugChroma *chroma);
+
+// Returns false if memory runs out; frames collected so far are kept
+extern bool HugChromaProcess(HugChroma *chroma, const float * const *channels, size_t frames);
+
+// Frames per second of audio
+extern double HugChromaGetFrameRate(const HugChroma *chroma);
+
+// HugChromaBinCount powers per frame, in time order. Frame i starts at input
+// frame i * HugChromaGetFrameStep().
+//
+extern size_t HugChromaGetFrameCount(const HugChroma *chroma);
+extern const float *HugChromaGetFrames(const HugChroma *chroma);
+
+extern size_t HugChromaGetFrameStep(const HugChroma *chroma);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,233 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugChunkRing.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define sMaxChannelCount 32
+
+
+struct HugChunkRing {
+    float   *_channels[sMaxChannelCount];
+    float   *_bytes;
+    size_t   _memorySize;
+    size_t   _channelCount;
+    size_t   _chunkFrames;
+    size_t   _capacity;
+    bool     _locked;
+
+    _Atomic bool   _finished;
+    _Atomic size_t _underrunCount;
+    _Atomic size_t _underrunFrames;
+
+    // Frame indices, they only ever increase
+    _Atomic size_t _writeIndex __attribute__((aligned(128)));
+    _Atomic size_t _readIndex  __attribute__((aligned(128)));
+};
+
+
+#pragma mark - Lifecycle
+
+HugChunkRing *HugChunkRingCreate(size_t channelCount, size_t chunkFrames, size_t chunkCount)
+{
+    if (!channelCount || channelCount > sMaxChannelCount) return NULL;
+    if (!chunkFrames || !chunkCount) return NULL;
+
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t capacity = chunkFrames * chunkCount;
+
+    // Each channel starts on its own page
+    size_t channelSize = ((capacity * sizeof(float) + pageSize - 1) / pageSize) * pageSize;
+    size_t memorySize  = channelSize * channelCount;
+
+    void *bytes = NULL;
+    if (posix_memalign(&bytes, pageSize, memorySize) != 0) {
+        return NULL;
+    }
+
+    // Touch every page now rather than on the render thread
+    memset(bytes, 0, memorySize);
+
+    HugChunkRing *self = aligned_alloc(128, sizeof(HugChunkRing));
+
+    if (!self) {
+        free(bytes);
+        return NULL;
+    }
+
+    memset(self, 0, sizeof(HugChunkRing));
+
+    self->_bytes        = bytes;
+    self->_memorySize   = memorySize;
+    self->_channelCount = channelCount;
+    self->_chunkFrames  = chunkFrames;
+    self->_capacity     = capacity;
+
+    for (size_t i = 0; i < channelCount; i++) {
+        self->_channels[i] = (float *)((uint8_t *)bytes + (i * channelSize));
+    }
+
+    return self;
+}
+
+
+void HugChunkRingFree(HugChunkRing *self)
+{
+    if (!self) return;
+
+    if (self->_locked) {
+        munlock(self->_bytes, self->_memorySize);
+    }
+
+    free(self->_bytes);
+    free(self);
+}
+
+
+bool HugChunkRingLock(HugChunkRing *self)
+{
+    if (!self->_locked) {
+        self->_locked = (mlock(self->_bytes, self->_memorySize) == 0);
+    }
+
+    return self->_locked;
+}
+
+
+#pragma mark - Producer
+
+size_t HugChunkRingGetWriteFrames(HugChunkRing *self, float **outChannels)
+{
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_relaxed);
+    size_t readIndex  = atomic_load_explicit(&self->_readIndex,  memory_order_acquire);
+
+    size_t freeFrames = self->_capacity - (writeIndex - readIndex);
+    size_t toChunkEnd = self->_chunkFrames - (writeIndex % self->_chunkFrames);
+
+    size_t frames = freeFrames < toChunkEnd ? freeFrames : toChunkEnd;
+
+    // Chunks never straddle the end, capacity is a whole number of them
+    size_t offset = writeIndex % self->_capacity;
+
+    for (size_t i = 0; i < self->_channelCount; i++) {
+        outChannels[i] = self->_channels[i] + offset;
+    }
+
+    return frames;
+}
+
+
+void HugChunkRingConfirmWrite(HugChunkRing *self, size_t frameCount)
+{
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_relaxed);
+    atomic_store_explicit(&self->_writeIndex, writeIndex + frameCount, memory_order_release);
+}
+
+
+void HugChunkRingFinish(HugChunkRing *self)
+{
+    atomic_store_explicit(&self->_finished, true, memory_order_release);
+}
+
+
+#pragma mark - Consumer
+
+size_t HugChunkRingRead(HugChunkRing *self, float * const *outChannels, size_t frameCount)
+{
+    // The producer writes its last frames before setting _finished. If it
+    // was already set, a short read is the end of the stream, not an underrun.
+    //
+    bool finished = atomic_load_explicit(&self->_finished, memory_order_acquire);
+
+    size_t readIndex  = atomic_load_explicit(&self->_readIndex,  memory_order_relaxed);
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_acquire);
+
+    size_t available = writeIndex - readIndex;
+    size_t frames = frameCount < available ? frameCount : available;
+
+    size_t offset = readIndex % self->_capacity;
+    size_t first  = self->_capacity - offset;
+    if (first > frames) first = frames;
+
+    for (size_t i = 0; i < self->_channelCount; i++) {
+        if (!outChannels[i]) continue;
+
+        memcpy(outChannels[i], self->_channels[i] + offset, first * sizeof(float));
+
+        if (frames > first) {
+            memcpy(outChannels[i] + first, self->_channels[i], (frames - first) * sizeof(float));
+        }
+    }
+
+    atomic_store_explicit(&self->_readIndex, readIndex + frames, memory_order_release);
+
+    if (frames < frameCount && !finished) {
+        atomic_fetch_add_explicit(&self->_underrunCount,  1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&self->_underrunFrames, frameCount - frames, memory_order_relaxed);
+    }
+
+    return frames;
+}
+
+
+bool HugChunkRingIsDrained(HugChunkRing *self)
+{
+    if (!atomic_load_explicit(&self->_finished, memory_order_acquire)) {
+        return false;
+    }
+
+    return HugChunkRingGetAvailableFrames(self) == 0;
+}
+
+
+#pragma mark - Accessors
+
+size_t HugChunkRingGetChannelCount(const HugChunkRing *self)
+{
+    return self->_channelCount;
+}
+
+
+size_t HugChunkRingGetChunkFrames(const HugChunkRing *self)
+{
+    return self->_chunkFrames;
+}
+
+
+size_t HugChunkRingGetCapacity(const HugChunkRing *self)
+{
+    return self->_capacity;
+}
+
+
+size_t HugChunkRingGetMemorySize(const HugChunkRing *self)
+{
+    return self->_memorySize;
+}
+
+
+size_t HugChunkRingGetAvailableFrames(HugChunkRing *self)
+{
+    size_t readIndex  = atomic_load_explicit(&self->_readIndex,  memory_order_acquire);
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_acquire);
+
+    return writeIndex - readIndex;
+}
+
+
+size_t HugChunkRingGetUnderrunCount(HugChunkRing *self)
+{
+    return atomic_load_explicit(&self->_underrunCount, memory_order_relaxed);
+}
+
+
+size_t HugChunkRingGetUnderrunFrames(HugChunkRing *self)
+{
+    return atomic_load_explicit(&self->_underrunFrames, memory_order_relaxed);
+}
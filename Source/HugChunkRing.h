@@ -0,0 +1,64 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Bounded single-producer, single-consumer ring of deinterleaved float audio,
+// used to stream tracks that are too long to buffer whole. The decoder thread
+// fills it one chunk at a time ahead of the play head; the render thread reads
+// from it without ever blocking. All memory is allocated (and optionally
+// locked) up front.
+//
+// A read that comes up short before the producer calls Finish() is an
+// underrun: the missing frames are left to the caller and counted.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugChunkRing HugChunkRing;
+
+// Capacity is chunkFrames * chunkCount frames per channel
+extern HugChunkRing *HugChunkRingCreate(size_t channelCount, size_t chunkFrames, size_t chunkCount);
+extern void HugChunkRingFree(HugChunkRing *ring);
+
+// Wires the memory with mlock(), returns false if that failed
+extern bool HugChunkRingLock(HugChunkRing *ring);
+
+// Producer
+//
+// GetWriteFrames() returns the number of frames that can be written
+// contiguously, up to the end of the current chunk, and fills outChannels
+// with one pointer per channel. ConfirmWrite() makes them readable.
+//
+extern size_t HugChunkRingGetWriteFrames(HugChunkRing *ring, float **outChannels);
+extern void   HugChunkRingConfirmWrite(HugChunkRing *ring, size_t frameCount);
+extern void   HugChunkRingFinish(HugChunkRing *ring);
+
+// Consumer
+//
+// Copies up to frameCount frames into outChannels (one pointer per channel)
+// and returns the number of frames copied.
+//
+extern size_t HugChunkRingRead(HugChunkRing *ring, float * const *outChannels, size_t frameCount);
+
+// True once Finish() was called and every frame has been read
+extern bool HugChunkRingIsDrained(HugChunkRing *ring);
+
+// Accessors, safe from any thread
+extern size_t HugChunkRingGetChannelCount(const HugChunkRing *ring);
+extern size_t HugChunkRingGetChunkFrames(const HugChunkRing *ring);
+extern size_t HugChunkRingGetCapacity(const HugChunkRing *ring);
+extern size_t HugChunkRingGetMemorySize(const HugChunkRing *ring);
+extern size_t HugChunkRingGetAvailableFrames(HugChunkRing *ring);
+
+extern size_t HugChunkRingGetUnderrunCount(HugChunkRing *ring);
+extern size_t HugChunkRingGetUnderrunFrames(HugChunkRing *ring);
+
+#ifdef __cplusplus
+}
+#endif
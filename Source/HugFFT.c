@@ -0,0 +1,260 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugFFT.h"
+#include "HugSIMD.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+struct HugFFT {
+    size_t _length;
+    size_t _halfLength;
+
+    // Input sample n of the half-length transform goes to _reversed[n]
+    uint32_t *_reversed;
+
+    // Stage twiddles: the stage with span h uses entries h through 2h - 1
+    float *_twiddleReal;
+    float *_twiddleImaginary;
+
+    // Twiddles that split the half-length result into the real transform
+    float *_splitReal;
+    float *_splitImaginary;
+
+    float *_real;
+    float *_imaginary;
+};
+
+
+static void sTransform(HugFFT *self, const float *input)
+{
+    size_t halfLength = self->_halfLength;
+
+    float *re = self->_real;
+    float *im = self->_imaginary;
+
+    for (size_t n = 0; n < halfLength; n++) {
+        uint32_t r = self->_reversed[n];
+
+        re[r] = input[2 * n];
+        im[r] = input[(2 * n) + 1];
+    }
+
+    size_t h = 1;
+
+    // The first two stages together, their twiddles are 1 and -i
+    if (halfLength >= 4) {
+        for (size_t k = 0; k < halfLength; k += 4) {
+            float r0 = re[k]     + re[k + 1], i0 = im[k]     + im[k + 1];
+            float r1 = re[k]     - re[k + 1], i1 = im[k]     - im[k + 1];
+            float r2 = re[k + 2] + re[k + 3], i2 = im[k + 2] + im[k + 3];
+            float r3 = re[k + 2] - re[k + 3], i3 = im[k + 2] - im[k + 3];
+
+            re[k]     = r0 + r2;  im[k]     = i0 + i2;
+            re[k + 2] = r0 - r2;  im[k + 2] = i0 - i2;
+            re[k + 1] = r1 + i3;  im[k + 1] = i1 - r3;
+            re[k + 3] = r1 - i3;  im[k + 3] = i1 + r3;
+        }
+
+        h = 4;
+    }
+
+    for ( ; h < halfLength; h *= 2) {
+        const float *wr = self->_twiddleReal + h;
+        const float *wi = self->_twiddleImaginary + h;
+
+        for (size_t k = 0; k < halfLength; k += 2 * h) {
+            float *ar = re + k, *ai = im + k;
+            float *br = ar + h, *bi = ai + h;
+
+            size_t j = 0;
+
+            if (h >= HUG_SIMD_FLOAT_LANES) {
+                for ( ; j + HUG_SIMD_FLOAT_LANES <= h; j += HUG_SIMD_FLOAT_LANES) {
+                    HugSIMDFloat vwr = HugSIMDLoad(wr + j);
+                    HugSIMDFloat vwi = HugSIMDLoad(wi + j);
+                    HugSIMDFloat vbr = HugSIMDLoad(br + j);
+                    HugSIMDFloat vbi = HugSIMDLoad(bi + j);
+                    HugSIMDFloat var = HugSIMDLoad(ar + j);
+                    HugSIMDFloat vai = HugSIMDLoad(ai + j);
+
+                    HugSIMDFloat tr = HugSIMDSub(HugSIMDMul(vwr, vbr), HugSIMDMul(vwi, vbi));
+                    HugSIMDFloat ti = HugSIMDAdd(HugSIMDMul(vwr, vbi), HugSIMDMul(vwi, vbr));
+
+                    HugSIMDStore(br + j, HugSIMDSub(var, tr));
+                    HugSIMDStore(bi + j, HugSIMDSub(vai, ti));
+                    HugSIMDStore(ar + j, HugSIMDAdd(var, tr));
+                    HugSIMDStore(ai + j, HugSIMDAdd(vai, ti));
+                }
+            }
+
+            for ( ; j < h; j++) {
+                float tr = (wr[j] * br[j]) - (wi[j] * bi[j]);
+                float ti = (wr[j] * bi[j]) + (wi[j] * br[j]);
+
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] = ar[j] + tr;
+                ai[j] = ai[j] + ti;
+            }
+        }
+    }
+}
+
+
+// Bin k of the real transform from bins k and (halfLength - k) of the packed
+// one. Bins 0 and halfLength both come from packed bin 0.
+//
+static inline void sSplit(const HugFFT *self, size_t k, float *outReal, float *outImaginary)
+{
+    size_t halfLength = self->_halfLength;
+    size_t a = k < halfLength ? k : 0;
+    size_t b = (k > 0 && k < halfLength) ? (halfLength - k) : 0;
+
+    float ar = self->_real[a], ai =  self->_imaginary[a];
+    float br = self->_real[b], bi = -self->_imaginary[b];
+
+    float evenReal      = 0.5f * (ar + br);
+    float evenImaginary = 0.5f * (ai + bi);
+    float oddReal       = 0.5f * (ai - bi);
+    float oddImaginary  = 0.5f * (br - ar);
+
+    float wr = self->_splitReal[k];
+    float wi = self->_splitImaginary[k];
+
+    *outReal      = evenReal      + (wr * oddReal) - (wi * oddImaginary);
+    *outImaginary = evenImaginary + (wr * oddImaginary) + (wi * oddReal);
+}
+
+
+#pragma mark - Lifecycle
+
+HugFFT *HugFFTCreate(size_t length)
+{
+    if (length < 4 || (length & (length - 1)) || length > UINT32_MAX) return NULL;
+
+    HugFFT *self = calloc(1, sizeof(HugFFT));
+    if (!self) return NULL;
+
+    size_t halfLength = length / 2;
+
+    self->_length     = length;
+    self->_halfLength = halfLength;
+
+    self->_reversed         = malloc(halfLength * sizeof(uint32_t));
+    self->_twiddleReal      = malloc(halfLength * sizeof(float));
+    self->_twiddleImaginary = malloc(halfLength * sizeof(float));
+    self->_splitReal        = malloc((halfLength + 1) * sizeof(float));
+    self->_splitImaginary   = malloc((halfLength + 1) * sizeof(float));
+    self->_real             = malloc(halfLength * sizeof(float));
+    self->_imaginary        = malloc(halfLength * sizeof(float));
+
+    if (!self->_reversed || !self->_twiddleReal || !self->_twiddleImaginary ||
+        !self->_splitReal || !self->_splitImaginary || !self->_real || !self->_imaginary
+    ) {
+        HugFFTFree(self);
+        return NULL;
+    }
+
+    size_t bits = 0;
+    while (((size_t)1 << bits) < halfLength) bits++;
+
+    for (size_t n = 0; n < halfLength; n++) {
+        uint32_t r = 0;
+
+        for (size_t b = 0; b < bits; b++) {
+            if (n & ((size_t)1 << b)) r |= 1u << (bits - 1 - b);
+        }
+
+        self->_reversed[n] = r;
+    }
+
+    self->_twiddleReal[0]      = 1;
+    self->_twiddleImaginary[0] = 0;
+
+    for (size_t h = 1; h < halfLength; h *= 2) {
+        for (size_t j = 0; j < h; j++) {
+            double angle = -M_PI * j / h;
+
+            self->_twiddleReal[h + j]      = cos(angle);
+            self->_twiddleImaginary[h + j] = sin(angle);
+        }
+    }
+
+    for (size_t k = 0; k <= halfLength; k++) {
+        double angle = -2.0 * M_PI * k / length;
+
+        self->_splitReal[k]      = cos(angle);
+        self->_splitImaginary[k] = sin(angle);
+    }
+
+    return self;
+}
+
+
+void HugFFTFree(HugFFT *self)
+{
+    if (!self) return;
+
+    free(self->_reversed);
+    free(self->_twiddleReal);
+    free(self->_twiddleImaginary);
+    free(self->_splitReal);
+    free(self->_splitImaginary);
+    free(self->_real);
+    free(self->_imaginary);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+size_t HugFFTGetLength(const HugFFT *self)
+{
+    return self->_length;
+}
+
+
+void HugFFTForward(HugFFT *self, const float *input, float *outReal, float *outImaginary)
+{
+    sTransform(self, input);
+
+    for (size_t k = 0; k <= self->_halfLength; k++) {
+        sSplit(self, k, &outReal[k], &outImaginary[k]);
+    }
+}
+
+
+void HugFFTGetPower(HugFFT *self, const float *input, float *outPower)
+{
+    sTransform(self, input);
+
+    size_t halfLength = self->_halfLength;
+
+    const float *re = self->_real;
+    const float *im = self->_imaginary;
+    const float *wr = self->_splitReal;
+    const float *wi = self->_splitImaginary;
+
+    // Packed bin 0 holds the sum of the even samples in its real part and
+    // of the odd ones in its imaginary part
+    outPower[0]          = (re[0] + im[0]) * (re[0] + im[0]);
+    outPower[halfLength] = (re[0] - im[0]) * (re[0] - im[0]);
+
+    for (size_t k = 1; k < halfLength; k++) {
+        size_t b = halfLength - k;
+
+        float evenReal      = 0.5f * (re[k] + re[b]);
+        float evenImaginary = 0.5f * (im[k] - im[b]);
+        float oddReal       = 0.5f * (im[k] + im[b]);
+        float oddImaginary  = 0.5f * (re[b] - re[k]);
+
+        float real      = evenReal      + (wr[k] * oddReal) - (wi[k] * oddImaginary);
+        float imaginary = evenImaginary + (wr[k] * oddImaginary) + (wi[k] * oddReal);
+
+        outPower[k] = (real * real) + (imaginary * imaginary);
+    }
+}
@@ -0,0 +1,37 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Forward FFT of real input for the analysis passes (chroma, tempo). The
+// length is a power of two; the input is packed into a complex transform
+// of half the length, whose butterflies run on HugSIMD vectors.
+//
+// A HugFFT holds its own scratch space, so use one per thread.
+//
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugFFT HugFFT;
+
+// length must be a power of two, 4 or more. Returns NULL otherwise.
+extern HugFFT *HugFFTCreate(size_t length);
+extern void HugFFTFree(HugFFT *fft);
+
+extern size_t HugFFTGetLength(const HugFFT *fft);
+
+// Transforms length samples into length / 2 + 1 bins, DC through Nyquist,
+// unnormalized (a full-scale sine at bin k has magnitude length / 2).
+//
+extern void HugFFTForward(HugFFT *fft, const float *input, float *outReal, float *outImaginary);
+
+// Squared magnitudes of the length / 2 + 1 bins
+extern void HugFFTGetPower(HugFFT *fft, const float *input, float *outPower);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,191 @@
+// (c) 2014-2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugFastUtils.h"
+#include "HugSIMD.h"
+
+#include <math.h>
+
+// The exponential and equal-power envelopes are recurrences (multiply or
+// rotate by a fixed step per sample). Each SIMD lane runs its own float copy,
+// stepping by N samples at once. Every sAnchorStepCount steps the lanes are
+// re-seeded from a double-precision recurrence so float rounding can't build
+// up over long fades.
+//
+#define sAnchorStepCount 32
+
+
+void HugApplySilence(float *samples, size_t frameCount)
+{
+    if (!samples) return;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] = 0;
+    }
+}
+
+
+static void sApplyExponentialFade(float *samples, size_t frameCount, double fromValue, double toValue)
+{
+    const double sSilence = pow(10.0, -120.0 / 20.0); // Silence is -120dB
+
+    if (!fromValue) fromValue = sSilence;
+    if (!toValue)   toValue   = sSilence;
+    
+    double multiplier = pow(toValue / fromValue, 1 / (double)frameCount);
+
+    // multiplier^0 ... multiplier^(lanes - 1), and multiplier^lanes to step all lanes
+    double laneOffsets[HUG_SIMD_FLOAT_LANES];
+    double laneStep = 1.0;
+
+    for (size_t k = 0; k < HUG_SIMD_FLOAT_LANES; k++) {
+        laneOffsets[k] = laneStep;
+        laneStep *= multiplier;
+    }
+
+    double anchorStep = pow(laneStep, sAnchorStepCount);
+    double anchor = fromValue;
+
+    const HugSIMDFloat vStep = HugSIMDSplat(laneStep);
+
+    size_t i = 0;
+
+    while (i + HUG_SIMD_FLOAT_LANES <= frameCount) {
+        float lanes[HUG_SIMD_FLOAT_LANES];
+
+        for (size_t k = 0; k < HUG_SIMD_FLOAT_LANES; k++) {
+            lanes[k] = anchor * laneOffsets[k];
+        }
+
+        HugSIMDFloat vEnv = HugSIMDLoad(lanes);
+
+        for (size_t step = 0; step < sAnchorStepCount && (i + HUG_SIMD_FLOAT_LANES <= frameCount); step++) {
+            HugSIMDStore(samples + i, HugSIMDMul(HugSIMDLoad(samples + i), vEnv));
+            vEnv = HugSIMDMul(vEnv, vStep);
+
+            i += HUG_SIMD_FLOAT_LANES;
+        }
+
+        anchor *= anchorStep;
+    }
+
+    double env = fromValue * pow(multiplier, i);
+
+    for ( ; i < frameCount; i++) {
+        samples[i] *= env;
+        env *= multiplier;
+    }
+}
+
+
+static void sApplyEqualPowerFade(float *samples, size_t frameCount, double fromValue, double toValue)
+{
+    double delta = (M_PI / 2.0) / (double)frameCount;
+
+    // (cos, sin) of k * delta for each lane, then rotation by lanes * delta
+    double laneCos[HUG_SIMD_FLOAT_LANES];
+    double laneSin[HUG_SIMD_FLOAT_LANES];
+
+    double deltaCos = cos(delta), deltaSin = sin(delta);
+    double stepCos  = 1.0,        stepSin  = 0.0;
+
+    for (size_t k = 0; k < HUG_SIMD_FLOAT_LANES; k++) {
+        laneCos[k] = stepCos;
+        laneSin[k] = stepSin;
+
+        double nextCos = (stepCos * deltaCos) - (stepSin * deltaSin);
+        double nextSin = (stepSin * deltaCos) + (stepCos * deltaSin);
+
+        stepCos = nextCos;
+        stepSin = nextSin;
+    }
+
+    double anchorAngle = delta * HUG_SIMD_FLOAT_LANES * sAnchorStepCount;
+    double anchorStepCos = cos(anchorAngle), anchorStepSin = sin(anchorAngle);
+    double anchorCos = 1.0, anchorSin = 0.0;
+
+    const HugSIMDFloat vStepCos = HugSIMDSplat(stepCos);
+    const HugSIMDFloat vStepSin = HugSIMDSplat(stepSin);
+    const HugSIMDFloat vFrom    = HugSIMDSplat(fromValue);
+    const HugSIMDFloat vTo      = HugSIMDSplat(toValue);
+
+    size_t i = 0;
+
+    while (i + HUG_SIMD_FLOAT_LANES <= frameCount) {
+        float lanesCos[HUG_SIMD_FLOAT_LANES];
+        float lanesSin[HUG_SIMD_FLOAT_LANES];
+
+        for (size_t k = 0; k < HUG_SIMD_FLOAT_LANES; k++) {
+            lanesCos[k] = (anchorCos * laneCos[k]) - (anchorSin * laneSin[k]);
+            lanesSin[k] = (anchorSin * laneCos[k]) + (anchorCos * laneSin[k]);
+        }
+
+        HugSIMDFloat vCos = HugSIMDLoad(lanesCos);
+        HugSIMDFloat vSin = HugSIMDLoad(lanesSin);
+
+        for (size_t step = 0; step < sAnchorStepCount && (i + HUG_SIMD_FLOAT_LANES <= frameCount); step++) {
+            HugSIMDFloat gain = HugSIMDAdd(HugSIMDMul(vFrom, vCos), HugSIMDMul(vTo, vSin));
+            HugSIMDStore(samples + i, HugSIMDMul(HugSIMDLoad(samples + i), gain));
+
+            HugSIMDFloat nextCos = HugSIMDSub(HugSIMDMul(vCos, vStepCos), HugSIMDMul(vSin, vStepSin));
+            HugSIMDFloat nextSin = HugSIMDAdd(HugSIMDMul(vSin, vStepCos), HugSIMDMul(vCos, vStepSin));
+
+            vCos = nextCos;
+            vSin = nextSin;
+
+            i += HUG_SIMD_FLOAT_LANES;
+        }
+
+        double nextCos = (anchorCos * anchorStepCos) - (anchorSin * anchorStepSin);
+        double nextSin = (anchorSin * anchorStepCos) + (anchorCos * anchorStepSin);
+
+        anchorCos = nextCos;
+        anchorSin = nextSin;
+    }
+
+    for ( ; i < frameCount; i++) {
+        samples[i] *= (fromValue * cos(delta * i)) + (toValue * sin(delta * i));
+    }
+}
+
+
+static void sApplyLinearFade(float *samples, size_t frameCount, float fromValue, float toValue)
+{
+    const float step  = 1.0f / (float)frameCount;
+    const float range = toValue - fromValue;
+
+    size_t i = 0;
+
+    HugSIMDFloat vIndex = HugSIMDIota();
+
+    for ( ; i + HUG_SIMD_FLOAT_LANES <= frameCount; i += HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat gain = HugSIMDAdd(HugSIMDMul(HugSIMDMul(vIndex, HugSIMDSplat(step)), HugSIMDSplat(range)), HugSIMDSplat(fromValue));
+        HugSIMDStore(samples + i, HugSIMDMul(HugSIMDLoad(samples + i), gain));
+
+        vIndex = HugSIMDAdd(vIndex, HugSIMDSplat(HUG_SIMD_FLOAT_LANES));
+    }
+
+    for ( ; i < frameCount; i++) {
+        samples[i] *= ((((float)i * step) * range) + fromValue);
+    }
+}
+
+
+void HugApplyFadeWithCurve(float *samples, size_t frameCount, float inFromValue, float inToValue, HugFadeCurve curve)
+{
+    if (!samples || !frameCount) return;
+
+    if (curve == HugFadeCurveEqualPower) {
+        sApplyEqualPowerFade(samples, frameCount, inFromValue, inToValue);
+    } else if (curve == HugFadeCurveLinear) {
+        sApplyLinearFade(samples, frameCount, inFromValue, inToValue);
+    } else {
+        sApplyExponentialFade(samples, frameCount, inFromValue, inToValue);
+    }
+}
+
+
+void HugApplyFade(float *samples, size_t frameCount, float inFromValue, float inToValue)
+{
+    HugApplyFadeWithCurve(samples, frameCount, inFromValue, inToValue, HugFadeCurveExponential);
+}
@@ -1,9 +1,28 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import <Foundation/Foundation.h>
+#pragma once
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HugFadeCurveExponential = 0, // Constant dB per sample, 0 is treated as -120 dB
+    HugFadeCurveEqualPower,      // from * cos(t * pi/2) + to * sin(t * pi/2)
+    HugFadeCurveLinear
+} HugFadeCurve;
 
 extern void HugApplySilence(float *samples, size_t frameCount);
 
+// Gain at sample i follows the curve at t = i / frameCount, so the next
+// block can start exactly at inToValue.
+//
 extern void HugApplyFade(float *samples, size_t frameCount, float inFromValue, float inToValue);
+extern void HugApplyFadeWithCurve(float *samples, size_t frameCount, float inFromValue, float inToValue, HugFadeCurve curve);
+
+#ifdef __cplusplus
+}
+#endif
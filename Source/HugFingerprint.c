@@ -0,0 +1,425 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugFingerprint.h"
+#include "HugLSHTable.h"
+#include "HugSIMD.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sMagic 0x31504648 // 'HFP1'
+
+#define sSegmentDuration  4.0
+#define sMinimumSegments  2
+#define sMaximumSegments  60
+#define sSegmentLength    HugChromaBinCount
+#define sQuantizeScale    127.0f
+
+// Center of a chroma frame, in frames from its start
+#define sFrameCenter ((HugChromaFrameLength / 2.0) / HugChromaHopLength)
+
+#define sDurationTolerance      2.0
+#define sDurationToleranceRatio 0.02
+
+// SimHash of the first 16 segments, 24 bands of 14 bits. Same-audio pairs
+// (cosine 0.95 and up) share a band over 99% of the time, unrelated tracks
+// (cosine near 0) about 0.15%.
+//
+#define sHashedSegments 16
+#define sHashedLength   (sHashedSegments * sSegmentLength)
+#define sBandCount      24
+#define sBitsPerBand    14
+
+
+typedef struct {
+    uint32_t magic;
+    uint16_t segmentCount;
+    uint16_t segmentLength;
+    float    duration;
+} HugFingerprintHeader;
+
+
+typedef struct {
+    HugFingerprintHeader header;
+    const int8_t *values;
+} HugFingerprintView;
+
+
+typedef struct {
+    uint8_t *bytes;
+    size_t   length;
+    bool     used;
+} HugFingerprintIndexItem;
+
+
+struct HugFingerprintIndex {
+    double _threshold;
+
+    HugFingerprintIndexItem *_items;
+    size_t _itemCapacity;
+    size_t _itemCount;      // Slots handed out, including free ones
+    size_t _usedCount;
+
+    size_t *_freeSlots;
+    size_t  _freeCount;
+
+    // sBandCount * sBitsPerBand hyperplanes of sHashedLength
+    float *_planes;
+
+    HugLSHTable *_table;
+};
+
+
+typedef struct {
+    HugFingerprintIndex *index;
+    size_t  slot;
+    size_t *result;
+    size_t  count;
+    size_t  capacity;
+    bool    failed;
+} HugFingerprintIndexQuery;
+
+
+static uint32_t sMix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+
+    return x;
+}
+
+
+static bool sReadView(const void *bytes, size_t length, HugFingerprintView *outView)
+{
+    if (!bytes || length < sizeof(HugFingerprintHeader)) return false;
+
+    memcpy(&outView->header, bytes, sizeof(HugFingerprintHeader));
+
+    const HugFingerprintHeader *header = &outView->header;
+
+    if (header->magic != sMagic || header->segmentLength != sSegmentLength) return false;
+    if (header->segmentCount < sMinimumSegments) return false;
+    if (length != sizeof(HugFingerprintHeader) + (header->segmentCount * sSegmentLength)) return false;
+    if (!(header->duration > 0)) return false;
+
+    outView->values = (const int8_t *)bytes + sizeof(HugFingerprintHeader);
+
+    return true;
+}
+
+
+static double sGetSimilarity(const HugFingerprintView *a, const HugFingerprintView *b)
+{
+    double durationA = a->header.duration;
+    double durationB = b->header.duration;
+    double longer    = durationA > durationB ? durationA : durationB;
+    double tolerance = longer * sDurationToleranceRatio;
+
+    if (tolerance < sDurationTolerance) tolerance = sDurationTolerance;
+    if (fabs(durationA - durationB) > tolerance) return 0;
+
+    size_t segmentCount = a->header.segmentCount < b->header.segmentCount ?
+        a->header.segmentCount : b->header.segmentCount;
+
+    size_t count = segmentCount * sSegmentLength;
+    int32_t dot = 0, squaresA = 0, squaresB = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t va = a->values[i];
+        int32_t vb = b->values[i];
+
+        dot      += va * vb;
+        squaresA += va * va;
+        squaresB += vb * vb;
+    }
+
+    if (!squaresA || !squaresB) return 0;
+
+    return dot / sqrt((double)squaresA * (double)squaresB);
+}
+
+
+#pragma mark - Fingerprints
+
+void *HugFingerprintCreateData(const HugChroma *chroma, double startTime, double endTime, size_t *outLength)
+{
+    double duration = endTime - startTime;
+    size_t segmentCount = duration > 0 ? (size_t)(duration / sSegmentDuration) : 0;
+
+    if (segmentCount > sMaximumSegments) segmentCount = sMaximumSegments;
+    if (segmentCount < sMinimumSegments) return NULL;
+
+    size_t length = sizeof(HugFingerprintHeader) + (segmentCount * sSegmentLength);
+    uint8_t *bytes = malloc(length);
+    if (!bytes) return NULL;
+
+    HugFingerprintHeader header = { sMagic, (uint16_t)segmentCount, sSegmentLength, (float)duration };
+    memcpy(bytes, &header, sizeof(header));
+
+    int8_t *values = (int8_t *)(bytes + sizeof(header));
+
+    const float *frames = HugChromaGetFrames(chroma);
+    size_t frameCount   = HugChromaGetFrameCount(chroma);
+    double frameRate    = HugChromaGetFrameRate(chroma);
+
+    for (size_t s = 0; s < segmentCount; s++) {
+        double segmentStart = startTime + (s * sSegmentDuration);
+
+        // A frame belongs to the segment holding its center
+        long first = lround(ceil((segmentStart * frameRate) - sFrameCenter));
+        long last  = lround(ceil(((segmentStart + sSegmentDuration) * frameRate) - sFrameCenter));
+
+        if (first < 0) first = 0;
+        if (last > (long)frameCount) last = (long)frameCount;
+
+        double sum[sSegmentLength] = {0};
+
+        // Each frame counts the same regardless of loudness
+        for (long f = first; f < last; f++) {
+            const float *frame = &frames[f * HugChromaBinCount];
+            double magnitudes[sSegmentLength];
+            double total = 0;
+
+            for (size_t c = 0; c < sSegmentLength; c++) {
+                magnitudes[c] = sqrt(frame[c]);
+                total += magnitudes[c];
+            }
+
+            if (!(total > 1e-6)) continue;
+
+            for (size_t c = 0; c < sSegmentLength; c++) {
+                sum[c] += magnitudes[c] / total;
+            }
+        }
+
+        double mean = 0, squares = 0;
+
+        for (size_t c = 0; c < sSegmentLength; c++) mean += sum[c];
+        mean /= sSegmentLength;
+
+        for (size_t c = 0; c < sSegmentLength; c++) {
+            sum[c] -= mean;
+            squares += sum[c] * sum[c];
+        }
+
+        double scale = squares > 0 ? (sQuantizeScale / sqrt(squares)) : 0;
+
+        for (size_t c = 0; c < sSegmentLength; c++) {
+            values[(s * sSegmentLength) + c] = (int8_t)lround(sum[c] * scale);
+        }
+    }
+
+    if (outLength) *outLength = length;
+
+    return bytes;
+}
+
+
+double HugFingerprintGetSimilarity(const void *a, size_t aLength, const void *b, size_t bLength)
+{
+    HugFingerprintView viewA, viewB;
+
+    if (!sReadView(a, aLength, &viewA) || !sReadView(b, bLength, &viewB)) return 0;
+
+    return sGetSimilarity(&viewA, &viewB);
+}
+
+
+#pragma mark - Index
+
+static void sMakeBandKeys(const HugFingerprintIndex *self, const HugFingerprintView *view, uint64_t *outKeys)
+{
+    float vector[sHashedLength] = {0};
+
+    size_t count = view->header.segmentCount * sSegmentLength;
+    if (count > sHashedLength) count = sHashedLength;
+
+    for (size_t i = 0; i < count; i++) {
+        vector[i] = view->values[i];
+    }
+
+    const float *plane = self->_planes;
+
+    for (size_t b = 0; b < sBandCount; b++) {
+        uint64_t bits = 0;
+
+        for (size_t r = 0; r < sBitsPerBand; r++, plane += sHashedLength) {
+            HugSIMDFloat sum = HugSIMDSplat(0);
+
+            for (size_t i = 0; i < sHashedLength; i += HUG_SIMD_FLOAT_LANES) {
+                sum = HugSIMDAdd(sum, HugSIMDMul(HugSIMDLoad(&plane[i]), HugSIMDLoad(&vector[i])));
+            }
+
+            bits = (bits << 1) | (HugSIMDReduceAdd(sum) >= 0);
+        }
+
+        uint64_t key = ((bits << 8) | b) * 0x9e3779b97f4a7c15ull;
+        outKeys[b] = key ^ (key >> 32);
+    }
+}
+
+
+static void sVisitCandidate(void *context, size_t other)
+{
+    HugFingerprintIndexQuery *query = context;
+    HugFingerprintIndex *self = query->index;
+
+    if (query->failed) return;
+
+    HugFingerprintIndexItem *item      = &self->_items[query->slot];
+    HugFingerprintIndexItem *otherItem = &self->_items[other];
+
+    double similarity = HugFingerprintGetSimilarity(item->bytes, item->length, otherItem->bytes, otherItem->length);
+    if (similarity < self->_threshold) return;
+
+    if (query->count == query->capacity) {
+        size_t capacity = query->capacity ? (query->capacity * 2) : 8;
+        size_t *result = realloc(query->result, capacity * sizeof(size_t));
+
+        if (!result) {
+            query->failed = true;
+            return;
+        }
+
+        query->result   = result;
+        query->capacity = capacity;
+    }
+
+    query->result[query->count++] = other;
+}
+
+
+HugFingerprintIndex *HugFingerprintIndexCreate(double threshold)
+{
+    HugFingerprintIndex *self = calloc(1, sizeof(HugFingerprintIndex));
+    if (!self) return NULL;
+
+    self->_threshold = threshold;
+    self->_table     = HugLSHTableCreate(sBandCount);
+    self->_planes    = malloc(sBandCount * sBitsPerBand * sHashedLength * sizeof(float));
+
+    if (!self->_table || !self->_planes) {
+        HugFingerprintIndexFree(self);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < sBandCount * sBitsPerBand * sHashedLength; i++) {
+        self->_planes[i] = (sMix32((uint32_t)i + 1) / (float)UINT32_MAX) - 0.5f;
+    }
+
+    return self;
+}
+
+
+void HugFingerprintIndexFree(HugFingerprintIndex *self)
+{
+    if (!self) return;
+
+    for (size_t slot = 0; slot < self->_itemCount; slot++) {
+        free(self->_items[slot].bytes);
+    }
+
+    HugLSHTableFree(self->_table);
+
+    free(self->_items);
+    free(self->_freeSlots);
+    free(self->_planes);
+    free(self);
+}
+
+
+size_t HugFingerprintIndexInsert(HugFingerprintIndex *self, const void *bytes, size_t length)
+{
+    HugFingerprintView view;
+    if (!sReadView(bytes, length, &view)) return HugFingerprintIndexNotFound;
+
+    if (!self->_freeCount && self->_itemCount == self->_itemCapacity) {
+        size_t capacity = self->_itemCapacity ? (self->_itemCapacity * 2) : 64;
+
+        HugFingerprintIndexItem *items = realloc(self->_items, capacity * sizeof(HugFingerprintIndexItem));
+        if (!items) return HugFingerprintIndexNotFound;
+        self->_items = items;
+
+        size_t *freeSlots = realloc(self->_freeSlots, capacity * sizeof(size_t));
+        if (!freeSlots) return HugFingerprintIndexNotFound;
+        self->_freeSlots = freeSlots;
+
+        self->_itemCapacity = capacity;
+    }
+
+    uint8_t *copy = malloc(length);
+    if (!copy) return HugFingerprintIndexNotFound;
+
+    memcpy(copy, bytes, length);
+
+    size_t slot = self->_freeCount ? self->_freeSlots[self->_freeCount - 1] : self->_itemCount;
+
+    uint64_t keys[sBandCount];
+    sMakeBandKeys(self, &view, keys);
+
+    if (!HugLSHTableInsert(self->_table, slot, keys)) {
+        free(copy);
+        return HugFingerprintIndexNotFound;
+    }
+
+    if (self->_freeCount) {
+        self->_freeCount--;
+    } else {
+        self->_itemCount++;
+    }
+
+    self->_items[slot] = (HugFingerprintIndexItem){ copy, length, true };
+    self->_usedCount++;
+
+    return slot;
+}
+
+
+void HugFingerprintIndexRemove(HugFingerprintIndex *self, size_t slot)
+{
+    if (slot >= self->_itemCount || !self->_items[slot].used) return;
+
+    HugFingerprintIndexItem *item = &self->_items[slot];
+
+    HugLSHTableRemove(self->_table, slot);
+
+    free(item->bytes);
+    item->bytes  = NULL;
+    item->length = 0;
+    item->used   = false;
+
+    self->_freeSlots[self->_freeCount++] = slot;
+    self->_usedCount--;
+}
+
+
+size_t HugFingerprintIndexGetCount(const HugFingerprintIndex *self)
+{
+    return self->_usedCount;
+}
+
+
+size_t *HugFingerprintIndexCopySimilar(HugFingerprintIndex *self, size_t slot, size_t *outCount)
+{
+    *outCount = 0;
+
+    if (slot >= self->_itemCount || !self->_items[slot].used) return NULL;
+
+    HugFingerprintIndexQuery query = { .index = self, .slot = slot };
+    HugLSHTableVisitCandidates(self->_table, slot, sVisitCandidate, &query);
+
+    if (query.failed) {
+        free(query.result);
+        return NULL;
+    }
+
+    *outCount = query.count;
+
+    return query.result;
+}
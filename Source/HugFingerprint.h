@@ -0,0 +1,62 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Audio fingerprints, for finding the same recording under two files (ripped
+// twice, exported from two libraries, or re-encoded).
+//
+// The audible part of a track is cut into four-second segments, starting at
+// the audible start so leading silence doesn't matter. Each segment is its
+// average chroma (see HugChroma), centered and scaled to unit length, stored
+// as twelve signed bytes. Up to 60 segments are kept, so a fingerprint is at
+// most about 730 bytes.
+//
+// Two fingerprints are the same audio when their audible durations agree
+// (within 2 seconds or 2%) and the cosine similarity of their common
+// segments reaches the index's threshold. HugFingerprintIndex finds those in
+// near-constant time with SimHash bits of the first segments, banded into LSH
+// tables.
+//
+
+#pragma once
+
+#include "HugChroma.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns NULL if the audible range is under eight seconds or memory runs out
+extern void *HugFingerprintCreateData(const HugChroma *chroma, double startTime, double endTime, size_t *outLength);
+
+// Cosine similarity of the common segments, -1 to 1. 0 if either fingerprint
+// is damaged or their durations differ.
+//
+extern double HugFingerprintGetSimilarity(const void *a, size_t aLength, const void *b, size_t bLength);
+
+
+typedef struct HugFingerprintIndex HugFingerprintIndex;
+
+#define HugFingerprintIndexNotFound ((size_t)-1)
+
+extern HugFingerprintIndex *HugFingerprintIndexCreate(double threshold);
+extern void HugFingerprintIndexFree(HugFingerprintIndex *index);
+
+// Copies the fingerprint and returns its slot, or HugFingerprintIndexNotFound
+// if it is damaged or memory runs out. Slots of removed fingerprints are reused.
+//
+extern size_t HugFingerprintIndexInsert(HugFingerprintIndex *index, const void *bytes, size_t length);
+extern void HugFingerprintIndexRemove(HugFingerprintIndex *index, size_t slot);
+
+extern size_t HugFingerprintIndexGetCount(const HugFingerprintIndex *index);
+
+// Returns a malloc'd array of the other slots with the same audio as slot,
+// or NULL if there are none.
+//
+extern size_t *HugFingerprintIndexCopySimilar(HugFingerprintIndex *index, size_t slot, size_t *outCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,197 @@
+/*
+    This file is not available under a 1-clause BSD License.
+    SPDX-License-Identifier: MIT
+
+    HugKWeighting
+    Copyright (c) 2014-2024 Ricci Adams
+
+    Heavily based on libebur128
+    Copyright (c) 2011 Jan Kokemüller
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of
+    this software and associated documentation files (the "Software"), to deal in
+    the Software without restriction, including without limitation the rights to
+    use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+    the Software, and to permit persons to whom the Software is furnished to do so,
+    subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+    FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+    COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// The BS.1770 K-weighting filter, shared by LoudnessMeasurer.c (analysis)
+// and HugLoudnessMeter.c (render thread) so that both read the same LUFS.
+//
+// Channels are filtered in groups, one channel per lane: a stereo signal
+// keeps L and R side by side in the same register. Nothing here allocates.
+//
+
+#pragma once
+
+#include "HugSIMD.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
+
+#define HUG_K_WEIGHTING_TILE_FRAMES 64
+
+
+typedef struct HugKWeightingLanes {
+    // Filter history, one column per channel: input x[n-1], x[n-2], first
+    // stage y[n-1], y[n-2] (also the input of the second stage), and second
+    // stage z[n-1], z[n-2]
+    //
+    double history[6][HUG_SIMD_DOUBLE_LANES];
+
+    // Running sum of squares of the K-weighted audio, cleared by the caller
+    double sum[HUG_SIMD_DOUBLE_LANES];
+} HugKWeightingLanes;
+
+
+// Pre-filter (high shelf) in outCoefficients[0], RLB high-pass in
+// outCoefficients[1], each as b0, b1, b2, a1, a2
+//
+static inline void HugKWeightingGetCoefficients(double sampleRate, double outCoefficients[2][5])
+{
+    double f0 = 1681.974450955533;
+    double G  =    3.999843853973347;
+    double Q  =    0.7071752369554196;
+
+    double K  = tan(M_PI * f0 / sampleRate);
+    double Vh = pow(10.0, G / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+
+    double pb[3] = {0.0,  0.0, 0.0};
+    double pa[3] = {1.0,  0.0, 0.0};
+    double rb[3] = {1.0, -2.0, 1.0};
+    double ra[3] = {1.0,  0.0, 0.0};
+
+    double a0 =      1.0 + K / Q + K * K      ;
+    pb[0] =     (Vh + Vb * K / Q + K * K) / a0;
+    pb[1] =           2.0 * (K * K -  Vh) / a0;
+    pb[2] =     (Vh - Vb * K / Q + K * K) / a0;
+    pa[1] =           2.0 * (K * K - 1.0) / a0;
+    pa[2] =         (1.0 - K / Q + K * K) / a0;
+
+    f0 = 38.13547087602444;
+    Q  =  0.5003270373238773;
+    K  = tan(M_PI * f0 / sampleRate);
+
+    ra[1] =   2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+    ra[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+
+    outCoefficients[0][0] = pb[0];
+    outCoefficients[0][1] = pb[1];
+    outCoefficients[0][2] = pb[2];
+    outCoefficients[0][3] = pa[1];
+    outCoefficients[0][4] = pa[2];
+
+    outCoefficients[1][0] = rb[0];
+    outCoefficients[1][1] = rb[1];
+    outCoefficients[1][2] = rb[2];
+    outCoefficients[1][3] = ra[1];
+    outCoefficients[1][4] = ra[2];
+}
+
+
+// Runs both stages over up to HUG_SIMD_DOUBLE_LANES channels at once and
+// adds the squared output to lanes->sum. Same recurrence and rounding as
+// HugVectorBiquadD(), the feedback terms are negated up front so that only
+// adds and multiplies are needed.
+//
+static inline void HugKWeightingFilterLanes(
+    const double coefficients[2][5],
+    HugKWeightingLanes *lanes,
+    const float * const *channels,
+    size_t laneCount,
+    size_t offset,
+    size_t frames
+) {
+#if defined(__x86_64__)
+    unsigned int mxcsr = _mm_getcsr();
+    _mm_setcsr(mxcsr | _MM_FLUSH_ZERO_ON);
+#endif
+
+    const double *p = coefficients[0];
+    const double *r = coefficients[1];
+
+    HugSIMDDouble pb0 = HugSIMDSplatD( p[0]), pb1 = HugSIMDSplatD( p[1]), pb2 = HugSIMDSplatD( p[2]);
+    HugSIMDDouble pa1 = HugSIMDSplatD(-p[3]), pa2 = HugSIMDSplatD(-p[4]);
+    HugSIMDDouble rb0 = HugSIMDSplatD( r[0]), rb1 = HugSIMDSplatD( r[1]), rb2 = HugSIMDSplatD( r[2]);
+    HugSIMDDouble ra1 = HugSIMDSplatD(-r[3]), ra2 = HugSIMDSplatD(-r[4]);
+
+    HugSIMDDouble x1 = HugSIMDLoadD(lanes->history[0]);
+    HugSIMDDouble x2 = HugSIMDLoadD(lanes->history[1]);
+    HugSIMDDouble y1 = HugSIMDLoadD(lanes->history[2]);
+    HugSIMDDouble y2 = HugSIMDLoadD(lanes->history[3]);
+    HugSIMDDouble z1 = HugSIMDLoadD(lanes->history[4]);
+    HugSIMDDouble z2 = HugSIMDLoadD(lanes->history[5]);
+
+    HugSIMDDouble sum = HugSIMDLoadD(lanes->sum);
+
+    // Frames interleaved by channel, unused lanes stay silent
+    double tile[HUG_K_WEIGHTING_TILE_FRAMES * HUG_SIMD_DOUBLE_LANES];
+    memset(tile, 0, sizeof(tile));
+
+    while (frames > 0) {
+        size_t count = frames < HUG_K_WEIGHTING_TILE_FRAMES ? frames : HUG_K_WEIGHTING_TILE_FRAMES;
+
+        for (size_t l = 0; l < laneCount; l++) {
+            const float *src = channels[l] + offset;
+
+            for (size_t i = 0; i < count; i++) {
+                tile[(i * HUG_SIMD_DOUBLE_LANES) + l] = src[i];
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            HugSIMDDouble x0 = HugSIMDLoadD(&tile[i * HUG_SIMD_DOUBLE_LANES]);
+
+            HugSIMDDouble y0 = HugSIMDMulD(pb0, x0);
+            y0 = HugSIMDAddD(y0, HugSIMDMulD(pb1, x1));
+            y0 = HugSIMDAddD(y0, HugSIMDMulD(pb2, x2));
+            y0 = HugSIMDAddD(y0, HugSIMDMulD(pa1, y1));
+            y0 = HugSIMDAddD(y0, HugSIMDMulD(pa2, y2));
+
+            HugSIMDDouble z0 = HugSIMDMulD(rb0, y0);
+            z0 = HugSIMDAddD(z0, HugSIMDMulD(rb1, y1));
+            z0 = HugSIMDAddD(z0, HugSIMDMulD(rb2, y2));
+            z0 = HugSIMDAddD(z0, HugSIMDMulD(ra1, z1));
+            z0 = HugSIMDAddD(z0, HugSIMDMulD(ra2, z2));
+
+            sum = HugSIMDAddD(sum, HugSIMDMulD(z0, z0));
+
+            x2 = x1; x1 = x0;
+            y2 = y1; y1 = y0;
+            z2 = z1; z1 = z0;
+        }
+
+        offset += count;
+        frames -= count;
+    }
+
+    HugSIMDStoreD(lanes->history[0], x1);
+    HugSIMDStoreD(lanes->history[1], x2);
+    HugSIMDStoreD(lanes->history[2], y1);
+    HugSIMDStoreD(lanes->history[3], y2);
+    HugSIMDStoreD(lanes->history[4], z1);
+    HugSIMDStoreD(lanes->history[5], z2);
+
+    HugSIMDStoreD(lanes->sum, sum);
+
+#if defined(__x86_64__)
+    _mm_setcsr(mxcsr);
+#endif
+}
@@ -0,0 +1,144 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugKey.h"
+#include "HugSIMD.h"
+
+#include <math.h>
+
+// Center of a chroma frame, in frames from its start
+#define sFrameCenter ((HugChromaFrameLength / 2.0) / HugChromaHopLength)
+
+// Two frames of chroma, a whole number of vectors for every backend
+#define sPairLength (2 * HugChromaBinCount)
+
+
+// Krumhansl and Kessler's probe-tone ratings, tonic first
+static const float sMajorProfile[HugChromaBinCount] = {
+    6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f
+};
+
+static const float sMinorProfile[HugChromaBinCount] = {
+    6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f
+};
+
+static const char *sNames[HugKeyCount] = {
+    "C",  "Db",  "D",  "Eb",  "E",  "F",  "F#",  "G",  "Ab",  "A",  "Bb",  "B",
+    "Cm", "C#m", "Dm", "Ebm", "Em", "Fm", "F#m", "Gm", "G#m", "Am", "Bbm", "Bm"
+};
+
+
+// Profiles rotated to every key, centered and scaled to unit length so that
+// a dot product with a centered unit chroma is their correlation. Stored by
+// pitch class, so one pitch class scales a row of all 24 keys.
+//
+static void sMakeProfiles(float profiles[HugChromaBinCount][HugKeyCount])
+{
+    for (unsigned int key = 0; key < HugKeyCount; key++) {
+        const float *profile = key < 12 ? sMajorProfile : sMinorProfile;
+        unsigned int tonic = key % 12;
+
+        double mean = 0, squares = 0;
+
+        for (size_t c = 0; c < HugChromaBinCount; c++) mean += profile[c];
+        mean /= HugChromaBinCount;
+
+        for (size_t c = 0; c < HugChromaBinCount; c++) squares += (profile[c] - mean) * (profile[c] - mean);
+
+        double scale = 1.0 / sqrt(squares);
+
+        for (size_t c = 0; c < HugChromaBinCount; c++) {
+            profiles[c][key] = (profile[(c + 12 - tonic) % 12] - mean) * scale;
+        }
+    }
+}
+
+
+// Sums the magnitudes of frames first through last - 1
+static void sSumMagnitudes(const float *frames, size_t first, size_t last, double outSum[HugChromaBinCount])
+{
+    float pairSum[sPairLength] = {0};
+    size_t f = first;
+
+    for ( ; f + 2 <= last; f += 2) {
+        const float *pair = &frames[f * HugChromaBinCount];
+
+        for (size_t i = 0; i < sPairLength; i += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat magnitudes = HugSIMDSqrt(HugSIMDLoad(pair + i));
+            HugSIMDStore(pairSum + i, HugSIMDAdd(HugSIMDLoad(pairSum + i), magnitudes));
+        }
+    }
+
+    for (size_t c = 0; c < HugChromaBinCount; c++) {
+        outSum[c] = (double)pairSum[c] + pairSum[c + HugChromaBinCount];
+    }
+
+    if (f < last) {
+        const float *frame = &frames[f * HugChromaBinCount];
+
+        for (size_t c = 0; c < HugChromaBinCount; c++) {
+            outSum[c] += sqrtf(frame[c]);
+        }
+    }
+}
+
+
+#pragma mark - Public Functions
+
+bool HugKeyEstimate(const HugChroma *chroma, double startTime, double endTime, unsigned int *outKey, double *outConfidence)
+{
+    double frameRate  = HugChromaGetFrameRate(chroma);
+    size_t frameCount = HugChromaGetFrameCount(chroma);
+
+    long first = lround(ceil((startTime * frameRate) - sFrameCenter));
+    long last  = lround(ceil((endTime   * frameRate) - sFrameCenter));
+
+    if (first < 0) first = 0;
+    if (last > (long)frameCount) last = (long)frameCount;
+    if (first >= last) return false;
+
+    double sum[HugChromaBinCount];
+    sSumMagnitudes(HugChromaGetFrames(chroma), first, last, sum);
+
+    double mean = 0, squares = 0;
+
+    for (size_t c = 0; c < HugChromaBinCount; c++) mean += sum[c];
+    mean /= HugChromaBinCount;
+
+    for (size_t c = 0; c < HugChromaBinCount; c++) squares += (sum[c] - mean) * (sum[c] - mean);
+
+    // Silence, or every pitch class alike
+    if (!(squares > (1e-12 * mean * mean)) || !(mean > 0)) return false;
+
+    float profiles[HugChromaBinCount][HugKeyCount];
+    sMakeProfiles(profiles);
+
+    float correlations[HugKeyCount] = {0};
+    double scale = 1.0 / sqrt(squares);
+
+    for (size_t c = 0; c < HugChromaBinCount; c++) {
+        HugSIMDFloat weight = HugSIMDSplat((sum[c] - mean) * scale);
+
+        for (size_t k = 0; k < HugKeyCount; k += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat product = HugSIMDMul(weight, HugSIMDLoad(&profiles[c][k]));
+            HugSIMDStore(&correlations[k], HugSIMDAdd(HugSIMDLoad(&correlations[k]), product));
+        }
+    }
+
+    unsigned int best = 0;
+
+    for (unsigned int k = 1; k < HugKeyCount; k++) {
+        if (correlations[k] > correlations[best]) best = k;
+    }
+
+    if (outKey)        *outKey        = best;
+    if (outConfidence) *outConfidence = correlations[best] > 0 ? correlations[best] : 0;
+
+    return true;
+}
+
+
+const char *HugKeyGetName(unsigned int key)
+{
+    return key < HugKeyCount ? sNames[key] : NULL;
+}
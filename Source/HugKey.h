@@ -0,0 +1,40 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Musical key of a track from the HugChroma frames that the loudness scan
+// already collects for the fingerprint, so no audio is transformed twice.
+//
+// The chroma magnitudes over the audible range are summed, and the sum is
+// correlated with the Krumhansl-Kessler key profiles rotated to all 24 keys.
+// The best correlation is the confidence: about 0.8 and up for music that
+// stays in its key, near 0 for noise.
+//
+
+#pragma once
+
+#include "HugChroma.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Keys are numbered by tonic pitch class, C first: 0 through 11 are major,
+// 12 through 23 the minor keys.
+//
+#define HugKeyCount 24
+
+// Uses the frames centered between startTime and endTime. Returns false if
+// there are none or they are silent.
+//
+extern bool HugKeyEstimate(const HugChroma *chroma, double startTime, double endTime, unsigned int *outKey, double *outConfidence);
+
+// Traditional name in the spelling GetTonalityForString() reads: "C", "F#",
+// "Bbm". NULL for keys out of range.
+//
+extern const char *HugKeyGetName(unsigned int key);
+
+#ifdef __cplusplus
+}
+#endif
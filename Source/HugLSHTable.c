@@ -0,0 +1,215 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugLSHTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define sMinimumTableSize 64
+#define sEmpty            UINT32_MAX
+
+
+struct HugLSHTable {
+    size_t _bandCount;
+
+    // Per slot: _bandCount keys, and the next slot in each band's bucket
+    uint64_t *_keys;
+    uint32_t *_next;
+    uint32_t *_visits;
+    bool     *_linked;
+    size_t    _slotCapacity;
+    size_t    _linkedCount;
+
+    // _bandCount tables of _tableSize heads each
+    uint32_t *_heads;
+    size_t    _tableSize;
+
+    uint32_t _visit;
+};
+
+
+static uint32_t *sGetHead(HugLSHTable *self, size_t band, uint64_t key)
+{
+    return &self->_heads[(band * self->_tableSize) + (size_t)(key & (self->_tableSize - 1))];
+}
+
+
+static void sLink(HugLSHTable *self, uint32_t slot)
+{
+    size_t bandCount = self->_bandCount;
+
+    for (size_t b = 0; b < bandCount; b++) {
+        uint32_t *head = sGetHead(self, b, self->_keys[(slot * bandCount) + b]);
+
+        self->_next[(slot * bandCount) + b] = *head;
+        *head = slot;
+    }
+}
+
+
+static void sUnlink(HugLSHTable *self, uint32_t slot)
+{
+    size_t bandCount = self->_bandCount;
+
+    for (size_t b = 0; b < bandCount; b++) {
+        uint32_t *link = sGetHead(self, b, self->_keys[(slot * bandCount) + b]);
+
+        while (*link != slot) {
+            link = &self->_next[(*link * bandCount) + b];
+        }
+
+        *link = self->_next[(slot * bandCount) + b];
+    }
+}
+
+
+static bool sResizeTables(HugLSHTable *self, size_t tableSize)
+{
+    uint32_t *heads = malloc(self->_bandCount * tableSize * sizeof(uint32_t));
+    if (!heads) return false;
+
+    memset(heads, 0xff, self->_bandCount * tableSize * sizeof(uint32_t));
+
+    free(self->_heads);
+    self->_heads     = heads;
+    self->_tableSize = tableSize;
+
+    for (size_t slot = 0; slot < self->_slotCapacity; slot++) {
+        if (self->_linked[slot]) sLink(self, (uint32_t)slot);
+    }
+
+    return true;
+}
+
+
+static bool sReserveSlot(HugLSHTable *self, size_t slot)
+{
+    if (slot < self->_slotCapacity) return true;
+    if (slot >= (sEmpty / 2)) return false;
+
+    size_t capacity = self->_slotCapacity ? self->_slotCapacity : sMinimumTableSize;
+    while (capacity <= slot) capacity *= 2;
+
+    size_t bandCount = self->_bandCount;
+
+    uint64_t *keys = realloc(self->_keys, capacity * bandCount * sizeof(uint64_t));
+    if (!keys) return false;
+    self->_keys = keys;
+
+    uint32_t *next = realloc(self->_next, capacity * bandCount * sizeof(uint32_t));
+    if (!next) return false;
+    self->_next = next;
+
+    uint32_t *visits = realloc(self->_visits, capacity * sizeof(uint32_t));
+    if (!visits) return false;
+    self->_visits = visits;
+
+    bool *linked = realloc(self->_linked, capacity * sizeof(bool));
+    if (!linked) return false;
+    self->_linked = linked;
+
+    size_t added = capacity - self->_slotCapacity;
+
+    memset(self->_visits + self->_slotCapacity, 0, added * sizeof(uint32_t));
+    memset(self->_linked + self->_slotCapacity, 0, added * sizeof(bool));
+
+    self->_slotCapacity = capacity;
+
+    return true;
+}
+
+
+#pragma mark - Lifecycle
+
+HugLSHTable *HugLSHTableCreate(size_t bandCount)
+{
+    if (!bandCount) return NULL;
+
+    HugLSHTable *self = calloc(1, sizeof(HugLSHTable));
+    if (!self) return NULL;
+
+    self->_bandCount = bandCount;
+
+    if (!sResizeTables(self, sMinimumTableSize)) {
+        HugLSHTableFree(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+void HugLSHTableFree(HugLSHTable *self)
+{
+    if (!self) return;
+
+    free(self->_keys);
+    free(self->_next);
+    free(self->_visits);
+    free(self->_linked);
+    free(self->_heads);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+bool HugLSHTableInsert(HugLSHTable *self, size_t slot, const uint64_t *keys)
+{
+    if (!sReserveSlot(self, slot)) return false;
+    if (self->_linked[slot]) return true;
+
+    if (self->_linkedCount + 1 > self->_tableSize) {
+        if (!sResizeTables(self, self->_tableSize * 2)) return false;
+    }
+
+    memcpy(&self->_keys[slot * self->_bandCount], keys, self->_bandCount * sizeof(uint64_t));
+
+    sLink(self, (uint32_t)slot);
+
+    self->_linked[slot] = true;
+    self->_linkedCount++;
+
+    return true;
+}
+
+
+void HugLSHTableRemove(HugLSHTable *self, size_t slot)
+{
+    if (slot >= self->_slotCapacity || !self->_linked[slot]) return;
+
+    sUnlink(self, (uint32_t)slot);
+
+    self->_linked[slot] = false;
+    self->_linkedCount--;
+}
+
+
+void HugLSHTableVisitCandidates(HugLSHTable *self, size_t slot, HugLSHTableVisitor visitor, void *context)
+{
+    if (slot >= self->_slotCapacity || !self->_linked[slot]) return;
+
+    // A slot is visited once even if it shares several bands
+    if (++self->_visit == 0) {
+        memset(self->_visits, 0, self->_slotCapacity * sizeof(uint32_t));
+        self->_visit = 1;
+    }
+
+    size_t bandCount = self->_bandCount;
+    const uint64_t *keys = &self->_keys[slot * bandCount];
+
+    self->_visits[slot] = self->_visit;
+
+    for (size_t b = 0; b < bandCount; b++) {
+        uint32_t other = *sGetHead(self, b, keys[b]);
+
+        for ( ; other != sEmpty; other = self->_next[(other * bandCount) + b]) {
+            if (self->_visits[other] == self->_visit) continue;
+            if (self->_keys[(other * bandCount) + b] != keys[b]) continue;
+
+            self->_visits[other] = self->_visit;
+            visitor(context, other);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Buckets for locality-sensitive hashing. Each item is linked into one
+// bucket per band by a 64-bit band key, and its candidates are the items
+// that share at least one band key with it. What the keys are (MinHash rows,
+// SimHash bits, ...) and how candidates are checked is up to the caller.
+//
+// Items are identified by slots that the caller hands out, ideally densely.
+// Not thread-safe: visiting candidates updates internal state.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugLSHTable HugLSHTable;
+
+typedef void (*HugLSHTableVisitor)(void *context, size_t slot);
+
+extern HugLSHTable *HugLSHTableCreate(size_t bandCount);
+extern void HugLSHTableFree(HugLSHTable *table);
+
+// keys holds one key per band. Returns false if memory runs out. A slot
+// that is already linked is left as it is.
+//
+extern bool HugLSHTableInsert(HugLSHTable *table, size_t slot, const uint64_t *keys);
+extern void HugLSHTableRemove(HugLSHTable *table, size_t slot);
+
+// Calls visitor once for each other slot sharing a band key with slot
+extern void HugLSHTableVisitCandidates(HugLSHTable *table, size_t slot, HugLSHTableVisitor visitor, void *context);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,46 +1,17 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import "HugLevelMeter.h"
+#include "HugLevelMeter.h"
+#include "HugVectorOps.h"
 
-#import <Accelerate/Accelerate.h>
-
-
-inline static void sGetPeak(float *samples, size_t frameCount, float *outMax, NSInteger *outMaxIndex)
-{
-    float     max      = 0;
-    NSInteger maxIndex = 0;
-
-    float bufferMax;
-    vDSP_Length bufferMaxIndex;
-    vDSP_maxvi(samples, 1, &bufferMax, &bufferMaxIndex, frameCount);
-
-    float bufferMin;
-    vDSP_Length bufferMinIndex;
-    vDSP_minvi(samples, 1, &bufferMin, &bufferMinIndex, frameCount);
-
-    if (-bufferMin > bufferMax) {
-        bufferMax = -bufferMin;
-        bufferMaxIndex = bufferMinIndex;
-    }
-    
-    if (bufferMax > max) {
-        max = bufferMax;
-        maxIndex = bufferMaxIndex;
-    }
-    
-    *outMax = max;
-    *outMaxIndex = maxIndex;
-}
+#include <math.h>
+#include <stdlib.h>
 
 
 struct HugLevelMeter {
-    size_t _maxFrameCount;
-    double _sampleRate;
-    UInt8  _averageEnabled;
-
-    float *_scratch;
-    size_t _scratchSize;
+    size_t  _maxFrameCount;
+    double  _sampleRate;
+    uint8_t _averageEnabled;
 
     double _averageLevel;
     double _peakLevel;
@@ -54,7 +25,7 @@ struct HugLevelMeter {
 
 #pragma mark - Lifecycle
 
-HugLevelMeter *HugLevelMeterCreate()
+HugLevelMeter *HugLevelMeterCreate(void)
 {
     HugLevelMeter *self = calloc(1, sizeof(HugLevelMeter));
     
@@ -68,33 +39,10 @@ void HugLevelMeterFree(HugLevelMeter *meter)
 {
     if (!meter) return;
 
-    if (meter->_scratch) {
-        free(meter->_scratch);
-    }
-
     free(meter);
 }
 
 
-#pragma mark - Private Methods
-
-static void sRemakeScratch(HugLevelMeter *self)
-{
-    size_t scratchSize = 0;
-    if (self->_averageEnabled && self->_maxFrameCount) {
-        scratchSize = sizeof(float) * self->_maxFrameCount;
-    }
-
-    if (scratchSize != self->_scratchSize) {
-        free(self->_scratch);
-        self->_scratch = scratchSize ? malloc(scratchSize) : NULL;
-        self->_scratchSize = scratchSize;
-    }
-
-    HugLevelMeterReset(self);
-}
-
-
 #pragma mark - Public Methods
 
 void HugLevelMeterReset(HugLevelMeter *self)
@@ -117,17 +65,26 @@ extern void HugLevelMeterProcess(HugLevelMeter *self, float *buffer, size_t fram
         frameCount = self->_maxFrameCount;
     }
 
-    float currentAverage;
     float currentPeak;
-    NSInteger peakIndex;
+    float currentMeanSquare = 0;
+
+    HugVectorGetMaxMagnitude(buffer, frameCount, &currentPeak, NULL);
+
+    if (self->_averageEnabled) {
+        currentMeanSquare = HugVectorGetMeanSquare(buffer, frameCount);
+    }
+
+    HugLevelMeterProcessLevels(self, frameCount, currentPeak, currentMeanSquare);
+}
 
-    sGetPeak(buffer, frameCount, &currentPeak, &peakIndex);
 
-    // Calculate RMS of scratch buffer
-    if (self->_scratch) {
-        vDSP_vsq(buffer, 1, self->_scratch, 1, frameCount);
-        vDSP_meanv(self->_scratch, 1, &currentAverage, frameCount);
-        currentAverage = sqrtf(currentAverage);
+void HugLevelMeterProcessLevels(HugLevelMeter *self, size_t frameCount, float currentPeak, float currentMeanSquare)
+{
+    float currentAverage;
+
+    // Calculate RMS of buffer
+    if (self->_averageEnabled) {
+        currentAverage = sqrtf(currentMeanSquare);
     } else {
         currentAverage = 0;
     }
@@ -177,7 +134,7 @@ extern void HugLevelMeterProcess(HugLevelMeter *self, float *buffer, size_t fram
 void HugLevelMeterSetSampleRate(HugLevelMeter *self, double sampleRate)
 {
     self->_sampleRate = sampleRate;
-    sRemakeScratch(self);
+    HugLevelMeterReset(self);
 }
 
 
@@ -190,7 +147,7 @@ double HugLevelMeterGetSampleRate(const HugLevelMeter *self)
 void HugLevelMeterSetMaxFrameCount(HugLevelMeter *self, size_t maxFrameCount)
 {
     self->_maxFrameCount = maxFrameCount;
-    sRemakeScratch(self);
+    HugLevelMeterReset(self);
 }
 
 
@@ -200,14 +157,14 @@ size_t HugLevelMeterGetMaxFrameCount(const HugLevelMeter *self)
 }
 
 
-void HugLevelMeterSetAverageEnabled(HugLevelMeter *self, UInt8 averageEnabled)
+void HugLevelMeterSetAverageEnabled(HugLevelMeter *self, uint8_t averageEnabled)
 {
     self->_averageEnabled = averageEnabled;
-    sRemakeScratch(self);
+    HugLevelMeterReset(self);
 }
 
 
-UInt8 HugLevelMeterIsAverageEnabled(const HugLevelMeter *self)
+uint8_t HugLevelMeterIsAverageEnabled(const HugLevelMeter *self)
 {
     return self->_averageEnabled > 0;
 }
@@ -1,7 +1,14 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import <Foundation/Foundation.h>
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct HugLevelMeter HugLevelMeter;
 
@@ -11,15 +18,25 @@ extern void HugLevelMeterFree(HugLevelMeter *meter);
 extern void HugLevelMeterReset(HugLevelMeter *meter);
 extern void HugLevelMeterProcess(HugLevelMeter *meter, float *buffer, size_t frameCount);
 
+// Applies the meter ballistics to levels measured elsewhere (the fused
+// kernel in HugRenderChain). currentMeanSquare is ignored unless averaging
+// is enabled.
+//
+extern void HugLevelMeterProcessLevels(HugLevelMeter *meter, size_t frameCount, float currentPeak, float currentMeanSquare);
+
 extern void HugLevelMeterSetSampleRate(HugLevelMeter *meter, double sampleRate);
 extern double HugLevelMeterGetSampleRate(const HugLevelMeter *meter);
 
 extern void HugLevelMeterSetMaxFrameCount(HugLevelMeter *meter, size_t maxFrameCount);
 extern size_t HugLevelMeterGetMaxFrameCount(const HugLevelMeter *meter);
 
-extern void HugLevelMeterSetAverageEnabled(HugLevelMeter *self, UInt8 averageEnabled);
-extern UInt8 HugLevelMeterIsAverageEnabled(const HugLevelMeter *self);
+extern void HugLevelMeterSetAverageEnabled(HugLevelMeter *self, uint8_t averageEnabled);
+extern uint8_t HugLevelMeterIsAverageEnabled(const HugLevelMeter *self);
 
 extern float HugLevelMeterGetAverageLevel(const HugLevelMeter *meter);
 extern float HugLevelMeterGetPeakLevel(const HugLevelMeter *meter);
 extern float HugLevelMeterGetHeldLevel(const HugLevelMeter *meter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,9 +1,11 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import "HugLimiter.h"
+#include "HugLimiter.h"
+#include "HugVectorOps.h"
 
-#import <Accelerate/Accelerate.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #define CHECK_RESULTS 0
 
@@ -16,20 +18,20 @@ enum {
 } HugLimiterState;
 
 struct HugLimiter {
-    NSInteger _holdTime;
-    NSInteger _decayTime;
-    NSInteger _initialDecayTime;
-    NSInteger _maxDecayTime;
+    long   _holdTime;
+    long   _decayTime;
+    long   _initialDecayTime;
+    long   _maxDecayTime;
     double _sampleRate;
 
-    NSInteger _state;
+    long   _state;
 
-    float     _lastMax;
-    float     _multiplier;
-    float     _multiplierAtDecayStart;
+    float  _lastMax;
+    float  _multiplier;
+    float  _multiplierAtDecayStart;
 
-    NSInteger _samplesHeld;
-    NSInteger _samplesDecayed;
+    long   _samplesHeld;
+    long   _samplesDecayed;
 };
 
 inline static float lerp(float v0, float v1, float t)
@@ -43,72 +45,63 @@ inline static void sApplyEnvelope(
     size_t frameCount,
     float fromMultiplier,
     float toMultiplier,
-    NSInteger toIndex)
+    size_t toIndex)
 {
     // If toIndex is specified, apply linear ramp from fromMultiplier to toMultiplier
     if (toIndex) {
         if (toIndex > frameCount) toIndex = frameCount;
     
-        for (NSInteger s = 0; s < toIndex; s++) {
+        for (size_t s = 0; s < toIndex; s++) {
             samples[s] *= lerp(fromMultiplier, toMultiplier, (s / (float)toIndex));
         }
     }
 
-    if ((frameCount - toIndex) > 0) {
-        vDSP_vsmul(samples + toIndex, 1, &toMultiplier, samples + toIndex, 1, frameCount - toIndex);
+    if (frameCount > toIndex) {
+        HugVectorMultiplyScalar(samples + toIndex, toMultiplier, samples + toIndex, frameCount - toIndex);
     }
 }
 
-inline static void sGetMax(float *samples, size_t frameCount, float *outMax, NSInteger *outMaxIndex)
+inline static void sGetStereoMax(float *left, float *right, size_t frameCount, float *outMax, size_t *outMaxIndex)
 {
-    float     max      = 0;
-    NSInteger maxIndex = 0;
+    float  leftMax      = 0;
+    size_t leftMaxIndex = 0;
 
-    float bufferMax;
-    vDSP_Length bufferMaxIndex;
-    vDSP_maxvi(samples, 1, &bufferMax, &bufferMaxIndex, frameCount);
+    float  rightMax      = 0;
+    size_t rightMaxIndex = 0;
 
-    float bufferMin;
-    vDSP_Length bufferMinIndex;
-    vDSP_minvi(samples, 1, &bufferMin, &bufferMinIndex, frameCount);
-
-    if (-bufferMin > bufferMax) {
-        bufferMax = -bufferMin;
-        bufferMaxIndex = bufferMinIndex;
-    }
-    
-    if (bufferMax > max) {
-        max = bufferMax;
-        maxIndex = bufferMaxIndex;
+    if (left)  HugVectorGetMaxMagnitude(left,  frameCount, &leftMax,  &leftMaxIndex);
+    if (right) HugVectorGetMaxMagnitude(right, frameCount, &rightMax, &rightMaxIndex);
+ 
+    if (rightMax > leftMax) {
+        leftMax      = rightMax;
+        leftMaxIndex = rightMaxIndex;
     }
     
-    *outMax = max;
-    *outMaxIndex = maxIndex;
+    *outMax      = leftMax;
+    *outMaxIndex = leftMaxIndex;
 }
 
 
-inline static void sGetStereoMax(float *left, float *right, size_t frameCount, float *outMax, NSInteger *outMaxIndex)
+// Same index HugVectorGetMaxMagnitude() would report for a buffer whose
+// peak magnitude is known: the first +peak wins over the first -peak.
+//
+static size_t sGetPeakIndex(const float *samples, size_t frameCount, float peak)
 {
-    float     leftMax      = 0;
-    NSInteger leftMaxIndex = 0;
+    if (!samples || !(peak > 0)) return 0;
 
-    float     rightMax      = 0;
-    NSInteger rightMaxIndex = 0;
+    for (size_t i = 0; i < frameCount; i++) {
+        if (samples[i] == peak) return i;
+    }
 
-    if (left)  sGetMax(left,  frameCount, &leftMax,  &leftMaxIndex);
-    if (right) sGetMax(right, frameCount, &rightMax, &rightMaxIndex);
- 
-    if (rightMax > leftMax) {
-        leftMax      = rightMax;
-        leftMaxIndex = rightMaxIndex;
+    for (size_t i = 0; i < frameCount; i++) {
+        if (samples[i] == -peak) return i;
     }
-    
-    *outMax      = leftMax;
-    *outMaxIndex = leftMaxIndex;
+
+    return 0;
 }
 
 
-inline static void sRamp(HugLimiter *self, float *left, float *right, size_t frameCount, float max, NSInteger index)
+inline static void sRamp(HugLimiter *self, float *left, float *right, size_t frameCount, float max, size_t index)
 {
     float toMultiplier = sPeakValue / max;
 
@@ -158,7 +151,7 @@ inline static void sDecay(HugLimiter *self, float *left, float *right, size_t fr
 
 #pragma mark - Lifecycle
 
-HugLimiter *HugLimiterCreate()
+HugLimiter *HugLimiterCreate(void)
 {
     HugLimiter *self = malloc(sizeof(HugLimiter));
     
@@ -194,12 +187,31 @@ void HugLimiterReset(HugLimiter *self)
 
 void HugLimiterProcess(HugLimiter *self, float *left, float *right, size_t frameCount)
 {
-    float max;
-    NSInteger maxIndex;
+    float leftPeak  = 0;
+    float rightPeak = 0;
+
+    if (left)  HugVectorGetMaxMagnitude(left,  frameCount, &leftPeak,  NULL);
+    if (right) HugVectorGetMaxMagnitude(right, frameCount, &rightPeak, NULL);
+
+    HugLimiterProcessWithPeaks(self, left, right, frameCount, leftPeak, rightPeak);
+}
+
+
+void HugLimiterProcessWithPeaks(HugLimiter *self, float *left, float *right, size_t frameCount, float leftPeak, float rightPeak)
+{
+    float  max = leftPeak;
+    size_t maxIndex;
+
+    if (rightPeak > leftPeak) {
+        max = rightPeak;
+    }
 
-    sGetStereoMax(left, right, frameCount, &max, &maxIndex);
-    
     if (max > self->_lastMax) {
+        // Only needed when ramping, which is rare; find it lazily
+        maxIndex = (rightPeak > leftPeak) ?
+            sGetPeakIndex(right, frameCount, rightPeak) :
+            sGetPeakIndex(left,  frameCount, leftPeak);
+
         self->_lastMax = max;
         sRamp(self, left, right, frameCount, max, maxIndex);
     
@@ -229,7 +241,7 @@ void HugLimiterProcess(HugLimiter *self, float *left, float *right, size_t frame
 #if CHECK_RESULTS
         sGetStereoMax(left, right, frameCount, &max, &maxIndex);
         if (max >= 1.0) {
-            NSLog(@"Still clipping after limiter");
+            fprintf(stderr, "Still clipping after limiter\n");
         }
 #endif
 }
@@ -257,7 +269,7 @@ double HugLimiterGetSampleRate(const HugLimiter *self)
 }
 
 
-BOOL HugLimiterIsActive(const HugLimiter *self)
+bool HugLimiterIsActive(const HugLimiter *self)
 {
     return self->_state != HugLimiterStateOff;
 }
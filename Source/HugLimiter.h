@@ -1,7 +1,14 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import <Foundation/Foundation.h>
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct HugLimiter HugLimiter;
 
@@ -11,7 +18,16 @@ extern void HugLimiterFree(HugLimiter *limiter);
 extern void HugLimiterReset(HugLimiter *limiter);
 extern void HugLimiterProcess(HugLimiter *self, float *left, float *right, size_t frameCount);
 
+// Same as HugLimiterProcess(), for callers that already measured each
+// channel's peak magnitude (as returned by HugVectorGetMaxMagnitude)
+//
+extern void HugLimiterProcessWithPeaks(HugLimiter *self, float *left, float *right, size_t frameCount, float leftPeak, float rightPeak);
+
 extern void HugLimiterSetSampleRate(HugLimiter *limiter, double sampleRate);
 extern double HugLimiterGetSampleRate(const HugLimiter *limiter);
 
-extern BOOL HugLimiterIsActive(const HugLimiter *limiter);
+extern bool HugLimiterIsActive(const HugLimiter *limiter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,9 +1,10 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import "HugLinearRamper.h"
+#include "HugLinearRamper.h"
+#include "HugVectorOps.h"
 
-#import <Accelerate/Accelerate.h>
+#include <stdlib.h>
 
 
 struct HugLinearRamper {
@@ -15,7 +16,7 @@ struct HugLinearRamper {
 
 #pragma mark - Lifecycle
 
-HugLinearRamper *HugLinearRamperCreate()
+HugLinearRamper *HugLinearRamperCreate(void)
 {
     HugLinearRamper *self = calloc(1, sizeof(HugLinearRamper));
     return self;
@@ -49,28 +50,18 @@ void HugLinearRamperProcess(HugLinearRamper *self, float *left, float *right, si
 
     // Fast path, level is the same as previous
     if (level == previousLevel) {
-        if (left)  vDSP_vsmul(left,  1, &level, left,  1, frameCount);
-        if (right) vDSP_vsmul(right, 1, &level, right, 1, frameCount);
+        if (left)  HugVectorMultiplyScalar(left,  level, left,  frameCount);
+        if (right) HugVectorMultiplyScalar(right, level, right, frameCount);
 
     // Slower path, we need to calculate envelope from previousLevel -> level and apply
     } else {
-        // scratch = linspace(0, 1, frameCount) 
-        for (NSInteger i = 0; i < frameCount; i++) {
-            scratch[i] = (float)i;
-        }
-
+        // scratch = (linspace(0, 1, frameCount) * (level - previousLevel)) + previousLevel
         float a = 1.0 / ((float)frameCount - 1);
-        vDSP_vsmul(scratch, 1, &a, scratch, 1, frameCount);
-
-        // scratch *= (level - previousLevel)
         float b = (level - previousLevel);
-        vDSP_vsmul(scratch, 1, &b, scratch, 1, frameCount);
+        HugVectorFillRamp(scratch, a, b, previousLevel, frameCount);
 
-        // scratch += previousLevel
-        vDSP_vsadd(scratch, 1, &previousLevel, scratch, 1, frameCount);
-
-        if (left)  vDSP_vmul(left,  1, scratch, 1, left,  1, frameCount);
-        if (right) vDSP_vmul(right, 1, scratch, 1, right, 1, frameCount);
+        if (left)  HugVectorMultiply(left,  scratch, left,  frameCount);
+        if (right) HugVectorMultiply(right, scratch, right, frameCount);
     }
     
     self->_previousLevel = level;
@@ -92,3 +83,9 @@ size_t HugLinearRamperGetMaxFrameCount(HugLinearRamper *self)
 {
     return self->_maxFrameCount;
 }
+
+
+float HugLinearRamperGetLevel(const HugLinearRamper *self)
+{
+    return self->_previousLevel;
+}
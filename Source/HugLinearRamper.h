@@ -1,7 +1,13 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import <Foundation/Foundation.h>
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct HugLinearRamper HugLinearRamper;
 
@@ -13,3 +19,10 @@ extern size_t HugLinearRamperGetMaxFrameCount(HugLinearRamper *ramper);
 
 extern void HugLinearRamperReset(HugLinearRamper *ramper, float level);
 void HugLinearRamperProcess(HugLinearRamper *self, float *left, float *right, size_t frameCount, float level);
+
+// Level reached at the end of the last processed block
+extern float HugLinearRamperGetLevel(const HugLinearRamper *ramper);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,361 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugLookaheadLimiter.h"
+#include "HugVectorOps.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Same ceiling as HugLimiter
+static float sPeakValue = 1.0 - (2.0 / 32767.0);
+
+static const double sMinLookaheadTime     = 0.001;
+static const double sMaxLookaheadTime     = 0.005;
+static const double sDefaultLookaheadTime = 0.002;
+
+// Time for the gain to recover from full attenuation back to unity
+static const double sReleaseTime = 0.1;
+
+
+struct HugLookaheadLimiter {
+    double _sampleRate;
+    double _lookaheadTime;
+
+    size_t _latency;
+    size_t _maxLatency;
+
+    // Delay lines, _latency frames each
+    float *_leftDelay;
+    float *_rightDelay;
+    size_t _delayIndex;
+
+    // Monotonic deque of (frame, peak) pairs for the overs in the last
+    // _latency + 1 frames. Peaks decrease from front to back, so the front
+    // is the window max.
+    float    *_dequePeaks;
+    uint64_t *_dequeFrames;
+    size_t    _dequeMask;
+    size_t    _dequeFront;
+    size_t    _dequeCount;
+
+    // Moving average of the required gain over _latency frames
+    float  *_requiredGains;
+    double  _requiredSum;
+    size_t  _requiredIndex;
+
+    uint64_t _frame;
+    float    _gain;
+    float    _releaseStep;
+};
+
+
+static void sFreeBuffers(HugLookaheadLimiter *self)
+{
+    free(self->_leftDelay);
+    free(self->_rightDelay);
+    free(self->_dequePeaks);
+    free(self->_dequeFrames);
+    free(self->_requiredGains);
+
+    self->_leftDelay     = NULL;
+    self->_rightDelay    = NULL;
+    self->_dequePeaks    = NULL;
+    self->_dequeFrames   = NULL;
+    self->_requiredGains = NULL;
+}
+
+
+static size_t sGetFrameCount(double sampleRate, double time)
+{
+    size_t frameCount = (size_t)(sampleRate * time + 0.5);
+    return frameCount ? frameCount : 1;
+}
+
+
+inline static float sAbs(float x)
+{
+    return x < 0 ? -x : x;
+}
+
+
+// Exchanges frameCount samples with the delay line starting at delayIndex.
+// A NULL channel feeds silence into the delay line.
+//
+static void sSwapDelay(float *delay, float *samples, size_t frameCount, size_t delayIndex, size_t latency)
+{
+    while (frameCount) {
+        size_t run = latency - delayIndex;
+        if (run > frameCount) run = frameCount;
+
+        float *d = delay + delayIndex;
+
+        if (samples) {
+            for (size_t i = 0; i < run; i++) {
+                float delayed = d[i];
+                d[i] = samples[i];
+                samples[i] = delayed;
+            }
+
+            samples += run;
+
+        } else {
+            for (size_t i = 0; i < run; i++) {
+                d[i] = 0;
+            }
+        }
+
+        frameCount -= run;
+        delayIndex = 0;
+    }
+}
+
+
+#pragma mark - Lifecycle
+
+HugLookaheadLimiter *HugLookaheadLimiterCreate(void)
+{
+    HugLookaheadLimiter *self = calloc(1, sizeof(HugLookaheadLimiter));
+
+    self->_lookaheadTime = sDefaultLookaheadTime;
+    self->_gain = 1.0;
+
+    return self;
+}
+
+
+void HugLookaheadLimiterFree(HugLookaheadLimiter *self)
+{
+    if (!self) return;
+
+    sFreeBuffers(self);
+    free(self);
+}
+
+
+#pragma mark - Public Methods
+
+void HugLookaheadLimiterReset(HugLookaheadLimiter *self)
+{
+    self->_latency = 0;
+    self->_frame = 0;
+    self->_gain = 1.0;
+
+    self->_delayIndex    = 0;
+    self->_dequeFront    = 0;
+    self->_dequeCount    = 0;
+    self->_requiredIndex = 0;
+
+    if (!self->_maxLatency) return;
+
+    size_t latency = sGetFrameCount(self->_sampleRate, self->_lookaheadTime);
+    if (latency > self->_maxLatency) latency = self->_maxLatency;
+
+    memset(self->_leftDelay,  0, sizeof(float) * latency);
+    memset(self->_rightDelay, 0, sizeof(float) * latency);
+
+    for (size_t i = 0; i < latency; i++) {
+        self->_requiredGains[i] = 1.0;
+    }
+
+    self->_requiredSum = latency;
+    self->_latency = latency;
+}
+
+
+void HugLookaheadLimiterProcess(HugLookaheadLimiter *self, float *left, float *right, size_t frameCount)
+{
+    float leftPeak  = 0;
+    float rightPeak = 0;
+
+    if (left)  HugVectorGetMaxMagnitude(left,  frameCount, &leftPeak,  NULL);
+    if (right) HugVectorGetMaxMagnitude(right, frameCount, &rightPeak, NULL);
+
+    HugLookaheadLimiterProcessWithPeaks(self, left, right, frameCount, leftPeak, rightPeak);
+}
+
+
+void HugLookaheadLimiterProcessWithPeaks(HugLookaheadLimiter *self, float *left, float *right, size_t frameCount, float leftPeak, float rightPeak)
+{
+    size_t latency = self->_latency;
+    if (!latency) return;
+
+    // Nothing over the ceiling in this block or the window before it, and no
+    // reduction left to release: the per-frame path would output the delayed
+    // input at unity gain, so skip straight to that.
+    //
+    bool isIdle = !self->_dequeCount && (self->_gain == 1.0f) && (self->_requiredSum == (double)latency);
+
+    if (isIdle && leftPeak <= sPeakValue && rightPeak <= sPeakValue) {
+        sSwapDelay(self->_leftDelay,  left,  frameCount, self->_delayIndex, latency);
+        sSwapDelay(self->_rightDelay, right, frameCount, self->_delayIndex, latency);
+
+        self->_delayIndex    = (self->_delayIndex    + frameCount) % latency;
+        self->_requiredIndex = (self->_requiredIndex + frameCount) % latency;
+        self->_frame += frameCount;
+
+        return;
+    }
+
+    float    *leftDelay     = self->_leftDelay;
+    float    *rightDelay    = self->_rightDelay;
+    float    *requiredGains = self->_requiredGains;
+    float    *dequePeaks    = self->_dequePeaks;
+    uint64_t *dequeFrames   = self->_dequeFrames;
+
+    size_t dequeMask     = self->_dequeMask;
+    size_t dequeFront    = self->_dequeFront;
+    size_t dequeCount    = self->_dequeCount;
+    size_t delayIndex    = self->_delayIndex;
+    size_t requiredIndex = self->_requiredIndex;
+    double requiredSum   = self->_requiredSum;
+
+    uint64_t frame       = self->_frame;
+    double averageScale  = 1.0 / latency;
+    float  releaseStep   = self->_releaseStep;
+    float  gain          = self->_gain;
+
+    for (size_t i = 0; i < frameCount; i++, frame++) {
+        float l = left  ? left[i]  : 0;
+        float r = right ? right[i] : 0;
+
+        float peak = sAbs(l) > sAbs(r) ? sAbs(l) : sAbs(r);
+
+        // Only overs can change the required gain, so only they enter the
+        // deque. Anything no longer able to be the window max is dropped.
+        //
+        if (peak > sPeakValue) {
+            while (dequeCount && dequePeaks[(dequeFront + dequeCount - 1) & dequeMask] <= peak) {
+                dequeCount--;
+            }
+
+            size_t back = (dequeFront + dequeCount) & dequeMask;
+            dequePeaks[back]  = peak;
+            dequeFrames[back] = frame;
+            dequeCount++;
+        }
+
+        // At most one entry leaves the window per frame
+        if (dequeCount && (dequeFrames[dequeFront] + latency < frame)) {
+            dequeFront = (dequeFront + 1) & dequeMask;
+            dequeCount--;
+        }
+
+        // Gain needed for every frame in the window [frame - latency, frame].
+        // Averaging it over the next latency frames gives a ramp that reaches
+        // the required level by the time the peak leaves the delay line.
+        //
+        float required = dequeCount ? (sPeakValue / dequePeaks[dequeFront]) : 1.0f;
+
+        requiredSum += (double)required - requiredGains[requiredIndex];
+        requiredGains[requiredIndex] = required;
+
+        if (++requiredIndex == latency) {
+            requiredIndex = 0;
+
+            // Re-sum once per window so rounding never accumulates
+            requiredSum = 0;
+            for (size_t j = 0; j < latency; j++) requiredSum += requiredGains[j];
+        }
+
+        float smoothed = requiredSum * averageScale;
+        float released = gain + releaseStep;
+        if (released > 1.0f) released = 1.0f;
+
+        gain = smoothed < released ? smoothed : released;
+
+        float delayedL = leftDelay[delayIndex];
+        float delayedR = rightDelay[delayIndex];
+
+        leftDelay[delayIndex]  = l;
+        rightDelay[delayIndex] = r;
+
+        if (++delayIndex == latency) delayIndex = 0;
+
+        // The moving average can only round above the required gain
+        float delayedPeak = sAbs(delayedL) > sAbs(delayedR) ? sAbs(delayedL) : sAbs(delayedR);
+        float outputGain  = gain;
+
+        if (delayedPeak * outputGain > sPeakValue) {
+            outputGain = sPeakValue / delayedPeak;
+        }
+
+        if (left)  left[i]  = delayedL * outputGain;
+        if (right) right[i] = delayedR * outputGain;
+    }
+
+    self->_dequeFront    = dequeFront;
+    self->_dequeCount    = dequeCount;
+    self->_delayIndex    = delayIndex;
+    self->_requiredIndex = requiredIndex;
+    self->_requiredSum   = requiredSum;
+    self->_frame         = frame;
+    self->_gain          = gain;
+}
+
+
+#pragma mark - Accessors
+
+void HugLookaheadLimiterSetSampleRate(HugLookaheadLimiter *self, double sampleRate)
+{
+    sFreeBuffers(self);
+
+    self->_sampleRate  = sampleRate;
+    self->_maxLatency  = 0;
+    self->_releaseStep = 1.0;
+
+    if (sampleRate > 0) {
+        size_t maxLatency = sGetFrameCount(sampleRate, sMaxLookaheadTime);
+
+        size_t dequeCapacity = 1;
+        while (dequeCapacity < maxLatency + 2) dequeCapacity <<= 1;
+
+        self->_leftDelay     = calloc(maxLatency, sizeof(float));
+        self->_rightDelay    = calloc(maxLatency, sizeof(float));
+        self->_requiredGains = calloc(maxLatency, sizeof(float));
+        self->_dequePeaks    = calloc(dequeCapacity, sizeof(float));
+        self->_dequeFrames   = calloc(dequeCapacity, sizeof(uint64_t));
+        self->_dequeMask     = dequeCapacity - 1;
+
+        self->_maxLatency  = maxLatency;
+        self->_releaseStep = 1.0 / (sampleRate * sReleaseTime);
+    }
+
+    HugLookaheadLimiterReset(self);
+}
+
+
+double HugLookaheadLimiterGetSampleRate(const HugLookaheadLimiter *self)
+{
+    return self->_sampleRate;
+}
+
+
+void HugLookaheadLimiterSetLookaheadTime(HugLookaheadLimiter *self, double lookaheadTime)
+{
+    if (lookaheadTime < sMinLookaheadTime) lookaheadTime = sMinLookaheadTime;
+    if (lookaheadTime > sMaxLookaheadTime) lookaheadTime = sMaxLookaheadTime;
+
+    self->_lookaheadTime = lookaheadTime;
+
+    HugLookaheadLimiterReset(self);
+}
+
+
+double HugLookaheadLimiterGetLookaheadTime(const HugLookaheadLimiter *self)
+{
+    return self->_lookaheadTime;
+}
+
+
+size_t HugLookaheadLimiterGetLatency(const HugLookaheadLimiter *self)
+{
+    return self->_latency;
+}
+
+
+bool HugLookaheadLimiterIsActive(const HugLookaheadLimiter *self)
+{
+    return self->_gain < 1.0f;
+}
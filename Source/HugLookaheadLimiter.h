@@ -0,0 +1,50 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Sample-accurate brickwall limiter. Input is delayed by the look-ahead
+// time (1-5 ms) so that gain reduction can ramp in before each peak
+// instead of after it. The window peak comes from a monotonic deque,
+// so detection is amortized O(1) per sample regardless of block size.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugLookaheadLimiter HugLookaheadLimiter;
+
+extern HugLookaheadLimiter *HugLookaheadLimiterCreate(void);
+extern void HugLookaheadLimiterFree(HugLookaheadLimiter *limiter);
+
+// Clears the delay line and gain state, the next Process() starts with silence
+extern void HugLookaheadLimiterReset(HugLookaheadLimiter *limiter);
+
+// Either channel may be NULL
+extern void HugLookaheadLimiterProcess(HugLookaheadLimiter *limiter, float *left, float *right, size_t frameCount);
+
+// Same as HugLookaheadLimiterProcess(), for callers that already measured
+// each channel's peak magnitude. Blocks without overs take a fast path.
+//
+extern void HugLookaheadLimiterProcessWithPeaks(HugLookaheadLimiter *limiter, float *left, float *right, size_t frameCount, float leftPeak, float rightPeak);
+
+// Allocates the delay line, call before processing
+extern void HugLookaheadLimiterSetSampleRate(HugLookaheadLimiter *limiter, double sampleRate);
+extern double HugLookaheadLimiterGetSampleRate(const HugLookaheadLimiter *limiter);
+
+// Clamped to 1-5 ms, defaults to 2 ms. Resets the limiter.
+extern void HugLookaheadLimiterSetLookaheadTime(HugLookaheadLimiter *limiter, double lookaheadTime);
+extern double HugLookaheadLimiterGetLookaheadTime(const HugLookaheadLimiter *limiter);
+
+// Added latency, in frames
+extern size_t HugLookaheadLimiterGetLatency(const HugLookaheadLimiter *limiter);
+
+extern bool HugLookaheadLimiterIsActive(const HugLookaheadLimiter *limiter);
+
+#ifdef __cplusplus
+}
+#endif
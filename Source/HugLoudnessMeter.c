@@ -0,0 +1,180 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugLoudnessMeter.h"
+#include "HugKWeighting.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Enough lane groups for two channels with any backend
+#define sGroupCount ((2 + HUG_SIMD_DOUBLE_LANES - 1) / HUG_SIMD_DOUBLE_LANES)
+
+// Blocks in a short-term (3s) window
+#define sBlockCount 30
+
+
+struct HugLoudnessMeter {
+    double _sampleRate;
+    double _coefficients[2][5];
+
+    HugKWeightingLanes _lanes[sGroupCount];
+
+    size_t _framesPerBlock;
+    size_t _blockFrames;
+
+    // Energies of the last sBlockCount 100ms blocks, summed across channels
+    double _blocks[sBlockCount];
+    size_t _blockIndex;
+
+    float _momentaryLoudness;
+    float _shortTermLoudness;
+};
+
+
+static float sGetLoudness(const HugLoudnessMeter *self, size_t blockCount)
+{
+    if (self->_blockIndex < blockCount) {
+        return -HUGE_VALF;
+    }
+
+    double energy = 0;
+
+    for (size_t i = self->_blockIndex - blockCount; i < self->_blockIndex; i++) {
+        energy += self->_blocks[i % sBlockCount];
+    }
+
+    energy /= (double)(self->_framesPerBlock * blockCount);
+
+    return 10 * log10(energy) - 0.691;
+}
+
+
+static void sFinishBlock(HugLoudnessMeter *self, size_t channelCount)
+{
+    double energy = 0;
+
+    for (size_t c = 0; c < channelCount; c++) {
+        energy += self->_lanes[c / HUG_SIMD_DOUBLE_LANES].sum[c % HUG_SIMD_DOUBLE_LANES];
+    }
+
+    for (size_t g = 0; g < sGroupCount; g++) {
+        memset(self->_lanes[g].sum, 0, sizeof(self->_lanes[g].sum));
+    }
+
+    self->_blocks[self->_blockIndex % sBlockCount] = energy;
+    self->_blockIndex++;
+
+    self->_momentaryLoudness = sGetLoudness(self, 4);
+    self->_shortTermLoudness = sGetLoudness(self, sBlockCount);
+}
+
+
+#pragma mark - Lifecycle
+
+HugLoudnessMeter *HugLoudnessMeterCreate(void)
+{
+    HugLoudnessMeter *self = calloc(1, sizeof(HugLoudnessMeter));
+
+    HugLoudnessMeterReset(self);
+
+    return self;
+}
+
+
+void HugLoudnessMeterFree(HugLoudnessMeter *meter)
+{
+    if (!meter) return;
+
+    free(meter);
+}
+
+
+#pragma mark - Public Methods
+
+void HugLoudnessMeterReset(HugLoudnessMeter *self)
+{
+    memset(self->_lanes,  0, sizeof(self->_lanes));
+    memset(self->_blocks, 0, sizeof(self->_blocks));
+
+    self->_blockFrames = 0;
+    self->_blockIndex  = 0;
+
+    self->_momentaryLoudness = -HUGE_VALF;
+    self->_shortTermLoudness = -HUGE_VALF;
+}
+
+
+void HugLoudnessMeterProcess(HugLoudnessMeter *self, const float *left, const float *right, size_t frameCount)
+{
+    if (!self->_framesPerBlock) return;
+
+    const float *channels[2] = { left, right };
+    size_t channelCount = 2;
+
+    if (!left)  { channels[0] = right; channelCount--; }
+    if (!right) { channelCount--; }
+
+    if (!channelCount) return;
+
+    size_t offset = 0;
+
+    while (offset < frameCount) {
+        size_t frames = self->_framesPerBlock - self->_blockFrames;
+        if (frames > frameCount - offset) frames = frameCount - offset;
+
+        for (size_t g = 0; g < sGroupCount; g++) {
+            size_t firstChannel = g * HUG_SIMD_DOUBLE_LANES;
+            if (firstChannel >= channelCount) break;
+
+            size_t laneCount = channelCount - firstChannel;
+            if (laneCount > HUG_SIMD_DOUBLE_LANES) laneCount = HUG_SIMD_DOUBLE_LANES;
+
+            HugKWeightingFilterLanes(self->_coefficients, &self->_lanes[g], channels + firstChannel, laneCount, offset, frames);
+        }
+
+        self->_blockFrames += frames;
+        offset += frames;
+
+        if (self->_blockFrames == self->_framesPerBlock) {
+            sFinishBlock(self, channelCount);
+            self->_blockFrames = 0;
+        }
+    }
+}
+
+
+#pragma mark - Accessors
+
+void HugLoudnessMeterSetSampleRate(HugLoudnessMeter *self, double sampleRate)
+{
+    self->_sampleRate = sampleRate;
+
+    if (sampleRate > 0) {
+        HugKWeightingGetCoefficients(sampleRate, self->_coefficients);
+        self->_framesPerBlock = (sampleRate + 5) / 10;
+    } else {
+        self->_framesPerBlock = 0;
+    }
+
+    HugLoudnessMeterReset(self);
+}
+
+
+double HugLoudnessMeterGetSampleRate(const HugLoudnessMeter *self)
+{
+    return self->_sampleRate;
+}
+
+
+float HugLoudnessMeterGetMomentaryLoudness(const HugLoudnessMeter *self)
+{
+    return self->_momentaryLoudness;
+}
+
+
+float HugLoudnessMeterGetShortTermLoudness(const HugLoudnessMeter *self)
+{
+    return self->_shortTermLoudness;
+}
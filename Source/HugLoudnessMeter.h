@@ -0,0 +1,37 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Momentary (400ms) and short-term (3s) loudness of the output, measured on
+// the render thread. All state is allocated up front; processing only
+// filters into the current 100ms block and updates both readouts when it
+// completes.
+//
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugLoudnessMeter HugLoudnessMeter;
+
+extern HugLoudnessMeter *HugLoudnessMeterCreate(void);
+extern void HugLoudnessMeterFree(HugLoudnessMeter *meter);
+
+extern void HugLoudnessMeterReset(HugLoudnessMeter *meter);
+
+// right may be NULL for a mono buffer
+extern void HugLoudnessMeterProcess(HugLoudnessMeter *meter, const float *left, const float *right, size_t frameCount);
+
+extern void HugLoudnessMeterSetSampleRate(HugLoudnessMeter *meter, double sampleRate);
+extern double HugLoudnessMeterGetSampleRate(const HugLoudnessMeter *meter);
+
+// LUFS, -HUGE_VALF until 400ms / 3s have been processed
+extern float HugLoudnessMeterGetMomentaryLoudness(const HugLoudnessMeter *meter);
+extern float HugLoudnessMeterGetShortTermLoudness(const HugLoudnessMeter *meter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,12 +2,7 @@
 // MIT License (or) 1-clause BSD License
 
 #import <Foundation/Foundation.h>
-
-typedef struct HugMeterDataStruct {
-    float peakLevel;
-    float heldLevel;
-    BOOL  limiterActive;
-} HugMeterDataStruct;
+#import "HugRenderChain.h"
 
 
 @interface HugMeterData : NSObject
@@ -18,5 +13,9 @@ typedef struct HugMeterDataStruct {
 @property (nonatomic, readonly) float heldLevel;
 @property (nonatomic, readonly, getter=isLimiterActive) BOOL limiterActive;
 
+// LUFS of both channels together, -HUGE_VALF until enough has played
+@property (nonatomic, readonly) float momentaryLoudness;
+@property (nonatomic, readonly) float shortTermLoudness;
+
 @end
 
@@ -12,6 +12,9 @@
         _peakLevel = meterData.peakLevel;
         _heldLevel = meterData.heldLevel;
         _limiterActive = meterData.limiterActive;
+
+        _momentaryLoudness = meterData.momentaryLoudness;
+        _shortTermLoudness = meterData.shortTermLoudness;
     }
     
     return self;
@@ -22,7 +25,9 @@
 {
     return [@(_peakLevel) hash] ^
            [@(_heldLevel) hash] ^
-           [@(_limiterActive) hash];
+           [@(_limiterActive) hash] ^
+           [@(_momentaryLoudness) hash] ^
+           [@(_shortTermLoudness) hash];
 }
 
 
@@ -34,9 +39,11 @@
     
     HugMeterData *otherData = (HugMeterData *)otherObject;
     
-    return _peakLevel     == otherData->_peakLevel &&
-           _heldLevel     == otherData->_heldLevel &&
-           _limiterActive == otherData->_limiterActive;
+    return _peakLevel         == otherData->_peakLevel &&
+           _heldLevel         == otherData->_heldLevel &&
+           _limiterActive     == otherData->_limiterActive &&
+           _momentaryLoudness == otherData->_momentaryLoudness &&
+           _shortTermLoudness == otherData->_shortTermLoudness;
 
 }
 
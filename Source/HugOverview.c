@@ -0,0 +1,355 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugOverview.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sMagic 0x32564F48 // 'HOV2'
+
+#define sStepsPerDecibel 2
+#define sFloorDecibels   -96
+#define sCeilingDecibels 6
+#define sMaxLevel        ((sCeilingDecibels - sFloorDecibels) * sStepsPerDecibel)
+
+#define sGroupLength  32
+#define sFieldCount   3
+
+
+typedef struct {
+    uint32_t magic;
+    uint16_t channelCount;
+    uint16_t stepsPerDecibel;
+    uint32_t binCount;
+    float    binRate;
+} HugOverviewHeader;
+
+
+struct HugOverview {
+    size_t          _channelCount;
+    size_t          _binCount;
+    double          _binRate;
+    HugOverviewBin *_bins;
+};
+
+
+typedef struct {
+    uint8_t *bytes;
+    size_t   length;
+    size_t   capacity;
+} HugOverviewWriter;
+
+
+#pragma mark - Quantization
+
+static int32_t sGetCode(float value)
+{
+    float magnitude = fabsf(value);
+    if (!(magnitude > 0)) return 0;
+
+    long level = lrintf((20.0f * log10f(magnitude) - sFloorDecibels) * sStepsPerDecibel);
+
+    if (level < 1)         return 0;
+    if (level > sMaxLevel) level = sMaxLevel;
+
+    return value < 0 ? -(int32_t)level : (int32_t)level;
+}
+
+
+static float sGetValue(int32_t code)
+{
+    if (!code) return 0;
+
+    int32_t level = code < 0 ? -code : code;
+    float magnitude = powf(10.0f, ((level / (float)sStepsPerDecibel) + sFloorDecibels) / 20.0f);
+
+    return code < 0 ? -magnitude : magnitude;
+}
+
+
+static float sGetField(const HugOverviewBin *bin, size_t field)
+{
+    return field == 0 ? bin->min : (field == 1 ? bin->max : bin->rms);
+}
+
+
+static void sSetField(HugOverviewBin *bin, size_t field, float value)
+{
+    if      (field == 0) bin->min = value;
+    else if (field == 1) bin->max = value;
+    else                 bin->rms = value;
+}
+
+
+#pragma mark - Packing
+
+static bool sWriterReserve(HugOverviewWriter *writer, size_t length)
+{
+    if (writer->length + length <= writer->capacity) return true;
+
+    size_t capacity = writer->capacity * 2;
+    if (capacity < writer->length + length) capacity = writer->length + length;
+
+    uint8_t *bytes = realloc(writer->bytes, capacity);
+    if (!bytes) return false;
+
+    writer->bytes    = bytes;
+    writer->capacity = capacity;
+
+    return true;
+}
+
+
+static bool sWriteGroup(HugOverviewWriter *writer, const uint32_t *values, size_t count)
+{
+    uint32_t all = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        all |= values[i];
+    }
+
+    uint8_t width = 0;
+    while (all >> width) width++;
+
+    size_t packedLength = ((count * width) + 7) / 8;
+    if (!sWriterReserve(writer, 1 + packedLength)) return false;
+
+    uint8_t *out = writer->bytes + writer->length;
+
+    *out++ = width;
+    memset(out, 0, packedLength);
+
+    size_t bit = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t b = 0; b < width; b++, bit++) {
+            if ((values[i] >> b) & 1) out[bit / 8] |= (1 << (bit % 8));
+        }
+    }
+
+    writer->length += 1 + packedLength;
+
+    return true;
+}
+
+
+// Returns the number of bytes read, 0 if the group is damaged
+static size_t sReadGroup(const uint8_t *bytes, size_t length, uint32_t *outValues, size_t count)
+{
+    if (length < 1) return 0;
+
+    uint8_t width = bytes[0];
+    if (width > 32) return 0;
+
+    size_t packedLength = ((count * width) + 7) / 8;
+    if (length < 1 + packedLength) return 0;
+
+    const uint8_t *in = bytes + 1;
+    size_t bit = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value = 0;
+
+        for (size_t b = 0; b < width; b++, bit++) {
+            value |= (uint32_t)((in[bit / 8] >> (bit % 8)) & 1) << b;
+        }
+
+        outValues[i] = value;
+    }
+
+    return 1 + packedLength;
+}
+
+
+static uint32_t sZigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+
+static int32_t sUnzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+
+#pragma mark - Lifecycle
+
+void *HugOverviewCreateData(const HugOverviewBin *bins, size_t channelCount, size_t binCount, double binRate, size_t *outLength)
+{
+    if (!channelCount || channelCount > UINT16_MAX || binCount > UINT32_MAX) return NULL;
+
+    HugOverviewWriter writer = {0};
+
+    HugOverviewHeader header = {
+        sMagic, (uint16_t)channelCount, sStepsPerDecibel, (uint32_t)binCount, (float)binRate
+    };
+
+    if (!sWriterReserve(&writer, sizeof(header) + (binCount * channelCount))) {
+        return NULL;
+    }
+
+    memcpy(writer.bytes, &header, sizeof(header));
+    writer.length = sizeof(header);
+
+    bool ok = true;
+
+    for (size_t c = 0; ok && c < channelCount; c++) {
+        for (size_t field = 0; ok && field < sFieldCount; field++) {
+            int32_t  previous = 0;
+            uint32_t group[sGroupLength];
+            size_t   groupCount = 0;
+
+            for (size_t i = 0; ok && i < binCount; i++) {
+                int32_t code = sGetCode(sGetField(&bins[(i * channelCount) + c], field));
+
+                group[groupCount++] = sZigzag(code - previous);
+                previous = code;
+
+                if (groupCount == sGroupLength) {
+                    ok = sWriteGroup(&writer, group, groupCount);
+                    groupCount = 0;
+                }
+            }
+
+            if (ok && groupCount) {
+                ok = sWriteGroup(&writer, group, groupCount);
+            }
+        }
+    }
+
+    if (!ok) {
+        free(writer.bytes);
+        return NULL;
+    }
+
+    if (outLength) *outLength = writer.length;
+
+    return writer.bytes;
+}
+
+
+HugOverview *HugOverviewCreate(const void *bytes, size_t length)
+{
+    HugOverviewHeader header;
+
+    if (!bytes || length < sizeof(header)) return NULL;
+    memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic != sMagic || header.stepsPerDecibel != sStepsPerDecibel) return NULL;
+    if (!header.channelCount || !(header.binRate > 0)) return NULL;
+
+    size_t channelCount = header.channelCount;
+    size_t binCount     = header.binCount;
+
+    // Every group has at least its width byte
+    size_t groupCount = (binCount + sGroupLength - 1) / sGroupLength;
+    if (groupCount * channelCount * sFieldCount > length - sizeof(header)) return NULL;
+
+    HugOverview *self = calloc(1, sizeof(HugOverview));
+    if (!self) return NULL;
+
+    self->_channelCount = channelCount;
+    self->_binCount     = binCount;
+    self->_binRate      = header.binRate;
+    self->_bins         = calloc((binCount * channelCount) + 1, sizeof(HugOverviewBin));
+
+    if (!self->_bins) {
+        HugOverviewFree(self);
+        return NULL;
+    }
+
+    const uint8_t *in = (const uint8_t *)bytes + sizeof(header);
+    size_t remaining = length - sizeof(header);
+
+    for (size_t c = 0; c < channelCount; c++) {
+        for (size_t field = 0; field < sFieldCount; field++) {
+            int32_t code = 0;
+
+            for (size_t i = 0; i < binCount; i += sGroupLength) {
+                uint32_t group[sGroupLength];
+                size_t count = binCount - i;
+                if (count > sGroupLength) count = sGroupLength;
+
+                size_t read = sReadGroup(in, remaining, group, count);
+
+                if (!read) {
+                    HugOverviewFree(self);
+                    return NULL;
+                }
+
+                in        += read;
+                remaining -= read;
+
+                for (size_t g = 0; g < count; g++) {
+                    code += sUnzigzag(group[g]);
+                    if (code > sMaxLevel || code < -sMaxLevel) code = 0;
+
+                    sSetField(&self->_bins[((i + g) * channelCount) + c], field, sGetValue(code));
+                }
+            }
+        }
+    }
+
+    return self;
+}
+
+
+void HugOverviewFree(HugOverview *self)
+{
+    if (!self) return;
+
+    free(self->_bins);
+    free(self);
+}
+
+
+#pragma mark - Accessors
+
+size_t HugOverviewGetChannelCount(const HugOverview *self)
+{
+    return self->_channelCount;
+}
+
+
+size_t HugOverviewGetBinCount(const HugOverview *self)
+{
+    return self->_binCount;
+}
+
+
+double HugOverviewGetBinRate(const HugOverview *self)
+{
+    return self->_binRate;
+}
+
+
+const HugOverviewBin *HugOverviewGetBins(const HugOverview *self)
+{
+    return self->_bins;
+}
+
+
+void HugOverviewGetPeaks(const HugOverview *self, uint8_t *outPeaks)
+{
+    size_t channelCount = self->_channelCount;
+
+    for (size_t i = 0; i < self->_binCount; i++) {
+        const HugOverviewBin *bins = &self->_bins[i * channelCount];
+        float peak = 0;
+
+        for (size_t c = 0; c < channelCount; c++) {
+            if ( bins[c].max > peak) peak =  bins[c].max;
+            if (-bins[c].min > peak) peak = -bins[c].min;
+        }
+
+        float value = floorf(peak * 255.0f);
+
+        if (value > 255) value = 255;
+        if (value < 0)   value = 0;
+
+        outPeaks[i] = (uint8_t)value;
+    }
+}
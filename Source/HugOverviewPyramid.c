@@ -0,0 +1,231 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugOverviewPyramid.h"
+
+#include <math.h>
+#include <string.h>
+
+#define sMaxLevelCount 32
+
+// Levels 1 and 2 aren't stored: below 16 samples per output, reading the
+// samples themselves is as quick and halves the size of the pyramid
+#define sFirstShift 3
+
+// Followed by each stored level: n mins, then n maxes. The first has a cell
+// for every 2^sFirstShift samples, each after that halves the one before.
+typedef struct {
+    uint32_t sampleCount;
+    uint32_t levelCount;
+} HugOverviewPyramidHeader;
+
+
+static size_t sGetFirstCount(size_t sampleCount)
+{
+    return ((sampleCount - 1) >> sFirstShift) + 1;
+}
+
+
+// Fills the arrays with level 0 (the samples) and each stored level
+static size_t sGetLevels(
+    const HugOverviewPyramidHeader *header, const uint8_t *samples,
+    const uint8_t **outMins, const uint8_t **outMaxes, size_t *outShifts
+) {
+    const uint8_t *cells = (const uint8_t *)(header + 1);
+    size_t levelCount = header->levelCount;
+    size_t n = sGetFirstCount(header->sampleCount);
+
+    outMins[0]   = samples;
+    outMaxes[0]  = samples;
+    outShifts[0] = 0;
+
+    for (size_t k = 1; k <= levelCount; k++) {
+        outMins[k]   = cells;
+        outMaxes[k]  = cells + n;
+        outShifts[k] = sFirstShift + (k - 1);
+
+        cells += n * 2;
+        n = (n + 1) / 2;
+    }
+
+    return levelCount + 1;
+}
+
+
+#pragma mark - Public Functions
+
+size_t HugOverviewPyramidGetSize(size_t sampleCount)
+{
+    if (!sampleCount || sampleCount > UINT32_MAX) return 0;
+
+    size_t result = sizeof(HugOverviewPyramidHeader);
+
+    for (size_t n = sGetFirstCount(sampleCount); ; n = (n + 1) / 2) {
+        result += n * 2;
+        if (n == 1) break;
+    }
+
+    return result;
+}
+
+
+void HugOverviewPyramidBuild(const uint8_t *samples, size_t sampleCount, void *outPyramid)
+{
+    if (!HugOverviewPyramidGetSize(sampleCount)) return;
+
+    HugOverviewPyramidHeader *header = outPyramid;
+
+    uint8_t *outMins  = (uint8_t *)(header + 1);
+    size_t   outCount = sGetFirstCount(sampleCount);
+    uint8_t *outMaxes = outMins + outCount;
+
+    for (size_t i = 0; i < outCount; i++) {
+        size_t a = i << sFirstShift;
+        size_t b = a + (1 << sFirstShift);
+        if (b > sampleCount) b = sampleCount;
+
+        uint8_t minValue = UINT8_MAX;
+        uint8_t maxValue = 0;
+
+        for (size_t j = a; j < b; j++) {
+            if (samples[j] < minValue) minValue = samples[j];
+            if (samples[j] > maxValue) maxValue = samples[j];
+        }
+
+        outMins[i]  = minValue;
+        outMaxes[i] = maxValue;
+    }
+
+    size_t levelCount = 1;
+
+    while (outCount > 1) {
+        const uint8_t *inMins  = outMins;
+        const uint8_t *inMaxes = outMaxes;
+        size_t inCount = outCount;
+
+        outMins  = outMaxes + inCount;
+        outCount = (inCount + 1) / 2;
+        outMaxes = outMins + outCount;
+
+        for (size_t i = 0; i < inCount / 2; i++) {
+            uint8_t minA = inMins[i * 2],  minB = inMins[i * 2 + 1];
+            uint8_t maxA = inMaxes[i * 2], maxB = inMaxes[i * 2 + 1];
+
+            outMins[i]  = minA < minB ? minA : minB;
+            outMaxes[i] = maxA > maxB ? maxA : maxB;
+        }
+
+        // An odd cell out moves up unchanged
+        if (inCount & 1) {
+            outMins[outCount - 1]  = inMins[inCount - 1];
+            outMaxes[outCount - 1] = inMaxes[inCount - 1];
+        }
+
+        levelCount++;
+    }
+
+    header->sampleCount = (uint32_t)sampleCount;
+    header->levelCount  = (uint32_t)levelCount;
+}
+
+
+bool HugOverviewPyramidReduce(
+    const void *pyramid,
+    const uint8_t *samples, size_t sampleCount,
+    double start, double stop,
+    size_t outCount, uint8_t *outMin, uint8_t *outMax
+) {
+    const HugOverviewPyramidHeader *header = pyramid;
+
+    if (!header || !samples || header->sampleCount != sampleCount) {
+        return false;
+    }
+
+    if (start < 0) start = 0;
+    if (stop > sampleCount) stop = sampleCount;
+
+    if (stop <= start || !outCount) {
+        if (outMin) memset(outMin, 0, outCount);
+        if (outMax) memset(outMax, 0, outCount);
+        return true;
+    }
+
+    double stride = (stop - start) / outCount;
+
+    // Zoomed in past one sample per output, interpolate between samples
+    if (stride < 1) {
+        for (size_t o = 0; o < outCount; o++) {
+            double x = start + (o + 0.5) * stride - 0.5;
+
+            if (x < 0) x = 0;
+            if (x > sampleCount - 1) x = sampleCount - 1;
+
+            size_t i = (size_t)x;
+            size_t j = (i + 1 < sampleCount) ? (i + 1) : i;
+            double t = x - i;
+
+            uint8_t value = (uint8_t)lrint(samples[i] + t * (samples[j] - samples[i]));
+
+            if (outMin) outMin[o] = value;
+            if (outMax) outMax[o] = value;
+        }
+
+        return true;
+    }
+
+    const uint8_t *mins[sMaxLevelCount + 1];
+    const uint8_t *maxes[sMaxLevelCount + 1];
+    size_t shifts[sMaxLevelCount + 1];
+
+    size_t levelCount = sGetLevels(header, samples, mins, maxes, shifts);
+
+    // Use the highest level with at least two cells per output
+    size_t level = 0;
+    while ((level + 1) < levelCount && (2ull << shifts[level + 1]) <= stride) {
+        level++;
+    }
+
+    const uint8_t *levelMins  = mins[level];
+    const uint8_t *levelMaxes = maxes[level];
+    size_t shift = shifts[level];
+
+    double cellsPerOutput = stride / (1ull << shift);
+    double firstCell      = start / (1ull << shift);
+    size_t cellCount      = ((sampleCount - 1) >> shift) + 1;
+
+    size_t c0 = (size_t)lrint(firstCell);
+    if (c0 >= cellCount) c0 = cellCount - 1;
+
+    for (size_t o = 0; o < outCount; o++) {
+        size_t c1 = (size_t)lrint(firstCell + (o + 1) * cellsPerOutput);
+
+        if (c1 > cellCount) c1 = cellCount;
+        if (c1 <= c0) c1 = (c0 < cellCount) ? (c0 + 1) : c0;
+
+        size_t c = (c0 < cellCount) ? c0 : (cellCount - 1);
+
+        if (outMin) {
+            uint8_t minValue = levelMins[c];
+
+            for (size_t i = c + 1; i < c1; i++) {
+                if (levelMins[i] < minValue) minValue = levelMins[i];
+            }
+
+            outMin[o] = minValue;
+        }
+
+        if (outMax) {
+            uint8_t maxValue = levelMaxes[c];
+
+            for (size_t i = c + 1; i < c1; i++) {
+                if (levelMaxes[i] > maxValue) maxValue = levelMaxes[i];
+            }
+
+            outMax[o] = maxValue;
+        }
+
+        c0 = c1;
+    }
+
+    return true;
+}
@@ -0,0 +1,48 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Min/max pyramid over a track's overview (one byte per 10 ms). Level k holds
+// the minimum and maximum of each run of 2^k samples, from runs of 8 upward;
+// the samples themselves are level 0 and are not copied. The pyramid is plain
+// bytes, about half the size of the overview, built once when the
+// overview arrives so it can be kept in an NSData next to it.
+//
+// Reducing a range to any width reads at most sixteen cells of a single level
+// for each output value and never allocates.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the pyramid for sampleCount samples, 0 if there is nothing to build
+extern size_t HugOverviewPyramidGetSize(size_t sampleCount);
+
+// outPyramid must hold HugOverviewPyramidGetSize(sampleCount) bytes
+extern void HugOverviewPyramidBuild(const uint8_t *samples, size_t sampleCount, void *outPyramid);
+
+// Reduces samples [start, stop) to outCount values, the minimum and maximum
+// of each (stop - start) / outCount samples. Edges are snapped to the cells
+// of the level used, which moves them by at most a quarter of an output (or
+// half a sample); every sample still lands in exactly one output. When there
+// are fewer samples than outputs, they are linearly interpolated instead.
+// Either output may be NULL.
+//
+// Returns false if the pyramid wasn't built from sampleCount samples.
+//
+extern bool HugOverviewPyramidReduce(
+    const void *pyramid,
+    const uint8_t *samples, size_t sampleCount,
+    double start, double stop,
+    size_t outCount, uint8_t *outMin, uint8_t *outMax
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,699 @@
+// (c) 2018-2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugRenderChain.h"
+
+#include "HugFastUtils.h"
+#include "HugLevelMeter.h"
+#include "HugLimiter.h"
+#include "HugLinearRamper.h"
+#include "HugLookaheadLimiter.h"
+#include "HugLoudnessMeter.h"
+#include "HugSIMD.h"
+#include "HugStereoField.h"
+#include "HugStereoFieldKernels.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+
+struct HugRenderChain {
+    double _sampleRate;
+    size_t _maxFrameCount;
+    size_t _meterFrameCount;
+
+    HugFadeCurve _fadeCurve;
+    HugLimiterMode _limiterMode;
+
+    HugLimiter          *_emergencyLimiter;
+    HugLookaheadLimiter *_lookaheadLimiter;
+    HugStereoField      *_stereoField;
+    HugLevelMeter       *_leftLevelMeter;
+    HugLevelMeter       *_rightLevelMeter;
+    HugLoudnessMeter    *_loudnessMeter;
+    HugLinearRamper     *_preGainRamper;
+    HugLinearRamper     *_volumeRamper;
+};
+
+
+// Everything the fused kernel needs to reproduce the separate
+// HugStereoField, HugLinearRamper, HugLevelMeter and HugLimiter passes
+//
+typedef struct {
+    bool  applySource;
+    bool  applyOutput;
+    bool  measureAverage;
+
+    int   widthStage;
+    int   balanceStage;
+    float stereoStep;
+    float fromWidth;
+    float toWidth;
+    float fromBalance;
+    float toBalance;
+
+    float fromPreGain;
+    float preGainStep;
+    float preGainDelta;
+
+    float fromVolume;
+    float volumeStep;
+    float volumeDelta;
+} RenderKernelParameters;
+
+typedef struct {
+    float leftMin,  leftMax;
+    float rightMin, rightMax;
+    float leftSumOfSquares;
+    float rightSumOfSquares;
+} RenderKernelLevels;
+
+typedef void (*RenderKernel)(
+    const RenderKernelParameters *p,
+    float *left, float *right,
+    size_t start, size_t end,
+    RenderKernelLevels *outLevels
+);
+
+
+static float sClamp(float value)
+{
+    if (value < -1.0f) value = -1.0f;
+    if (value >  1.0f) value =  1.0f;
+
+    return value;
+}
+
+
+// Matches HugVectorGetMaxMagnitude()
+static float sGetPeak(float min, float max)
+{
+    float target = max;
+    if (-min > max) target = min;
+    if (target < 0) target = -target;
+
+    return target > 0 ? target : 0;
+}
+
+
+static void sMakeParameters(
+    HugRenderChain *self, RenderKernelParameters *p, size_t frameCount,
+    bool applySource, float preGain, float stereoBalance, float stereoWidth,
+    bool applyOutput, float volume
+) {
+    p->applySource = applySource;
+    p->applyOutput = applyOutput;
+
+    p->measureAverage = applyOutput &&
+        (HugLevelMeterIsAverageEnabled(self->_leftLevelMeter) || HugLevelMeterIsAverageEnabled(self->_rightLevelMeter));
+
+    // Same (i * step) * delta interpolation as HugLinearRamper, so that
+    // results stay bit-identical with the standalone kernels.
+    float rampStep = 1.0 / ((float)frameCount - 1);
+
+    if (applySource) {
+        float previousWidth   = HugStereoFieldGetWidth(self->_stereoField);
+        float previousBalance = HugStereoFieldGetBalance(self->_stereoField);
+        float previousPreGain = HugLinearRamperGetLevel(self->_preGainRamper);
+
+        stereoBalance = sClamp(stereoBalance);
+        stereoWidth   = sClamp(stereoWidth);
+
+        p->widthStage   = HugStereoFieldGetStage(previousWidth,   stereoWidth,   1.0f);
+        p->balanceStage = HugStereoFieldGetStage(previousBalance, stereoBalance, 0.0f);
+        p->stereoStep   = HugStereoFieldGetRampStep(frameCount);
+        p->fromWidth    = previousWidth;
+        p->toWidth      = stereoWidth;
+        p->fromBalance  = previousBalance;
+        p->toBalance    = stereoBalance;
+
+        p->fromPreGain  = previousPreGain;
+        p->preGainStep  = (preGain == previousPreGain) ? 0 : rampStep;
+        p->preGainDelta = (preGain == previousPreGain) ? 0 : (preGain - previousPreGain);
+    }
+
+    if (applyOutput) {
+        float previousVolume = HugLinearRamperGetLevel(self->_volumeRamper);
+
+        p->fromVolume  = previousVolume;
+        p->volumeStep  = (volume == previousVolume) ? 0 : rampStep;
+        p->volumeDelta = (volume == previousVolume) ? 0 : (volume - previousVolume);
+    }
+}
+
+
+static void sCommitParameters(HugRenderChain *self, const RenderKernelParameters *p, float preGain, float volume)
+{
+    if (p->applySource) {
+        HugStereoFieldReset(self->_stereoField, p->toBalance, p->toWidth);
+        HugLinearRamperReset(self->_preGainRamper, preGain);
+    }
+
+    if (p->applyOutput) {
+        HugLinearRamperReset(self->_volumeRamper, volume);
+    }
+}
+
+
+// Single pass over [start, end): stereo width -> balance -> pre-gain ramp ->
+// volume ramp -> min/max/sum-of-squares for the meters and limiter.
+// Specialized below for each width/balance stage.
+//
+HUG_SIMD_ALWAYS_INLINE void sProcessChunk(
+    const RenderKernelParameters *p,
+    float *left, float *right,
+    size_t start, size_t end,
+    RenderKernelLevels *outLevels,
+    const int widthStage, const int balanceStage
+) {
+    const bool applySource = p->applySource;
+    const bool applyOutput = p->applyOutput;
+
+    float myWidth, otherWidth;
+    HugStereoFieldGetWidthGains(p->toWidth, &myWidth, &otherWidth);
+
+    float leftBalance, rightBalance;
+    HugStereoFieldGetBalanceGains(p->toBalance, &leftBalance, &rightBalance);
+
+    size_t i = start;
+
+    HugSIMDFloat vLeftMin  = HugSIMDSplat( INFINITY), vLeftMax  = HugSIMDSplat(-INFINITY);
+    HugSIMDFloat vRightMin = HugSIMDSplat( INFINITY), vRightMax = HugSIMDSplat(-INFINITY);
+    HugSIMDFloat vLeftSum  = HugSIMDSplat(0),         vRightSum = HugSIMDSplat(0);
+
+    {
+        const HugSIMDFloat vLanes = HugSIMDSplat(HUG_SIMD_FLOAT_LANES);
+
+        HugSIMDFloat vIndex = HugSIMDAdd(HugSIMDIota(), HugSIMDSplat((float)start));
+
+        for ( ; i + HUG_SIMD_FLOAT_LANES <= end; i += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat l = HugSIMDLoad(left  + i);
+            HugSIMDFloat r = HugSIMDLoad(right + i);
+            HugSIMDFloat t = HugSIMDMul(vIndex, HugSIMDSplat(p->stereoStep));
+
+            if (widthStage != HugStereoFieldStageOff) {
+                HugSIMDFloat vMy    = HugSIMDSplat(myWidth);
+                HugSIMDFloat vOther = HugSIMDSplat(otherWidth);
+
+                if (widthStage == HugStereoFieldStageRamp) {
+                    HugStereoFieldGetWidthGainsSIMD(HugStereoFieldLerpSIMD(p->fromWidth, p->toWidth, t), &vMy, &vOther);
+                }
+
+                HugSIMDFloat newL = HugSIMDAdd(HugSIMDMul(l, vMy), HugSIMDMul(r, vOther));
+                HugSIMDFloat newR = HugSIMDAdd(HugSIMDMul(r, vMy), HugSIMDMul(l, vOther));
+
+                l = newL;
+                r = newR;
+            }
+
+            if (balanceStage != HugStereoFieldStageOff) {
+                HugSIMDFloat vLeft  = HugSIMDSplat(leftBalance);
+                HugSIMDFloat vRight = HugSIMDSplat(rightBalance);
+
+                if (balanceStage == HugStereoFieldStageRamp) {
+                    HugStereoFieldGetBalanceGainsSIMD(HugStereoFieldLerpSIMD(p->fromBalance, p->toBalance, t), &vLeft, &vRight);
+                }
+
+                l = HugSIMDMul(l, vLeft);
+                r = HugSIMDMul(r, vRight);
+            }
+
+            if (applySource) {
+                HugSIMDFloat gain = HugSIMDAdd(
+                    HugSIMDMul(HugSIMDMul(vIndex, HugSIMDSplat(p->preGainStep)), HugSIMDSplat(p->preGainDelta)),
+                    HugSIMDSplat(p->fromPreGain)
+                );
+
+                l = HugSIMDMul(l, gain);
+                r = HugSIMDMul(r, gain);
+            }
+
+            if (applyOutput) {
+                HugSIMDFloat gain = HugSIMDAdd(
+                    HugSIMDMul(HugSIMDMul(vIndex, HugSIMDSplat(p->volumeStep)), HugSIMDSplat(p->volumeDelta)),
+                    HugSIMDSplat(p->fromVolume)
+                );
+
+                l = HugSIMDMul(l, gain);
+                r = HugSIMDMul(r, gain);
+
+                vLeftMin  = HugSIMDMin(vLeftMin,  l);
+                vLeftMax  = HugSIMDMax(vLeftMax,  l);
+                vRightMin = HugSIMDMin(vRightMin, r);
+                vRightMax = HugSIMDMax(vRightMax, r);
+
+                if (p->measureAverage) {
+                    vLeftSum  = HugSIMDAdd(vLeftSum,  HugSIMDMul(l, l));
+                    vRightSum = HugSIMDAdd(vRightSum, HugSIMDMul(r, r));
+                }
+            }
+
+            HugSIMDStore(left  + i, l);
+            HugSIMDStore(right + i, r);
+
+            vIndex = HugSIMDAdd(vIndex, vLanes);
+        }
+    }
+
+    float leftMin  = HugSIMDReduceMin(vLeftMin),  leftMax  = HugSIMDReduceMax(vLeftMax);
+    float rightMin = HugSIMDReduceMin(vRightMin), rightMax = HugSIMDReduceMax(vRightMax);
+    float leftSum  = HugSIMDReduceAdd(vLeftSum),  rightSum = HugSIMDReduceAdd(vRightSum);
+
+    for ( ; i < end; i++) {
+        float l = left[i];
+        float r = right[i];
+        float t = (float)i * p->stereoStep;
+
+        if (widthStage != HugStereoFieldStageOff) {
+            float my    = myWidth;
+            float other = otherWidth;
+
+            if (widthStage == HugStereoFieldStageRamp) {
+                HugStereoFieldGetWidthGains(HugStereoFieldLerp(p->fromWidth, p->toWidth, t), &my, &other);
+            }
+
+            float newL = (l * my) + (r * other);
+            float newR = (r * my) + (l * other);
+
+            l = newL;
+            r = newR;
+        }
+
+        if (balanceStage != HugStereoFieldStageOff) {
+            float leftGain  = leftBalance;
+            float rightGain = rightBalance;
+
+            if (balanceStage == HugStereoFieldStageRamp) {
+                HugStereoFieldGetBalanceGains(HugStereoFieldLerp(p->fromBalance, p->toBalance, t), &leftGain, &rightGain);
+            }
+
+            l *= leftGain;
+            r *= rightGain;
+        }
+
+        if (applySource) {
+            float gain = (((float)i * p->preGainStep) * p->preGainDelta) + p->fromPreGain;
+
+            l *= gain;
+            r *= gain;
+        }
+
+        if (applyOutput) {
+            float gain = (((float)i * p->volumeStep) * p->volumeDelta) + p->fromVolume;
+
+            l *= gain;
+            r *= gain;
+
+            if (l < leftMin)  leftMin  = l;
+            if (l > leftMax)  leftMax  = l;
+            if (r < rightMin) rightMin = r;
+            if (r > rightMax) rightMax = r;
+
+            leftSum  += l * l;
+            rightSum += r * r;
+        }
+
+        left[i]  = l;
+        right[i] = r;
+    }
+
+    outLevels->leftMin  = leftMin;
+    outLevels->leftMax  = leftMax;
+    outLevels->rightMin = rightMin;
+    outLevels->rightMax = rightMax;
+    outLevels->leftSumOfSquares  = leftSum;
+    outLevels->rightSumOfSquares = rightSum;
+}
+
+
+#define sDefineKernel(W, B) \
+    static void sProcessChunk_##W##_##B( \
+        const RenderKernelParameters *p, \
+        float *left, float *right, \
+        size_t start, size_t end, \
+        RenderKernelLevels *outLevels \
+    ) { \
+        sProcessChunk(p, left, right, start, end, outLevels, HugStereoFieldStage##W, HugStereoFieldStage##B); \
+    }
+
+sDefineKernel(Off,    Off)
+sDefineKernel(Off,    Steady)
+sDefineKernel(Off,    Ramp)
+sDefineKernel(Steady, Off)
+sDefineKernel(Steady, Steady)
+sDefineKernel(Steady, Ramp)
+sDefineKernel(Ramp,   Off)
+sDefineKernel(Ramp,   Steady)
+sDefineKernel(Ramp,   Ramp)
+
+
+// Indexed by [widthStage][balanceStage]
+static const RenderKernel sKernels[HugStereoFieldStageCount][HugStereoFieldStageCount] = {
+    { sProcessChunk_Off_Off,    sProcessChunk_Off_Steady,    sProcessChunk_Off_Ramp    },
+    { sProcessChunk_Steady_Off, sProcessChunk_Steady_Steady, sProcessChunk_Steady_Ramp },
+    { sProcessChunk_Ramp_Off,   sProcessChunk_Ramp_Steady,   sProcessChunk_Ramp_Ramp   }
+};
+
+
+static void sApplyLimiter(HugRenderChain *self, float *left, float *right, size_t frameCount, float leftPeak, float rightPeak)
+{
+    if (self->_limiterMode == HugLimiterModeLookahead) {
+        HugLookaheadLimiterProcessWithPeaks(self->_lookaheadLimiter, left, right, frameCount, leftPeak, rightPeak);
+    } else {
+        HugLimiterProcessWithPeaks(self->_emergencyLimiter, left, right, frameCount, leftPeak, rightPeak);
+    }
+}
+
+
+static bool sIsLimiterActive(const HugRenderChain *self)
+{
+    if (self->_limiterMode == HugLimiterModeLookahead) {
+        return HugLookaheadLimiterIsActive(self->_lookaheadLimiter);
+    } else {
+        return HugLimiterIsActive(self->_emergencyLimiter);
+    }
+}
+
+
+// Loudness covers both channels, so both carry the same readouts
+static void sSetLoudness(const HugRenderChain *self, HugMeterDataStruct *leftMeterData, HugMeterDataStruct *rightMeterData)
+{
+    leftMeterData->momentaryLoudness = HugLoudnessMeterGetMomentaryLoudness(self->_loudnessMeter);
+    leftMeterData->shortTermLoudness = HugLoudnessMeterGetShortTermLoudness(self->_loudnessMeter);
+
+    rightMeterData->momentaryLoudness = leftMeterData->momentaryLoudness;
+    rightMeterData->shortTermLoudness = leftMeterData->shortTermLoudness;
+}
+
+
+static void sProcessFused(
+    HugRenderChain *self,
+    const RenderKernelParameters *p,
+    float *left, float *right, size_t frameCount,
+    HugRenderChainMeterCallback meterCallback, void *context
+) {
+    size_t meterFrameCount = self->_meterFrameCount;
+    size_t offset = 0;
+
+    RenderKernel kernel = sKernels[p->widthStage][p->balanceStage];
+
+    while (offset < frameCount) {
+        size_t framesToProcess = frameCount - offset;
+        if (framesToProcess > meterFrameCount) framesToProcess = meterFrameCount;
+
+        RenderKernelLevels levels;
+        kernel(p, left, right, offset, offset + framesToProcess, &levels);
+
+        if (p->applyOutput) {
+            float leftPeak  = sGetPeak(levels.leftMin,  levels.leftMax);
+            float rightPeak = sGetPeak(levels.rightMin, levels.rightMax);
+
+            HugLevelMeterProcessLevels(self->_leftLevelMeter,  framesToProcess, leftPeak,  levels.leftSumOfSquares  / (float)framesToProcess);
+            HugLevelMeterProcessLevels(self->_rightLevelMeter, framesToProcess, rightPeak, levels.rightSumOfSquares / (float)framesToProcess);
+
+            sApplyLimiter(self, left + offset, right + offset, framesToProcess, leftPeak, rightPeak);
+
+            HugLoudnessMeterProcess(self->_loudnessMeter, left + offset, right + offset, framesToProcess);
+
+            if (meterCallback) {
+                HugMeterDataStruct leftMeterData  = {0};
+                HugMeterDataStruct rightMeterData = {0};
+
+                leftMeterData.peakLevel  = HugLevelMeterGetPeakLevel(self->_leftLevelMeter);
+                leftMeterData.heldLevel  = HugLevelMeterGetHeldLevel(self->_leftLevelMeter);
+                rightMeterData.peakLevel = HugLevelMeterGetPeakLevel(self->_rightLevelMeter);
+                rightMeterData.heldLevel = HugLevelMeterGetHeldLevel(self->_rightLevelMeter);
+
+                leftMeterData.limiterActive  = sIsLimiterActive(self);
+                rightMeterData.limiterActive = leftMeterData.limiterActive;
+
+                sSetLoudness(self, &leftMeterData, &rightMeterData);
+
+                meterCallback(context, offset, &leftMeterData, &rightMeterData);
+            }
+        }
+
+        offset += framesToProcess;
+    }
+}
+
+
+// Separate passes through each kernel, used for mono buffers
+static void sProcessOutputUnfused(
+    HugRenderChain *self,
+    float *left, float *right, size_t frameCount,
+    float volume,
+    HugRenderChainMeterCallback meterCallback, void *context
+) {
+    size_t meterFrameCount = self->_meterFrameCount;
+
+    HugLinearRamperProcess(self->_volumeRamper, left, right, frameCount, volume);
+
+    size_t offset = 0;
+
+    while (offset < frameCount) {
+        size_t framesToProcess = frameCount - offset;
+        if (framesToProcess > meterFrameCount) framesToProcess = meterFrameCount;
+
+        float *leftChunk  = left  ? left  + offset : NULL;
+        float *rightChunk = right ? right + offset : NULL;
+
+        HugMeterDataStruct leftMeterData  = {0};
+        HugMeterDataStruct rightMeterData = {0};
+
+        if (leftChunk) {
+            HugLevelMeterProcess(self->_leftLevelMeter, leftChunk, framesToProcess);
+
+            leftMeterData.peakLevel = HugLevelMeterGetPeakLevel(self->_leftLevelMeter);
+            leftMeterData.heldLevel = HugLevelMeterGetHeldLevel(self->_leftLevelMeter);
+        }
+
+        if (rightChunk) {
+            HugLevelMeterProcess(self->_rightLevelMeter, rightChunk, framesToProcess);
+
+            rightMeterData.peakLevel = HugLevelMeterGetPeakLevel(self->_rightLevelMeter);
+            rightMeterData.heldLevel = HugLevelMeterGetHeldLevel(self->_rightLevelMeter);
+        }
+
+        if (self->_limiterMode == HugLimiterModeLookahead) {
+            HugLookaheadLimiterProcess(self->_lookaheadLimiter, leftChunk, rightChunk, framesToProcess);
+        } else {
+            HugLimiterProcess(self->_emergencyLimiter, leftChunk, rightChunk, framesToProcess);
+        }
+
+        HugLoudnessMeterProcess(self->_loudnessMeter, leftChunk, rightChunk, framesToProcess);
+
+        leftMeterData.limiterActive  = sIsLimiterActive(self);
+        rightMeterData.limiterActive = leftMeterData.limiterActive;
+
+        sSetLoudness(self, &leftMeterData, &rightMeterData);
+
+        if (meterCallback) {
+            meterCallback(context, offset, &leftMeterData, &rightMeterData);
+        }
+
+        offset += framesToProcess;
+    }
+}
+
+
+#pragma mark - Lifecycle
+
+HugRenderChain *HugRenderChainCreate(void)
+{
+    HugRenderChain *self = calloc(1, sizeof(HugRenderChain));
+
+    self->_stereoField      = HugStereoFieldCreate();
+    self->_preGainRamper    = HugLinearRamperCreate();
+    self->_volumeRamper     = HugLinearRamperCreate();
+    self->_leftLevelMeter   = HugLevelMeterCreate();
+    self->_rightLevelMeter  = HugLevelMeterCreate();
+    self->_loudnessMeter    = HugLoudnessMeterCreate();
+    self->_emergencyLimiter = HugLimiterCreate();
+    self->_lookaheadLimiter = HugLookaheadLimiterCreate();
+
+    return self;
+}
+
+
+void HugRenderChainFree(HugRenderChain *self)
+{
+    if (!self) return;
+
+    HugStereoFieldFree(self->_stereoField);
+    HugLinearRamperFree(self->_preGainRamper);
+    HugLinearRamperFree(self->_volumeRamper);
+    HugLevelMeterFree(self->_leftLevelMeter);
+    HugLevelMeterFree(self->_rightLevelMeter);
+    HugLoudnessMeterFree(self->_loudnessMeter);
+    HugLimiterFree(self->_emergencyLimiter);
+    HugLookaheadLimiterFree(self->_lookaheadLimiter);
+
+    free(self);
+}
+
+
+#pragma mark - Public Methods
+
+void HugRenderChainConfigure(HugRenderChain *self, double sampleRate, size_t maxFrameCount)
+{
+    self->_sampleRate    = sampleRate;
+    self->_maxFrameCount = maxFrameCount;
+
+    HugLevelMeterSetSampleRate(self->_leftLevelMeter, sampleRate);
+    HugLevelMeterSetSampleRate(self->_rightLevelMeter, sampleRate);
+    HugLoudnessMeterSetSampleRate(self->_loudnessMeter, sampleRate);
+    HugLimiterSetSampleRate(self->_emergencyLimiter, sampleRate);
+    HugLookaheadLimiterSetSampleRate(self->_lookaheadLimiter, sampleRate);
+
+    HugLinearRamperSetMaxFrameCount(self->_preGainRamper, maxFrameCount);
+    HugLinearRamperSetMaxFrameCount(self->_volumeRamper, maxFrameCount);
+    HugStereoFieldSetMaxFrameCount(self->_stereoField, maxFrameCount);
+
+    size_t meterFrameCount = maxFrameCount < 1024 ? maxFrameCount : 1024;
+    HugLevelMeterSetMaxFrameCount(self->_leftLevelMeter, meterFrameCount);
+    HugLevelMeterSetMaxFrameCount(self->_rightLevelMeter, meterFrameCount);
+
+    self->_meterFrameCount = meterFrameCount;
+}
+
+
+void HugRenderChainReset(HugRenderChain *self, float preGain, float volume, float stereoBalance, float stereoWidth)
+{
+    HugLinearRamperReset(self->_preGainRamper, preGain);
+    HugLinearRamperReset(self->_volumeRamper,  volume);
+    HugStereoFieldReset(self->_stereoField, stereoBalance, stereoWidth);
+}
+
+
+void HugRenderChainResetMeters(HugRenderChain *self)
+{
+    HugLevelMeterReset(self->_leftLevelMeter);
+    HugLevelMeterReset(self->_rightLevelMeter);
+    HugLoudnessMeterReset(self->_loudnessMeter);
+}
+
+
+void HugRenderChainProcessSource(
+    HugRenderChain *self,
+    float *left, float *right, size_t frameCount,
+    float preGain, float stereoBalance, float stereoWidth,
+    bool fadeOut
+) {
+    if (left && right && self->_meterFrameCount) {
+        RenderKernelParameters p = {0};
+        sMakeParameters(self, &p, frameCount, true, preGain, stereoBalance, stereoWidth, false, 0);
+        sProcessFused(self, &p, left, right, frameCount, NULL, NULL);
+        sCommitParameters(self, &p, preGain, 0);
+
+    } else {
+        HugStereoFieldProcess(self->_stereoField, left, right, frameCount, stereoBalance, stereoWidth);
+        HugLinearRamperProcess(self->_preGainRamper, left, right, frameCount, preGain);
+    }
+
+    if (fadeOut) {
+        HugApplyFadeWithCurve(left,  frameCount, 1.0, 0.0, self->_fadeCurve);
+        HugApplyFadeWithCurve(right, frameCount, 1.0, 0.0, self->_fadeCurve);
+    }
+}
+
+
+void HugRenderChainProcessOutput(
+    HugRenderChain *self,
+    float *left, float *right, size_t frameCount,
+    float volume,
+    HugRenderChainMeterCallback meterCallback, void *context
+) {
+    if (!self->_meterFrameCount) return;
+
+    if (left && right) {
+        RenderKernelParameters p = {0};
+        sMakeParameters(self, &p, frameCount, false, 0, 0, 0, true, volume);
+        sProcessFused(self, &p, left, right, frameCount, meterCallback, context);
+        sCommitParameters(self, &p, 0, volume);
+
+    } else {
+        sProcessOutputUnfused(self, left, right, frameCount, volume, meterCallback, context);
+    }
+}
+
+
+void HugRenderChainProcess(
+    HugRenderChain *self,
+    float *left, float *right, size_t frameCount,
+    float preGain, float stereoBalance, float stereoWidth,
+    float volume,
+    HugRenderChainMeterCallback meterCallback, void *context
+) {
+    if (!self->_meterFrameCount) return;
+
+    if (!left || !right) {
+        HugRenderChainProcessSource(self, left, right, frameCount, preGain, stereoBalance, stereoWidth, false);
+        HugRenderChainProcessOutput(self, left, right, frameCount, volume, meterCallback, context);
+        return;
+    }
+
+    RenderKernelParameters p = {0};
+    sMakeParameters(self, &p, frameCount, true, preGain, stereoBalance, stereoWidth, true, volume);
+    sProcessFused(self, &p, left, right, frameCount, meterCallback, context);
+    sCommitParameters(self, &p, preGain, volume);
+}
+
+
+#pragma mark - Accessors
+
+double HugRenderChainGetSampleRate(const HugRenderChain *self)
+{
+    return self->_sampleRate;
+}
+
+
+size_t HugRenderChainGetMaxFrameCount(const HugRenderChain *self)
+{
+    return self->_maxFrameCount;
+}
+
+
+size_t HugRenderChainGetMeterFrameCount(const HugRenderChain *self)
+{
+    return self->_meterFrameCount;
+}
+
+
+void HugRenderChainSetFadeCurve(HugRenderChain *self, HugFadeCurve fadeCurve)
+{
+    self->_fadeCurve = fadeCurve;
+}
+
+
+HugFadeCurve HugRenderChainGetFadeCurve(const HugRenderChain *self)
+{
+    return self->_fadeCurve;
+}
+
+
+void HugRenderChainSetLimiterMode(HugRenderChain *self, HugLimiterMode limiterMode)
+{
+    if (self->_limiterMode == limiterMode) return;
+
+    self->_limiterMode = limiterMode;
+
+    HugLimiterReset(self->_emergencyLimiter);
+    HugLookaheadLimiterReset(self->_lookaheadLimiter);
+}
+
+
+HugLimiterMode HugRenderChainGetLimiterMode(const HugRenderChain *self)
+{
+    return self->_limiterMode;
+}
+
+
+size_t HugRenderChainGetLatency(const HugRenderChain *self)
+{
+    if (self->_limiterMode == HugLimiterModeLookahead) {
+        return HugLookaheadLimiterGetLatency(self->_lookaheadLimiter);
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+// (c) 2018-2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// The fixed DSP portion of HugAudioEngine's render graph. The engine calls
+// HugRenderChainProcessSource() after pulling from the HugAudioSource and
+// HugRenderChainProcessOutput() after the effect audio units, or
+// HugRenderChainProcess() when there are none. The offline benchmark in
+// Benchmarks/ drives the same functions.
+//
+// Stereo field, ramps, meter measurement and limiter detection share one
+// SIMD pass per meter chunk; the standalone kernels remain the reference.
+//
+
+#pragma once
+
+#include "HugFastUtils.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugMeterDataStruct {
+    float peakLevel;
+    float heldLevel;
+    bool  limiterActive;
+
+    // LUFS of the output after the limiter, the same for both channels.
+    // -HUGE_VALF until 400ms / 3s have been heard.
+    float momentaryLoudness;
+    float shortTermLoudness;
+} HugMeterDataStruct;
+
+typedef enum {
+    // Holds and decays after an over, reacts within the offending chunk
+    HugLimiterModeEmergency = 0,
+
+    // HugLookaheadLimiter, delays the output by its look-ahead time
+    HugLimiterModeLookahead
+} HugLimiterMode;
+
+typedef struct HugRenderChain HugRenderChain;
+
+// Called once per meter chunk (at most 1024 frames) from the render thread
+typedef void (*HugRenderChainMeterCallback)(
+    void *context,
+    size_t frameOffset,
+    const HugMeterDataStruct *leftMeterData,
+    const HugMeterDataStruct *rightMeterData
+);
+
+extern HugRenderChain *HugRenderChainCreate(void);
+extern void HugRenderChainFree(HugRenderChain *chain);
+
+extern void HugRenderChainConfigure(HugRenderChain *chain, double sampleRate, size_t maxFrameCount);
+
+extern double HugRenderChainGetSampleRate(const HugRenderChain *chain);
+extern size_t HugRenderChainGetMaxFrameCount(const HugRenderChain *chain);
+extern size_t HugRenderChainGetMeterFrameCount(const HugRenderChain *chain);
+
+// Curve used for the fade-out when switching sources, defaults to exponential
+extern void HugRenderChainSetFadeCurve(HugRenderChain *chain, HugFadeCurve fadeCurve);
+extern HugFadeCurve HugRenderChainGetFadeCurve(const HugRenderChain *chain);
+
+// Limiter used after the level meters, defaults to emergency
+extern void HugRenderChainSetLimiterMode(HugRenderChain *chain, HugLimiterMode limiterMode);
+extern HugLimiterMode HugRenderChainGetLimiterMode(const HugRenderChain *chain);
+
+// Frames of delay added by the output stage, non-zero in look-ahead mode
+extern size_t HugRenderChainGetLatency(const HugRenderChain *chain);
+
+// Snaps the ramps to the current values, used when switching sources
+extern void HugRenderChainReset(HugRenderChain *chain, float preGain, float volume, float stereoBalance, float stereoWidth);
+
+extern void HugRenderChainResetMeters(HugRenderChain *chain);
+
+// Stereo field -> pre-gain ramp -> optional fade-out
+extern void HugRenderChainProcessSource(
+    HugRenderChain *chain,
+    float *left, float *right, size_t frameCount,
+    float preGain, float stereoBalance, float stereoWidth,
+    bool fadeOut
+);
+
+// Volume ramp -> level meters -> limiter -> loudness meter
+extern void HugRenderChainProcessOutput(
+    HugRenderChain *chain,
+    float *left, float *right, size_t frameCount,
+    float volume,
+    HugRenderChainMeterCallback meterCallback, void *context
+);
+
+// Both stages in a single pass per meter chunk, for graphs without effect
+// audio units in between. Produces bit-identical output to calling
+// HugRenderChainProcessSource() (without fade) and then
+// HugRenderChainProcessOutput().
+//
+extern void HugRenderChainProcess(
+    HugRenderChain *chain,
+    float *left, float *right, size_t frameCount,
+    float preGain, float stereoBalance, float stereoWidth,
+    float volume,
+    HugRenderChainMeterCallback meterCallback, void *context
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,324 @@
+// (c) 2018-2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Based on logic presented in these articles:
+//
+// https://www.mikeash.com/pyblog/friday-qa-2012-02-03-ring-buffers-and-mirrored-memory-part-i.html
+// https://www.mikeash.com/pyblog/friday-qa-2012-02-17-ring-buffers-and-mirrored-memory-part-ii.html
+//
+// The read and write indices only ever increase. Each side owns one of them
+// along with its offset into the buffer, and keeps a cached copy of the other
+// side's index, which it only refreshes (with an acquire load) when the cached
+// value says there isn't enough room. In the common case neither side touches
+// the other's cache line.
+//
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include "HugRingBuffer.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+struct HugRingBuffer {
+    uint8_t *_bytes;
+    size_t   _capacity;
+
+    // Producer
+    _Atomic size_t _writeIndex __attribute__((aligned(128)));
+    size_t _writeOffset;
+    size_t _cachedReadIndex;
+
+    // Consumer
+    _Atomic size_t _readIndex __attribute__((aligned(128)));
+    size_t _readOffset;
+    size_t _cachedWriteIndex;
+};
+
+
+static inline size_t sAdvance(size_t offset, size_t length, size_t capacity)
+{
+    offset += length;
+    return offset >= capacity ? offset - capacity : offset;
+}
+
+
+// Packets are small and of varying length; fixed-size memcpy()
+// calls compile down to single vector or word moves.
+//
+static void sCopy(void *dst, const void *src, size_t n)
+{
+    uint8_t       *d = dst;
+    const uint8_t *s = src;
+
+    for ( ; n >= 16; n -= 16, d += 16, s += 16) {
+        memcpy(d, s, 16);
+    }
+
+    if (n >= 8) { memcpy(d, s, 8); n -= 8; d += 8; s += 8; }
+    if (n >= 4) { memcpy(d, s, 4); n -= 4; d += 4; s += 4; }
+
+    while (n--) {
+        *d++ = *s++;
+    }
+}
+
+
+#if defined(__APPLE__)
+
+static uint8_t *sMapMirrored(size_t capacity)
+{
+    int loopGuard = 128;
+    vm_address_t addr1 = 0;
+    vm_address_t addr2 = 0;
+
+    while (loopGuard-- > 0) {
+        kern_return_t result;
+
+        addr1 = addr2 = 0;
+
+        result = vm_allocate(mach_task_self(), &addr1, capacity * 2, VM_FLAGS_ANYWHERE);
+        if (result != ERR_SUCCESS) continue;
+
+        result = vm_deallocate(mach_task_self(), addr1 + capacity, capacity);
+        if (result != ERR_SUCCESS) continue;
+
+        addr2 = addr1 + capacity;
+        vm_prot_t unused1, unused2;
+
+        result = vm_remap(
+            mach_task_self(), &addr2, capacity, 0, 0,
+            mach_task_self(),  addr1,
+            0, &unused1, &unused2, VM_INHERIT_DEFAULT
+        );
+
+        if (result != ERR_SUCCESS) {
+            if (addr1) vm_deallocate(mach_task_self(), addr1, capacity);
+            addr1 = addr2 = 0;
+
+            continue;
+        }
+
+        if (addr2 != (addr1 + capacity)) {
+            if (addr2) vm_deallocate(mach_task_self(), addr2, capacity);
+            if (addr1) vm_deallocate(mach_task_self(), addr1, capacity);
+            addr2 = addr1 = 0;
+
+            continue;
+        }
+
+        break;
+    }
+
+    if (addr1 && (addr2 == (addr1 + capacity))) {
+        return (uint8_t *)addr1;
+    }
+
+    return NULL;
+}
+
+
+static void sUnmapMirrored(uint8_t *bytes, size_t capacity)
+{
+    vm_deallocate(mach_task_self(), (vm_address_t)bytes, capacity * 2);
+}
+
+
+#elif defined(__linux__)
+
+static uint8_t *sMapMirrored(size_t capacity)
+{
+    int fd = memfd_create("HugRingBuffer", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    if (ftruncate(fd, capacity) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    // Reserve both halves first so that nothing else can be mapped in between
+    uint8_t *bytes = mmap(NULL, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (bytes == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr1 = mmap(bytes,            capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *addr2 = mmap(bytes + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+
+    close(fd);
+
+    if (addr1 != bytes || addr2 != (bytes + capacity)) {
+        munmap(bytes, capacity * 2);
+        return NULL;
+    }
+
+    return bytes;
+}
+
+
+static void sUnmapMirrored(uint8_t *bytes, size_t capacity)
+{
+    munmap(bytes, capacity * 2);
+}
+
+#else
+#error "HugRingBuffer needs vm_remap() or memfd_create()"
+#endif
+
+
+#pragma mark - Lifecycle
+
+HugRingBuffer *HugRingBufferCreate(size_t capacity)
+{
+    // Round capacity up to nearest page size
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    capacity = ((capacity + pageSize - 1) / pageSize) * pageSize;
+    if (!capacity) capacity = pageSize;
+
+    uint8_t *bytes = sMapMirrored(capacity);
+    if (!bytes) return NULL;
+
+    // calloc() only guarantees 16 bytes, the indices are on their own cache lines
+    HugRingBuffer *buffer = aligned_alloc(128, sizeof(HugRingBuffer));
+
+    if (!buffer) {
+        sUnmapMirrored(bytes, capacity);
+        return NULL;
+    }
+
+    memset(buffer, 0, sizeof(HugRingBuffer));
+
+    buffer->_bytes = bytes;
+    buffer->_capacity = capacity;
+
+    return buffer;
+}
+
+
+void HugRingBufferFree(HugRingBuffer *self)
+{
+    if (!self) return;
+
+    sUnmapMirrored(self->_bytes, self->_capacity);
+    free(self);
+}
+
+
+#pragma mark - Consumer
+
+void HugRingBufferConfirmReadAll(HugRingBuffer *self)
+{
+    if (!self) return;
+
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_acquire);
+
+    size_t readIndex = atomic_load_explicit(&self->_readIndex, memory_order_relaxed);
+
+    self->_readOffset = sAdvance(self->_readOffset, (writeIndex - readIndex) % self->_capacity, self->_capacity);
+    self->_cachedWriteIndex = writeIndex;
+
+    atomic_store_explicit(&self->_readIndex, writeIndex, memory_order_release);
+}
+
+
+void *HugRingBufferGetReadPtr(HugRingBuffer *self, size_t neededLength)
+{
+    if (!self) return NULL;
+
+    size_t readIndex = atomic_load_explicit(&self->_readIndex, memory_order_relaxed);
+
+    if ((self->_cachedWriteIndex - readIndex) < neededLength) {
+        self->_cachedWriteIndex = atomic_load_explicit(&self->_writeIndex, memory_order_acquire);
+        if ((self->_cachedWriteIndex - readIndex) < neededLength) return NULL;
+    }
+
+    return self->_bytes + self->_readOffset;
+}
+
+
+void HugRingBufferConfirmRead(HugRingBuffer *self, size_t length)
+{
+    if (!self) return;
+
+    size_t readIndex = atomic_load_explicit(&self->_readIndex, memory_order_relaxed);
+
+    self->_readOffset = sAdvance(self->_readOffset, length, self->_capacity);
+    atomic_store_explicit(&self->_readIndex, readIndex + length, memory_order_release);
+}
+
+
+bool HugRingBufferRead(HugRingBuffer *self, void *buffer, size_t length)
+{
+    void *readPtr = HugRingBufferGetReadPtr(self, length);
+    if (!readPtr) return false;
+
+    sCopy(buffer, readPtr, length);
+
+    HugRingBufferConfirmRead(self, length);
+
+    return true;
+}
+
+
+#pragma mark - Producer
+
+void *HugRingBufferGetWritePtr(HugRingBuffer *self, size_t neededLength)
+{
+    if (!self) return NULL;
+
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_relaxed);
+    size_t capacity   = self->_capacity;
+
+    if ((capacity - (writeIndex - self->_cachedReadIndex)) < neededLength) {
+        self->_cachedReadIndex = atomic_load_explicit(&self->_readIndex, memory_order_acquire);
+        if ((capacity - (writeIndex - self->_cachedReadIndex)) < neededLength) return NULL;
+    }
+
+    return self->_bytes + self->_writeOffset;
+}
+
+
+void HugRingBufferConfirmWrite(HugRingBuffer *self, size_t length)
+{
+    if (!self) return;
+
+    size_t writeIndex = atomic_load_explicit(&self->_writeIndex, memory_order_relaxed);
+
+    self->_writeOffset = sAdvance(self->_writeOffset, length, self->_capacity);
+    atomic_store_explicit(&self->_writeIndex, writeIndex + length, memory_order_release);
+}
+
+
+bool HugRingBufferWrite(HugRingBuffer *self, const void *buffer, size_t length)
+{
+    void *writePtr = HugRingBufferGetWritePtr(self, length);
+    if (!writePtr) return false;
+
+    sCopy(writePtr, buffer, length);
+
+    HugRingBufferConfirmWrite(self, length);
+
+    return true;
+}
+
+
+#pragma mark - Accessors
+
+size_t HugRingBufferGetCapacity(HugRingBuffer *self)
+{
+    return self->_capacity;
+}
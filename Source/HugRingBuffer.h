@@ -1,32 +1,42 @@
 // (c) 2018-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
+//
+// Single-producer, single-consumer ring buffer over mirrored memory, so
+// every read or write of up to capacity bytes is contiguous. The Write
+// functions belong to the producer thread and the Read functions to the
+// consumer thread.
+//
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct HugRingBuffer HugRingBuffer;
 
-extern HugRingBuffer *HugRingBufferCreate(CFIndex capacity);
+// Capacity is rounded up to the page size. Returns NULL if the mirrored
+// mapping could not be created.
+//
+extern HugRingBuffer *HugRingBufferCreate(size_t capacity);
 extern void HugRingBufferFree(HugRingBuffer *buffer);
 
 extern void HugRingBufferConfirmReadAll(HugRingBuffer *buffer);
 
-extern void *HugRingBufferGetReadPtr(HugRingBuffer *buffer, CFIndex neededLength);
-extern void  HugRingBufferConfirmRead(HugRingBuffer *buffer, CFIndex length);
+extern void *HugRingBufferGetReadPtr(HugRingBuffer *buffer, size_t neededLength);
+extern void  HugRingBufferConfirmRead(HugRingBuffer *buffer, size_t length);
 
-extern void *HugRingBufferGetWritePtr(HugRingBuffer *buffer, CFIndex neededLength);
-extern void  HugRingBufferConfirmWrite(HugRingBuffer *buffer, CFIndex length);
+extern void *HugRingBufferGetWritePtr(HugRingBuffer *buffer, size_t neededLength);
+extern void  HugRingBufferConfirmWrite(HugRingBuffer *buffer, size_t length);
 
-extern BOOL HugRingBufferRead( HugRingBuffer *self, void *buffer, CFIndex length);
-extern BOOL HugRingBufferWrite(HugRingBuffer *self, void *buffer, CFIndex length);
+extern bool HugRingBufferRead( HugRingBuffer *self, void *buffer, size_t length);
+extern bool HugRingBufferWrite(HugRingBuffer *self, const void *buffer, size_t length);
 
-extern CFIndex HugRingBufferGetCapacity(HugRingBuffer *buffer);
+extern size_t HugRingBufferGetCapacity(HugRingBuffer *buffer);
 
 #ifdef __cplusplus
 }
 #endif
-
-
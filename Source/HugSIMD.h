@@ -0,0 +1,269 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Thin, header-only wrapper around the SIMD instruction sets used by the
+// render-path kernels. Each kernel is written once against HugSIMDFloat /
+// HugSIMDDouble and compiles to AVX2, SSE2, NEON, or plain scalar code.
+//
+// Define HUG_SIMD_FORCE_SCALAR to disable vectorization entirely.
+//
+// Kernels must not rely on fused multiply-add. The scalar and vector paths
+// are expected to produce bit-identical results for element-wise math.
+//
+
+#pragma once
+
+#include <stddef.h>
+
+// Generic kernels take their mode as constant arguments and are stamped out
+// into specialized functions; force inlining so the constants fold away.
+#if defined(__GNUC__) || defined(__clang__)
+    #define HUG_SIMD_ALWAYS_INLINE static inline __attribute__((always_inline))
+#else
+    #define HUG_SIMD_ALWAYS_INLINE static inline
+#endif
+
+#if defined(HUG_SIMD_FORCE_SCALAR)
+    #define HUG_SIMD_SCALAR 1
+#elif defined(__AVX2__)
+    #define HUG_SIMD_AVX2 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #define HUG_SIMD_SSE 1
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #define HUG_SIMD_NEON 1
+    #include <arm_neon.h>
+#else
+    #define HUG_SIMD_SCALAR 1
+#endif
+
+
+#pragma mark - AVX2
+
+#if HUG_SIMD_AVX2
+
+#define HUG_SIMD_NAME "AVX2"
+#define HUG_SIMD_FLOAT_LANES  8
+#define HUG_SIMD_DOUBLE_LANES 4
+
+typedef __m256  HugSIMDFloat;
+typedef __m256d HugSIMDDouble;
+
+static inline HugSIMDFloat HugSIMDLoad(const float *p)            { return _mm256_loadu_ps(p); }
+static inline void         HugSIMDStore(float *p, HugSIMDFloat v) { _mm256_storeu_ps(p, v); }
+static inline HugSIMDFloat HugSIMDSplat(float f)                  { return _mm256_set1_ps(f); }
+static inline HugSIMDFloat HugSIMDIota(void)                      { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+
+static inline HugSIMDFloat HugSIMDAdd(HugSIMDFloat a, HugSIMDFloat b) { return _mm256_add_ps(a, b); }
+static inline HugSIMDFloat HugSIMDSub(HugSIMDFloat a, HugSIMDFloat b) { return _mm256_sub_ps(a, b); }
+static inline HugSIMDFloat HugSIMDMul(HugSIMDFloat a, HugSIMDFloat b) { return _mm256_mul_ps(a, b); }
+static inline HugSIMDFloat HugSIMDDiv(HugSIMDFloat a, HugSIMDFloat b) { return _mm256_div_ps(a, b); }
+static inline HugSIMDFloat HugSIMDMax(HugSIMDFloat a, HugSIMDFloat b) { return _mm256_max_ps(a, b); }
+static inline HugSIMDFloat HugSIMDMin(HugSIMDFloat a, HugSIMDFloat b) { return _mm256_min_ps(a, b); }
+static inline HugSIMDFloat HugSIMDSqrt(HugSIMDFloat a)                { return _mm256_sqrt_ps(a); }
+
+static inline HugSIMDFloat HugSIMDAbs(HugSIMDFloat a)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+}
+
+static inline float HugSIMDReduceMax(HugSIMDFloat v)
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+static inline float HugSIMDReduceMin(HugSIMDFloat v)
+{
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+static inline float HugSIMDReduceAdd(HugSIMDFloat v)
+{
+    __m128 m = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_add_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_add_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+static inline HugSIMDDouble HugSIMDLoadD(const double *p)             { return _mm256_loadu_pd(p); }
+static inline void          HugSIMDStoreD(double *p, HugSIMDDouble v) { _mm256_storeu_pd(p, v); }
+static inline HugSIMDDouble HugSIMDSplatD(double d)                   { return _mm256_set1_pd(d); }
+static inline HugSIMDDouble HugSIMDAddD(HugSIMDDouble a, HugSIMDDouble b) { return _mm256_add_pd(a, b); }
+static inline HugSIMDDouble HugSIMDMulD(HugSIMDDouble a, HugSIMDDouble b) { return _mm256_mul_pd(a, b); }
+
+static inline HugSIMDDouble HugSIMDConvertLowD(const float *p)
+{
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+static inline double HugSIMDReduceAddD(HugSIMDDouble v)
+{
+    __m128d m = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    m = _mm_add_sd(m, _mm_unpackhi_pd(m, m));
+    return _mm_cvtsd_f64(m);
+}
+
+
+#pragma mark - SSE
+
+#elif HUG_SIMD_SSE
+
+#define HUG_SIMD_NAME "SSE2"
+#define HUG_SIMD_FLOAT_LANES  4
+#define HUG_SIMD_DOUBLE_LANES 2
+
+typedef __m128  HugSIMDFloat;
+typedef __m128d HugSIMDDouble;
+
+static inline HugSIMDFloat HugSIMDLoad(const float *p)            { return _mm_loadu_ps(p); }
+static inline void         HugSIMDStore(float *p, HugSIMDFloat v) { _mm_storeu_ps(p, v); }
+static inline HugSIMDFloat HugSIMDSplat(float f)                  { return _mm_set1_ps(f); }
+static inline HugSIMDFloat HugSIMDIota(void)                      { return _mm_setr_ps(0, 1, 2, 3); }
+
+static inline HugSIMDFloat HugSIMDAdd(HugSIMDFloat a, HugSIMDFloat b) { return _mm_add_ps(a, b); }
+static inline HugSIMDFloat HugSIMDSub(HugSIMDFloat a, HugSIMDFloat b) { return _mm_sub_ps(a, b); }
+static inline HugSIMDFloat HugSIMDMul(HugSIMDFloat a, HugSIMDFloat b) { return _mm_mul_ps(a, b); }
+static inline HugSIMDFloat HugSIMDDiv(HugSIMDFloat a, HugSIMDFloat b) { return _mm_div_ps(a, b); }
+static inline HugSIMDFloat HugSIMDMax(HugSIMDFloat a, HugSIMDFloat b) { return _mm_max_ps(a, b); }
+static inline HugSIMDFloat HugSIMDMin(HugSIMDFloat a, HugSIMDFloat b) { return _mm_min_ps(a, b); }
+static inline HugSIMDFloat HugSIMDSqrt(HugSIMDFloat a)                { return _mm_sqrt_ps(a); }
+
+static inline HugSIMDFloat HugSIMDAbs(HugSIMDFloat a)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+static inline float HugSIMDReduceMax(HugSIMDFloat v)
+{
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float HugSIMDReduceMin(HugSIMDFloat v)
+{
+    v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float HugSIMDReduceAdd(HugSIMDFloat v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static inline HugSIMDDouble HugSIMDLoadD(const double *p)             { return _mm_loadu_pd(p); }
+static inline void          HugSIMDStoreD(double *p, HugSIMDDouble v) { _mm_storeu_pd(p, v); }
+static inline HugSIMDDouble HugSIMDSplatD(double d)                   { return _mm_set1_pd(d); }
+static inline HugSIMDDouble HugSIMDAddD(HugSIMDDouble a, HugSIMDDouble b) { return _mm_add_pd(a, b); }
+static inline HugSIMDDouble HugSIMDMulD(HugSIMDDouble a, HugSIMDDouble b) { return _mm_mul_pd(a, b); }
+
+static inline HugSIMDDouble HugSIMDConvertLowD(const float *p)
+{
+    return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double *)p)));
+}
+
+static inline double HugSIMDReduceAddD(HugSIMDDouble v)
+{
+    v = _mm_add_sd(v, _mm_unpackhi_pd(v, v));
+    return _mm_cvtsd_f64(v);
+}
+
+
+#pragma mark - NEON
+
+#elif HUG_SIMD_NEON
+
+#define HUG_SIMD_NAME "NEON"
+#define HUG_SIMD_FLOAT_LANES  4
+#define HUG_SIMD_DOUBLE_LANES 2
+
+typedef float32x4_t HugSIMDFloat;
+typedef float64x2_t HugSIMDDouble;
+
+static inline HugSIMDFloat HugSIMDLoad(const float *p)            { return vld1q_f32(p); }
+static inline void         HugSIMDStore(float *p, HugSIMDFloat v) { vst1q_f32(p, v); }
+static inline HugSIMDFloat HugSIMDSplat(float f)                  { return vdupq_n_f32(f); }
+
+static inline HugSIMDFloat HugSIMDIota(void)
+{
+    static const float sIota[4] = { 0, 1, 2, 3 };
+    return vld1q_f32(sIota);
+}
+
+static inline HugSIMDFloat HugSIMDAdd(HugSIMDFloat a, HugSIMDFloat b) { return vaddq_f32(a, b); }
+static inline HugSIMDFloat HugSIMDSub(HugSIMDFloat a, HugSIMDFloat b) { return vsubq_f32(a, b); }
+static inline HugSIMDFloat HugSIMDMul(HugSIMDFloat a, HugSIMDFloat b) { return vmulq_f32(a, b); }
+static inline HugSIMDFloat HugSIMDDiv(HugSIMDFloat a, HugSIMDFloat b) { return vdivq_f32(a, b); }
+static inline HugSIMDFloat HugSIMDMax(HugSIMDFloat a, HugSIMDFloat b) { return vmaxq_f32(a, b); }
+static inline HugSIMDFloat HugSIMDMin(HugSIMDFloat a, HugSIMDFloat b) { return vminq_f32(a, b); }
+static inline HugSIMDFloat HugSIMDAbs(HugSIMDFloat a)                 { return vabsq_f32(a); }
+static inline HugSIMDFloat HugSIMDSqrt(HugSIMDFloat a)                { return vsqrtq_f32(a); }
+
+static inline float HugSIMDReduceMax(HugSIMDFloat v) { return vmaxvq_f32(v); }
+static inline float HugSIMDReduceMin(HugSIMDFloat v) { return vminvq_f32(v); }
+static inline float HugSIMDReduceAdd(HugSIMDFloat v) { return vaddvq_f32(v); }
+
+static inline HugSIMDDouble HugSIMDLoadD(const double *p)             { return vld1q_f64(p); }
+static inline void          HugSIMDStoreD(double *p, HugSIMDDouble v) { vst1q_f64(p, v); }
+static inline HugSIMDDouble HugSIMDSplatD(double d)                   { return vdupq_n_f64(d); }
+static inline HugSIMDDouble HugSIMDAddD(HugSIMDDouble a, HugSIMDDouble b) { return vaddq_f64(a, b); }
+static inline HugSIMDDouble HugSIMDMulD(HugSIMDDouble a, HugSIMDDouble b) { return vmulq_f64(a, b); }
+
+static inline HugSIMDDouble HugSIMDConvertLowD(const float *p)
+{
+    return vcvt_f64_f32(vld1_f32(p));
+}
+
+static inline double HugSIMDReduceAddD(HugSIMDDouble v) { return vaddvq_f64(v); }
+
+
+#pragma mark - Scalar
+
+#else
+
+#include <math.h>
+
+#define HUG_SIMD_NAME "Scalar"
+#define HUG_SIMD_FLOAT_LANES  1
+#define HUG_SIMD_DOUBLE_LANES 1
+
+typedef float  HugSIMDFloat;
+typedef double HugSIMDDouble;
+
+static inline HugSIMDFloat HugSIMDLoad(const float *p)            { return *p; }
+static inline void         HugSIMDStore(float *p, HugSIMDFloat v) { *p = v; }
+static inline HugSIMDFloat HugSIMDSplat(float f)                  { return f; }
+static inline HugSIMDFloat HugSIMDIota(void)                      { return 0; }
+
+static inline HugSIMDFloat HugSIMDAdd(HugSIMDFloat a, HugSIMDFloat b) { return a + b; }
+static inline HugSIMDFloat HugSIMDSub(HugSIMDFloat a, HugSIMDFloat b) { return a - b; }
+static inline HugSIMDFloat HugSIMDMul(HugSIMDFloat a, HugSIMDFloat b) { return a * b; }
+static inline HugSIMDFloat HugSIMDDiv(HugSIMDFloat a, HugSIMDFloat b) { return a / b; }
+static inline HugSIMDFloat HugSIMDMax(HugSIMDFloat a, HugSIMDFloat b) { return a > b ? a : b; }
+static inline HugSIMDFloat HugSIMDMin(HugSIMDFloat a, HugSIMDFloat b) { return a < b ? a : b; }
+static inline HugSIMDFloat HugSIMDAbs(HugSIMDFloat a)                 { return a < 0 ? -a : a; }
+static inline HugSIMDFloat HugSIMDSqrt(HugSIMDFloat a)                { return sqrtf(a); }
+
+static inline float HugSIMDReduceMax(HugSIMDFloat v) { return v; }
+static inline float HugSIMDReduceMin(HugSIMDFloat v) { return v; }
+static inline float HugSIMDReduceAdd(HugSIMDFloat v) { return v; }
+
+static inline HugSIMDDouble HugSIMDLoadD(const double *p)             { return *p; }
+static inline void          HugSIMDStoreD(double *p, HugSIMDDouble v) { *p = v; }
+static inline HugSIMDDouble HugSIMDSplatD(double d)                   { return d; }
+static inline HugSIMDDouble HugSIMDAddD(HugSIMDDouble a, HugSIMDDouble b) { return a + b; }
+static inline HugSIMDDouble HugSIMDMulD(HugSIMDDouble a, HugSIMDDouble b) { return a * b; }
+static inline HugSIMDDouble HugSIMDConvertLowD(const float *p)            { return *p; }
+static inline double        HugSIMDReduceAddD(HugSIMDDouble v)            { return v; }
+
+#endif
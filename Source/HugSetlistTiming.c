@@ -0,0 +1,175 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugSetlistTiming.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Updates add the difference to each covering node, so rounding can creep
+// into the sums. Rebuilding after this many updates (or count, if larger)
+// keeps it in check at O(1) amortized.
+//
+#define sMinimumUpdatesBeforeRebuild 1024
+
+
+struct HugSetlistTiming {
+    // _spans[i] is entry i, _tree[k] (1-based) sums the k & -k entries ending at k - 1
+    double *_spans;
+    double *_tree;
+
+    size_t _count;
+    size_t _updateCount;
+
+    double _startTime;
+};
+
+
+static void sRebuild(HugSetlistTiming *self)
+{
+    size_t count = self->_count;
+
+    self->_tree[0] = 0;
+    memcpy(self->_tree + 1, self->_spans, count * sizeof(double));
+
+    for (size_t k = 1; k <= count; k++) {
+        size_t parent = k + (k & -k);
+        if (parent <= count) self->_tree[parent] += self->_tree[k];
+    }
+
+    self->_updateCount = 0;
+}
+
+
+// Sum of the first k entries
+static double sGetSum(const HugSetlistTiming *self, size_t k)
+{
+    double sum = 0;
+
+    for ( ; k > 0; k -= (k & -k)) {
+        sum += self->_tree[k];
+    }
+
+    return sum;
+}
+
+
+#pragma mark - Lifecycle
+
+HugSetlistTiming *HugSetlistTimingCreate(void)
+{
+    HugSetlistTiming *self = calloc(1, sizeof(HugSetlistTiming));
+    if (!self) return NULL;
+
+    self->_spans = malloc(sizeof(double));
+    self->_tree  = calloc(1, sizeof(double));
+
+    if (!self->_spans || !self->_tree) {
+        HugSetlistTimingFree(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+void HugSetlistTimingFree(HugSetlistTiming *self)
+{
+    if (!self) return;
+
+    free(self->_spans);
+    free(self->_tree);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+bool HugSetlistTimingReset(HugSetlistTiming *self, const double *spans, size_t count)
+{
+    if (count != self->_count) {
+        double *newSpans = malloc((count ? count : 1) * sizeof(double));
+        double *newTree  = malloc((count + 1) * sizeof(double));
+
+        if (!newSpans || !newTree) {
+            free(newSpans);
+            free(newTree);
+            return false;
+        }
+
+        free(self->_spans);
+        free(self->_tree);
+
+        self->_spans = newSpans;
+        self->_tree  = newTree;
+        self->_count = count;
+    }
+
+    if (count) memcpy(self->_spans, spans, count * sizeof(double));
+    sRebuild(self);
+
+    return true;
+}
+
+
+size_t HugSetlistTimingGetCount(const HugSetlistTiming *self)
+{
+    return self->_count;
+}
+
+
+void HugSetlistTimingSetSpan(HugSetlistTiming *self, size_t index, double span)
+{
+    if (index >= self->_count) return;
+
+    double delta = span - self->_spans[index];
+    if (delta == 0) return;
+
+    self->_spans[index] = span;
+
+    size_t count = self->_count;
+
+    for (size_t k = index + 1; k <= count; k += (k & -k)) {
+        self->_tree[k] += delta;
+    }
+
+    self->_updateCount++;
+
+    if (self->_updateCount >= count && self->_updateCount >= sMinimumUpdatesBeforeRebuild) {
+        sRebuild(self);
+    }
+}
+
+
+double HugSetlistTimingGetSpan(const HugSetlistTiming *self, size_t index)
+{
+    return index < self->_count ? self->_spans[index] : 0;
+}
+
+
+double HugSetlistTimingGetEndTime(const HugSetlistTiming *self, size_t index)
+{
+    size_t k = index < self->_count ? (index + 1) : self->_count;
+    return self->_startTime + sGetSum(self, k);
+}
+
+
+void HugSetlistTimingSetStartTime(HugSetlistTiming *self, double startTime)
+{
+    self->_startTime = startTime;
+}
+
+
+double HugSetlistTimingGetStartTime(const HugSetlistTiming *self)
+{
+    return self->_startTime;
+}
+
+
+void HugSetlistTimingSetEndTime(HugSetlistTiming *self, size_t index, double endTime)
+{
+    if (index >= self->_count) return;
+
+    double span = endTime - (self->_startTime + sGetSum(self, index));
+    HugSetlistTimingSetSpan(self, index, span > 0 ? span : 0);
+}
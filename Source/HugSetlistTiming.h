@@ -0,0 +1,51 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Running end times of a setlist. Each entry is one track's span: the gap
+// before it plus the time it plays. The spans are kept in a Fenwick tree, so
+// changing one or reading the end time of any entry is O(log n); replacing
+// all of them is O(n). End times count from a start time, 0 by default.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugSetlistTiming HugSetlistTiming;
+
+extern HugSetlistTiming *HugSetlistTimingCreate(void);
+extern void HugSetlistTimingFree(HugSetlistTiming *timing);
+
+// Replaces every entry. Returns false (leaving the entries as they were) if
+// memory runs out.
+//
+extern bool HugSetlistTimingReset(HugSetlistTiming *timing, const double *spans, size_t count);
+
+extern size_t HugSetlistTimingGetCount(const HugSetlistTiming *timing);
+
+// index must be less than the count
+extern void   HugSetlistTimingSetSpan(HugSetlistTiming *timing, size_t index, double span);
+extern double HugSetlistTimingGetSpan(const HugSetlistTiming *timing, size_t index);
+
+// The start time plus the spans of entries 0 through index. Past the end,
+// the start time plus the total.
+//
+extern double HugSetlistTimingGetEndTime(const HugSetlistTiming *timing, size_t index);
+
+extern void   HugSetlistTimingSetStartTime(HugSetlistTiming *timing, double startTime);
+extern double HugSetlistTimingGetStartTime(const HugSetlistTiming *timing);
+
+// Sets the span of an entry so that it ends at endTime, for a playing track
+// whose remaining time is known at some time after the start time. The span
+// is never negative.
+//
+extern void HugSetlistTimingSetEndTime(HugSetlistTiming *timing, size_t index, double endTime);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1166 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugStateStore.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define sFileMagic   0x31535348
+#define sFileVersion 1
+
+#define sCompactionSuffix ".compact"
+
+// Larger blobs go to the heap file, so that the log stays small enough to
+// walk on open without faulting in the payloads between record headers
+//
+#define sInlineLimit 2048
+
+// Garbage below this is never worth a rewrite
+#define sCompactionSlack (1024 * 1024)
+
+#define sWriterBufferLength (256 * 1024)
+
+enum {
+    sRecordNumbers    = 1,
+    sRecordBlob       = 2,
+    sRecordBlobRef    = 3,
+    sRecordRemoveBlob = 4,
+    sRecordRemoveItem = 5,
+    sRecordList       = 6
+};
+
+enum {
+    sBlobUnset    = 0,
+    sBlobInline   = 1,
+    sBlobExternal = 2
+};
+
+
+// The file is only ever read on the machine that wrote it, so fields are in
+// native byte order
+//
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numberCount;
+    uint32_t blobCount;
+    uint32_t heapGeneration;
+    uint32_t reserved;
+} HugStateStoreFileHeader;
+
+
+// Followed by the payload, padded to 8 bytes. check covers the header only,
+// so opening never touches blob payloads; a torn append is caught by its
+// length running past the end of the file.
+//
+typedef struct {
+    uint32_t type;
+    uint32_t field;
+    uint32_t length;
+    uint32_t check;
+    HugStateStoreID itemID;
+} HugStateStoreRecordHeader;
+
+
+// Payload of a sRecordBlobRef, the blob itself is in the heap file
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} HugStateStoreHeapRef;
+
+
+typedef struct {
+    uint64_t offset;  // Of the payload, in the log or the heap
+    uint32_t length;
+    uint32_t kind;
+} HugStateStoreBlobRef;
+
+
+typedef struct {
+    HugStateStoreID itemID;
+    uint64_t mask;
+    bool     removed;
+} HugStateStoreItem;
+
+
+typedef struct {
+    int      fd;
+    uint64_t offset;
+    uint8_t *buffer;
+    size_t   used;
+    bool     ok;
+} HugStateStoreWriter;
+
+
+struct HugStateStore {
+    pthread_mutex_t _mutex;
+
+    // Held for the whole of a compaction, taken before _mutex
+    pthread_mutex_t _compactionMutex;
+
+    char  *_path;
+    size_t _numberCount;
+    size_t _blobCount;
+
+    int      _fd;
+    uint64_t _fileLength;
+    uint8_t *_map;
+    size_t   _mapLength;
+
+    // Compaction writes a new heap next to the old one
+    int      _heapFD;
+    uint64_t _heapLength;
+    uint32_t _heapGeneration;
+
+    // Parallel arrays: _numbers has _numberCount doubles per item and _blobs
+    // has _blobCount refs per item. Removed items keep their slot.
+    //
+    HugStateStoreItem    *_items;
+    double               *_numbers;
+    HugStateStoreBlobRef *_blobs;
+    size_t _itemCount;
+    size_t _itemCapacity;
+    size_t _liveItemCount;
+
+    // Open addressing, item index + 1, 0 is empty
+    uint32_t *_table;
+    size_t    _tableCapacity;
+
+    HugStateStoreBlobRef _list;
+
+    uint64_t _liveBytes;
+    uint64_t _compactions;
+
+    // Bumped by HugStateStoreRemoveAll(), which invalidates a compaction in flight
+    uint64_t _resetCount;
+};
+
+
+static uint64_t sPad(uint64_t length)
+{
+    return (length + 7) & ~7ull;
+}
+
+
+static uint64_t sGetRecordSize(uint64_t payloadLength)
+{
+    return sizeof(HugStateStoreRecordHeader) + sPad(payloadLength);
+}
+
+
+// 32-bit FNV-1a over everything but the check itself
+static uint32_t sGetCheck(const HugStateStoreRecordHeader *header)
+{
+    uint32_t words[3] = { header->type, header->field, header->length };
+    uint32_t hash = 0x811c9dc5;
+
+    const uint8_t *b = (const uint8_t *)words;
+
+    for (size_t i = 0; i < sizeof(words); i++) {
+        hash ^= b[i];
+        hash *= 0x01000193;
+    }
+
+    for (size_t i = 0; i < sizeof(header->itemID.bytes); i++) {
+        hash ^= header->itemID.bytes[i];
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+
+static bool sReadFully(int fd, void *buffer, size_t length, off_t offset)
+{
+    uint8_t *b = buffer;
+
+    while (length > 0) {
+        ssize_t result = pread(fd, b, length, offset);
+
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) return false;
+
+        b      += result;
+        offset += result;
+        length -= result;
+    }
+
+    return true;
+}
+
+
+static bool sWriteFully(int fd, const void *buffer, size_t length, off_t offset)
+{
+    const uint8_t *b = buffer;
+
+    while (length > 0) {
+        ssize_t result = pwrite(fd, b, length, offset);
+
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) return false;
+
+        b      += result;
+        offset += result;
+        length -= result;
+    }
+
+    return true;
+}
+
+
+static bool sMakeHeapPath(const HugStateStore *self, uint32_t generation, char *outPath, size_t outLength)
+{
+    return (size_t)snprintf(outPath, outLength, "%s.%u.heap", self->_path, generation) < outLength;
+}
+
+
+#pragma mark - Index
+
+static inline double *sGetNumbers(const HugStateStore *self, size_t index)
+{
+    return self->_numbers + (index * self->_numberCount);
+}
+
+
+static inline HugStateStoreBlobRef *sGetBlobs(const HugStateStore *self, size_t index)
+{
+    return self->_blobs + (index * self->_blobCount);
+}
+
+
+static inline size_t sGetTableSlot(const HugStateStore *self, HugStateStoreID itemID)
+{
+    uint64_t hash;
+    memcpy(&hash, itemID.bytes, sizeof(hash));
+
+    hash ^= hash >> 29;
+    hash *= 0x9e3779b97f4a7c15ull;
+
+    return (hash >> 32) & (self->_tableCapacity - 1);
+}
+
+
+static uint64_t sGetBlobLiveBytes(HugStateStoreBlobRef blob)
+{
+    if (blob.kind == sBlobInline)   return sGetRecordSize(blob.length);
+    if (blob.kind == sBlobExternal) return sGetRecordSize(sizeof(HugStateStoreHeapRef)) + sPad(blob.length);
+
+    return 0;
+}
+
+
+static uint64_t sGetItemLiveBytes(const HugStateStore *self, size_t index)
+{
+    const HugStateStoreItem *item = &self->_items[index];
+    if (item->removed) return 0;
+
+    uint64_t result = item->mask ? sGetRecordSize(sizeof(uint64_t) + (sizeof(double) * self->_numberCount)) : 0;
+
+    const HugStateStoreBlobRef *blobs = sGetBlobs(self, index);
+
+    for (size_t i = 0; i < self->_blobCount; i++) {
+        result += sGetBlobLiveBytes(blobs[i]);
+    }
+
+    return result;
+}
+
+
+// Called with _mutex held
+static size_t sFindItem(const HugStateStore *self, HugStateStoreID itemID)
+{
+    if (!self->_tableCapacity) return SIZE_MAX;
+
+    size_t slot = sGetTableSlot(self, itemID);
+
+    while (self->_table[slot]) {
+        size_t index = self->_table[slot] - 1;
+
+        if (!memcmp(&self->_items[index].itemID, &itemID, sizeof(HugStateStoreID))) {
+            return self->_items[index].removed ? SIZE_MAX : index;
+        }
+
+        slot = (slot + 1) & (self->_tableCapacity - 1);
+    }
+
+    return SIZE_MAX;
+}
+
+
+// Called with _mutex held
+static bool sGrowTable(HugStateStore *self)
+{
+    size_t capacity = self->_tableCapacity ? (self->_tableCapacity * 2) : 256;
+    uint32_t *table = calloc(capacity, sizeof(uint32_t));
+    if (!table) return false;
+
+    free(self->_table);
+    self->_table = table;
+    self->_tableCapacity = capacity;
+
+    for (size_t i = 0; i < self->_itemCount; i++) {
+        size_t slot = sGetTableSlot(self, self->_items[i].itemID);
+
+        while (table[slot]) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        table[slot] = (uint32_t)(i + 1);
+    }
+
+    return true;
+}
+
+
+// Called with _mutex held. Revives a removed item with empty fields.
+static size_t sFindOrAddItem(HugStateStore *self, HugStateStoreID itemID)
+{
+    if (((self->_itemCount + 1) * 2) > self->_tableCapacity) {
+        if (!sGrowTable(self)) return SIZE_MAX;
+    }
+
+    size_t slot = sGetTableSlot(self, itemID);
+
+    while (self->_table[slot]) {
+        size_t index = self->_table[slot] - 1;
+        HugStateStoreItem *item = &self->_items[index];
+
+        if (!memcmp(&item->itemID, &itemID, sizeof(HugStateStoreID))) {
+            if (item->removed) {
+                item->removed = false;
+                self->_liveItemCount++;
+            }
+
+            return index;
+        }
+
+        slot = (slot + 1) & (self->_tableCapacity - 1);
+    }
+
+    if (self->_itemCount == self->_itemCapacity) {
+        size_t capacity = self->_itemCapacity ? (self->_itemCapacity * 2) : 256;
+
+        HugStateStoreItem *items = realloc(self->_items, capacity * sizeof(HugStateStoreItem));
+        if (items) self->_items = items;
+
+        double *numbers = realloc(self->_numbers, (capacity * self->_numberCount * sizeof(double)) + 1);
+        if (numbers) self->_numbers = numbers;
+
+        HugStateStoreBlobRef *blobs = realloc(self->_blobs, (capacity * self->_blobCount * sizeof(HugStateStoreBlobRef)) + 1);
+        if (blobs) self->_blobs = blobs;
+
+        if (!items || !numbers || !blobs) return SIZE_MAX;
+
+        self->_itemCapacity = capacity;
+    }
+
+    size_t index = self->_itemCount++;
+
+    self->_items[index] = (HugStateStoreItem){ itemID, 0, false };
+    memset(sGetNumbers(self, index), 0, self->_numberCount * sizeof(double));
+    memset(sGetBlobs(self, index),   0, self->_blobCount   * sizeof(HugStateStoreBlobRef));
+
+    self->_table[slot] = (uint32_t)(index + 1);
+    self->_liveItemCount++;
+
+    return index;
+}
+
+
+// Called with _mutex held
+static void sResetIndex(HugStateStore *self)
+{
+    self->_itemCount     = 0;
+    self->_liveItemCount = 0;
+    self->_list          = (HugStateStoreBlobRef){ 0, 0, sBlobUnset };
+    self->_liveBytes     = sizeof(HugStateStoreFileHeader);
+
+    if (self->_table) {
+        memset(self->_table, 0, self->_tableCapacity * sizeof(uint32_t));
+    }
+}
+
+
+// Called with _mutex held. payload is only read for numbers and blob ref records.
+static void sApplyRecord(HugStateStore *self, const HugStateStoreRecordHeader *header, uint64_t payloadOffset, const uint8_t *payload)
+{
+    uint32_t type = header->type;
+
+    if (type == sRecordList) {
+        self->_liveBytes -= sGetBlobLiveBytes(self->_list);
+        self->_list = (HugStateStoreBlobRef){ payloadOffset, header->length, sBlobInline };
+        self->_liveBytes += sGetBlobLiveBytes(self->_list);
+
+        return;
+    }
+
+    if (type == sRecordRemoveItem) {
+        size_t index = sFindItem(self, header->itemID);
+        if (index == SIZE_MAX) return;
+
+        self->_liveBytes -= sGetItemLiveBytes(self, index);
+
+        self->_items[index].removed = true;
+        self->_items[index].mask = 0;
+        memset(sGetNumbers(self, index), 0, self->_numberCount * sizeof(double));
+        memset(sGetBlobs(self, index),   0, self->_blobCount   * sizeof(HugStateStoreBlobRef));
+
+        self->_liveItemCount--;
+
+        return;
+    }
+
+    HugStateStoreBlobRef blob = { 0, 0, sBlobUnset };
+
+    if (type == sRecordBlob) {
+        blob = (HugStateStoreBlobRef){ payloadOffset, header->length, sBlobInline };
+
+    } else if (type == sRecordBlobRef) {
+        HugStateStoreHeapRef ref;
+        memcpy(&ref, payload, sizeof(ref));
+
+        // The heap is written first, so this only happens if it was damaged
+        if ((ref.offset + ref.length > self->_heapLength) || (ref.length > UINT32_MAX)) return;
+
+        blob = (HugStateStoreBlobRef){ ref.offset, (uint32_t)ref.length, sBlobExternal };
+    }
+
+    size_t index = sFindOrAddItem(self, header->itemID);
+    if (index == SIZE_MAX) return;
+
+    self->_liveBytes -= sGetItemLiveBytes(self, index);
+
+    if (type == sRecordNumbers) {
+        uint64_t mask;
+        memcpy(&mask, payload, sizeof(mask));
+
+        // Records from a version with fewer fields are shorter
+        size_t count = (header->length - sizeof(uint64_t)) / sizeof(double);
+        if (count > self->_numberCount) count = self->_numberCount;
+
+        double *numbers = sGetNumbers(self, index);
+
+        for (size_t i = 0; i < count; i++) {
+            if (mask & (1ull << i)) {
+                memcpy(&numbers[i], payload + sizeof(uint64_t) + (i * sizeof(double)), sizeof(double));
+                self->_items[index].mask |= (1ull << i);
+            }
+        }
+
+    } else if (header->field < self->_blobCount) {
+        sGetBlobs(self, index)[header->field] = blob;
+    }
+
+    self->_liveBytes += sGetItemLiveBytes(self, index);
+}
+
+
+#pragma mark - File
+
+static bool sWriteFileHeader(const HugStateStore *self, int fd, uint32_t heapGeneration)
+{
+    HugStateStoreFileHeader header = {
+        sFileMagic,
+        sFileVersion,
+        (uint32_t)self->_numberCount,
+        (uint32_t)self->_blobCount,
+        heapGeneration,
+        0
+    };
+
+    return sWriteFully(fd, &header, sizeof(header), 0);
+}
+
+
+// Called with _mutex held
+static void sUnmap(HugStateStore *self)
+{
+    if (self->_map) munmap(self->_map, self->_mapLength);
+
+    self->_map = NULL;
+    self->_mapLength = 0;
+}
+
+
+// Called with _mutex held
+static bool sOpenHeap(HugStateStore *self, uint32_t generation, bool truncate)
+{
+    char path[PATH_MAX];
+    if (!sMakeHeapPath(self, generation, path, sizeof(path))) return false;
+
+    if (self->_heapFD >= 0) close(self->_heapFD);
+
+    self->_heapFD = open(path, O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    self->_heapGeneration = generation;
+
+    struct stat st;
+    if (self->_heapFD < 0 || fstat(self->_heapFD, &st) != 0) return false;
+
+    self->_heapLength = st.st_size;
+
+    // Left behind by a compaction that crashed, either before or after its rename()
+    for (int i = -1; i <= 1; i += 2) {
+        if (sMakeHeapPath(self, generation + i, path, sizeof(path))) unlink(path);
+    }
+
+    return true;
+}
+
+
+// Called with _mutex held. Maps the file and rebuilds the index from it.
+static bool sLoad(HugStateStore *self)
+{
+    sUnmap(self);
+    sResetIndex(self);
+
+    struct stat st;
+    if (fstat(self->_fd, &st) != 0) return false;
+
+    uint64_t length = st.st_size;
+
+    HugStateStoreFileHeader fileHeader = {0};
+
+    if (length >= sizeof(fileHeader)) {
+        sReadFully(self->_fd, &fileHeader, sizeof(fileHeader), 0);
+    }
+
+    if (fileHeader.magic != sFileMagic || fileHeader.version != sFileVersion) {
+        if (length > 0) {
+            fprintf(stderr, "HugStateStore: '%s' is not a state store, starting over\n", self->_path);
+        }
+
+        if (ftruncate(self->_fd, 0) != 0) return false;
+        if (!sWriteFileHeader(self, self->_fd, 0)) return false;
+
+        self->_fileLength = sizeof(fileHeader);
+
+        return sOpenHeap(self, 0, true);
+    }
+
+    if (!sOpenHeap(self, fileHeader.heapGeneration, false)) return false;
+
+    void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, self->_fd, 0);
+    if (map == MAP_FAILED) return false;
+
+    self->_map = map;
+    self->_mapLength = length;
+
+    uint64_t offset = sizeof(fileHeader);
+
+    while (offset + sizeof(HugStateStoreRecordHeader) <= length) {
+        HugStateStoreRecordHeader header;
+        memcpy(&header, self->_map + offset, sizeof(header));
+
+        if (header.check != sGetCheck(&header)) break;
+        if (header.type < sRecordNumbers || header.type > sRecordList) break;
+        if (offset + sGetRecordSize(header.length) > length) break;
+
+        if (header.type == sRecordNumbers && header.length < sizeof(uint64_t)) break;
+        if (header.type == sRecordBlobRef && header.length != sizeof(HugStateStoreHeapRef)) break;
+
+        uint64_t payloadOffset = offset + sizeof(header);
+        sApplyRecord(self, &header, payloadOffset, self->_map + payloadOffset);
+
+        offset += sGetRecordSize(header.length);
+    }
+
+    // Drop a torn append so that new records follow the last good one
+    if (offset < length) {
+        fprintf(stderr, "HugStateStore: discarding %llu bytes at the end of '%s'\n", (unsigned long long)(length - offset), self->_path);
+        if (ftruncate(self->_fd, offset) != 0) return false;
+    }
+
+    self->_fileLength = offset;
+
+    return true;
+}
+
+
+// Called with _mutex held
+static bool sReadBlob(const HugStateStore *self, HugStateStoreBlobRef blob, void *buffer)
+{
+    if (blob.kind == sBlobExternal) {
+        return sReadFully(self->_heapFD, buffer, blob.length, blob.offset);
+    }
+
+    if (blob.offset + blob.length <= self->_mapLength) {
+        memcpy(buffer, self->_map + blob.offset, blob.length);
+        return true;
+    }
+
+    return sReadFully(self->_fd, buffer, blob.length, blob.offset);
+}
+
+
+// Called with _mutex held
+static void *sCopyBlob(const HugStateStore *self, HugStateStoreBlobRef blob)
+{
+    if (blob.kind == sBlobUnset) return NULL;
+
+    // Never malloc(0), an empty blob still needs a non-NULL result
+    void *result = malloc(blob.length ? blob.length : 1);
+
+    if (result && !sReadBlob(self, blob, result)) {
+        free(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+
+// Called with _mutex held
+static bool sAppendRecord(HugStateStore *self, uint32_t type, uint32_t field, HugStateStoreID itemID, const void *payload, size_t length)
+{
+    if (length > UINT32_MAX) return false;
+
+    HugStateStoreRecordHeader header = { type, field, (uint32_t)length, 0, itemID };
+    header.check = sGetCheck(&header);
+
+    uint64_t recordSize = sGetRecordSize(length);
+
+    uint8_t *record = calloc(1, recordSize);
+    if (!record) return false;
+
+    memcpy(record, &header, sizeof(header));
+    if (length) memcpy(record + sizeof(header), payload, length);
+
+    uint64_t offset = self->_fileLength;
+    bool ok = sWriteFully(self->_fd, record, recordSize, offset);
+
+    if (ok) {
+        self->_fileLength += recordSize;
+        sApplyRecord(self, &header, offset + sizeof(header), record + sizeof(header));
+
+    } else {
+        // If this fails too, the next open drops the partial record
+        ftruncate(self->_fd, offset);
+    }
+
+    free(record);
+
+    return ok;
+}
+
+
+// Called with _mutex held
+static bool sAppendHeapBlob(HugStateStore *self, uint32_t field, HugStateStoreID itemID, const void *bytes, size_t length)
+{
+    HugStateStoreHeapRef ref = { self->_heapLength, length };
+
+    if (!sWriteFully(self->_heapFD, bytes, length, ref.offset)) {
+        ftruncate(self->_heapFD, ref.offset);
+        return false;
+    }
+
+    self->_heapLength += sPad(length);
+
+    return sAppendRecord(self, sRecordBlobRef, field, itemID, &ref, sizeof(ref));
+}
+
+
+#pragma mark - Writer
+
+static void sWriterFlush(HugStateStoreWriter *writer)
+{
+    if (writer->ok && writer->used) {
+        writer->ok = sWriteFully(writer->fd, writer->buffer, writer->used, writer->offset);
+    }
+
+    writer->offset += writer->used;
+    writer->used = 0;
+}
+
+
+static uint64_t sWriterGetPosition(const HugStateStoreWriter *writer)
+{
+    return writer->offset + writer->used;
+}
+
+
+static void sWriterWrite(HugStateStoreWriter *writer, const void *bytes, size_t length)
+{
+    const uint8_t *b = bytes;
+
+    while (length > 0) {
+        if (writer->used == sWriterBufferLength) sWriterFlush(writer);
+
+        size_t count = sWriterBufferLength - writer->used;
+        if (count > length) count = length;
+
+        if (b) {
+            memcpy(writer->buffer + writer->used, b, count);
+            b += count;
+        } else {
+            memset(writer->buffer + writer->used, 0, count);
+        }
+
+        writer->used += count;
+        length -= count;
+    }
+}
+
+
+static void sWriterCopy(HugStateStoreWriter *writer, int sourceFD, uint64_t sourceOffset, size_t length)
+{
+    while (length > 0) {
+        if (writer->used == sWriterBufferLength) sWriterFlush(writer);
+
+        size_t count = sWriterBufferLength - writer->used;
+        if (count > length) count = length;
+
+        if (!sReadFully(sourceFD, writer->buffer + writer->used, count, sourceOffset)) {
+            writer->ok = false;
+        }
+
+        writer->used += count;
+        sourceOffset += count;
+        length -= count;
+    }
+}
+
+
+static void sWriterPad(HugStateStoreWriter *writer)
+{
+    uint64_t position = sWriterGetPosition(writer);
+    sWriterWrite(writer, NULL, sPad(position) - position);
+}
+
+
+// Exactly one of payload and sourceFD is used
+static void sWriterAppendRecord(HugStateStoreWriter *writer, HugStateStoreRecordHeader header, const void *payload, int sourceFD, uint64_t sourceOffset)
+{
+    header.check = sGetCheck(&header);
+    sWriterWrite(writer, &header, sizeof(header));
+
+    if (payload) {
+        sWriterWrite(writer, payload, header.length);
+    } else {
+        sWriterCopy(writer, sourceFD, sourceOffset, header.length);
+    }
+
+    sWriterPad(writer);
+}
+
+
+static void sWriterAppendHeapBlob(HugStateStoreWriter *writer, HugStateStoreWriter *heapWriter, HugStateStoreRecordHeader header, int sourceFD, HugStateStoreHeapRef ref)
+{
+    HugStateStoreHeapRef newRef = { sWriterGetPosition(heapWriter), ref.length };
+
+    sWriterCopy(heapWriter, sourceFD, ref.offset, ref.length);
+    sWriterPad(heapWriter);
+
+    header.length = sizeof(newRef);
+    sWriterAppendRecord(writer, header, &newRef, -1, 0);
+}
+
+
+#pragma mark - Lifecycle
+
+HugStateStore *HugStateStoreOpen(const char *path, size_t numberCount, size_t blobCount)
+{
+    if (numberCount > HUG_STATE_STORE_MAX_FIELDS || blobCount > HUG_STATE_STORE_MAX_FIELDS) {
+        return NULL;
+    }
+
+    HugStateStore *self = calloc(1, sizeof(HugStateStore));
+    if (!self) return NULL;
+
+    pthread_mutex_init(&self->_mutex, NULL);
+    pthread_mutex_init(&self->_compactionMutex, NULL);
+
+    self->_path        = strdup(path);
+    self->_numberCount = numberCount;
+    self->_blobCount   = blobCount;
+    self->_heapFD      = -1;
+    self->_fd          = open(path, O_RDWR | O_CREAT, 0644);
+
+    pthread_mutex_lock(&self->_mutex);
+    bool loaded = (self->_fd >= 0) && sLoad(self);
+    pthread_mutex_unlock(&self->_mutex);
+
+    if (!loaded) {
+        HugStateStoreFree(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+void HugStateStoreFree(HugStateStore *self)
+{
+    if (!self) return;
+
+    sUnmap(self);
+    if (self->_fd     >= 0) close(self->_fd);
+    if (self->_heapFD >= 0) close(self->_heapFD);
+
+    free(self->_items);
+    free(self->_numbers);
+    free(self->_blobs);
+    free(self->_table);
+    free(self->_path);
+
+    pthread_mutex_destroy(&self->_mutex);
+    pthread_mutex_destroy(&self->_compactionMutex);
+
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+bool HugStateStoreHasItem(HugStateStore *self, HugStateStoreID itemID)
+{
+    pthread_mutex_lock(&self->_mutex);
+    bool result = sFindItem(self, itemID) != SIZE_MAX;
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugStateStoreWriteNumbers(HugStateStore *self, HugStateStoreID itemID, uint64_t mask, const double *numbers)
+{
+    uint8_t payload[sizeof(uint64_t) + (sizeof(double) * HUG_STATE_STORE_MAX_FIELDS)] = {0};
+    size_t length = sizeof(uint64_t) + (sizeof(double) * self->_numberCount);
+
+    if (self->_numberCount < 64) mask &= (1ull << self->_numberCount) - 1;
+
+    memcpy(payload, &mask, sizeof(mask));
+
+    for (size_t i = 0; i < self->_numberCount; i++) {
+        if (mask & (1ull << i)) {
+            memcpy(payload + sizeof(uint64_t) + (i * sizeof(double)), &numbers[i], sizeof(double));
+        }
+    }
+
+    pthread_mutex_lock(&self->_mutex);
+    bool result = sAppendRecord(self, sRecordNumbers, 0, itemID, payload, length);
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugStateStoreReadNumbers(HugStateStore *self, HugStateStoreID itemID, uint64_t *outMask, double *outNumbers)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    size_t index = sFindItem(self, itemID);
+
+    if (index != SIZE_MAX) {
+        if (outMask) *outMask = self->_items[index].mask;
+        memcpy(outNumbers, sGetNumbers(self, index), self->_numberCount * sizeof(double));
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return index != SIZE_MAX;
+}
+
+
+bool HugStateStoreWriteBlob(HugStateStore *self, HugStateStoreID itemID, size_t field, const void *bytes, size_t length)
+{
+    if (field >= self->_blobCount || length > UINT32_MAX) return false;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    bool result;
+
+    if (!bytes) {
+        result = sAppendRecord(self, sRecordRemoveBlob, (uint32_t)field, itemID, NULL, 0);
+    } else if (length > sInlineLimit) {
+        result = sAppendHeapBlob(self, (uint32_t)field, itemID, bytes, length);
+    } else {
+        result = sAppendRecord(self, sRecordBlob, (uint32_t)field, itemID, bytes, length);
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+void *HugStateStoreCopyBlob(HugStateStore *self, HugStateStoreID itemID, size_t field, size_t *outLength)
+{
+    if (field >= self->_blobCount) return NULL;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    void *result = NULL;
+    size_t index = sFindItem(self, itemID);
+
+    if (index != SIZE_MAX) {
+        HugStateStoreBlobRef blob = sGetBlobs(self, index)[field];
+
+        result = sCopyBlob(self, blob);
+        if (result && outLength) *outLength = blob.length;
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugStateStoreRemoveItem(HugStateStore *self, HugStateStoreID itemID)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    bool result = true;
+
+    if (sFindItem(self, itemID) != SIZE_MAX) {
+        result = sAppendRecord(self, sRecordRemoveItem, 0, itemID, NULL, 0);
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugStateStoreRemoveAll(HugStateStore *self)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    sUnmap(self);
+    sResetIndex(self);
+
+    bool result = (ftruncate(self->_fd, sizeof(HugStateStoreFileHeader)) == 0) &&
+                  (ftruncate(self->_heapFD, 0) == 0);
+
+    self->_fileLength = sizeof(HugStateStoreFileHeader);
+    self->_heapLength = 0;
+    self->_resetCount++;
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugStateStoreWriteList(HugStateStore *self, const HugStateStoreID *itemIDs, size_t count)
+{
+    HugStateStoreID none = {{0}};
+
+    pthread_mutex_lock(&self->_mutex);
+    bool result = sAppendRecord(self, sRecordList, 0, none, itemIDs, count * sizeof(HugStateStoreID));
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+HugStateStoreID *HugStateStoreCopyList(HugStateStore *self, size_t *outCount)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    HugStateStoreID *result = sCopyBlob(self, self->_list);
+    size_t count = self->_list.length / sizeof(HugStateStoreID);
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    if (outCount) *outCount = result ? count : 0;
+
+    return result;
+}
+
+
+bool HugStateStoreNeedsCompaction(HugStateStore *self)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    uint64_t garbage = (self->_fileLength + self->_heapLength) - self->_liveBytes;
+    bool result = (garbage > self->_liveBytes) && (garbage > sCompactionSlack);
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return result;
+}
+
+
+bool HugStateStoreCompact(HugStateStore *self)
+{
+    pthread_mutex_lock(&self->_compactionMutex);
+    pthread_mutex_lock(&self->_mutex);
+
+    // Snapshot the index. Records appended while the snapshot is written out
+    // are replayed at the end.
+    //
+    size_t   itemCount      = self->_itemCount;
+    uint64_t snapshotEnd    = self->_fileLength;
+    uint64_t resetCount     = self->_resetCount;
+    uint32_t heapGeneration = self->_heapGeneration + 1;
+    int      sourceFD       = self->_fd;
+    int      sourceHeapFD   = self->_heapFD;
+
+    HugStateStoreItem    *items   = malloc((itemCount * sizeof(HugStateStoreItem)) + 1);
+    double               *numbers = malloc((itemCount * self->_numberCount * sizeof(double)) + 1);
+    HugStateStoreBlobRef *blobs   = malloc((itemCount * self->_blobCount * sizeof(HugStateStoreBlobRef)) + 1);
+    HugStateStoreBlobRef  list    = self->_list;
+
+    if (items && numbers && blobs) {
+        memcpy(items,   self->_items,   itemCount * sizeof(HugStateStoreItem));
+        memcpy(numbers, self->_numbers, itemCount * self->_numberCount * sizeof(double));
+        memcpy(blobs,   self->_blobs,   itemCount * self->_blobCount * sizeof(HugStateStoreBlobRef));
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    char path[PATH_MAX], heapPath[PATH_MAX];
+
+    bool pathsFit = ((size_t)snprintf(path, sizeof(path), "%s%s", self->_path, sCompactionSuffix) < sizeof(path)) &&
+                    sMakeHeapPath(self, heapGeneration, heapPath, sizeof(heapPath));
+
+    HugStateStoreWriter writer = {
+        pathsFit ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1,
+        0, malloc(sWriterBufferLength), 0, true
+    };
+
+    HugStateStoreWriter heapWriter = {
+        pathsFit ? open(heapPath, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1,
+        0, malloc(sWriterBufferLength), 0, true
+    };
+
+    bool ok = (writer.fd >= 0) && writer.buffer && (heapWriter.fd >= 0) && heapWriter.buffer && items && numbers && blobs;
+
+    if (ok) {
+        HugStateStoreFileHeader header = { sFileMagic, sFileVersion, (uint32_t)self->_numberCount, (uint32_t)self->_blobCount, heapGeneration, 0 };
+        sWriterWrite(&writer, &header, sizeof(header));
+    }
+
+    size_t numbersLength = sizeof(uint64_t) + (sizeof(double) * self->_numberCount);
+
+    for (size_t i = 0; ok && i < itemCount; i++) {
+        HugStateStoreItem *item = &items[i];
+        if (item->removed) continue;
+
+        if (item->mask) {
+            uint8_t payload[sizeof(uint64_t) + (sizeof(double) * HUG_STATE_STORE_MAX_FIELDS)];
+
+            memcpy(payload, &item->mask, sizeof(uint64_t));
+            memcpy(payload + sizeof(uint64_t), numbers + (i * self->_numberCount), self->_numberCount * sizeof(double));
+
+            HugStateStoreRecordHeader header = { sRecordNumbers, 0, (uint32_t)numbersLength, 0, item->itemID };
+            sWriterAppendRecord(&writer, header, payload, -1, 0);
+        }
+
+        for (size_t f = 0; f < self->_blobCount; f++) {
+            HugStateStoreBlobRef blob = blobs[(i * self->_blobCount) + f];
+            HugStateStoreRecordHeader header = { sRecordBlob, (uint32_t)f, blob.length, 0, item->itemID };
+
+            if (blob.kind == sBlobInline) {
+                sWriterAppendRecord(&writer, header, NULL, sourceFD, blob.offset);
+            } else if (blob.kind == sBlobExternal) {
+                header.type = sRecordBlobRef;
+                sWriterAppendHeapBlob(&writer, &heapWriter, header, sourceHeapFD, (HugStateStoreHeapRef){ blob.offset, blob.length });
+            }
+        }
+    }
+
+    if (list.kind != sBlobUnset) {
+        HugStateStoreRecordHeader header = { sRecordList, 0, list.length, 0, {{0}} };
+        sWriterAppendRecord(&writer, header, NULL, sourceFD, list.offset);
+    }
+
+    pthread_mutex_lock(&self->_mutex);
+
+    if (self->_resetCount != resetCount) {
+        ok = false;
+    }
+
+    // Replay records appended since the snapshot
+    for (uint64_t offset = snapshotEnd; ok && offset < self->_fileLength; ) {
+        HugStateStoreRecordHeader header;
+        HugStateStoreHeapRef ref;
+
+        ok = sReadFully(self->_fd, &header, sizeof(header), offset);
+        uint64_t payloadOffset = offset + sizeof(header);
+
+        if (ok && header.type == sRecordBlobRef) {
+            ok = sReadFully(self->_fd, &ref, sizeof(ref), payloadOffset);
+            sWriterAppendHeapBlob(&writer, &heapWriter, header, self->_heapFD, ref);
+        } else if (ok) {
+            sWriterAppendRecord(&writer, header, NULL, self->_fd, payloadOffset);
+        }
+
+        offset += sGetRecordSize(header.length);
+    }
+
+    sWriterFlush(&writer);
+    sWriterFlush(&heapWriter);
+
+    ok = ok && writer.ok && heapWriter.ok;
+
+    // The log's rename() commits both files
+    ok = ok && (fsync(heapWriter.fd) == 0) && (fsync(writer.fd) == 0) && (rename(path, self->_path) == 0);
+
+    bool result = false;
+
+    if (ok) {
+        char oldHeapPath[PATH_MAX];
+
+        close(self->_fd);
+        close(self->_heapFD);
+
+        if (sMakeHeapPath(self, self->_heapGeneration, oldHeapPath, sizeof(oldHeapPath))) {
+            unlink(oldHeapPath);
+        }
+
+        self->_fd = writer.fd;
+        self->_heapFD = heapWriter.fd;
+
+        result = sLoad(self);
+        if (result) self->_compactions++;
+
+    } else {
+        if (writer.fd     >= 0) close(writer.fd);
+        if (heapWriter.fd >= 0) close(heapWriter.fd);
+
+        if (pathsFit) {
+            unlink(path);
+            unlink(heapPath);
+        }
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+    pthread_mutex_unlock(&self->_compactionMutex);
+
+    free(writer.buffer);
+    free(heapWriter.buffer);
+    free(items);
+    free(numbers);
+    free(blobs);
+
+    return result;
+}
+
+
+#pragma mark - Accessors
+
+HugStateStoreStats HugStateStoreGetStats(HugStateStore *self)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    HugStateStoreStats stats = {
+        self->_liveItemCount,
+        self->_fileLength + self->_heapLength,
+        self->_liveBytes,
+        self->_compactions
+    };
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return stats;
+}
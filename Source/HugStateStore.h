@@ -0,0 +1,82 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Single-file store for per-track state. The file is an append-only log of
+// records: a numbers record holds every numeric field at a fixed offset plus
+// a mask of the fields it changes, and each blob (strings, bookmarks,
+// overview data) gets a record of its own. Writing a track only appends the
+// fields that changed. Blobs over 2 KB are appended to a separate heap file
+// and the log records where they are.
+//
+// Opening maps the file and walks the record headers to build an index;
+// blob payloads are left untouched until they are copied out. Superseded
+// records are garbage until HugStateStoreCompact() rewrites the file, which
+// is safe to call from a background thread while other threads keep reading
+// and writing.
+//
+// All functions are thread-safe.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HUG_STATE_STORE_MAX_FIELDS 64
+
+typedef struct HugStateStore HugStateStore;
+
+typedef struct {
+    uint8_t bytes[16];
+} HugStateStoreID;
+
+typedef struct {
+    size_t   itemCount;
+    uint64_t fileBytes;
+    uint64_t liveBytes;
+    uint64_t compactions;
+} HugStateStoreStats;
+
+// Creates the file if needed. numberCount and blobCount are part of the file
+// format: fields may be appended in later versions, never reordered.
+//
+extern HugStateStore *HugStateStoreOpen(const char *path, size_t numberCount, size_t blobCount);
+extern void HugStateStoreFree(HugStateStore *store);
+
+extern bool HugStateStoreHasItem(HugStateStore *store, HugStateStoreID itemID);
+
+// Writes numbers[i] for each bit i set in mask, other fields keep their values
+extern bool HugStateStoreWriteNumbers(HugStateStore *store, HugStateStoreID itemID, uint64_t mask, const double *numbers);
+
+// Fills numbers with every field (unwritten ones are 0) and returns the mask
+// of written fields. Returns false if the item doesn't exist.
+//
+extern bool HugStateStoreReadNumbers(HugStateStore *store, HugStateStoreID itemID, uint64_t *outMask, double *outNumbers);
+
+// A NULL bytes removes the blob
+extern bool HugStateStoreWriteBlob(HugStateStore *store, HugStateStoreID itemID, size_t field, const void *bytes, size_t length);
+
+// Returns a malloc()'d copy of the blob, or NULL if it isn't set
+extern void *HugStateStoreCopyBlob(HugStateStore *store, HugStateStoreID itemID, size_t field, size_t *outLength);
+
+extern bool HugStateStoreRemoveItem(HugStateStore *store, HugStateStoreID itemID);
+extern bool HugStateStoreRemoveAll(HugStateStore *store);
+
+// A single ordered list of IDs, replaced as a whole
+extern bool HugStateStoreWriteList(HugStateStore *store, const HugStateStoreID *itemIDs, size_t count);
+extern HugStateStoreID *HugStateStoreCopyList(HugStateStore *store, size_t *outCount);
+
+// True once garbage outweighs live records and exceeds 1 MB
+extern bool HugStateStoreNeedsCompaction(HugStateStore *store);
+extern bool HugStateStoreCompact(HugStateStore *store);
+
+extern HugStateStoreStats HugStateStoreGetStats(HugStateStore *store);
+
+#ifdef __cplusplus
+}
+#endif
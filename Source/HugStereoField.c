@@ -0,0 +1,227 @@
+// (c) 2014-2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugStereoField.h"
+#include "HugStereoFieldKernels.h"
+
+#include <stdlib.h>
+
+
+struct HugStereoField {
+    size_t _maxFrameCount;
+    float  _previousBalance;
+    float  _previousWidth;
+};
+
+
+typedef void (*StereoFieldKernel)(
+    float *left, float *right, size_t frameCount,
+    float fromWidth, float toWidth,
+    float fromBalance, float toBalance
+);
+
+
+HUG_SIMD_ALWAYS_INLINE void sProcess(
+    float *left, float *right, size_t frameCount,
+    float fromWidth, float toWidth,
+    float fromBalance, float toBalance,
+    const int widthStage, const int balanceStage
+) {
+    const float step = HugStereoFieldGetRampStep(frameCount);
+
+    float myWidth, otherWidth;
+    HugStereoFieldGetWidthGains(toWidth, &myWidth, &otherWidth);
+
+    float leftBalance, rightBalance;
+    HugStereoFieldGetBalanceGains(toBalance, &leftBalance, &rightBalance);
+
+    size_t i = 0;
+
+    const HugSIMDFloat vStep  = HugSIMDSplat(step);
+    const HugSIMDFloat vLanes = HugSIMDSplat(HUG_SIMD_FLOAT_LANES);
+
+    HugSIMDFloat vIndex = HugSIMDIota();
+
+    for ( ; i + HUG_SIMD_FLOAT_LANES <= frameCount; i += HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat l = HugSIMDLoad(left  + i);
+        HugSIMDFloat r = HugSIMDLoad(right + i);
+        HugSIMDFloat t = HugSIMDMul(vIndex, vStep);
+
+        if (widthStage != HugStereoFieldStageOff) {
+            HugSIMDFloat vMy    = HugSIMDSplat(myWidth);
+            HugSIMDFloat vOther = HugSIMDSplat(otherWidth);
+
+            if (widthStage == HugStereoFieldStageRamp) {
+                HugStereoFieldGetWidthGainsSIMD(HugStereoFieldLerpSIMD(fromWidth, toWidth, t), &vMy, &vOther);
+            }
+
+            HugSIMDFloat newL = HugSIMDAdd(HugSIMDMul(l, vMy), HugSIMDMul(r, vOther));
+            HugSIMDFloat newR = HugSIMDAdd(HugSIMDMul(r, vMy), HugSIMDMul(l, vOther));
+
+            l = newL;
+            r = newR;
+        }
+
+        if (balanceStage != HugStereoFieldStageOff) {
+            HugSIMDFloat vLeft  = HugSIMDSplat(leftBalance);
+            HugSIMDFloat vRight = HugSIMDSplat(rightBalance);
+
+            if (balanceStage == HugStereoFieldStageRamp) {
+                HugStereoFieldGetBalanceGainsSIMD(HugStereoFieldLerpSIMD(fromBalance, toBalance, t), &vLeft, &vRight);
+            }
+
+            l = HugSIMDMul(l, vLeft);
+            r = HugSIMDMul(r, vRight);
+        }
+
+        HugSIMDStore(left  + i, l);
+        HugSIMDStore(right + i, r);
+
+        vIndex = HugSIMDAdd(vIndex, vLanes);
+    }
+
+    for ( ; i < frameCount; i++) {
+        float l = left[i];
+        float r = right[i];
+        float t = (float)i * step;
+
+        if (widthStage != HugStereoFieldStageOff) {
+            float my    = myWidth;
+            float other = otherWidth;
+
+            if (widthStage == HugStereoFieldStageRamp) {
+                HugStereoFieldGetWidthGains(HugStereoFieldLerp(fromWidth, toWidth, t), &my, &other);
+            }
+
+            float newL = (l * my) + (r * other);
+            float newR = (r * my) + (l * other);
+
+            l = newL;
+            r = newR;
+        }
+
+        if (balanceStage != HugStereoFieldStageOff) {
+            float leftGain  = leftBalance;
+            float rightGain = rightBalance;
+
+            if (balanceStage == HugStereoFieldStageRamp) {
+                HugStereoFieldGetBalanceGains(HugStereoFieldLerp(fromBalance, toBalance, t), &leftGain, &rightGain);
+            }
+
+            l *= leftGain;
+            r *= rightGain;
+        }
+
+        left[i]  = l;
+        right[i] = r;
+    }
+}
+
+
+#define sDefineKernel(W, B) \
+    static void sProcess_##W##_##B( \
+        float *left, float *right, size_t frameCount, \
+        float fromWidth, float toWidth, \
+        float fromBalance, float toBalance \
+    ) { \
+        sProcess(left, right, frameCount, fromWidth, toWidth, fromBalance, toBalance, HugStereoFieldStage##W, HugStereoFieldStage##B); \
+    }
+
+sDefineKernel(Off,    Steady)
+sDefineKernel(Off,    Ramp)
+sDefineKernel(Steady, Off)
+sDefineKernel(Steady, Steady)
+sDefineKernel(Steady, Ramp)
+sDefineKernel(Ramp,   Off)
+sDefineKernel(Ramp,   Steady)
+sDefineKernel(Ramp,   Ramp)
+
+
+static void sProcess_Off_Off(
+    float *left, float *right, size_t frameCount,
+    float fromWidth, float toWidth,
+    float fromBalance, float toBalance
+) {
+    // Nothing to do, the signature is the one sKernels holds
+    (void)left; (void)right; (void)frameCount;
+    (void)fromWidth; (void)toWidth;
+    (void)fromBalance; (void)toBalance;
+}
+
+
+// Indexed by [widthStage][balanceStage]
+static const StereoFieldKernel sKernels[HugStereoFieldStageCount][HugStereoFieldStageCount] = {
+    { sProcess_Off_Off,    sProcess_Off_Steady,    sProcess_Off_Ramp    },
+    { sProcess_Steady_Off, sProcess_Steady_Steady, sProcess_Steady_Ramp },
+    { sProcess_Ramp_Off,   sProcess_Ramp_Steady,   sProcess_Ramp_Ramp   }
+};
+
+
+#pragma mark - Public Functions
+
+HugStereoField *HugStereoFieldCreate(void)
+{
+    HugStereoField *self = calloc(1, sizeof(HugStereoField));
+    return self;
+}
+
+
+void HugStereoFieldFree(HugStereoField *self)
+{
+    free(self);
+}
+
+
+void HugStereoFieldReset(HugStereoField *self, float balance, float width)
+{
+    self->_previousBalance = balance;
+    self->_previousWidth = width;
+}
+
+
+void HugStereoFieldProcess(HugStereoField *self, float *left, float *right, size_t frameCount, float balance, float width)
+{
+    if (!left || !right) return;
+
+    if (balance < -1.0f) balance = -1.0f;
+    if (balance >  1.0f) balance =  1.0f;
+
+    if (width   < -1.0f) width   = -1.0f;
+    if (width   >  1.0f) width   =  1.0f;
+
+    int widthStage   = HugStereoFieldGetStage(self->_previousWidth,   width,   1.0f);
+    int balanceStage = HugStereoFieldGetStage(self->_previousBalance, balance, 0.0f);
+
+    sKernels[widthStage][balanceStage](
+        left, right, frameCount,
+        self->_previousWidth, width,
+        self->_previousBalance, balance
+    );
+
+    self->_previousWidth   = width;
+    self->_previousBalance = balance;
+}
+
+
+void HugStereoFieldSetMaxFrameCount(HugStereoField *self, size_t maxFrameCount)
+{
+    self->_maxFrameCount = maxFrameCount;
+}
+
+
+size_t HugStereoFieldGetMaxFrameCount(const HugStereoField *self)
+{
+    return self->_maxFrameCount;
+}
+
+
+float HugStereoFieldGetBalance(const HugStereoField *self)
+{
+    return self->_previousBalance;
+}
+
+
+float HugStereoFieldGetWidth(const HugStereoField *self)
+{
+    return self->_previousWidth;
+}
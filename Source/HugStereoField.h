@@ -1,7 +1,13 @@
 // (c) 2014-2024 Ricci Adams
 // MIT License (or) 1-clause BSD License
 
-#import <Foundation/Foundation.h>
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct HugStereoField HugStereoField;
 
@@ -13,3 +19,11 @@ extern void HugStereoFieldProcess(HugStereoField *self, float *left, float *righ
 
 extern void HugStereoFieldSetMaxFrameCount(HugStereoField *field, size_t maxFrameCount);
 extern size_t HugStereoFieldGetMaxFrameCount(const HugStereoField *field);
+
+// Values reached at the end of the last processed block
+extern float HugStereoFieldGetBalance(const HugStereoField *field);
+extern float HugStereoFieldGetWidth(const HugStereoField *field);
+
+#ifdef __cplusplus
+}
+#endif
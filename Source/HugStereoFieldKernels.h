@@ -0,0 +1,94 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Per-sample stereo field math, shared by HugStereoField.c and the fused
+// kernel in HugRenderChain.c so that both produce identical samples.
+//
+// Balance attenuates the opposite channel by (1 -/+ balance)^3. That is an
+// exact cubic, so it is evaluated with two multiplies instead of pow().
+// Ramps interpolate with t = i * (1 / (frameCount - 1)).
+//
+
+#pragma once
+
+#include "HugSIMD.h"
+
+enum {
+    HugStereoFieldStageOff = 0,
+    HugStereoFieldStageSteady,
+    HugStereoFieldStageRamp,
+
+    HugStereoFieldStageCount
+};
+
+
+static inline int HugStereoFieldGetStage(float previous, float current, float neutral)
+{
+    if (previous == neutral && current == neutral) return HugStereoFieldStageOff;
+    return (previous == current) ? HugStereoFieldStageSteady : HugStereoFieldStageRamp;
+}
+
+
+static inline float HugStereoFieldGetRampStep(size_t frameCount)
+{
+    return 1.0f / ((float)frameCount - 1);
+}
+
+
+static inline float HugStereoFieldLerp(float from, float to, float t)
+{
+    return (from * (1.0f - t)) + (to * t);
+}
+
+
+static inline void HugStereoFieldGetWidthGains(float width, float *outMyGain, float *outOtherGain)
+{
+    *outMyGain    = (width + 1.0f) *  0.5f;
+    *outOtherGain = (width - 1.0f) * -0.5f;
+}
+
+
+static inline void HugStereoFieldGetBalanceGains(float balance, float *outLeftGain, float *outRightGain)
+{
+    float l = 1.0f - balance;
+    float r = 1.0f + balance;
+
+    l = l * l * l;
+    r = r * r * r;
+
+    *outLeftGain  = l < 1.0f ? l : 1.0f;
+    *outRightGain = r < 1.0f ? r : 1.0f;
+}
+
+
+#pragma mark - SIMD
+
+static inline HugSIMDFloat HugStereoFieldLerpSIMD(float from, float to, HugSIMDFloat t)
+{
+    HugSIMDFloat oneMinusT = HugSIMDSub(HugSIMDSplat(1.0f), t);
+    return HugSIMDAdd(HugSIMDMul(HugSIMDSplat(from), oneMinusT), HugSIMDMul(HugSIMDSplat(to), t));
+}
+
+
+static inline void HugStereoFieldGetWidthGainsSIMD(HugSIMDFloat width, HugSIMDFloat *outMyGain, HugSIMDFloat *outOtherGain)
+{
+    HugSIMDFloat one = HugSIMDSplat(1.0f);
+
+    *outMyGain    = HugSIMDMul(HugSIMDAdd(width, one), HugSIMDSplat( 0.5f));
+    *outOtherGain = HugSIMDMul(HugSIMDSub(width, one), HugSIMDSplat(-0.5f));
+}
+
+
+static inline void HugStereoFieldGetBalanceGainsSIMD(HugSIMDFloat balance, HugSIMDFloat *outLeftGain, HugSIMDFloat *outRightGain)
+{
+    HugSIMDFloat one = HugSIMDSplat(1.0f);
+
+    HugSIMDFloat l = HugSIMDSub(one, balance);
+    HugSIMDFloat r = HugSIMDAdd(one, balance);
+
+    l = HugSIMDMul(HugSIMDMul(l, l), l);
+    r = HugSIMDMul(HugSIMDMul(r, r), r);
+
+    *outLeftGain  = HugSIMDMin(l, one);
+    *outRightGain = HugSIMDMin(r, one);
+}
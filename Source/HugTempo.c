@@ -0,0 +1,417 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTempo.h"
+#include "HugFFT.h"
+#include "HugSIMD.h"
+#include "HugVectorOps.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sTargetRate       11025.0
+#define sMixLength        4096
+#define sMinimumSeconds   10.0
+#define sMeanSeconds      0.4
+#define sCombLength       4
+#define sGridStep         0.05
+#define sPreferredBPM     120.0
+#define sPreferenceWidth  1.0
+#define sDoubleRatio      0.7
+#define sDoubleTolerance  0.02
+
+
+struct HugTempo {
+    unsigned int _channels;
+    size_t _decimation;
+    double _decimatedRate;
+
+    // Mono mix of the input, starting with the samples left over from the
+    // previous call that didn't make up a whole decimated sample
+    float *_mixed;
+    size_t _carried;
+
+    float *_decimated;
+
+    float *_buffer;
+    size_t _filled;
+
+    float  *_window;
+    float  *_windowed;
+    float  *_power;
+    float  *_previous;
+    bool    _hasPrevious;
+    HugFFT *_fft;
+
+    float  *_envelope;
+    size_t  _envelopeCount;
+    size_t  _envelopeCapacity;
+};
+
+
+static bool sAddFrame(HugTempo *self)
+{
+    if (self->_envelopeCount == self->_envelopeCapacity) {
+        size_t capacity = self->_envelopeCapacity ? (self->_envelopeCapacity * 2) : 4096;
+        float *envelope = realloc(self->_envelope, capacity * sizeof(float));
+
+        if (!envelope) return false;
+
+        self->_envelope         = envelope;
+        self->_envelopeCapacity = capacity;
+    }
+
+    HugVectorMultiply(self->_buffer, self->_window, self->_windowed, HugTempoFrameLength);
+    HugFFTGetPower(self->_fft, self->_windowed, self->_power);
+
+    float *power    = self->_power;
+    float *previous = self->_previous;
+    float  flux     = 0;
+
+    // Bin 0 is left out, a shifting DC offset is no onset
+    for (size_t k = 1; k <= HugTempoFrameLength / 2; k++) {
+        float level = log1pf(power[k]);
+        float rise  = level - previous[k];
+
+        if (rise > 0) flux += rise;
+        previous[k] = level;
+    }
+
+    // The first frame rises from nothing
+    self->_envelope[self->_envelopeCount++] = self->_hasPrevious ? flux : 0;
+    self->_hasPrevious = true;
+
+    return true;
+}
+
+
+static float sDot(const float *a, const float *b, size_t count)
+{
+    size_t i = 0;
+    float sum = 0;
+
+    if (count >= HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat vsum = HugSIMDSplat(0);
+
+        for ( ; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+            vsum = HugSIMDAdd(vsum, HugSIMDMul(HugSIMDLoad(a + i), HugSIMDLoad(b + i)));
+        }
+
+        sum = HugSIMDReduceAdd(vsum);
+    }
+
+    for ( ; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+
+    return sum;
+}
+
+
+// Removes the envelope's local mean and keeps what rises above it, then
+// centers the result so that its autocorrelation is zero for unrelated lags
+static void sMakeNovelty(const float *envelope, size_t count, size_t halfWidth, float *outNovelty)
+{
+    double sum = 0;
+    size_t first = 0, last = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t windowFirst = i > halfWidth ? (i - halfWidth) : 0;
+        size_t windowLast  = (i + halfWidth + 1) < count ? (i + halfWidth + 1) : count;
+
+        while (last  < windowLast)  sum += envelope[last++];
+        while (first < windowFirst) sum -= envelope[first++];
+
+        float novelty = envelope[i] - (float)(sum / (windowLast - windowFirst));
+        outNovelty[i] = novelty > 0 ? novelty : 0;
+    }
+
+    double mean = 0;
+    for (size_t i = 0; i < count; i++) mean += outNovelty[i];
+    mean /= count;
+
+    for (size_t i = 0; i < count; i++) outNovelty[i] -= (float)mean;
+}
+
+
+static double sInterpolate(const float *values, double position)
+{
+    size_t index = (size_t)position;
+    double fraction = position - index;
+
+    return values[index] + (fraction * (values[index + 1] - values[index]));
+}
+
+
+// Index of the best score within tolerance of bpm, or SIZE_MAX if bpm is off the grid
+static size_t sFindPeak(const double *scores, size_t count, double bpm)
+{
+    double low  = (bpm * (1 - sDoubleTolerance) - HugTempoMinimumBPM) / sGridStep;
+    double high = (bpm * (1 + sDoubleTolerance) - HugTempoMinimumBPM) / sGridStep;
+
+    if (high < 0 || low >= count) return SIZE_MAX;
+
+    size_t first = low > 0 ? (size_t)ceil(low) : 0;
+    size_t last  = high < (count - 1) ? (size_t)high : (count - 1);
+    size_t best  = first;
+
+    for (size_t i = first; i <= last; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+
+    return best;
+}
+
+
+// The comb's grid and its interpolation are coarse for fast tempos, so
+// the chosen tempo is refined on the peak at the longest multiple of its
+// period that was correlated
+static double sRefine(const float *correlation, size_t lagCount, double frameRate, double bpm)
+{
+    double period = (60.0 * frameRate) / bpm;
+    size_t multiple = (size_t)((lagCount - 3) / (period * (1 + sDoubleTolerance)));
+
+    double center = multiple * period;
+    size_t first  = (size_t)(center * (1 - sDoubleTolerance));
+    size_t last   = (size_t)(center * (1 + sDoubleTolerance)) + 1;
+
+    if (first < 1) first = 1;
+
+    size_t peak = first;
+
+    for (size_t lag = first; lag <= last; lag++) {
+        if (correlation[lag] > correlation[peak]) peak = lag;
+    }
+
+    if (peak == first || peak == last) return bpm;
+
+    double before = correlation[peak - 1];
+    double at     = correlation[peak];
+    double after  = correlation[peak + 1];
+    double curvature = before - (2 * at) + after;
+
+    if (!(curvature < 0)) return bpm;
+
+    double offset = (0.5 * (before - after)) / curvature;
+
+    return (60.0 * frameRate * multiple) / (peak + offset);
+}
+
+
+// Picks the tempo from the normalized autocorrelation of the novelty,
+// scores has room for the whole grid
+static void sPickTempo(const float *correlation, size_t lagCount, double frameRate, double *scores, size_t scoreCount, double *outBeatsPerMinute, double *outConfidence)
+{
+    size_t best = 0;
+    double bestWeighted = -INFINITY;
+
+    for (size_t i = 0; i < scoreCount; i++) {
+        double bpm = HugTempoMinimumBPM + (i * sGridStep);
+        double period = (60.0 * frameRate) / bpm;
+        double score = 0;
+
+        for (size_t k = 1; k <= sCombLength; k++) {
+            score += sInterpolate(correlation, k * period);
+        }
+
+        score /= sCombLength;
+        scores[i] = score;
+
+        double octaves  = log2(bpm / sPreferredBPM) / sPreferenceWidth;
+        double weighted = score * exp(-0.5 * octaves * octaves);
+
+        if (weighted > bestWeighted) {
+            bestWeighted = weighted;
+            best = i;
+        }
+    }
+
+    // A beat that repeats every other beat also fits half the tempo
+    size_t doubled = sFindPeak(scores, scoreCount, 2 * (HugTempoMinimumBPM + (best * sGridStep)));
+
+    if (doubled != SIZE_MAX && scores[doubled] >= (sDoubleRatio * scores[best])) {
+        best = doubled;
+    }
+
+    double confidence = scores[best];
+
+    *outBeatsPerMinute = sRefine(correlation, lagCount, frameRate, HugTempoMinimumBPM + (best * sGridStep));
+    *outConfidence     = confidence > 0 ? (confidence < 1 ? confidence : 1) : 0;
+}
+
+
+#pragma mark - Lifecycle
+
+HugTempo *HugTempoCreate(unsigned int channels, double sampleRate)
+{
+    if (!channels || !(sampleRate > 0)) return NULL;
+
+    HugTempo *self = calloc(1, sizeof(HugTempo));
+    if (!self) return NULL;
+
+    long decimation = lround(sampleRate / sTargetRate);
+
+    self->_channels      = channels;
+    self->_decimation    = decimation > 1 ? decimation : 1;
+    self->_decimatedRate = sampleRate / self->_decimation;
+
+    size_t binLimit = (HugTempoFrameLength / 2) + 1;
+
+    self->_mixed     = malloc((sMixLength + self->_decimation) * sizeof(float));
+    self->_decimated = malloc(((sMixLength / self->_decimation) + 1) * sizeof(float));
+    self->_buffer    = malloc(HugTempoFrameLength * sizeof(float));
+    self->_window    = malloc(HugTempoFrameLength * sizeof(float));
+    self->_windowed  = malloc(HugTempoFrameLength * sizeof(float));
+    self->_power     = malloc(binLimit * sizeof(float));
+    self->_previous  = malloc(binLimit * sizeof(float));
+    self->_fft       = HugFFTCreate(HugTempoFrameLength);
+
+    if (!self->_mixed || !self->_decimated || !self->_buffer || !self->_window ||
+        !self->_windowed || !self->_power || !self->_previous || !self->_fft
+    ) {
+        HugTempoFree(self);
+        return NULL;
+    }
+
+    // The window also averages the mixed and decimated samples
+    double scale = 1.0 / (channels * self->_decimation);
+
+    for (size_t i = 0; i < HugTempoFrameLength; i++) {
+        self->_window[i] = scale * (0.5 - (0.5 * cos((2.0 * M_PI * i) / HugTempoFrameLength)));
+    }
+
+    return self;
+}
+
+
+void HugTempoFree(HugTempo *self)
+{
+    if (!self) return;
+
+    HugFFTFree(self->_fft);
+
+    free(self->_mixed);
+    free(self->_decimated);
+    free(self->_buffer);
+    free(self->_window);
+    free(self->_windowed);
+    free(self->_power);
+    free(self->_previous);
+    free(self->_envelope);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+bool HugTempoProcess(HugTempo *self, const float * const *channels, size_t frames)
+{
+    unsigned int channelCount = self->_channels;
+    size_t decimation = self->_decimation;
+
+    float *mixed     = self->_mixed;
+    float *decimated = self->_decimated;
+
+    for (size_t offset = 0; offset < frames; offset += sMixLength) {
+        size_t count = frames - offset;
+        if (count > sMixLength) count = sMixLength;
+
+        float *destination = mixed + self->_carried;
+
+        memcpy(destination, channels[0] + offset, count * sizeof(float));
+
+        for (unsigned int c = 1; c < channelCount; c++) {
+            const float *samples = channels[c] + offset;
+
+            for (size_t i = 0; i < count; i++) {
+                destination[i] += samples[i];
+            }
+        }
+
+        size_t total = self->_carried + count;
+        size_t decimatedCount = total / decimation;
+
+        for (size_t i = 0; i < decimatedCount; i++) {
+            decimated[i] = mixed[i * decimation];
+        }
+
+        for (size_t j = 1; j < decimation; j++) {
+            for (size_t i = 0; i < decimatedCount; i++) {
+                decimated[i] += mixed[(i * decimation) + j];
+            }
+        }
+
+        self->_carried = total - (decimatedCount * decimation);
+        memmove(mixed, mixed + (decimatedCount * decimation), self->_carried * sizeof(float));
+
+        for (size_t i = 0; i < decimatedCount; ) {
+            size_t available = HugTempoFrameLength - self->_filled;
+            size_t copied = decimatedCount - i;
+            if (copied > available) copied = available;
+
+            memcpy(self->_buffer + self->_filled, decimated + i, copied * sizeof(float));
+
+            self->_filled += copied;
+            i += copied;
+
+            if (self->_filled == HugTempoFrameLength) {
+                if (!sAddFrame(self)) return false;
+
+                size_t kept = HugTempoFrameLength - HugTempoHopLength;
+                memmove(self->_buffer, self->_buffer + HugTempoHopLength, kept * sizeof(float));
+                self->_filled = kept;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool HugTempoGetEstimate(const HugTempo *self, double *outBeatsPerMinute, double *outConfidence)
+{
+    double frameRate = self->_decimatedRate / HugTempoHopLength;
+    size_t count = self->_envelopeCount;
+
+    if (count < (sMinimumSeconds * frameRate)) return false;
+
+    // Long enough for the comb at the slowest tempo, plus one for interpolation
+    size_t lagCount   = (size_t)ceil((sCombLength * 60.0 * frameRate) / HugTempoMinimumBPM) + 2;
+    size_t scoreCount = (size_t)((HugTempoMaximumBPM - HugTempoMinimumBPM) / sGridStep) + 1;
+
+    float  *novelty     = malloc(count * sizeof(float));
+    float  *correlation = malloc(lagCount * sizeof(float));
+    double *scores      = malloc(scoreCount * sizeof(double));
+
+    float energy = 0;
+
+    if (novelty && correlation && scores) {
+        sMakeNovelty(self->_envelope, count, (size_t)lround((sMeanSeconds * frameRate) / 2), novelty);
+        energy = sDot(novelty, novelty, count) / count;
+    }
+
+    // Silence, or a steady tone, has no onsets to correlate
+    bool result = energy > 0;
+
+    if (result) {
+        // Normalized so that lag 0 is 1, with each lag averaged over the
+        // products it has
+        for (size_t lag = 0; lag < lagCount; lag++) {
+            correlation[lag] = sDot(novelty, novelty + lag, count - lag) / ((count - lag) * energy);
+        }
+
+        double bpm, confidence;
+        sPickTempo(correlation, lagCount, frameRate, scores, scoreCount, &bpm, &confidence);
+
+        if (outBeatsPerMinute) *outBeatsPerMinute = bpm;
+        if (outConfidence)     *outConfidence     = confidence;
+    }
+
+    free(novelty);
+    free(correlation);
+    free(scores);
+
+    return result;
+}
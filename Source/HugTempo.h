@@ -0,0 +1,53 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Tempo estimate for tracks whose tags lack a BPM, collected while the track
+// is decoded for loudness.
+//
+// The audio is mixed to mono and decimated to about 11 kHz. Every
+// HugTempoHopLength decimated samples, a Hann-windowed frame of
+// HugTempoFrameLength samples is transformed, and the rise in log power
+// summed over the bins (spectral flux) becomes one sample of an onset
+// envelope at about 86 Hz.
+//
+// At the end, the envelope's autocorrelation is scored with a comb at the
+// first four multiples of each beat period from HugTempoMinimumBPM to
+// HugTempoMaximumBPM. A broad preference for tempos near 120 BPM settles
+// between a tempo and its half, and the double still wins when it scores at
+// least 70% as well, since clicks at 180 BPM also repeat at 90 and a fast
+// kick and snare pattern repeats best at half its tempo. The result is then
+// refined on the autocorrelation peak at the longest multiple of the beat.
+//
+// The confidence is the comb's mean normalized autocorrelation, from 0 for
+// noise to near 1 for a metronome.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HugTempoFrameLength 512
+#define HugTempoHopLength   128
+#define HugTempoMinimumBPM  60.0
+#define HugTempoMaximumBPM  200.0
+
+typedef struct HugTempo HugTempo;
+
+extern HugTempo *HugTempoCreate(unsigned int channels, double sampleRate);
+extern void HugTempoFree(HugTempo *tempo);
+
+// Returns false if memory runs out; the envelope collected so far is kept
+extern bool HugTempoProcess(HugTempo *tempo, const float * const *channels, size_t frames);
+
+// Returns false if fewer than ten seconds were processed, or they had no
+// onsets at all
+extern bool HugTempoGetEstimate(const HugTempo *tempo, double *outBeatsPerMinute, double *outConfidence);
+
+#ifdef __cplusplus
+}
+#endif
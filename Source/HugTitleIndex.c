@@ -0,0 +1,429 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTitleIndex.h"
+#include "HugLSHTable.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 16 bands of 4 rows: a pair at 0.7 similarity shares a band 99% of the
+// time, one right at 0.6 about 89%, one at 0.2 under 3%. Three-row bands
+// find a few more pairs near the threshold, but check over twice as many
+// candidates.
+//
+#define sBandCount   16
+#define sRowCount    4
+#define sHashCount   (sBandCount * sRowCount)
+
+
+typedef struct {
+    uint32_t *grams;        // Sorted, unique trigrams
+    uint32_t  gramCount;
+    bool      used;
+} HugTitleIndexItem;
+
+
+struct HugTitleIndex {
+    double _threshold;
+
+    HugTitleIndexItem *_items;
+    size_t _itemCapacity;
+    size_t _itemCount;      // Slots handed out, including free ones
+    size_t _usedCount;
+
+    size_t *_freeSlots;
+    size_t  _freeCount;
+
+    HugLSHTable *_table;
+};
+
+
+typedef struct {
+    HugTitleIndex *index;
+    size_t         slot;
+    size_t        *result;
+    size_t         count;
+    size_t         capacity;
+    bool           failed;
+} HugTitleIndexQuery;
+
+
+static const char * const sFeaturingWords[] = { "feat", "ft", "featuring", NULL };
+
+static const char * const sVersionWords[] = {
+    "bootleg", "club", "dub", "edit", "extended", "instrumental", "mix", "original",
+    "radio", "remaster", "remastered", "remix", "rework", "rmx", "version", "vip", NULL
+};
+
+
+static uint32_t sMix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+
+    return x;
+}
+
+
+static int sCompareGrams(const void *a, const void *b)
+{
+    uint32_t ga = *(const uint32_t *)a;
+    uint32_t gb = *(const uint32_t *)b;
+
+    return (ga > gb) - (ga < gb);
+}
+
+
+static bool sIsWord(const char *token, size_t length, const char * const *words)
+{
+    for ( ; *words; words++) {
+        if (strlen(*words) == length && !memcmp(*words, token, length)) return true;
+    }
+
+    return false;
+}
+
+
+#pragma mark - Normalization
+
+// Writes " word word ... " to outString: lowercased, single-spaced, with the
+// featuring clause and trailing version words dropped. The first word always
+// stays. Returns false if memory runs out.
+//
+static bool sNormalize(const char *title, char *outString, size_t *outLength)
+{
+    size_t length = strlen(title);
+
+    char *lowered = outString + length + 3;
+    size_t *starts  = malloc(((length / 2) + 1) * sizeof(size_t));
+    size_t *lengths = malloc(((length / 2) + 1) * sizeof(size_t));
+    size_t tokenCount = 0;
+
+    if (!starts || !lengths) {
+        free(starts);
+        free(lengths);
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        char c = title[i];
+        lowered[i] = (c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c;
+    }
+
+    for (size_t i = 0; i < length; ) {
+        while (i < length && lowered[i] == ' ') i++;
+        if (i == length) break;
+
+        size_t start = i;
+        while (i < length && lowered[i] != ' ') i++;
+
+        starts[tokenCount]  = start;
+        lengths[tokenCount] = i - start;
+        tokenCount++;
+    }
+
+    for (size_t t = 1; t < tokenCount; t++) {
+        if (sIsWord(lowered + starts[t], lengths[t], sFeaturingWords)) {
+            tokenCount = t;
+            break;
+        }
+    }
+
+    while (tokenCount > 1 && sIsWord(lowered + starts[tokenCount - 1], lengths[tokenCount - 1], sVersionWords)) {
+        tokenCount--;
+    }
+
+    size_t written = 0;
+    outString[written++] = ' ';
+
+    for (size_t t = 0; t < tokenCount; t++) {
+        memmove(outString + written, lowered + starts[t], lengths[t]);
+        written += lengths[t];
+        outString[written++] = ' ';
+    }
+
+    free(starts);
+    free(lengths);
+
+    *outLength = tokenCount ? written : 0;
+
+    return true;
+}
+
+
+#pragma mark - Items
+
+static bool sMakeGrams(HugTitleIndexItem *item, const char *title)
+{
+    size_t length = strlen(title);
+
+    // The normalized string, then the lowered copy it is built from
+    char *string = malloc((length * 2) + 4);
+    if (!string) return false;
+
+    size_t stringLength = 0;
+
+    if (!sNormalize(title, string, &stringLength)) {
+        free(string);
+        return false;
+    }
+
+    size_t gramCount = stringLength >= 3 ? (stringLength - 2) : 0;
+
+    item->grams = malloc((gramCount ? gramCount : 1) * sizeof(uint32_t));
+
+    if (!item->grams) {
+        free(string);
+        return false;
+    }
+
+    for (size_t i = 0; i < gramCount; i++) {
+        const uint8_t *bytes = (const uint8_t *)string + i;
+        item->grams[i] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+    }
+
+    qsort(item->grams, gramCount, sizeof(uint32_t), sCompareGrams);
+
+    size_t uniqueCount = 0;
+
+    for (size_t i = 0; i < gramCount; i++) {
+        if (!uniqueCount || item->grams[uniqueCount - 1] != item->grams[i]) {
+            item->grams[uniqueCount++] = item->grams[i];
+        }
+    }
+
+    item->gramCount = (uint32_t)uniqueCount;
+
+    free(string);
+
+    return true;
+}
+
+
+static void sMakeBandKeys(const HugTitleIndexItem *item, uint64_t *outKeys)
+{
+    uint32_t signature[sHashCount];
+
+    for (size_t h = 0; h < sHashCount; h++) {
+        uint32_t seed = sMix32((uint32_t)h + 1) * 0x9e3779b9u;
+        uint32_t minimum = UINT32_MAX;
+
+        for (size_t g = 0; g < item->gramCount; g++) {
+            uint32_t value = sMix32(item->grams[g] ^ seed);
+            if (value < minimum) minimum = value;
+        }
+
+        signature[h] = minimum;
+    }
+
+    for (size_t b = 0; b < sBandCount; b++) {
+        uint64_t key = b;
+
+        for (size_t r = 0; r < sRowCount; r++) {
+            key = (key ^ signature[(b * sRowCount) + r]) * 0x9e3779b97f4a7c15ull;
+            key ^= key >> 32;
+        }
+
+        outKeys[b] = key;
+    }
+}
+
+
+static double sGetSimilarity(const HugTitleIndexItem *a, const HugTitleIndexItem *b)
+{
+    if (!a->gramCount || !b->gramCount) return 0;
+
+    size_t i = 0, j = 0, shared = 0;
+
+    while (i < a->gramCount && j < b->gramCount) {
+        uint32_t ga = a->grams[i];
+        uint32_t gb = b->grams[j];
+
+        shared += (ga == gb);
+        i += (ga <= gb);
+        j += (gb <= ga);
+    }
+
+    return shared / (double)(a->gramCount + b->gramCount - shared);
+}
+
+
+// The similarity can be no more than the ratio of the set sizes
+static bool sIsSimilar(const HugTitleIndex *self, const HugTitleIndexItem *a, const HugTitleIndexItem *b)
+{
+    uint32_t smaller = a->gramCount < b->gramCount ? a->gramCount : b->gramCount;
+    uint32_t larger  = a->gramCount < b->gramCount ? b->gramCount : a->gramCount;
+
+    if (smaller < self->_threshold * larger) return false;
+
+    return sGetSimilarity(a, b) >= self->_threshold;
+}
+
+
+static void sVisitCandidate(void *context, size_t other)
+{
+    HugTitleIndexQuery *query = context;
+    HugTitleIndex *self = query->index;
+
+    if (query->failed) return;
+    if (!sIsSimilar(self, &self->_items[query->slot], &self->_items[other])) return;
+
+    if (query->count == query->capacity) {
+        size_t capacity = query->capacity ? (query->capacity * 2) : 8;
+        size_t *result = realloc(query->result, capacity * sizeof(size_t));
+
+        if (!result) {
+            query->failed = true;
+            return;
+        }
+
+        query->result   = result;
+        query->capacity = capacity;
+    }
+
+    query->result[query->count++] = other;
+}
+
+
+#pragma mark - Lifecycle
+
+HugTitleIndex *HugTitleIndexCreate(double threshold)
+{
+    HugTitleIndex *self = calloc(1, sizeof(HugTitleIndex));
+    if (!self) return NULL;
+
+    self->_threshold = threshold;
+    self->_table     = HugLSHTableCreate(sBandCount);
+
+    if (!self->_table) {
+        HugTitleIndexFree(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+void HugTitleIndexFree(HugTitleIndex *self)
+{
+    if (!self) return;
+
+    for (size_t slot = 0; slot < self->_itemCount; slot++) {
+        free(self->_items[slot].grams);
+    }
+
+    HugLSHTableFree(self->_table);
+
+    free(self->_items);
+    free(self->_freeSlots);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+size_t HugTitleIndexInsert(HugTitleIndex *self, const char *title)
+{
+    if (!self->_freeCount && self->_itemCount == self->_itemCapacity) {
+        size_t capacity = self->_itemCapacity ? (self->_itemCapacity * 2) : 64;
+
+        HugTitleIndexItem *items = realloc(self->_items, capacity * sizeof(HugTitleIndexItem));
+        if (!items) return HugTitleIndexNotFound;
+        self->_items = items;
+
+        size_t *freeSlots = realloc(self->_freeSlots, capacity * sizeof(size_t));
+        if (!freeSlots) return HugTitleIndexNotFound;
+        self->_freeSlots = freeSlots;
+
+        self->_itemCapacity = capacity;
+    }
+
+    HugTitleIndexItem item = {0};
+
+    if (!sMakeGrams(&item, title ? title : "")) {
+        return HugTitleIndexNotFound;
+    }
+
+    size_t slot = self->_freeCount ? self->_freeSlots[self->_freeCount - 1] : self->_itemCount;
+
+    // An empty title has no candidates, so it stays out of the table
+    if (item.gramCount) {
+        uint64_t keys[sBandCount];
+        sMakeBandKeys(&item, keys);
+
+        if (!HugLSHTableInsert(self->_table, slot, keys)) {
+            free(item.grams);
+            return HugTitleIndexNotFound;
+        }
+    }
+
+    if (self->_freeCount) {
+        self->_freeCount--;
+    } else {
+        self->_itemCount++;
+    }
+
+    item.used = true;
+
+    self->_items[slot] = item;
+    self->_usedCount++;
+
+    return slot;
+}
+
+
+void HugTitleIndexRemove(HugTitleIndex *self, size_t slot)
+{
+    if (slot >= self->_itemCount || !self->_items[slot].used) return;
+
+    HugTitleIndexItem *item = &self->_items[slot];
+
+    HugLSHTableRemove(self->_table, slot);
+
+    free(item->grams);
+    item->grams     = NULL;
+    item->gramCount = 0;
+    item->used      = false;
+
+    self->_freeSlots[self->_freeCount++] = slot;
+    self->_usedCount--;
+}
+
+
+size_t HugTitleIndexGetCount(const HugTitleIndex *self)
+{
+    return self->_usedCount;
+}
+
+
+size_t *HugTitleIndexCopySimilar(HugTitleIndex *self, size_t slot, size_t *outCount)
+{
+    *outCount = 0;
+
+    if (slot >= self->_itemCount || !self->_items[slot].used) return NULL;
+
+    HugTitleIndexQuery query = { .index = self, .slot = slot };
+    HugLSHTableVisitCandidates(self->_table, slot, sVisitCandidate, &query);
+
+    if (query.failed) {
+        free(query.result);
+        return NULL;
+    }
+
+    *outCount = query.count;
+
+    return query.result;
+}
+
+
+double HugTitleIndexGetSimilarity(const HugTitleIndex *self, size_t slotA, size_t slotB)
+{
+    if (slotA >= self->_itemCount || slotB >= self->_itemCount) return 0;
+
+    return sGetSimilarity(&self->_items[slotA], &self->_items[slotB]);
+}
@@ -0,0 +1,55 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Finds titles that are near-duplicates of each other, such as remixes,
+// "feat." variants, and small misspellings.
+//
+// Titles are expected to be simplified already (see GetSimplifiedString()).
+// A trailing "feat"/"ft"/"featuring" clause and trailing version words
+// ("radio edit", "extended mix", ...) are then dropped, and what is left is
+// compared as a set of character trigrams. Two titles are similar when the
+// Jaccard similarity of their sets reaches the index's threshold.
+//
+// Candidates come from MinHash signatures banded into LSH tables, so adding,
+// removing, or querying a title only looks at titles that share a band with
+// it rather than at every title. Candidates are then checked against their
+// exact similarity, so the results never contain a pair under the threshold.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugTitleIndex HugTitleIndex;
+
+#define HugTitleIndexNotFound ((size_t)-1)
+
+// threshold is the minimum Jaccard similarity, 0 to 1
+extern HugTitleIndex *HugTitleIndexCreate(double threshold);
+extern void HugTitleIndexFree(HugTitleIndex *index);
+
+// Adds a UTF-8 title and returns its slot, or HugTitleIndexNotFound if
+// memory runs out. Slots of removed titles are reused. An empty title is
+// similar to nothing.
+//
+extern size_t HugTitleIndexInsert(HugTitleIndex *index, const char *title);
+extern void HugTitleIndexRemove(HugTitleIndex *index, size_t slot);
+
+extern size_t HugTitleIndexGetCount(const HugTitleIndex *index);
+
+// Returns a malloc'd array of the other slots similar to slot, or NULL if
+// there are none.
+//
+extern size_t *HugTitleIndexCopySimilar(HugTitleIndex *index, size_t slot, size_t *outCount);
+
+// Exact trigram Jaccard similarity of two slots, 0 if either is empty
+extern double HugTitleIndexGetSimilarity(const HugTitleIndex *index, size_t slotA, size_t slotB);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,133 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTripleBuffer.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Set in _middle when it holds a slot the consumer hasn't taken yet
+static const unsigned int sFreshBit = 0x4;
+
+static const size_t sSlotAlignment = 128;
+
+
+struct HugTripleBuffer {
+    uint8_t *_bytes;
+    size_t   _size;
+    size_t   _stride;
+
+    // Slot index, plus sFreshBit
+    _Atomic unsigned int _middle __attribute__((aligned(128)));
+
+    // Producer
+    unsigned int _back __attribute__((aligned(128)));
+
+    // Consumer
+    unsigned int _front __attribute__((aligned(128)));
+};
+
+
+#pragma mark - Lifecycle
+
+HugTripleBuffer *HugTripleBufferCreate(size_t size)
+{
+    size_t stride = ((size + sSlotAlignment - 1) / sSlotAlignment) * sSlotAlignment;
+    if (!stride) stride = sSlotAlignment;
+
+    uint8_t *bytes = aligned_alloc(sSlotAlignment, stride * 3);
+    if (!bytes) return NULL;
+
+    memset(bytes, 0, stride * 3);
+
+    HugTripleBuffer *self = aligned_alloc(sSlotAlignment, sizeof(HugTripleBuffer));
+
+    if (!self) {
+        free(bytes);
+        return NULL;
+    }
+
+    memset(self, 0, sizeof(HugTripleBuffer));
+
+    self->_bytes  = bytes;
+    self->_size   = size;
+    self->_stride = stride;
+
+    self->_front = 0;
+    self->_back  = 2;
+    atomic_init(&self->_middle, 1);
+
+    return self;
+}
+
+
+void HugTripleBufferFree(HugTripleBuffer *self)
+{
+    if (!self) return;
+
+    free(self->_bytes);
+    free(self);
+}
+
+
+#pragma mark - Producer
+
+void *HugTripleBufferGetWritePtr(HugTripleBuffer *self)
+{
+    return self->_bytes + (self->_back * self->_stride);
+}
+
+
+void HugTripleBufferPublish(HugTripleBuffer *self)
+{
+    unsigned int previous = atomic_exchange_explicit(&self->_middle, self->_back | sFreshBit, memory_order_acq_rel);
+    self->_back = previous & ~sFreshBit;
+}
+
+
+void HugTripleBufferWrite(HugTripleBuffer *self, const void *bytes, size_t length)
+{
+    if (length > self->_size) length = self->_size;
+
+    memcpy(HugTripleBufferGetWritePtr(self), bytes, length);
+    HugTripleBufferPublish(self);
+}
+
+
+#pragma mark - Consumer
+
+const void *HugTripleBufferGetReadPtr(HugTripleBuffer *self, bool *outIsNew)
+{
+    bool isNew = false;
+
+    if (atomic_load_explicit(&self->_middle, memory_order_relaxed) & sFreshBit) {
+        unsigned int previous = atomic_exchange_explicit(&self->_middle, self->_front, memory_order_acq_rel);
+        self->_front = previous & ~sFreshBit;
+        isNew = true;
+    }
+
+    if (outIsNew) *outIsNew = isNew;
+
+    return self->_bytes + (self->_front * self->_stride);
+}
+
+
+bool HugTripleBufferRead(HugTripleBuffer *self, void *bytes, size_t length)
+{
+    if (length > self->_size) length = self->_size;
+
+    bool isNew;
+    memcpy(bytes, HugTripleBufferGetReadPtr(self, &isNew), length);
+
+    return isNew;
+}
+
+
+#pragma mark - Accessors
+
+size_t HugTripleBufferGetSize(const HugTripleBuffer *self)
+{
+    return self->_size;
+}
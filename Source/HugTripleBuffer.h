@@ -0,0 +1,46 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Wait-free single-producer, single-consumer channel for values where only
+// the latest one matters. The producer writes into a back slot and swaps it
+// with the middle slot; the consumer swaps the middle slot with its front
+// slot when something new was published. Neither side ever blocks or fails,
+// no matter how long the other one stalls.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugTripleBuffer HugTripleBuffer;
+
+// Each of the three slots holds size bytes and starts zeroed
+extern HugTripleBuffer *HugTripleBufferCreate(size_t size);
+extern void HugTripleBufferFree(HugTripleBuffer *buffer);
+
+extern size_t HugTripleBufferGetSize(const HugTripleBuffer *buffer);
+
+// Producer: fill the slot returned by GetWritePtr(), then Publish()
+extern void *HugTripleBufferGetWritePtr(HugTripleBuffer *buffer);
+extern void  HugTripleBufferPublish(HugTripleBuffer *buffer);
+
+// Copies length bytes (at most the slot size) and publishes them
+extern void HugTripleBufferWrite(HugTripleBuffer *buffer, const void *bytes, size_t length);
+
+// Consumer: returns the most recently published slot, which stays valid
+// until the next call. outIsNew reports whether it was published since
+// the previous call.
+//
+extern const void *HugTripleBufferGetReadPtr(HugTripleBuffer *buffer, bool *outIsNew);
+
+// Copies the most recently published value, returns true if it is new
+extern bool HugTripleBufferRead(HugTripleBuffer *buffer, void *bytes, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
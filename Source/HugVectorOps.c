@@ -0,0 +1,313 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugVectorOps.h"
+#include "HugSIMD.h"
+
+#if HUG_USE_ACCELERATE
+#include <Accelerate/Accelerate.h>
+#endif
+
+
+const char *HugVectorGetBackendName(void)
+{
+#if HUG_USE_ACCELERATE
+    return "Accelerate";
+#else
+    return HUG_SIMD_NAME;
+#endif
+}
+
+
+void HugVectorGetMinMax(const float *src, size_t count, float *outMin, float *outMax)
+{
+    if (!count) {
+        *outMin = 0;
+        *outMax = 0;
+        return;
+    }
+
+#if HUG_USE_ACCELERATE
+    vDSP_minv(src, 1, outMin, count);
+    vDSP_maxv(src, 1, outMax, count);
+#else
+    size_t i = 0;
+    float min = src[0];
+    float max = src[0];
+
+    if (count >= HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat vMin = HugSIMDLoad(src);
+        HugSIMDFloat vMax = vMin;
+
+        for (i = HUG_SIMD_FLOAT_LANES; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat v = HugSIMDLoad(src + i);
+            vMin = HugSIMDMin(vMin, v);
+            vMax = HugSIMDMax(vMax, v);
+        }
+
+        min = HugSIMDReduceMin(vMin);
+        max = HugSIMDReduceMax(vMax);
+    }
+
+    for ( ; i < count; i++) {
+        if (src[i] < min) min = src[i];
+        if (src[i] > max) max = src[i];
+    }
+
+    *outMin = min;
+    *outMax = max;
+#endif
+}
+
+
+void HugVectorGetMaxMagnitude(const float *src, size_t count, float *outMax, size_t *outIndex)
+{
+    float  max      = 0;
+    size_t maxIndex = 0;
+
+    if (count) {
+        float bufferMin, bufferMax;
+        HugVectorGetMinMax(src, count, &bufferMin, &bufferMax);
+
+        float target = bufferMax;
+        if (-bufferMin > bufferMax) target = bufferMin;
+
+        if (outIndex) {
+            while (maxIndex < count && src[maxIndex] != target) {
+                maxIndex++;
+            }
+        }
+
+        if (target < 0) target = -target;
+        if (target > max) {
+            max = target;
+        } else {
+            maxIndex = 0;
+        }
+    }
+
+    *outMax = max;
+    if (outIndex) *outIndex = maxIndex;
+}
+
+
+float HugVectorGetMeanSquare(const float *src, size_t count)
+{
+    if (!count) return 0;
+
+#if HUG_USE_ACCELERATE
+    float result;
+    vDSP_measqv(src, 1, &result, count);
+    return result;
+#else
+    size_t i = 0;
+    float sum = 0;
+
+    if (count >= HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat vSum = HugSIMDSplat(0);
+
+        for ( ; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat v = HugSIMDLoad(src + i);
+            vSum = HugSIMDAdd(vSum, HugSIMDMul(v, v));
+        }
+
+        sum = HugSIMDReduceAdd(vSum);
+    }
+
+    for ( ; i < count; i++) {
+        sum += src[i] * src[i];
+    }
+
+    return sum / (float)count;
+#endif
+}
+
+
+void HugVectorGetMinMaxSumOfSquares(const float *src, size_t count, float *outMin, float *outMax, float *outSumOfSquares)
+{
+    if (!count) {
+        *outMin = 0;
+        *outMax = 0;
+        *outSumOfSquares = 0;
+        return;
+    }
+
+#if HUG_USE_ACCELERATE
+    vDSP_minv(src, 1, outMin, count);
+    vDSP_maxv(src, 1, outMax, count);
+    vDSP_svesq(src, 1, outSumOfSquares, count);
+#else
+    size_t i = 0;
+    float min = src[0];
+    float max = src[0];
+    float sum = 0;
+
+    if (count >= HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat vMin = HugSIMDLoad(src);
+        HugSIMDFloat vMax = vMin;
+        HugSIMDFloat vSum = HugSIMDMul(vMin, vMin);
+
+        for (i = HUG_SIMD_FLOAT_LANES; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat v = HugSIMDLoad(src + i);
+            vMin = HugSIMDMin(vMin, v);
+            vMax = HugSIMDMax(vMax, v);
+            vSum = HugSIMDAdd(vSum, HugSIMDMul(v, v));
+        }
+
+        min = HugSIMDReduceMin(vMin);
+        max = HugSIMDReduceMax(vMax);
+        sum = HugSIMDReduceAdd(vSum);
+    }
+
+    for ( ; i < count; i++) {
+        if (src[i] < min) min = src[i];
+        if (src[i] > max) max = src[i];
+        sum += src[i] * src[i];
+    }
+
+    *outMin = min;
+    *outMax = max;
+    *outSumOfSquares = sum;
+#endif
+}
+
+
+void HugVectorMultiplyScalar(const float *src, float scalar, float *dst, size_t count)
+{
+#if HUG_USE_ACCELERATE
+    vDSP_vsmul(src, 1, &scalar, dst, 1, count);
+#else
+    size_t i = 0;
+    HugSIMDFloat vScalar = HugSIMDSplat(scalar);
+
+    for ( ; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+        HugSIMDStore(dst + i, HugSIMDMul(HugSIMDLoad(src + i), vScalar));
+    }
+
+    for ( ; i < count; i++) {
+        dst[i] = src[i] * scalar;
+    }
+#endif
+}
+
+
+void HugVectorMultiply(const float *a, const float *b, float *dst, size_t count)
+{
+#if HUG_USE_ACCELERATE
+    vDSP_vmul(a, 1, b, 1, dst, 1, count);
+#else
+    size_t i = 0;
+
+    for ( ; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+        HugSIMDStore(dst + i, HugSIMDMul(HugSIMDLoad(a + i), HugSIMDLoad(b + i)));
+    }
+
+    for ( ; i < count; i++) {
+        dst[i] = a[i] * b[i];
+    }
+#endif
+}
+
+
+void HugVectorFillRamp(float *dst, float step, float scale, float start, size_t count)
+{
+    size_t i = 0;
+
+#if !HUG_USE_ACCELERATE
+    HugSIMDFloat vIndex = HugSIMDIota();
+    HugSIMDFloat vLanes = HugSIMDSplat(HUG_SIMD_FLOAT_LANES);
+    HugSIMDFloat vStep  = HugSIMDSplat(step);
+    HugSIMDFloat vScale = HugSIMDSplat(scale);
+    HugSIMDFloat vStart = HugSIMDSplat(start);
+
+    for ( ; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+        HugSIMDFloat v = HugSIMDMul(HugSIMDMul(vIndex, vStep), vScale);
+        HugSIMDStore(dst + i, HugSIMDAdd(v, vStart));
+        vIndex = HugSIMDAdd(vIndex, vLanes);
+    }
+#endif
+
+    for ( ; i < count; i++) {
+        dst[i] = (((float)i * step) * scale) + start;
+    }
+}
+
+
+void HugVectorConvertToDouble(const float *src, double *dst, size_t count)
+{
+#if HUG_USE_ACCELERATE
+    vDSP_vspdp(src, 1, dst, 1, count);
+#else
+    size_t i = 0;
+
+    for ( ; i + HUG_SIMD_DOUBLE_LANES <= count; i += HUG_SIMD_DOUBLE_LANES) {
+        HugSIMDStoreD(dst + i, HugSIMDConvertLowD(src + i));
+    }
+
+    for ( ; i < count; i++) {
+        dst[i] = src[i];
+    }
+#endif
+}
+
+
+void HugVectorBiquadD(const double *input, double *output, const double *coefficients, size_t count)
+{
+#if HUG_USE_ACCELERATE
+    vDSP_deq22D(input, 1, coefficients, output, 1, count);
+#else
+    const double b0 = coefficients[0];
+    const double b1 = coefficients[1];
+    const double b2 = coefficients[2];
+    const double a1 = coefficients[3];
+    const double a2 = coefficients[4];
+
+    double x1 = input[1],  x2 = input[0];
+    double y1 = output[1], y2 = output[0];
+
+    input  += 2;
+    output += 2;
+
+    // The recursion can't be vectorized across time; keep the
+    // history in registers instead of re-reading it from memory.
+    for (size_t i = 0; i < count; i++) {
+        double x0 = input[i];
+        double y0 = (b0 * x0) + (b1 * x1) + (b2 * x2) - (a1 * y1) - (a2 * y2);
+
+        output[i] = y0;
+
+        x2 = x1; x1 = x0;
+        y2 = y1; y1 = y0;
+    }
+#endif
+}
+
+
+double HugVectorGetSumOfSquaresD(const double *src, size_t count)
+{
+#if HUG_USE_ACCELERATE
+    double result = 0;
+    vDSP_svesqD(src, 1, &result, count);
+    return result;
+#else
+    size_t i = 0;
+    double sum = 0;
+
+    if (count >= HUG_SIMD_DOUBLE_LANES) {
+        HugSIMDDouble vSum = HugSIMDSplatD(0);
+
+        for ( ; i + HUG_SIMD_DOUBLE_LANES <= count; i += HUG_SIMD_DOUBLE_LANES) {
+            HugSIMDDouble v = HugSIMDLoadD(src + i);
+            vSum = HugSIMDAddD(vSum, HugSIMDMulD(v, v));
+        }
+
+        sum = HugSIMDReduceAddD(vSum);
+    }
+
+    for ( ; i < count; i++) {
+        sum += src[i] * src[i];
+    }
+
+    return sum;
+#endif
+}
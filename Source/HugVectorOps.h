@@ -0,0 +1,55 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Portable replacements for the vDSP routines used on the render thread
+// and by LoudnessMeasurer. By default these use the kernels in HugSIMD.h,
+// so the same code runs on macOS and under Linux profilers. Define
+// HUG_USE_ACCELERATE to route them back through vDSP for comparison.
+//
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const char *HugVectorGetBackendName(void);
+
+// Finds the sample with the largest magnitude. Ties resolve to the first
+// index, and a negative peak wins only if it is strictly larger than the
+// positive peak (matches vDSP_maxvi + vDSP_minvi). outIndex may be NULL.
+//
+extern void HugVectorGetMaxMagnitude(const float *src, size_t count, float *outMax, size_t *outIndex);
+
+extern void HugVectorGetMinMax(const float *src, size_t count, float *outMin, float *outMax);
+
+extern float HugVectorGetMeanSquare(const float *src, size_t count);
+
+// HugVectorGetMinMax() and the sum of squares in one pass
+extern void HugVectorGetMinMaxSumOfSquares(const float *src, size_t count, float *outMin, float *outMax, float *outSumOfSquares);
+
+// dst[i] = src[i] * scalar (vDSP_vsmul)
+extern void HugVectorMultiplyScalar(const float *src, float scalar, float *dst, size_t count);
+
+// dst[i] = a[i] * b[i] (vDSP_vmul)
+extern void HugVectorMultiply(const float *a, const float *b, float *dst, size_t count);
+
+// dst[i] = ((i * step) * scale) + start
+extern void HugVectorFillRamp(float *dst, float step, float scale, float start, size_t count);
+
+// vDSP_vspdp
+extern void HugVectorConvertToDouble(const float *src, double *dst, size_t count);
+
+// Second-order recursive filter with the same layout as vDSP_deq22D:
+// input and output point at two history samples followed by count samples,
+// coefficients are { b0, b1, b2, a1, a2 }.
+//
+extern void HugVectorBiquadD(const double *input, double *output, const double *coefficients, size_t count);
+
+extern double HugVectorGetSumOfSquaresD(const double *src, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,348 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugWorkPool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+struct HugWorkJob {
+    HugWorkJob *_next;
+
+    HugWorkJob *_runningPrev;
+    HugWorkJob *_runningNext;
+
+    HugWorkPool    *_pool;
+    HugWorkKey      _key;
+    HugWorkPriority _priority;
+    HugWorkFunction _function;
+    void           *_context;
+
+    _Atomic bool _cancelled;
+};
+
+
+struct HugWorkPool {
+    pthread_mutex_t _mutex;
+    pthread_cond_t  _workCondition;
+    pthread_cond_t  _idleCondition;
+
+    pthread_t *_threads;
+    size_t     _threadCount;
+    size_t     _busyThreads;
+    bool       _stopping;
+
+    // Indexed by HugWorkPriority
+    HugWorkJob *_heads[2];
+    HugWorkJob *_tails[2];
+    size_t      _queued[2];
+
+    HugWorkJob *_running;
+    size_t      _runningCount;
+
+    uint64_t _submitted;
+    uint64_t _completed;
+    uint64_t _cancelled;
+    uint64_t _preemptions;
+    uint64_t _busyNanoseconds;
+
+    // Read without the lock by HugWorkJobCheckpoint()
+    _Atomic size_t   _queuedImmediateHint;
+    _Atomic uint64_t _processedUnits;
+};
+
+
+static uint64_t sGetNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+// Called with _mutex held
+static HugWorkJob *sDequeue(HugWorkPool *self, HugWorkPriority priority)
+{
+    HugWorkJob *job = self->_heads[priority];
+    if (!job) return NULL;
+
+    self->_heads[priority] = job->_next;
+    if (!self->_heads[priority]) self->_tails[priority] = NULL;
+
+    self->_queued[priority]--;
+    job->_next = NULL;
+
+    if (priority == HugWorkPriorityImmediate) {
+        atomic_store_explicit(&self->_queuedImmediateHint, self->_queued[priority], memory_order_relaxed);
+    }
+
+    return job;
+}
+
+
+// Called with _mutex held, drops it while the job runs
+static void sRunJob(HugWorkPool *self, HugWorkJob *job, bool isInline)
+{
+    job->_runningPrev = NULL;
+    job->_runningNext = self->_running;
+    if (self->_running) self->_running->_runningPrev = job;
+    self->_running = job;
+    self->_runningCount++;
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    uint64_t start = sGetNanoseconds();
+    job->_function(job, job->_context);
+    uint64_t elapsed = sGetNanoseconds() - start;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    if (job->_runningPrev) job->_runningPrev->_runningNext = job->_runningNext;
+    if (job->_runningNext) job->_runningNext->_runningPrev = job->_runningPrev;
+    if (self->_running == job) self->_running = job->_runningNext;
+    self->_runningCount--;
+
+    if (atomic_load_explicit(&job->_cancelled, memory_order_relaxed)) {
+        self->_cancelled++;
+    } else {
+        self->_completed++;
+    }
+
+    // Inline jobs already count towards the job they interrupted
+    if (!isInline) self->_busyNanoseconds += elapsed;
+
+    if (!self->_runningCount && !self->_queued[0] && !self->_queued[1]) {
+        pthread_cond_broadcast(&self->_idleCondition);
+    }
+
+    free(job);
+}
+
+
+static void *sWorkerMain(void *context)
+{
+    HugWorkPool *self = context;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    while (1) {
+        HugWorkJob *job = sDequeue(self, HugWorkPriorityImmediate);
+        if (!job) job = sDequeue(self, HugWorkPriorityBackground);
+
+        if (!job) {
+            if (self->_stopping) break;
+
+            pthread_cond_wait(&self->_workCondition, &self->_mutex);
+            continue;
+        }
+
+        self->_busyThreads++;
+        sRunJob(self, job, false);
+        self->_busyThreads--;
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    return NULL;
+}
+
+
+#pragma mark - Lifecycle
+
+HugWorkPool *HugWorkPoolCreate(size_t threadCount)
+{
+    if (!threadCount) {
+        long onlineCount = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = onlineCount > 0 ? (size_t)onlineCount : 1;
+    }
+
+    HugWorkPool *self = calloc(1, sizeof(HugWorkPool));
+
+    pthread_mutex_init(&self->_mutex, NULL);
+    pthread_cond_init(&self->_workCondition, NULL);
+    pthread_cond_init(&self->_idleCondition, NULL);
+
+    self->_threads = calloc(threadCount, sizeof(pthread_t));
+
+    for (size_t i = 0; i < threadCount; i++) {
+        if (pthread_create(&self->_threads[i], NULL, sWorkerMain, self) != 0) break;
+        self->_threadCount++;
+    }
+
+    if (!self->_threadCount) {
+        HugWorkPoolFree(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+void HugWorkPoolFree(HugWorkPool *self)
+{
+    if (!self) return;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    self->_stopping = true;
+
+    for (size_t p = 0; p < 2; p++) {
+        for (HugWorkJob *job = self->_heads[p]; job; job = job->_next) {
+            atomic_store(&job->_cancelled, true);
+        }
+    }
+
+    pthread_cond_broadcast(&self->_workCondition);
+    pthread_mutex_unlock(&self->_mutex);
+
+    for (size_t i = 0; i < self->_threadCount; i++) {
+        pthread_join(self->_threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&self->_idleCondition);
+    pthread_cond_destroy(&self->_workCondition);
+    pthread_mutex_destroy(&self->_mutex);
+
+    free(self->_threads);
+    free(self);
+}
+
+
+#pragma mark - Public Functions
+
+void HugWorkPoolSubmit(HugWorkPool *self, HugWorkPriority priority, HugWorkKey key, HugWorkFunction function, void *context)
+{
+    HugWorkJob *job = calloc(1, sizeof(HugWorkJob));
+
+    job->_pool     = self;
+    job->_key      = key;
+    job->_priority = priority;
+    job->_function = function;
+    job->_context  = context;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    if (self->_tails[priority]) {
+        self->_tails[priority]->_next = job;
+    } else {
+        self->_heads[priority] = job;
+    }
+
+    self->_tails[priority] = job;
+    self->_queued[priority]++;
+    self->_submitted++;
+
+    if (priority == HugWorkPriorityImmediate) {
+        atomic_store_explicit(&self->_queuedImmediateHint, self->_queued[priority], memory_order_relaxed);
+    }
+
+    pthread_cond_signal(&self->_workCondition);
+    pthread_mutex_unlock(&self->_mutex);
+}
+
+
+void HugWorkPoolCancel(HugWorkPool *self, HugWorkKey key)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    for (size_t p = 0; p < 2; p++) {
+        for (HugWorkJob *job = self->_heads[p]; job; job = job->_next) {
+            if (!memcmp(&job->_key, &key, sizeof(HugWorkKey))) {
+                atomic_store(&job->_cancelled, true);
+            }
+        }
+    }
+
+    for (HugWorkJob *job = self->_running; job; job = job->_runningNext) {
+        if (!memcmp(&job->_key, &key, sizeof(HugWorkKey))) {
+            atomic_store(&job->_cancelled, true);
+        }
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+}
+
+
+void HugWorkPoolWaitUntilIdle(HugWorkPool *self)
+{
+    pthread_mutex_lock(&self->_mutex);
+
+    while (self->_runningCount || self->_queued[0] || self->_queued[1]) {
+        pthread_cond_wait(&self->_idleCondition, &self->_mutex);
+    }
+
+    pthread_mutex_unlock(&self->_mutex);
+}
+
+
+HugWorkPoolStats HugWorkPoolGetStats(HugWorkPool *self)
+{
+    HugWorkPoolStats stats;
+
+    pthread_mutex_lock(&self->_mutex);
+
+    stats.threadCount      = self->_threadCount;
+    stats.queuedImmediate  = self->_queued[HugWorkPriorityImmediate];
+    stats.queuedBackground = self->_queued[HugWorkPriorityBackground];
+    stats.running          = self->_runningCount;
+    stats.submitted        = self->_submitted;
+    stats.completed        = self->_completed;
+    stats.cancelled        = self->_cancelled;
+    stats.preemptions      = self->_preemptions;
+    stats.busyNanoseconds  = self->_busyNanoseconds;
+
+    pthread_mutex_unlock(&self->_mutex);
+
+    stats.processedUnits = atomic_load_explicit(&self->_processedUnits, memory_order_relaxed);
+
+    return stats;
+}
+
+
+#pragma mark - Jobs
+
+bool HugWorkJobCheckpoint(HugWorkJob *job, uint64_t processedUnits)
+{
+    HugWorkPool *pool = job->_pool;
+
+    if (processedUnits) {
+        atomic_fetch_add_explicit(&pool->_processedUnits, processedUnits, memory_order_relaxed);
+    }
+
+    if (
+        (job->_priority == HugWorkPriorityBackground) &&
+        atomic_load_explicit(&pool->_queuedImmediateHint, memory_order_relaxed)
+    ) {
+        pthread_mutex_lock(&pool->_mutex);
+
+        // Only step in when every thread is busy, else an idle one will take it
+        while (pool->_queued[HugWorkPriorityImmediate] && (pool->_busyThreads >= pool->_threadCount)) {
+            HugWorkJob *immediateJob = sDequeue(pool, HugWorkPriorityImmediate);
+
+            pool->_preemptions++;
+            sRunJob(pool, immediateJob, true);
+        }
+
+        pthread_mutex_unlock(&pool->_mutex);
+    }
+
+    return !atomic_load_explicit(&job->_cancelled, memory_order_relaxed);
+}
+
+
+bool HugWorkJobIsCancelled(const HugWorkJob *job)
+{
+    return atomic_load_explicit(&job->_cancelled, memory_order_relaxed);
+}
+
+
+HugWorkPriority HugWorkJobGetPriority(const HugWorkJob *job)
+{
+    return job->_priority;
+}
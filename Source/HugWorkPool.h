@@ -0,0 +1,84 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Bounded pool of worker threads with two priorities. Immediate jobs always
+// start before background ones. Long-running jobs call HugWorkJobCheckpoint()
+// between chunks of work; a background job at a checkpoint runs any waiting
+// immediate jobs inline when no thread is free, so immediate work never waits
+// for a whole background job to finish. The checkpoint is also where
+// cancellation is noticed.
+//
+// Every submitted function is called exactly once, even if its job was
+// cancelled before it started, so that it can release its context.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HugWorkPool HugWorkPool;
+typedef struct HugWorkJob  HugWorkJob;
+
+typedef enum {
+    HugWorkPriorityImmediate = 0,
+    HugWorkPriorityBackground
+} HugWorkPriority;
+
+// Identifies the jobs to cancel, e.g. the bytes of a UUID
+typedef struct {
+    uint8_t bytes[16];
+} HugWorkKey;
+
+typedef void (*HugWorkFunction)(HugWorkJob *job, void *context);
+
+typedef struct {
+    size_t threadCount;
+    size_t queuedImmediate;
+    size_t queuedBackground;
+    size_t running;
+
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t cancelled;
+    uint64_t preemptions;
+
+    // Sum of the units passed to HugWorkJobCheckpoint(), e.g. decoded frames
+    uint64_t processedUnits;
+
+    // Time spent inside job functions, summed over all threads
+    uint64_t busyNanoseconds;
+} HugWorkPoolStats;
+
+// A threadCount of 0 uses one thread per online core
+extern HugWorkPool *HugWorkPoolCreate(size_t threadCount);
+
+// Cancels queued jobs, waits for all jobs to return, then joins the threads
+extern void HugWorkPoolFree(HugWorkPool *pool);
+
+extern void HugWorkPoolSubmit(HugWorkPool *pool, HugWorkPriority priority, HugWorkKey key, HugWorkFunction function, void *context);
+
+// Cancels every queued or running job with this key
+extern void HugWorkPoolCancel(HugWorkPool *pool, HugWorkKey key);
+
+extern void HugWorkPoolWaitUntilIdle(HugWorkPool *pool);
+
+extern HugWorkPoolStats HugWorkPoolGetStats(HugWorkPool *pool);
+
+// Called by a job function between chunks of work. Adds processedUnits to
+// the pool's counters and may run immediate jobs inline. Returns false once
+// the job is cancelled.
+//
+extern bool HugWorkJobCheckpoint(HugWorkJob *job, uint64_t processedUnits);
+
+extern bool HugWorkJobIsCancelled(const HugWorkJob *job);
+extern HugWorkPriority HugWorkJobGetPriority(const HugWorkJob *job);
+
+#ifdef __cplusplus
+}
+#endif
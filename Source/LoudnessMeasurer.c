@@ -0,0 +1,1271 @@
+/*
+    This file is not available under a 1-clause BSD License.
+    SPDX-License-Identifier: MIT
+
+    LoudnessMeasurer
+    Copyright (c) 2014-2020 Ricci Adams
+
+    Heavily based on libebur128
+    Copyright (c) 2011 Jan Kokemüller
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of
+    this software and associated documentation files (the "Software"), to deal in
+    the Software without restriction, including without limitation the rights to
+    use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+    the Software, and to permit persons to whom the Software is furnished to do so,
+    subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+    FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+    COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "LoudnessMeasurer.h"
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "HugKWeighting.h"
+#include "HugOverview.h"
+#include "HugSIMD.h"
+#include "HugVectorOps.h"
+
+// Channels are filtered in groups, one channel per lane: a stereo file
+// keeps L and R side by side in the same register.
+//
+#define sLaneCount   HUG_SIMD_DOUBLE_LANES
+#define sMaxSegments 16
+
+// Hops in a short-term (3s) block, the longest window measured
+#define sRecentHopCount 30
+
+// 0.1 LU bins from -70 to +30 LUFS, as in libebur128
+#define sHistogramBinCount 1000
+
+// 4x oversampling for true peaks, 12 taps per phase
+#define sTruePeakPhaseCount  4
+#define sTruePeakTapCount    12
+#define sTruePeakHistory     (sTruePeakTapCount - 1)
+#define sTruePeakTileFrames  256
+
+#define sDefaultSilenceDecibels -34
+#define sDefaultOnsetDecibels   -30
+
+
+// ITU-R BS.1770-4, Annex 2
+static const float sTruePeakCoefficients[sTruePeakPhaseCount][sTruePeakTapCount] = {
+    {  0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000, -0.0594482421875,  0.1373291015625,
+       0.9721679687500, -0.1022949218750,  0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+    { -0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250, -0.1665039062500,  0.4650878906250,
+       0.7797851562500, -0.2003173828125,  0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+    { -0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000, -0.2003173828125,  0.7797851562500,
+       0.4650878906250, -0.1665039062500,  0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+    { -0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750, -0.1022949218750,  0.9721679687500,
+       0.1373291015625, -0.0594482421875,  0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750 }
+};
+
+
+typedef struct LoudnessMeasurerScanState {
+    HugKWeightingLanes *_lanes;
+
+    // Per channel: running peak of the current overview block, and of everything scanned
+    float *_overviewMax;
+    float *_peak;
+
+    // Per channel: the last sTruePeakHistory input samples, and the oversampled peak
+    float *_truePeakHistory;
+    float *_truePeak;
+
+    // Per channel: running minimum, maximum and sum of squares of the current detailed bin
+    float  *_binMin;
+    float  *_binMax;
+    double *_binSum;
+
+    // Per channel: sum of squares of the current overview block, only kept
+    // while that block could still be the onset
+    double *_onsetSum;
+
+    // First audible frame and the frame after the last one, SIZE_MAX and 0
+    // until one is found. _onsetFrame is SIZE_MAX until a block reaches it.
+    //
+    size_t _audibleStart;
+    size_t _audibleEnd;
+    size_t _onsetFrame;
+
+    size_t _frameIndex;
+
+    // Segments after the first queue their hop energies here, they are
+    // added to the measurer in order once every segment is done
+    //
+    double *_pendingHops;
+    size_t  _pendingHopCount;
+} LoudnessMeasurerScanState;
+
+
+// Blocks at or above the absolute gate
+typedef struct LoudnessMeasurerBlocks {
+    // Running totals for the relative gate
+    double _energySum;
+    size_t _count;
+
+    // LoudnessMeasurerGatingBlocks: every energy, in order
+    double *_energies;
+    size_t  _capacity;
+
+    // LoudnessMeasurerGatingHistogram: count per bin
+    size_t *_histogram;
+} LoudnessMeasurerBlocks;
+
+
+struct LoudnessMeasurer {
+    size_t _channelCount;
+    size_t _groupCount;
+
+    LoudnessMeasurerGating    _gating;
+    LoudnessMeasurerScanState _state;
+
+    // Energy of the most recent 100ms hops, summed over channels. A 400ms
+    // gating block is four consecutive hops (75% overlap as specified in the
+    // 2011 revision of BS1770), a 3s short-term block is thirty.
+    //
+    double _recentHops[sRecentHopCount];
+    size_t _hopCount;
+
+    LoudnessMeasurerBlocks _gatingBlocks;
+    LoudnessMeasurerBlocks _shortTermBlocks;
+
+    // Peak of each 10ms block of input audio over all channels, 0-255
+    uint8_t *_overview;
+    size_t   _overviewCapacity;
+
+    // How many samples fit in 100ms (rounded)
+    unsigned long _samplesIn100ms;
+
+    // How many samples fit in 400ms (rounded)
+    unsigned long _samplesIn400ms;
+
+    // Each hop has ten overview blocks, the last one takes any remainder
+    size_t _framesPerOverview;
+
+    // Version 2 overview, binsPerHop * channelCount bins per hop. Off while
+    // _binsPerHop is 0. As above, the last bin of a hop takes any remainder.
+    //
+    HugOverviewBin *_detailedBins;
+    size_t _detailedCapacity;
+    size_t _binsPerHop;
+    size_t _framesPerBin;
+
+    // Linear sample magnitude and mean square, see LoudnessMeasurerSetSilenceThresholds()
+    float  _silenceThreshold;
+    double _onsetEnergy;
+
+    // Largest sum of absolute coefficients of any phase. A block can only
+    // raise the true peak if its sample peak times this exceeds it.
+    //
+    float _truePeakGain;
+
+    size_t _parallelMinimumFrames;
+    size_t _parallelThreadCount;
+
+    double _coefficients[2][5];
+};
+
+
+static double sGetAbsoluteGate(void)
+{
+    return pow(10.0, (-70.0 + 0.691) / 10.0);
+}
+
+
+static double sGetLoudnessForEnergy(double energy)
+{
+    return 10 * (log(energy) / log(10.0)) - 0.691;
+}
+
+
+// Lower edge of a histogram bin
+static double sGetBinBoundary(size_t bin)
+{
+    return pow(10.0, ((bin / 10.0) - 70.0 + 0.691) / 10.0);
+}
+
+
+// Energy at the center of a histogram bin
+static double sGetBinEnergy(size_t bin)
+{
+    return pow(10.0, ((bin / 10.0) - 69.95 + 0.691) / 10.0);
+}
+
+
+static size_t sGetBinIndex(double energy)
+{
+    size_t low  = 0;
+    size_t high = sHistogramBinCount;
+
+    // Last bin whose lower edge is at or below energy, louder than +30 LUFS goes in the top bin
+    while (high - low > 1) {
+        size_t mid = (low + high) / 2;
+
+        if (sGetBinBoundary(mid) <= energy) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+
+static bool sBlocksInit(LoudnessMeasurerBlocks *blocks, LoudnessMeasurerGating gating, size_t capacity)
+{
+    if (gating == LoudnessMeasurerGatingHistogram) {
+        blocks->_histogram = calloc(sHistogramBinCount, sizeof(size_t));
+        return blocks->_histogram != NULL;
+
+    } else {
+        blocks->_capacity = capacity;
+        blocks->_energies = malloc((capacity ? capacity : 1) * sizeof(double));
+        return blocks->_energies != NULL;
+    }
+}
+
+
+static void sBlocksFree(LoudnessMeasurerBlocks *blocks)
+{
+    free(blocks->_energies);
+    free(blocks->_histogram);
+}
+
+
+static void sBlocksAdd(LoudnessMeasurerBlocks *blocks, double energy)
+{
+    if (energy < sGetAbsoluteGate()) return;
+
+    if (blocks->_histogram) {
+        blocks->_histogram[sGetBinIndex(energy)]++;
+
+    } else {
+        if (blocks->_count == blocks->_capacity) {
+            size_t  capacity = blocks->_capacity ? (blocks->_capacity * 2) : 64;
+            double *energies = realloc(blocks->_energies, capacity * sizeof(double));
+
+            if (!energies) return;
+
+            blocks->_energies = energies;
+            blocks->_capacity = capacity;
+        }
+
+        blocks->_energies[blocks->_count] = energy;
+    }
+
+    blocks->_energySum += energy;
+    blocks->_count++;
+}
+
+
+static bool sScanStateInit(const LoudnessMeasurer *self, LoudnessMeasurerScanState *state)
+{
+    state->_lanes       = calloc(self->_groupCount,   sizeof(HugKWeightingLanes));
+    state->_overviewMax = calloc(self->_channelCount, sizeof(float));
+    state->_peak        = calloc(self->_channelCount, sizeof(float));
+    state->_frameIndex  = 0;
+
+    state->_truePeakHistory = calloc(self->_channelCount * sTruePeakHistory, sizeof(float));
+    state->_truePeak        = calloc(self->_channelCount, sizeof(float));
+
+    state->_binMin = malloc(self->_channelCount * sizeof(float));
+    state->_binMax = malloc(self->_channelCount * sizeof(float));
+    state->_binSum = calloc(self->_channelCount, sizeof(double));
+
+    state->_onsetSum     = calloc(self->_channelCount, sizeof(double));
+    state->_audibleStart = SIZE_MAX;
+    state->_audibleEnd   = 0;
+    state->_onsetFrame   = SIZE_MAX;
+
+    for (size_t c = 0; state->_binMin && state->_binMax && c < self->_channelCount; c++) {
+        state->_binMin[c] =  FLT_MAX;
+        state->_binMax[c] = -FLT_MAX;
+    }
+
+    state->_pendingHops     = NULL;
+    state->_pendingHopCount = 0;
+
+    return state->_lanes && state->_overviewMax && state->_peak && state->_truePeakHistory && state->_truePeak &&
+           state->_binMin && state->_binMax && state->_binSum && state->_onsetSum;
+}
+
+
+static void sScanStateFree(LoudnessMeasurerScanState *state)
+{
+    free(state->_lanes);
+    free(state->_overviewMax);
+    free(state->_peak);
+    free(state->_truePeakHistory);
+    free(state->_truePeak);
+    free(state->_binMin);
+    free(state->_binMax);
+    free(state->_binSum);
+    free(state->_onsetSum);
+    free(state->_pendingHops);
+}
+
+
+LoudnessMeasurer *LoudnessMeasurerCreate(unsigned int channelCount, double sampleRate, size_t totalFrames)
+{
+    return LoudnessMeasurerCreateWithGating(channelCount, sampleRate, totalFrames, LoudnessMeasurerGatingBlocks);
+}
+
+
+LoudnessMeasurer *LoudnessMeasurerCreateWithGating(unsigned int channelCount, double sampleRate, size_t totalFrames, LoudnessMeasurerGating gating)
+{
+    LoudnessMeasurer *self = (LoudnessMeasurer *)calloc(1, sizeof(LoudnessMeasurer));
+    if (!self) return NULL;
+
+    self->_channelCount = channelCount;
+    self->_groupCount   = (channelCount + sLaneCount - 1) / sLaneCount;
+    self->_gating       = gating;
+    
+    self->_samplesIn100ms = (sampleRate + 5) / 10;
+    self->_samplesIn400ms = self->_samplesIn100ms * 4;
+
+    self->_framesPerOverview = self->_samplesIn100ms / 10;
+    if (!self->_framesPerOverview) self->_framesPerOverview = 1;
+
+    for (size_t p = 0; p < sTruePeakPhaseCount; p++) {
+        float gain = 0;
+
+        for (size_t k = 0; k < sTruePeakTapCount; k++) {
+            gain += fabsf(sTruePeakCoefficients[p][k]);
+        }
+
+        if (gain > self->_truePeakGain) self->_truePeakGain = gain;
+    }
+
+    LoudnessMeasurerSetSilenceThresholds(self, sDefaultSilenceDecibels, sDefaultOnsetDecibels);
+
+    // totalFrames is only a hint, e.g. VBR files estimate it. Everything
+    // that depends on the length grows as needed.
+    //
+    size_t hopCapacity = ceil(totalFrames / sampleRate) * 10;
+
+    self->_overviewCapacity = hopCapacity * 10;
+    self->_overview = malloc(self->_overviewCapacity ? self->_overviewCapacity : 1);
+
+    bool ok = (self->_overview != NULL);
+
+    ok = ok && sScanStateInit(self, &self->_state);
+    ok = ok && sBlocksInit(&self->_gatingBlocks,    gating, hopCapacity);
+    ok = ok && sBlocksInit(&self->_shortTermBlocks, gating, hopCapacity);
+
+    if (!ok) {
+        LoudnessMeasurerFree(self);
+        return NULL;
+    }
+
+    HugKWeightingGetCoefficients(sampleRate, self->_coefficients);
+
+    return self;
+}
+
+
+void LoudnessMeasurerFree(LoudnessMeasurer *self)
+{
+    sScanStateFree(&self->_state);
+
+    sBlocksFree(&self->_gatingBlocks);
+    sBlocksFree(&self->_shortTermBlocks);
+
+    free(self->_overview);
+    free(self->_detailedBins);
+
+    free(self);
+}
+
+
+void LoudnessMeasurerSetParallelScan(LoudnessMeasurer *self, size_t minimumFrames, size_t threadCount)
+{
+    self->_parallelMinimumFrames = minimumFrames;
+    self->_parallelThreadCount   = threadCount;
+}
+
+
+void LoudnessMeasurerSetDetailedOverviewRate(LoudnessMeasurer *self, size_t binsPerSecond)
+{
+    if (self->_state._frameIndex > 0) return;
+
+    size_t binsPerHop = (binsPerSecond + 5) / 10;
+
+    if (binsPerHop < 1) binsPerHop = 1;
+    if (binsPerHop > self->_samplesIn100ms) binsPerHop = self->_samplesIn100ms;
+
+    size_t capacity = (self->_overviewCapacity / 10) * binsPerHop * self->_channelCount;
+    HugOverviewBin *bins = realloc(self->_detailedBins, (capacity ? capacity : 1) * sizeof(HugOverviewBin));
+
+    if (bins) {
+        self->_detailedBins     = bins;
+        self->_detailedCapacity = capacity;
+        self->_binsPerHop       = binsPerHop;
+        self->_framesPerBin     = self->_samplesIn100ms / binsPerHop;
+    }
+}
+
+
+void LoudnessMeasurerSetSilenceThresholds(LoudnessMeasurer *self, double silenceDecibels, double onsetDecibels)
+{
+    if (self->_state._frameIndex > 0) return;
+
+    self->_silenceThreshold = pow(10.0, silenceDecibels / 20.0);
+    self->_onsetEnergy      = pow(10.0, onsetDecibels  / 10.0);
+}
+
+
+static void sFilterAllLanes(const LoudnessMeasurer *self, LoudnessMeasurerScanState *state, const float * const *channels, size_t offset, size_t frames)
+{
+    for (size_t g = 0; g < self->_groupCount; g++) {
+        size_t firstChannel = g * sLaneCount;
+        size_t laneCount    = self->_channelCount - firstChannel;
+
+        if (laneCount > sLaneCount) laneCount = sLaneCount;
+
+        HugKWeightingFilterLanes(self->_coefficients, &state->_lanes[g], channels + firstChannel, laneCount, offset, frames);
+    }
+}
+
+
+static double sGetRecentEnergy(const LoudnessMeasurer *self, size_t hopCount)
+{
+    double energy = 0;
+
+    for (size_t hop = self->_hopCount - hopCount; hop < self->_hopCount; hop++) {
+        energy += self->_recentHops[hop % sRecentHopCount];
+    }
+
+    return energy;
+}
+
+
+static void sAddHop(LoudnessMeasurer *self, double energy)
+{
+    self->_recentHops[self->_hopCount % sRecentHopCount] = energy;
+    self->_hopCount++;
+
+    if (self->_hopCount >= 4) {
+        sBlocksAdd(&self->_gatingBlocks, sGetRecentEnergy(self, 4) / self->_samplesIn400ms);
+    }
+
+    if (self->_hopCount >= sRecentHopCount) {
+        sBlocksAdd(&self->_shortTermBlocks, sGetRecentEnergy(self, sRecentHopCount) / (self->_samplesIn100ms * sRecentHopCount));
+    }
+}
+
+
+static void sFinishHop(LoudnessMeasurer *self, LoudnessMeasurerScanState *state)
+{
+    double energy = 0;
+
+    for (size_t c = 0; c < self->_channelCount; c++) {
+        energy += state->_lanes[c / sLaneCount].sum[c % sLaneCount];
+    }
+
+    for (size_t g = 0; g < self->_groupCount; g++) {
+        memset(state->_lanes[g].sum, 0, sizeof(state->_lanes[g].sum));
+    }
+
+    if (state->_pendingHops) {
+        state->_pendingHops[state->_pendingHopCount++] = energy;
+    } else {
+        sAddHop(self, energy);
+    }
+}
+
+
+// Largest magnitude of the 4x oversampled input. history holds the
+// sTruePeakHistory samples before src and is left unchanged.
+//
+// Phases 3 and 2 are phases 0 and 1 reversed. With s = x[n-k] + x[n-11+k],
+// d = x[n-k] - x[n-11+k] and the even/odd halves of a phase's coefficients,
+// P = sum(even * s) and Q = sum(odd * d) give both phases of a pair as P + Q
+// and P - Q, so their larger magnitude is |P| + |Q|.
+//
+static float sGetTruePeak(const float *src, size_t frames, const float *history)
+{
+    float even[2][sTruePeakTapCount / 2];
+    float odd [2][sTruePeakTapCount / 2];
+
+    HugSIMDFloat evenVector[2][sTruePeakTapCount / 2];
+    HugSIMDFloat oddVector [2][sTruePeakTapCount / 2];
+
+    for (size_t p = 0; p < 2; p++) {
+        for (size_t k = 0; k < sTruePeakTapCount / 2; k++) {
+            float a = sTruePeakCoefficients[p][k];
+            float b = sTruePeakCoefficients[p][sTruePeakHistory - k];
+
+            even[p][k] = (a + b) * 0.5f;
+            odd [p][k] = (a - b) * 0.5f;
+
+            evenVector[p][k] = HugSIMDSplat(even[p][k]);
+            oddVector [p][k] = HugSIMDSplat(odd [p][k]);
+        }
+    }
+
+    float buffer[sTruePeakHistory + sTruePeakTileFrames];
+    memcpy(buffer, history, sTruePeakHistory * sizeof(float));
+
+    HugSIMDFloat peakVector = HugSIMDSplat(0);
+    float peak = 0;
+
+    while (frames > 0) {
+        size_t count = frames < sTruePeakTileFrames ? frames : sTruePeakTileFrames;
+        memcpy(buffer + sTruePeakHistory, src, count * sizeof(float));
+
+        const float *x = buffer + sTruePeakHistory;
+        size_t i = 0;
+
+        // Vectorized over time, each lane is an input frame
+        for ( ; i + HUG_SIMD_FLOAT_LANES <= count; i += HUG_SIMD_FLOAT_LANES) {
+            HugSIMDFloat p0 = HugSIMDSplat(0);
+            HugSIMDFloat q0 = p0, p1 = p0, q1 = p0;
+
+            for (size_t k = 0; k < sTruePeakTapCount / 2; k++) {
+                HugSIMDFloat newer = HugSIMDLoad(x + i - k);
+                HugSIMDFloat older = HugSIMDLoad(x + i - sTruePeakHistory + k);
+
+                HugSIMDFloat sum        = HugSIMDAdd(newer, older);
+                HugSIMDFloat difference = HugSIMDSub(newer, older);
+
+                p0 = HugSIMDAdd(p0, HugSIMDMul(evenVector[0][k], sum));
+                q0 = HugSIMDAdd(q0, HugSIMDMul(oddVector [0][k], difference));
+                p1 = HugSIMDAdd(p1, HugSIMDMul(evenVector[1][k], sum));
+                q1 = HugSIMDAdd(q1, HugSIMDMul(oddVector [1][k], difference));
+            }
+
+            HugSIMDFloat m0 = HugSIMDAdd(HugSIMDAbs(p0), HugSIMDAbs(q0));
+            HugSIMDFloat m1 = HugSIMDAdd(HugSIMDAbs(p1), HugSIMDAbs(q1));
+
+            peakVector = HugSIMDMax(peakVector, HugSIMDMax(m0, m1));
+        }
+
+        for ( ; i < count; i++) {
+            float p0 = 0, q0 = 0, p1 = 0, q1 = 0;
+
+            for (size_t k = 0; k < sTruePeakTapCount / 2; k++) {
+                float newer = x[(ptrdiff_t)i - (ptrdiff_t)k];
+                float older = x[(ptrdiff_t)i - sTruePeakHistory + (ptrdiff_t)k];
+
+                float sum        = newer + older;
+                float difference = newer - older;
+
+                p0 += even[0][k] * sum;
+                q0 += odd [0][k] * difference;
+                p1 += even[1][k] * sum;
+                q1 += odd [1][k] * difference;
+            }
+
+            float m0 = fabsf(p0) + fabsf(q0);
+            float m1 = fabsf(p1) + fabsf(q1);
+
+            if (m0 > peak) peak = m0;
+            if (m1 > peak) peak = m1;
+        }
+
+        memmove(buffer, buffer + count, sTruePeakHistory * sizeof(float));
+
+        src    += count;
+        frames -= count;
+    }
+
+    float vectorPeak = HugSIMDReduceMax(peakVector);
+    return vectorPeak > peak ? vectorPeak : peak;
+}
+
+
+static void sUpdateTruePeakHistory(float *history, const float *src, size_t count)
+{
+    if (count >= sTruePeakHistory) {
+        memcpy(history, src + count - sTruePeakHistory, sTruePeakHistory * sizeof(float));
+    } else {
+        memmove(history, history + count, (sTruePeakHistory - count) * sizeof(float));
+        memcpy(history + sTruePeakHistory - count, src, count * sizeof(float));
+    }
+}
+
+
+static void sFinishDetailedBin(LoudnessMeasurer *self, LoudnessMeasurerScanState *state, size_t c, size_t bin, size_t frameCount)
+{
+    size_t index = (bin * self->_channelCount) + c;
+
+    // Bins are disjoint between segments, as overview blocks are
+    if (index < self->_detailedCapacity) {
+        HugOverviewBin *out = &self->_detailedBins[index];
+
+        out->min = state->_binMin[c];
+        out->max = state->_binMax[c];
+        out->rms = frameCount ? sqrt(state->_binSum[c] / frameCount) : 0;
+    }
+
+    state->_binMin[c] =  FLT_MAX;
+    state->_binMax[c] = -FLT_MAX;
+    state->_binSum[c] = 0;
+}
+
+
+// src holds count frames from frameIndex, at least one of them audible.
+// Only searches when it can move the start or end.
+//
+static void sUpdateAudibleRange(const LoudnessMeasurer *self, LoudnessMeasurerScanState *state, const float *src, size_t count, size_t frameIndex)
+{
+    float threshold = self->_silenceThreshold;
+
+    if (frameIndex < state->_audibleStart) {
+        for (size_t i = 0; i < count; i++) {
+            if (fabsf(src[i]) > threshold) {
+                if (frameIndex + i < state->_audibleStart) state->_audibleStart = frameIndex + i;
+                break;
+            }
+        }
+    }
+
+    if (frameIndex + count > state->_audibleEnd) {
+        for (size_t i = count; i > 0; i--) {
+            if (fabsf(src[i - 1]) > threshold) {
+                if (frameIndex + i > state->_audibleEnd) state->_audibleEnd = frameIndex + i;
+                break;
+            }
+        }
+    }
+}
+
+
+// Peaks work on the unfiltered input, one channel at a time. With a detailed
+// overview, blocks also end at bin boundaries, and a single pass over each
+// block finds its minimum, maximum and sum of squares. Until the onset is
+// found, each overview block's sum of squares is checked against it.
+//
+static void sScanPeaks(LoudnessMeasurer *self, LoudnessMeasurerScanState *state, const float * const *channels, size_t offset, size_t frames)
+{
+    size_t framesPerHop      = self->_samplesIn100ms;
+    size_t framesPerOverview = self->_framesPerOverview;
+    size_t framesPerBin      = self->_framesPerBin;
+    size_t binsPerHop        = self->_binsPerHop;
+
+    for (size_t c = 0; c < self->_channelCount; c++) {
+        const float *src = channels[c] + offset;
+        size_t frameIndex = state->_frameIndex;
+        size_t remaining  = frames;
+
+        float  overviewMax = state->_overviewMax[c];
+        double onsetSum    = state->_onsetSum[c];
+        float peak        = state->_peak[c];
+        float truePeak    = state->_truePeak[c];
+
+        float *history = &state->_truePeakHistory[c * sTruePeakHistory];
+
+        while (remaining > 0) {
+            size_t hopOffset = frameIndex % framesPerHop;
+            size_t hopBlock  = hopOffset / framesPerOverview;
+            if (hopBlock > 9) hopBlock = 9;
+
+            size_t blockEnd = (hopBlock == 9) ? framesPerHop : ((hopBlock + 1) * framesPerOverview);
+            size_t block    = ((frameIndex / framesPerHop) * 10) + hopBlock;
+
+            size_t end = blockEnd;
+
+            size_t hopBin = 0;
+            size_t binEnd = 0;
+
+            if (binsPerHop) {
+                hopBin = hopOffset / framesPerBin;
+                if (hopBin > binsPerHop - 1) hopBin = binsPerHop - 1;
+
+                binEnd = (hopBin == binsPerHop - 1) ? framesPerHop : ((hopBin + 1) * framesPerBin);
+                if (binEnd < end) end = binEnd;
+            }
+
+            size_t count = end - hopOffset;
+            if (count > remaining) count = remaining;
+
+            float m;
+            float sumOfSquares = 0;
+
+            if (binsPerHop) {
+                float blockMin, blockMax;
+                HugVectorGetMinMaxSumOfSquares(src, count, &blockMin, &blockMax, &sumOfSquares);
+
+                if (blockMin < state->_binMin[c]) state->_binMin[c] = blockMin;
+                if (blockMax > state->_binMax[c]) state->_binMax[c] = blockMax;
+                state->_binSum[c] += sumOfSquares;
+
+                // Same result as HugVectorGetMaxMagnitude()
+                m = (-blockMin > blockMax) ? -blockMin : blockMax;
+                if (m < 0) m = 0;
+
+            } else {
+                HugVectorGetMaxMagnitude(src, count, &m, NULL);
+            }
+
+            if (m > overviewMax) overviewMax = m;
+            if (m > peak)        peak = m;
+
+            if (m > self->_silenceThreshold) {
+                sUpdateAudibleRange(self, state, src, count, frameIndex);
+            }
+
+            // Only blocks before the earliest onset so far can move it
+            size_t blockStart = (frameIndex - hopOffset) + (hopBlock * framesPerOverview);
+            bool   checksOnset = (blockStart < state->_onsetFrame);
+
+            if (checksOnset) {
+                if (!binsPerHop) sumOfSquares = HugVectorGetMeanSquare(src, count) * count;
+                onsetSum += sumOfSquares;
+            }
+
+            // Oversampling is most of the cost, skip blocks that can't matter
+            float historyMax;
+            HugVectorGetMaxMagnitude(history, sTruePeakHistory, &historyMax, NULL);
+
+            if (self->_truePeakGain * (m > historyMax ? m : historyMax) > truePeak) {
+                float blockTruePeak = sGetTruePeak(src, count, history);
+                if (blockTruePeak > truePeak) truePeak = blockTruePeak;
+            }
+
+            sUpdateTruePeakHistory(history, src, count);
+
+            src        += count;
+            frameIndex += count;
+            remaining  -= count;
+
+            if (binsPerHop && (hopOffset + count == binEnd)) {
+                size_t bin = ((frameIndex - 1) / framesPerHop) * binsPerHop + hopBin;
+                sFinishDetailedBin(self, state, c, bin, binEnd - (hopBin * framesPerBin));
+            }
+
+            if (hopOffset + count == blockEnd) {
+                int16_t value = floor(overviewMax * 255.0);
+
+                if (value > 255) value = 255;
+                if (value < 0)   value = 0;
+
+                // Blocks are disjoint between segments, so this is only raced by itself
+                if (block < self->_overviewCapacity) {
+                    if (c == 0 || value > self->_overview[block]) {
+                        self->_overview[block] = value;
+                    }
+                }
+
+                size_t blockFrames = blockEnd - (hopBlock * framesPerOverview);
+
+                if (checksOnset && (onsetSum / blockFrames) >= self->_onsetEnergy) {
+                    state->_onsetFrame = blockStart;
+                }
+
+                overviewMax = 0;
+                onsetSum    = 0;
+            }
+        }
+
+        state->_overviewMax[c] = overviewMax;
+        state->_onsetSum[c]    = onsetSum;
+        state->_peak[c]        = peak;
+        state->_truePeak[c]    = truePeak;
+    }
+}
+
+
+static void sScanRange(LoudnessMeasurer *self, LoudnessMeasurerScanState *state, const float * const *channels, size_t offset, size_t frames)
+{
+    sScanPeaks(self, state, channels, offset, frames);
+
+    while (frames > 0) {
+        size_t hopOffset = state->_frameIndex % self->_samplesIn100ms;
+        size_t count = self->_samplesIn100ms - hopOffset;
+        if (count > frames) count = frames;
+
+        sFilterAllLanes(self, state, channels, offset, count);
+
+        offset += count;
+        frames -= count;
+        state->_frameIndex += count;
+
+        if (hopOffset + count == self->_samplesIn100ms) {
+            sFinishHop(self, state);
+        }
+    }
+}
+
+
+typedef struct {
+    LoudnessMeasurer *measurer;
+    const float * const *channels;
+    LoudnessMeasurerScanState *states[sMaxSegments];
+    size_t offsets[sMaxSegments + 1];
+} LoudnessMeasurerScanContext;
+
+
+static void sScanSegment(void *inContext, size_t s)
+{
+    LoudnessMeasurerScanContext *context = inContext;
+    LoudnessMeasurer *self = context->measurer;
+    LoudnessMeasurerScanState *state = context->states[s];
+
+    size_t offset = context->offsets[s];
+    size_t frames = context->offsets[s + 1] - offset;
+
+    // Every segment but the first starts with silent filter history. Running
+    // the filters over the preceding 400ms first brings it within rounding
+    // of the sequential result; the warm-up energy is thrown away.
+    //
+    if (s > 0) {
+        size_t warmUpFrames = self->_samplesIn400ms;
+        if (warmUpFrames > offset) warmUpFrames = offset;
+
+        sFilterAllLanes(self, state, context->channels, offset - warmUpFrames, warmUpFrames);
+
+        for (size_t g = 0; g < self->_groupCount; g++) {
+            memset(state->_lanes[g].sum, 0, sizeof(state->_lanes[g].sum));
+        }
+
+        for (size_t c = 0; c < self->_channelCount; c++) {
+            float *history = &state->_truePeakHistory[c * sTruePeakHistory];
+            memcpy(history, context->channels[c] + offset - sTruePeakHistory, sTruePeakHistory * sizeof(float));
+        }
+    }
+
+    sScanRange(self, state, context->channels, offset, frames);
+}
+
+
+#if !defined(__APPLE__)
+
+typedef struct {
+    LoudnessMeasurerScanContext *context;
+    size_t segment;
+} LoudnessMeasurerThreadContext;
+
+
+static void *sScanSegmentThreadMain(void *inThreadContext)
+{
+    LoudnessMeasurerThreadContext *threadContext = inThreadContext;
+    sScanSegment(threadContext->context, threadContext->segment);
+    return NULL;
+}
+
+#endif
+
+
+static size_t sGetSegmentCount(const LoudnessMeasurer *self, size_t frames)
+{
+    if (!self->_parallelMinimumFrames || frames < self->_parallelMinimumFrames) {
+        return 1;
+    }
+
+    size_t threadCount = self->_parallelThreadCount;
+
+    if (!threadCount) {
+        long onlineCount = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = onlineCount > 0 ? (size_t)onlineCount : 1;
+    }
+
+    // Keep the warm-up small next to each segment
+    size_t minimumSegmentFrames = self->_samplesIn400ms * 25;
+    size_t segmentCount = frames / minimumSegmentFrames;
+
+    if (segmentCount > threadCount)  segmentCount = threadCount;
+    if (segmentCount > sMaxSegments) segmentCount = sMaxSegments;
+
+    return segmentCount ? segmentCount : 1;
+}
+
+
+static void sScanParallel(LoudnessMeasurer *self, const float * const *channels, size_t frames, size_t segmentCount)
+{
+    LoudnessMeasurerScanContext context = { .measurer = self, .channels = channels };
+    LoudnessMeasurerScanState   segmentStates[sMaxSegments];
+
+    size_t startIndex    = self->_state._frameIndex;
+    size_t segmentFrames = frames / segmentCount;
+    size_t alignment     = self->_samplesIn100ms;
+
+    context.states[0]  = &self->_state;
+    context.offsets[0] = 0;
+
+    for (size_t s = 1; s < segmentCount; s++) {
+        size_t index = startIndex + (s * segmentFrames);
+        index = ((index + alignment - 1) / alignment) * alignment;
+
+        context.states[s]  = &segmentStates[s];
+        context.offsets[s] = index - startIndex;
+    }
+
+    context.offsets[segmentCount] = frames;
+
+    for (size_t s = 1; s < segmentCount; s++) {
+        size_t segmentHopCount = ((context.offsets[s + 1] - context.offsets[s]) / alignment) + 1;
+
+        bool ok = sScanStateInit(self, &segmentStates[s]);
+        segmentStates[s]._frameIndex  = startIndex + context.offsets[s];
+        segmentStates[s]._pendingHops = ok ? malloc(segmentHopCount * sizeof(double)) : NULL;
+
+        // Out of memory, scan serially. A segment without _pendingHops
+        // would add its hops from a worker thread.
+        //
+        if (!segmentStates[s]._pendingHops) {
+            for (size_t f = 1; f <= s; f++) {
+                sScanStateFree(&segmentStates[f]);
+            }
+
+            sScanRange(self, &self->_state, channels, 0, frames);
+            return;
+        }
+    }
+
+#if defined(__APPLE__)
+    dispatch_apply_f(segmentCount, dispatch_get_global_queue(0, 0), &context, sScanSegment);
+#else
+    pthread_t threads[sMaxSegments];
+    bool      started[sMaxSegments] = {0};
+
+    LoudnessMeasurerThreadContext threadContexts[sMaxSegments];
+
+    for (size_t s = 1; s < segmentCount; s++) {
+        threadContexts[s] = (LoudnessMeasurerThreadContext){ &context, s };
+        started[s] = (pthread_create(&threads[s], NULL, sScanSegmentThreadMain, &threadContexts[s]) == 0);
+    }
+
+    sScanSegment(&context, 0);
+
+    for (size_t s = 1; s < segmentCount; s++) {
+        if (started[s]) {
+            pthread_join(threads[s], NULL);
+        } else {
+            sScanSegment(&context, s);
+        }
+    }
+#endif
+
+    for (size_t s = 1; s < segmentCount; s++) {
+        LoudnessMeasurerScanState *state = &segmentStates[s];
+
+        for (size_t h = 0; h < state->_pendingHopCount; h++) {
+            sAddHop(self, state->_pendingHops[h]);
+        }
+
+        for (size_t c = 0; c < self->_channelCount; c++) {
+            if (state->_peak[c] > self->_state._peak[c]) {
+                self->_state._peak[c] = state->_peak[c];
+            }
+
+            if (state->_truePeak[c] > self->_state._truePeak[c]) {
+                self->_state._truePeak[c] = state->_truePeak[c];
+            }
+        }
+
+        if (state->_audibleStart < self->_state._audibleStart) self->_state._audibleStart = state->_audibleStart;
+        if (state->_audibleEnd   > self->_state._audibleEnd)   self->_state._audibleEnd   = state->_audibleEnd;
+        if (state->_onsetFrame   < self->_state._onsetFrame)   self->_state._onsetFrame   = state->_onsetFrame;
+    }
+
+    // The last segment carries the filter history and partial sums forward
+    LoudnessMeasurerScanState *last = context.states[segmentCount - 1];
+
+    memcpy(self->_state._lanes,       last->_lanes,       self->_groupCount   * sizeof(HugKWeightingLanes));
+    memcpy(self->_state._overviewMax, last->_overviewMax, self->_channelCount * sizeof(float));
+    memcpy(self->_state._truePeakHistory, last->_truePeakHistory, self->_channelCount * sTruePeakHistory * sizeof(float));
+    memcpy(self->_state._binMin, last->_binMin, self->_channelCount * sizeof(float));
+    memcpy(self->_state._binMax, last->_binMax, self->_channelCount * sizeof(float));
+    memcpy(self->_state._binSum, last->_binSum, self->_channelCount * sizeof(double));
+    memcpy(self->_state._onsetSum, last->_onsetSum, self->_channelCount * sizeof(double));
+    self->_state._frameIndex = last->_frameIndex;
+
+    for (size_t s = 1; s < segmentCount; s++) {
+        sScanStateFree(&segmentStates[s]);
+    }
+}
+
+
+// Called before scanning, so that segments never move the overview
+static void sReserveOverview(LoudnessMeasurer *self, size_t frames)
+{
+    size_t endIndex = self->_state._frameIndex + frames;
+    size_t needed   = ((endIndex / self->_samplesIn100ms) + 1) * 10;
+
+    if (needed <= self->_overviewCapacity) return;
+
+    size_t capacity = self->_overviewCapacity * 2;
+    if (capacity < needed) capacity = needed;
+
+    uint8_t *overview = realloc(self->_overview, capacity);
+
+    if (overview) {
+        self->_overview = overview;
+        self->_overviewCapacity = capacity;
+    }
+
+    if (self->_binsPerHop) {
+        size_t binCapacity = (capacity / 10) * self->_binsPerHop * self->_channelCount;
+        HugOverviewBin *bins = realloc(self->_detailedBins, binCapacity * sizeof(HugOverviewBin));
+
+        if (bins) {
+            self->_detailedBins = bins;
+            self->_detailedCapacity = binCapacity;
+        }
+    }
+}
+
+
+void LoudnessMeasurerScanAudioBuffer(LoudnessMeasurer *self, const float * const *channels, size_t inFrames)
+{
+    sReserveOverview(self, inFrames);
+
+    size_t segmentCount = sGetSegmentCount(self, inFrames);
+
+    if (segmentCount > 1) {
+        sScanParallel(self, channels, inFrames, segmentCount);
+    } else {
+        sScanRange(self, &self->_state, channels, 0, inFrames);
+    }
+}
+
+
+uint8_t *LoudnessMeasurerCopyOverview(LoudnessMeasurer *self, size_t *outCount)
+{
+    // Blocks are published once the gating block after them is complete,
+    // the last 10ms before that stays pending
+    //
+    size_t overviewCount = 0;
+
+    if (self->_hopCount >= 4) {
+        overviewCount = (self->_hopCount * 10) - 1;
+
+        if (overviewCount > self->_overviewCapacity) {
+            overviewCount = self->_overviewCapacity;
+        }
+    }
+
+    uint8_t *overview = malloc(sizeof(uint8_t) * (overviewCount ? overviewCount : 1));
+
+    if (overviewCount) {
+        memcpy(overview, self->_overview, overviewCount);
+    }
+
+    if (outCount) *outCount = overviewCount;
+
+    return overview;
+}
+
+
+void *LoudnessMeasurerCopyDetailedOverview(LoudnessMeasurer *self, size_t *outLength)
+{
+    if (!self->_binsPerHop) return NULL;
+
+    size_t framesPerHop = self->_samplesIn100ms;
+    size_t frameIndex   = self->_state._frameIndex;
+
+    // Complete bins only, the last one of a hop completes with the hop
+    size_t hopBin = (frameIndex % framesPerHop) / self->_framesPerBin;
+    if (hopBin > self->_binsPerHop - 1) hopBin = self->_binsPerHop - 1;
+
+    size_t binCount = ((frameIndex / framesPerHop) * self->_binsPerHop) + hopBin;
+    size_t maxCount = self->_detailedCapacity / self->_channelCount;
+
+    if (binCount > maxCount) binCount = maxCount;
+
+    double binRate = self->_binsPerHop * 10.0;
+
+    return HugOverviewCreateData(self->_detailedBins, self->_channelCount, binCount, binRate, outLength);
+}
+
+
+bool LoudnessMeasurerGetAudibleRange(LoudnessMeasurer *self, size_t *outStartFrame, size_t *outEndFrame)
+{
+    if (self->_state._audibleEnd == 0) return false;
+
+    if (outStartFrame) *outStartFrame = self->_state._audibleStart;
+    if (outEndFrame)   *outEndFrame   = self->_state._audibleEnd;
+
+    return true;
+}
+
+
+bool LoudnessMeasurerGetOnsetFrame(LoudnessMeasurer *self, size_t *outFrame)
+{
+    if (self->_state._onsetFrame == SIZE_MAX) return false;
+
+    if (outFrame) *outFrame = self->_state._onsetFrame;
+
+    return true;
+}
+
+
+double LoudnessMeasurerGetLoudness(LoudnessMeasurer *self)
+{
+    const LoudnessMeasurerBlocks *blocks = &self->_gatingBlocks;
+
+    if (!blocks->_count) {
+        return 0;
+    }
+
+    double relativeThreshold = (blocks->_energySum / blocks->_count) * pow(10.0, -10 / 10.0);
+    double gatedLoudness = 0.0;
+    size_t aboveThresholdCounter = 0;
+
+    if (blocks->_histogram) {
+        for (size_t i = sGetBinIndex(relativeThreshold); i < sHistogramBinCount; i++) {
+            aboveThresholdCounter += blocks->_histogram[i];
+            gatedLoudness += blocks->_histogram[i] * sGetBinEnergy(i);
+        }
+
+    } else {
+        for (size_t i = 0; i < blocks->_count; i++) {
+            double sum = blocks->_energies[i];
+
+            if (sum >= relativeThreshold) {
+                ++aboveThresholdCounter;
+                gatedLoudness += sum;
+            }
+        }
+    }
+
+    if (!aboveThresholdCounter) {
+        return 0;
+    }
+
+    gatedLoudness /= (double)aboveThresholdCounter;
+    return sGetLoudnessForEnergy(gatedLoudness);
+}
+
+
+double LoudnessMeasurerGetMomentaryLoudness(LoudnessMeasurer *self)
+{
+    if (self->_hopCount < 4) return -HUGE_VAL;
+    return sGetLoudnessForEnergy(sGetRecentEnergy(self, 4) / self->_samplesIn400ms);
+}
+
+
+double LoudnessMeasurerGetShortTermLoudness(LoudnessMeasurer *self)
+{
+    if (self->_hopCount < sRecentHopCount) return -HUGE_VAL;
+    return sGetLoudnessForEnergy(sGetRecentEnergy(self, sRecentHopCount) / (self->_samplesIn100ms * sRecentHopCount));
+}
+
+
+static int sCompareEnergies(const void *a, const void *b)
+{
+    double ea = *(const double *)a;
+    double eb = *(const double *)b;
+
+    return (ea > eb) - (ea < eb);
+}
+
+
+double LoudnessMeasurerGetLoudnessRange(LoudnessMeasurer *self)
+{
+    const LoudnessMeasurerBlocks *blocks = &self->_shortTermBlocks;
+
+    if (!blocks->_count) {
+        return 0;
+    }
+
+    // EBU Tech 3342: relative gate 20 LU below the mean, then the spread
+    // between the 10th and 95th percentiles
+    //
+    double relativeThreshold = (blocks->_energySum / blocks->_count) * pow(10.0, -20 / 10.0);
+
+    if (blocks->_histogram) {
+        size_t startBin = sGetBinIndex(relativeThreshold);
+        size_t count = 0;
+
+        for (size_t i = startBin; i < sHistogramBinCount; i++) {
+            count += blocks->_histogram[i];
+        }
+
+        if (!count) return 0;
+
+        size_t lowIndex  = (size_t)(((count - 1) * 0.10) + 0.5);
+        size_t highIndex = (size_t)(((count - 1) * 0.95) + 0.5);
+
+        double low = 0, high = 0;
+        size_t seen = 0;
+
+        for (size_t i = startBin; i < sHistogramBinCount; i++) {
+            size_t binCount = blocks->_histogram[i];
+
+            if (binCount && (seen <= lowIndex)  && (lowIndex  < seen + binCount)) low  = sGetBinEnergy(i);
+            if (binCount && (seen <= highIndex) && (highIndex < seen + binCount)) high = sGetBinEnergy(i);
+
+            seen += binCount;
+        }
+
+        return sGetLoudnessForEnergy(high) - sGetLoudnessForEnergy(low);
+
+    } else {
+        double *energies = malloc(blocks->_count * sizeof(double));
+        size_t  count    = 0;
+
+        for (size_t i = 0; i < blocks->_count; i++) {
+            if (blocks->_energies[i] >= relativeThreshold) {
+                energies[count++] = blocks->_energies[i];
+            }
+        }
+
+        qsort(energies, count, sizeof(double), sCompareEnergies);
+
+        double low  = energies[(size_t)(((count - 1) * 0.10) + 0.5)];
+        double high = energies[(size_t)(((count - 1) * 0.95) + 0.5)];
+
+        free(energies);
+
+        return sGetLoudnessForEnergy(high) - sGetLoudnessForEnergy(low);
+    }
+}
+
+
+double LoudnessMeasurerGetPeak(LoudnessMeasurer *self)
+{
+    double result = 0;
+
+    for (size_t c = 0; c < self->_channelCount; c++) {
+        double peak = self->_state._peak[c];
+        if (peak > result) {
+            result = peak;
+        }
+    }
+
+    return result;
+}
+
+
+double LoudnessMeasurerGetTruePeak(LoudnessMeasurer *self)
+{
+    double result = 0;
+
+    // Never below the sample peak, the interpolator doesn't pass samples through exactly
+    for (size_t c = 0; c < self->_channelCount; c++) {
+        double peak = self->_state._truePeak[c];
+        if (self->_state._peak[c] > peak) peak = self->_state._peak[c];
+
+        if (peak > result) {
+            result = peak;
+        }
+    }
+
+    return result;
+}
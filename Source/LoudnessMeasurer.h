@@ -26,26 +26,83 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#include <stddef.h>
-#import  <Foundation/Foundation.h>
-#include <AudioToolbox/AudioToolbox.h>
-
 typedef struct LoudnessMeasurer LoudnessMeasurer;
 
+typedef enum {
+    // Keeps the energy of every gating block, memory grows with length
+    LoudnessMeasurerGatingBlocks = 0,
+
+    // Counts blocks in 0.1 LU bins (as libebur128 does), fixed memory at
+    // the cost of up to 0.05 LU in the integrated loudness and range
+    LoudnessMeasurerGatingHistogram
+} LoudnessMeasurerGating;
+
+// totalFrames sizes the initial allocations and may be 0 or an estimate
 extern LoudnessMeasurer *LoudnessMeasurerCreate(unsigned int channels, double sampleRate, size_t totalFrames);
+extern LoudnessMeasurer *LoudnessMeasurerCreateWithGating(unsigned int channels, double sampleRate, size_t totalFrames, LoudnessMeasurerGating gating);
 extern void LoudnessMeasurerFree(LoudnessMeasurer *measurer);
 
-extern void LoudnessMeasurerScanAudioBuffer(LoudnessMeasurer *st, AudioBufferList *bufferList, size_t frames);
+// Buffers of at least minimumFrames are split into segments that are scanned
+// on up to threadCount threads. A minimumFrames of 0 (the default) always
+// scans on the calling thread, a threadCount of 0 uses one thread per core.
+//
+extern void LoudnessMeasurerSetParallelScan(LoudnessMeasurer *measurer, size_t minimumFrames, size_t threadCount);
+
+// channels is an array of one non-interleaved float buffer per channel
+extern void LoudnessMeasurerScanAudioBuffer(LoudnessMeasurer *st, const float * const *channels, size_t frames);
 
-extern NSData *LoudnessMeasurerGetOverview(LoudnessMeasurer *st);
+// Returns a malloc'd array of 8-bit peak values (one per 10ms), caller frees
+extern uint8_t *LoudnessMeasurerCopyOverview(LoudnessMeasurer *st, size_t *outCount);
 
+// Also keeps the minimum, maximum and RMS of each channel for binsPerSecond
+// bins per second (rounded to a multiple of 10). Call before scanning.
+//
+extern void LoudnessMeasurerSetDetailedOverviewRate(LoudnessMeasurer *st, size_t binsPerSecond);
+
+// Returns a malloc'd version 2 overview (see HugOverview.h), caller frees.
+// NULL unless LoudnessMeasurerSetDetailedOverviewRate() was called.
+//
+extern void *LoudnessMeasurerCopyDetailedOverview(LoudnessMeasurer *st, size_t *outLength);
+
+// Samples louder than silenceDecibels (dBFS) in any channel are audible. The
+// onset is the start of the first 10ms overview block with a mean square of
+// at least onsetDecibels in any channel. Defaults to -34 dBFS (the former
+// overview threshold) and -30 dBFS. Call before scanning.
+//
+extern void LoudnessMeasurerSetSilenceThresholds(LoudnessMeasurer *st, double silenceDecibels, double onsetDecibels);
+
+// First audible frame and the frame after the last one, false if nothing was audible
+extern bool LoudnessMeasurerGetAudibleRange(LoudnessMeasurer *st, size_t *outStartFrame, size_t *outEndFrame);
+
+// False if no block reached the onset threshold
+extern bool LoudnessMeasurerGetOnsetFrame(LoudnessMeasurer *st, size_t *outFrame);
+
+// Integrated loudness in LUFS of everything scanned so far, 0 if all of it is below the gate
 extern double LoudnessMeasurerGetLoudness(LoudnessMeasurer *st);
 extern double LoudnessMeasurerGetPeak(LoudnessMeasurer *st);
 
+// Inter-sample peak from 4x oversampling (ITU-R BS.1770-4, Annex 2), linear
+extern double LoudnessMeasurerGetTruePeak(LoudnessMeasurer *st);
+
+// Loudness in LUFS of the last 400ms and 3s, updated every 100ms.
+// -HUGE_VAL until that much audio has been scanned.
+//
+extern double LoudnessMeasurerGetMomentaryLoudness(LoudnessMeasurer *st);
+extern double LoudnessMeasurerGetShortTermLoudness(LoudnessMeasurer *st);
+
+// Loudness range (EBU Tech 3342) in LU, from the short-term loudness every 100ms
+extern double LoudnessMeasurerGetLoudnessRange(LoudnessMeasurer *st);
+
 
 #ifdef __cplusplus
 }
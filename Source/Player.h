@@ -52,7 +52,8 @@ extern volatile NSInteger PlayerShouldUseCrashPad;
                  sampleRate: (double) sampleRate
                      frames: (UInt32) frames
                     hogMode: (BOOL) hogMode
-               resetsVolume: (BOOL) resetsVolume;
+               resetsVolume: (BOOL) resetsVolume
+           lookaheadLimiter: (BOOL) lookaheadLimiter;
                    
 @property (nonatomic, readonly) HugAudioDevice *outputDevice;
 @property (nonatomic, readonly) double outputSampleRate;
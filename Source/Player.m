@@ -12,6 +12,7 @@
 #import "HugAudioSettings.h"
 #import "HugAudioSource.h"
 #import "HugAudioFile.h"
+#import "HugRenderChain.h"
 
 #import <pthread.h>
 #import <signal.h>
@@ -48,6 +49,7 @@ static double sMaxVolume = 1.0 - (2.0 / 32767.0);
     UInt32          _outputFrames;
     BOOL            _outputHogMode;
     BOOL            _outputResetsVolume;
+    BOOL            _outputLookaheadLimiter;
     
     AudioDeviceID _listeningDeviceID;
 
@@ -263,7 +265,10 @@ static double sMaxVolume = 1.0 - (2.0 / 32767.0);
     }
 
     double trackLoudness = [_currentTrack trackLoudness];
-    double trackPeak     = [_currentTrack trackPeak];
+    double trackPeak     = [_currentTrack trackTruePeak];
+
+    // Tracks analyzed before true peaks were measured only have the sample peak
+    if (!trackPeak) trackPeak = [_currentTrack trackPeak];
 
     double preamp     = _preAmpLevel;
     double replayGain = (-18.0 - trackLoudness);
@@ -496,8 +501,9 @@ static OSStatus sHandleAudioDevicePropertyChanged(AudioObjectID inObjectID, UInt
 
     if (ok && deviceID) {
         ok = [_engine configureWithDeviceID:deviceID settings:@{
-            HugAudioSettingSampleRate: @(_outputSampleRate),
-            HugAudioSettingFrameSize:  @(_outputFrames)
+            HugAudioSettingSampleRate:  @(_outputSampleRate),
+            HugAudioSettingFrameSize:   @(_outputFrames),
+            HugAudioSettingLimiterMode: @(_outputLookaheadLimiter ? HugLimiterModeLookahead : HugLimiterModeEmergency)
         }];
         
         if (!ok) raiseIssue(PlayerIssueErrorConfiguringOutputDevice);
@@ -742,14 +748,16 @@ static OSStatus sHandleAudioDevicePropertyChanged(AudioObjectID inObjectID, UInt
                      frames: (UInt32) frames
                     hogMode: (BOOL) hogMode
                resetsVolume: (BOOL) resetsVolume
+           lookaheadLimiter: (BOOL) lookaheadLimiter
 {
-    EmbraceLog(@"Player", @"updateOutputDevice:%@ sampleRate:%lf frames:%lu hogMode:%ld", self, sampleRate, (unsigned long)frames, (long)hogMode);
+    EmbraceLog(@"Player", @"updateOutputDevice:%@ sampleRate:%lf frames:%lu hogMode:%ld lookaheadLimiter:%ld", self, sampleRate, (unsigned long)frames, (long)hogMode, (long)lookaheadLimiter);
 
-    if (_outputDevice       != outputDevice ||
-        _outputSampleRate   != sampleRate   ||
-        _outputFrames       != frames       ||
-        _outputHogMode      != hogMode      ||
-        _outputResetsVolume != resetsVolume)
+    if (_outputDevice           != outputDevice ||
+        _outputSampleRate       != sampleRate   ||
+        _outputFrames           != frames       ||
+        _outputHogMode          != hogMode      ||
+        _outputResetsVolume     != resetsVolume ||
+        _outputLookaheadLimiter != lookaheadLimiter)
     {
         if (_outputDevice != outputDevice) {
             [_outputDevice removeObserver:self forKeyPath:@"connected"];
@@ -762,6 +770,7 @@ static OSStatus sHandleAudioDevicePropertyChanged(AudioObjectID inObjectID, UInt
         _outputFrames       = frames;
         _outputHogMode      = hogMode;
         _outputResetsVolume = resetsVolume;
+        _outputLookaheadLimiter = lookaheadLimiter;
 
         [self _reconfigureOutput];
     }
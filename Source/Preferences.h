@@ -88,5 +88,6 @@ extern NSString * const PreferencesDidChangeNotification;
 @property (nonatomic) UInt32          mainOutputFrames;
 @property (nonatomic) BOOL            mainOutputUsesHogMode;
 @property (nonatomic) BOOL            mainOutputResetsVolume;
+@property (nonatomic) BOOL            mainOutputUsesLookaheadLimiter;
 
 @end
@@ -51,7 +51,8 @@ static NSDictionary *sGetDefaultValues()
         @"mainOutputSampleRate":   @(44100),
         @"mainOutputFrames":       @(2048),
         @"mainOutputUsesHogMode":  @(NO),
-        @"mainOutputResetsVolume": @(YES)
+        @"mainOutputResetsVolume": @(YES),
+        @"mainOutputUsesLookaheadLimiter": @(NO)
     };
     
     });
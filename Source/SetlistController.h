@@ -4,7 +4,9 @@
 #import <Cocoa/Cocoa.h>
 #import "Player.h"
 
-@class TracksController;
+@class TracksController, Track;
+
+extern NSString * const SetlistControllerDidUpdateEndTimesNotificationName;
 
 
 typedef NS_ENUM(NSInteger, PlaybackAction) {
@@ -52,6 +54,9 @@ typedef NS_ENUM(NSInteger, PlaybackAction) {
 
 - (IBAction) revealTime:(id)sender;
 
+// Queued tracks and the playing one, nil for others. O(log n).
+- (NSDate *) estimatedEndTimeDateForTrack:(Track *)track;
+
 - (void) showAlertForIssue:(PlayerIssue)issue;
 
 @property (nonatomic) NSInteger minimumSilenceBetweenTracks;
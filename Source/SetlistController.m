@@ -4,6 +4,7 @@
 #import "SetlistController.h"
 
 #import "HugAudioDevice.h"
+#import "HugSetlistTiming.h"
 
 #import "Track.h"
 #import "EffectType.h"
@@ -30,6 +31,8 @@
 
 #import <AVFoundation/AVFoundation.h>
 
+NSString * const SetlistControllerDidUpdateEndTimesNotificationName = @"SetlistControllerDidUpdateEndTimes";
+
 static NSString * const sMinimumSilenceKey = @"minimum-silence";
 static NSString * const sSavedAtKey = @"saved-at";
 
@@ -78,7 +81,17 @@ static NSInteger sAutoGapMaximum = 16;
     double     _volumeBeforeDrag;
     double     _volumeBeforeKeyboard;
     BOOL       _confirmStop;
-    BOOL       _willCalculateStartAndEndTimes;
+
+    // Spans of _timedTracks, rebuilt by -_calculateStartAndEndTimes and
+    // updated in place when single tracks change duration. The only record
+    // of end times: rows on screen ask -estimatedEndTimeDateForTrack:.
+    //
+    HugSetlistTiming *_timing;
+    NSArray          *_timedTracks;
+    NSMapTable       *_timedTrackIndexes;
+
+    NSMutableSet *_tracksWithModifiedDuration;
+    BOOL          _willUpdateModifiedDurations;
 }
 
 
@@ -95,6 +108,7 @@ static NSInteger sAutoGapMaximum = 16;
 - (void) dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
+    HugSetlistTimingFree(_timing);
 }
 
 
@@ -159,6 +173,7 @@ static NSInteger sAutoGapMaximum = 16;
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_handleTrackDidModifyDuration:)          name:TrackDidModifyDurationNotificationName  object:nil];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_handleTrackDidModifyTitle:)             name:TrackDidModifyTitleNotificationName             object:nil];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_handleTrackDidModifyExternalURL:)       name:TrackDidModifyExternalURLNotificationName       object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_handleTrackDidModifyAudioFingerprint:)  name:TrackDidModifyAudioFingerprintNotificationName  object:nil];
 
     [self _handlePreferencesDidChange:nil];
 
@@ -295,8 +310,9 @@ static NSInteger sAutoGapMaximum = 16;
     BOOL            hogMode      = [preferences mainOutputUsesHogMode];
 
     BOOL resetsVolume = hogMode && [preferences mainOutputResetsVolume];
+    BOOL lookaheadLimiter = [preferences mainOutputUsesLookaheadLimiter];
     
-    [[Player sharedInstance] updateOutputDevice:device sampleRate:sampleRate frames:frames hogMode:hogMode resetsVolume:resetsVolume];
+    [[Player sharedInstance] updateOutputDevice:device sampleRate:sampleRate frames:frames hogMode:hogMode resetsVolume:resetsVolume lookaheadLimiter:lookaheadLimiter];
     
     NSWindow *window = [self window];
     if ([preferences floatsOnTop]) {
@@ -338,11 +354,25 @@ static NSInteger sAutoGapMaximum = 16;
 
 
 
+- (void) _handleTrackDidModifyAudioFingerprint:(NSNotification *)note
+{
+    [self detectDuplicates];
+}
+
+
+
 - (void) _handleTrackDidModifyDuration:(NSNotification *)note
 {
-    if (!_willCalculateStartAndEndTimes) {
-        [self performSelector:@selector(_calculateStartAndEndTimes) withObject:nil afterDelay:10];
-        _willCalculateStartAndEndTimes = YES;
+    Track *track = [note object];
+
+    if (track) {
+        if (!_tracksWithModifiedDuration) _tracksWithModifiedDuration = [NSMutableSet set];
+        [_tracksWithModifiedDuration addObject:track];
+    }
+
+    if (!_willUpdateModifiedDurations) {
+        [self performSelector:@selector(_updateModifiedDurations) withObject:nil afterDelay:10];
+        _willUpdateModifiedDurations = YES;
     }
 }
 
@@ -449,74 +479,183 @@ static NSInteger sAutoGapMaximum = 16;
 }
 
 
-- (void) _calculateStartAndEndTimes
+// The gap before a track plus the time it plays, 0 for tracks that won't play
+- (NSTimeInterval) _timingSpanForTrack:(Track *)track previousTrack:(Track *)previousTrack
 {
-    _willCalculateStartAndEndTimes = NO;
+    Player *player = [Player sharedInstance];
+    TrackStatus status = [track trackStatus];
+
+    if (status == TrackStatusPreparing || status == TrackStatusPlaying) {
+        if (![track isEqual:[player currentTrack]]) return 0;
+
+        NSTimeInterval expectedDuration = [track expectedDuration];
+        NSTimeInterval remaining = (status == TrackStatusPreparing) ? [track playDuration] : [player timeRemaining];
+
+        if (expectedDuration) {
+            remaining = expectedDuration - [player timeElapsed];
+            if (remaining < 0) remaining = 0;
+        }
+
+        return remaining;
+
+    } else if (status == TrackStatusQueued) {
+        NSTimeInterval duration = [track expectedDuration];
+        if (!duration) duration = [track playDuration];
+
+        NSTimeInterval padding = 0;
+
+        if (previousTrack) {
+            NSTimeInterval minimumSilence = [self minimumSilenceBetweenTracks];
+
+            NSTimeInterval totalSilence = [previousTrack silenceAtEnd] + [track silenceAtStart];
+            padding = minimumSilence - totalSilence;
+            if (padding < 0) padding = 0;
+
+            if (minimumSilence > 0 && padding == 0) {
+                padding = 1.0;
+            }
+        }
+
+        return padding + duration;
+    }
+
+    return 0;
+}
+
+
+// The playing track's span is its remaining time from now, so its end time
+// is pinned to now rather than to the start time of the last rebuild
+//
+- (void) _updateTimingSpanAtIndex:(NSUInteger)index
+{
+    Track *track = [_timedTracks objectAtIndex:index];
+    Track *previousTrack = nil;
+
+    for (NSUInteger i = index; i > 0; i--) {
+        Track *candidate = [_timedTracks objectAtIndex:(i - 1)];
+
+        if ([candidate trackStatus] != TrackStatusPlayed) {
+            previousTrack = candidate;
+            break;
+        }
+    }
 
     Player *player = [Player sharedInstance];
+    NSTimeInterval span = [self _timingSpanForTrack:track previousTrack:previousTrack];
+
+    if ([player isPlaying] && [track isEqual:[player currentTrack]]) {
+        HugSetlistTimingSetEndTime(_timing, index, [NSDate timeIntervalSinceReferenceDate] + span);
+    } else {
+        HugSetlistTimingSetSpan(_timing, index, span);
+    }
+}
+
 
-    NSTimeInterval now = [player isPlaying] ? [NSDate timeIntervalSinceReferenceDate] : 0.0;
-    NSTimeInterval time = 0;
+- (void) _postEndTimesDidUpdate
+{
+    [[NSNotificationCenter defaultCenter] postNotificationName:SetlistControllerDidUpdateEndTimesNotificationName object:self];
+}
+
+
+- (void) _calculateStartAndEndTimes
+{
+    [_tracksWithModifiedDuration removeAllObjects];
 
+    Player  *player = [Player sharedInstance];
+    NSArray *tracks = [[[self tracksController] tracks] copy];
+
+    NSUInteger  count = [tracks count];
+    double     *spans = malloc((count ? count : 1) * sizeof(double));
+
+    NSMapTable *indexes = [NSMapTable strongToStrongObjectsMapTable];
     Track *lastTrack = nil;
 
-    for (Track *track in [[self tracksController] tracks]) {
-        NSTimeInterval endTime = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        Track *track = [tracks objectAtIndex:i];
 
-        TrackStatus status = [track trackStatus];
-        
-        if (status == TrackStatusPlayed) {
-            continue;
-
-        } else if (status == TrackStatusPreparing || status == TrackStatusPlaying) {
-            if ([track isEqual:[player currentTrack]]) {
-                NSTimeInterval expectedDuration = [track expectedDuration];
-                NSTimeInterval remaining = (status == TrackStatusPreparing) ? [track playDuration] : [player timeRemaining];
-                
-                if (expectedDuration) {
-                    remaining = expectedDuration - [player timeElapsed];
-                    if (remaining < 0) remaining = 0;
-                }
-
-                time += remaining;
-                endTime = now + time;
-            }
+        spans[i] = [self _timingSpanForTrack:track previousTrack:lastTrack];
+        [indexes setObject:@(i) forKey:track];
 
-        } else if (status == TrackStatusQueued) {
-            NSTimeInterval duration = [track expectedDuration];
-            if (!duration) duration = [track playDuration];
+        if ([track trackStatus] != TrackStatusPlayed) {
+            lastTrack = track;
+        }
+    }
 
-            time += duration;
-            endTime = now + time;
-            
-            if (lastTrack) {
-                NSTimeInterval padding = 0;
+    if (!_timing) _timing = HugSetlistTimingCreate();
 
-                NSTimeInterval minimumSilence = [self minimumSilenceBetweenTracks];
+    if (HugSetlistTimingReset(_timing, spans, count)) {
+        _timedTracks       = tracks;
+        _timedTrackIndexes = indexes;
+
+        HugSetlistTimingSetStartTime(_timing, [player isPlaying] ? [NSDate timeIntervalSinceReferenceDate] : 0.0);
+
+        [self _postEndTimesDidUpdate];
+    }
+
+    free(spans);
+}
+
+
+// Each changed track moves its own span and the gap before the next track
+// that plays, O(log n) apiece. Visible rows then ask for their end times.
+//
+- (void) _updateModifiedDurations
+{
+    _willUpdateModifiedDurations = NO;
 
-                NSTimeInterval totalSilence = [lastTrack silenceAtEnd] + [track silenceAtStart];
-                padding = minimumSilence - totalSilence;
-                if (padding < 0) padding = 0;
-                
-                if (minimumSilence > 0 && padding == 0) {
-                    padding = 1.0;
-                }
+    NSUInteger count = [_timedTracks count];
+    BOOL didUpdate = NO;
 
-                time += padding;
+    for (Track *track in _tracksWithModifiedDuration) {
+        NSNumber *indexNumber = [_timedTrackIndexes objectForKey:track];
+        if (!indexNumber) continue;
+
+        NSUInteger index = [indexNumber unsignedIntegerValue];
+        [self _updateTimingSpanAtIndex:index];
+
+        for (NSUInteger i = index + 1; i < count; i++) {
+            if ([[_timedTracks objectAtIndex:i] trackStatus] != TrackStatusPlayed) {
+                [self _updateTimingSpanAtIndex:i];
+                break;
             }
         }
-        
-        if (endTime) {
-            [track setEstimatedEndTime:endTime];
-        }
 
-        lastTrack = track;
+        didUpdate = YES;
+    }
+
+    [_tracksWithModifiedDuration removeAllObjects];
+
+    if (didUpdate) {
+        [self _postEndTimesDidUpdate];
     }
 }
 
 
 #pragma mark - Public Methods
 
+- (NSDate *) estimatedEndTimeDateForTrack:(Track *)track
+{
+    NSNumber *indexNumber = [_timedTrackIndexes objectForKey:track];
+    if (!indexNumber) return nil;
+
+    Player *player = [Player sharedInstance];
+    TrackStatus status = [track trackStatus];
+
+    BOOL isCurrent = (status == TrackStatusPreparing || status == TrackStatusPlaying) && [track isEqual:[player currentTrack]];
+    if (status != TrackStatusQueued && !isCurrent) return nil;
+
+    NSTimeInterval endTime = HugSetlistTimingGetEndTime(_timing, [indexNumber unsignedIntegerValue]);
+    if (!endTime) return nil;
+
+    // Relative to now when nothing is playing
+    if (!HugSetlistTimingGetStartTime(_timing)) {
+        return [NSDate dateWithTimeIntervalSinceNow:endTime];
+    } else {
+        return [NSDate dateWithTimeIntervalSinceReferenceDate:endTime];
+    }
+}
+
+
 - (void) clear
 {
     EmbraceLogReopenLogFile();
@@ -882,7 +1021,14 @@ static NSInteger sAutoGapMaximum = 16;
     NSArray *tracks = [[self tracksController] selectedTracks];
     if ([tracks count] == 0) return;
 
-    [self _calculateStartAndEndTimes];
+    // Playback may have drifted, only the playing track's end time moves
+    Track *currentTrack = [[Player sharedInstance] currentTrack];
+    NSNumber *indexNumber = currentTrack ? [_timedTrackIndexes objectForKey:currentTrack] : nil;
+
+    if (indexNumber) {
+        [self _updateTimingSpanAtIndex:[indexNumber unsignedIntegerValue]];
+        [self _postEndTimesDidUpdate];
+    }
 
     [[self tracksController] revealTime:self];
 }
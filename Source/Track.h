@@ -6,6 +6,7 @@
 extern NSString * const TrackDidModifyTitleNotificationName;
 extern NSString * const TrackDidModifyExternalURLNotificationName;
 extern NSString * const TrackDidModifyDurationNotificationName;
+extern NSString * const TrackDidModifyAudioFingerprintNotificationName;
 
 @class TrackAnalyzer;
 
@@ -36,6 +37,10 @@ typedef NS_ENUM(NSInteger, TrackLabel) {
 
 + (instancetype) trackWithUUID:(NSUUID *)uuid;
 
+// Order of the tracks in the set list, kept in the same store as their state
++ (NSArray<NSUUID *> *) persistedTrackUUIDs;
++ (BOOL) persistTrackUUIDs:(NSArray<NSUUID *> *)UUIDs;
+
 + (instancetype) trackWithFileURL:(NSURL *)url;
 
 - (void) cancelLoad;
@@ -48,12 +53,6 @@ typedef NS_ENUM(NSInteger, TrackLabel) {
 @property (nonatomic, readonly) NSTimeInterval playedTime;
 
 
-// estimatedEndTime may either be a relative date (when not playing a track)
-// or an absolute date (when playing a track).  estimatedEndTimeDate returns
-// the correct value
-//
-- (NSDate *) estimatedEndTimeDate;
-
 - (Track *) duplicatedTrack;
 
 @property (nonatomic, readonly) BOOL isResolvingURLs;
@@ -69,7 +68,6 @@ typedef NS_ENUM(NSInteger, TrackLabel) {
 
 @property (nonatomic) NSTimeInterval expectedDuration;
 
-@property (nonatomic) NSTimeInterval estimatedEndTime;
 @property (nonatomic) NSError *error;
 
 @property (nonatomic) TrackLabel trackLabel;
@@ -93,15 +91,50 @@ typedef NS_ENUM(NSInteger, TrackLabel) {
 @property (nonatomic, readonly) NSTimeInterval stopTime;
 @property (nonatomic, readonly) NSTimeInterval duration;
 @property (nonatomic, readonly) NSInteger databaseID;
-@property (nonatomic, readonly) Tonality tonality;
+@property (nonatomic, readonly) Tonality tonality; // From initialKey, or a confident estimatedKey
 @property (nonatomic, readonly) NSInteger energyLevel;
 @property (nonatomic, readonly) NSInteger year;
 
 @property (nonatomic, readonly) NSTimeInterval decodedDuration;
 @property (nonatomic, readonly) double  trackLoudness;
 @property (nonatomic, readonly) double  trackPeak;
+@property (nonatomic, readonly) double  trackTruePeak;
 @property (nonatomic, readonly) NSData *overviewData;
 @property (nonatomic, readonly) double  overviewRate;
+@property (nonatomic, readonly) NSInteger overviewVersion;
+
+// One version 1 byte per overview bin, derived from overviewData for version 2
+@property (nonatomic, readonly) NSData *overviewPeaks;
+
+// HugOverviewPyramid over overviewPeaks, rebuilt whenever it changes
+@property (nonatomic, readonly) NSData *overviewPyramid;
+
+// First audible sample, end of the last one, and the start of the first
+// 10ms loud enough to count as the music starting. From the start of the
+// file, ignoring startTime and stopTime. audibleEndTime is 0 for tracks
+// analyzed before these were measured.
+//
+@property (nonatomic, readonly) NSTimeInterval audibleStartTime;
+@property (nonatomic, readonly) NSTimeInterval audibleEndTime;
+@property (nonatomic, readonly) NSTimeInterval onsetTime;
+
+// See HugFingerprint.h, nil for tracks under eight seconds or analyzed
+// before fingerprints were made
+//
+@property (nonatomic, readonly) NSData *audioFingerprint;
+
+// See HugTempo.h, 0 for tracks with no steady beat or analyzed before tempos
+// were estimated. The confidence goes from 0 to 1.
+//
+@property (nonatomic, readonly) double estimatedBeatsPerMinute;
+@property (nonatomic, readonly) double estimatedBeatsPerMinuteConfidence;
+
+// See HugKey.h, a traditional key name such as "F#m", or nil for silent
+// tracks and ones analyzed before keys were estimated. The confidence goes
+// from 0 to 1.
+//
+@property (nonatomic, readonly) NSString *estimatedKey;
+@property (nonatomic, readonly) double estimatedKeyConfidence;
 
 // Dynamic
 @property (nonatomic, readonly) NSTimeInterval playDuration;
@@ -109,4 +142,8 @@ typedef NS_ENUM(NSInteger, TrackLabel) {
 @property (nonatomic, readonly) NSTimeInterval silenceAtEnd;
 @property (nonatomic, readonly) BOOL didAnalyzeLoudness;
 
+// beatsPerMinute, or the rounded estimate when tags lack one and the
+// estimate is confident enough. 0 if neither is available.
+@property (nonatomic, readonly) NSInteger displayedBeatsPerMinute;
+
 @end
@@ -8,12 +8,17 @@
 #import "ScriptsManager.h"
 #import "WorkerService.h"
 #import "HugError.h"
+#import "HugOverview.h"
+#import "HugOverviewPyramid.h"
+#import "HugStateStore.h"
 
 #import <AVFoundation/AVFoundation.h>
+#import <stdatomic.h>
 
-NSString * const TrackDidModifyTitleNotificationName       = @"TrackDidModifyTitleNotificationName";
-NSString * const TrackDidModifyExternalURLNotificationName = @"TrackDidModifyExternalURLNotificationName";
-NSString * const TrackDidModifyDurationNotificationName    = @"TrackDidModifyDurationNotificationName";
+NSString * const TrackDidModifyTitleNotificationName            = @"TrackDidModifyTitleNotificationName";
+NSString * const TrackDidModifyExternalURLNotificationName      = @"TrackDidModifyExternalURLNotificationName";
+NSString * const TrackDidModifyDurationNotificationName         = @"TrackDidModifyDurationNotificationName";
+NSString * const TrackDidModifyAudioFingerprintNotificationName = @"TrackDidModifyAudioFingerprintNotificationName";
 
 #define DUMP_UNKNOWN_TAGS 0
 
@@ -23,6 +28,15 @@ static NSString * const sIgnoresAutoGapKey    = @"ignoresAutoGap";
 static NSString * const sStatusKey            = @"trackStatus";
 static NSString * const sPlayedTimeKey        = @"playedTime";
 
+// Below this, an estimated tempo is more likely wrong than right
+static const double sEstimatedBPMMinimumConfidence = 0.3;
+
+// Noise correlates up to about 0.4 with some key, music in one key 0.8 and up
+static const double sEstimatedKeyMinimumConfidence = 0.6;
+
+// LoudnessMeasurer finds onsets to the 10ms overview block
+static const NSTimeInterval sOnsetBlockDuration = 0.01;
+
 
 @interface Track ()
 @property (nonatomic) NSUUID *UUID;
@@ -37,8 +51,18 @@ static NSString * const sPlayedTimeKey        = @"playedTime";
 @property (nonatomic) Tonality tonality;
 @property (nonatomic) double trackLoudness;
 @property (nonatomic) double trackPeak;
+@property (nonatomic) double trackTruePeak;
 @property (nonatomic) NSData *overviewData;
 @property (nonatomic) double  overviewRate;
+@property (nonatomic) NSInteger overviewVersion;
+@property (nonatomic) NSTimeInterval audibleStartTime;
+@property (nonatomic) NSTimeInterval audibleEndTime;
+@property (nonatomic) NSTimeInterval onsetTime;
+@property (nonatomic) NSData *audioFingerprint;
+@property (nonatomic) double estimatedBeatsPerMinute;
+@property (nonatomic) double estimatedBeatsPerMinuteConfidence;
+@property (nonatomic) NSString *estimatedKey;
+@property (nonatomic) double estimatedKeyConfidence;
 @property (nonatomic) NSInteger databaseID;
 @property (nonatomic) NSInteger energyLevel;
 @property (nonatomic) NSString *genre;
@@ -58,11 +82,15 @@ static NSString * const sPlayedTimeKey        = @"playedTime";
 
     NSMutableArray *_dirtyKeys;
     BOOL            _dirty;
+
+    // What the store has for this track, saves only write the differences
+    NSDictionary   *_savedState;
+    BOOL            _hasLegacyState;
     BOOL            _cleared;
     BOOL            _priorityAnalysisRequested;
 }
 
-@dynamic playDuration, silenceAtStart, silenceAtEnd, tonality;
+@dynamic playDuration, silenceAtStart, silenceAtEnd, tonality, displayedBeatsPerMinute;
 
 
 static NSURL *sGetStateDirectoryURL()
@@ -82,6 +110,153 @@ static NSURL *sGetStateDirectoryURL()
 }
 
 
+// Indices are part of Tracks.store's format: append new keys, never reorder
+static NSArray<NSString *> *sStoreNumberKeys = nil;
+static NSArray<NSString *> *sStoreBlobKeys   = nil;
+static NSSet<NSString *>   *sStoreDataKeys   = nil;
+
+
+static HugStateStore *sGetStateStore()
+{
+    static HugStateStore *sStateStore = NULL;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sStoreNumberKeys = @[
+            sLabelKey, sStatusKey, sPlayedTimeKey, sStopsAfterPlayingKey, sIgnoresAutoGapKey,
+            TrackKeyBPM, TrackKeyDatabaseID, TrackKeyDecodedDuration, TrackKeyDuration,
+            TrackKeyEnergyLevel, TrackKeyExpectedDuration, TrackKeyOverviewRate,
+            TrackKeyStartTime, TrackKeyStopTime, TrackKeyTrackLoudness, TrackKeyTrackPeak,
+            TrackKeyTrackTruePeak, TrackKeyYear, TrackKeyOverviewVersion,
+            TrackKeyAudibleStartTime, TrackKeyAudibleEndTime, TrackKeyOnsetTime,
+            TrackKeyEstimatedBPM, TrackKeyEstimatedBPMConfidence, TrackKeyEstimatedKeyConfidence
+        ];
+
+        sStoreBlobKeys = @[
+            TrackKeyURL, TrackKeyAlbum, TrackKeyAlbumArtist, TrackKeyArtist, TrackKeyComments,
+            TrackKeyComposer, TrackKeyGenre, TrackKeyGrouping, TrackKeyInitialKey, TrackKeyTitle,
+            TrackKeyBookmark, TrackKeyError, TrackKeyOverviewData, TrackKeyAudioFingerprint,
+            TrackKeyEstimatedKey
+        ];
+
+        // Everything else in sStoreBlobKeys is a UTF-8 string
+        sStoreDataKeys = [NSSet setWithObjects:TrackKeyBookmark, TrackKeyError, TrackKeyOverviewData, TrackKeyAudioFingerprint, nil];
+
+        NSString *path = [GetApplicationSupportDirectory() stringByAppendingPathComponent:@"Tracks.store"];
+        sStateStore = HugStateStoreOpen([path fileSystemRepresentation], [sStoreNumberKeys count], [sStoreBlobKeys count]);
+
+        if (!sStateStore) {
+            EmbraceLog(@"Track", @"Could not open state store at %@", path);
+        }
+    });
+    
+    return sStateStore;
+}
+
+
+static HugStateStoreID sGetStoreID(NSUUID *UUID)
+{
+    HugStateStoreID result;
+    [UUID getUUIDBytes:result.bytes];
+    return result;
+}
+
+
+static NSDictionary *sReadStateFromStore(NSUUID *UUID)
+{
+    HugStateStore  *store  = sGetStateStore();
+    HugStateStoreID itemID = sGetStoreID(UUID);
+
+    double numbers[HUG_STATE_STORE_MAX_FIELDS];
+    if (!store || !HugStateStoreReadNumbers(store, itemID, NULL, numbers)) return nil;
+
+    NSMutableDictionary *state = [NSMutableDictionary dictionary];
+
+    for (NSUInteger i = 0; i < [sStoreNumberKeys count]; i++) {
+        if (numbers[i]) [state setObject:@(numbers[i]) forKey:[sStoreNumberKeys objectAtIndex:i]];
+    }
+
+    for (NSUInteger i = 0; i < [sStoreBlobKeys count]; i++) {
+        NSString *key = [sStoreBlobKeys objectAtIndex:i];
+
+        size_t length = 0;
+        void  *bytes  = HugStateStoreCopyBlob(store, itemID, i, &length);
+
+        if (!bytes) continue;
+
+        NSData *data = [[NSData alloc] initWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+        id value = [sStoreDataKeys containsObject:key] ? data : [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+
+        if (value) [state setObject:value forKey:key];
+    }
+
+    return state;
+}
+
+
+// Writes the keys that differ from savedState, or all of them if it is nil
+static BOOL sWriteStateToStore(NSUUID *UUID, NSDictionary *state, NSDictionary *savedState)
+{
+    HugStateStore  *store  = sGetStateStore();
+    HugStateStoreID itemID = sGetStoreID(UUID);
+
+    if (!store) return NO;
+
+    double   numbers[HUG_STATE_STORE_MAX_FIELDS] = {0};
+    uint64_t mask = 0;
+
+    for (NSUInteger i = 0; i < [sStoreNumberKeys count]; i++) {
+        NSString *key = [sStoreNumberKeys objectAtIndex:i];
+        numbers[i] = [[state objectForKey:key] doubleValue];
+
+        if (!savedState || (numbers[i] != [[savedState objectForKey:key] doubleValue])) {
+            mask |= (1ull << i);
+        }
+    }
+
+    BOOL ok = YES;
+
+    if (mask) {
+        ok = HugStateStoreWriteNumbers(store, itemID, mask, numbers);
+    }
+
+    for (NSUInteger i = 0; ok && i < [sStoreBlobKeys count]; i++) {
+        NSString *key = [sStoreBlobKeys objectAtIndex:i];
+
+        id value    = [state      objectForKey:key];
+        id oldValue = [savedState objectForKey:key];
+
+        if (savedState ? (value == oldValue || [value isEqual:oldValue]) : !value) {
+            continue;
+        }
+
+        NSData *data = [value isKindOfClass:[NSString class]] ? [value dataUsingEncoding:NSUTF8StringEncoding] : value;
+        const void *bytes = data ? ([data bytes] ? [data bytes] : "") : NULL;
+
+        ok = HugStateStoreWriteBlob(store, itemID, i, bytes, [data length]);
+    }
+
+    return ok;
+}
+
+
+static void sCompactStateStoreIfNeeded()
+{
+    static atomic_bool sCompacting = false;
+
+    HugStateStore *store = sGetStateStore();
+    if (!store || !HugStateStoreNeedsCompaction(store)) return;
+
+    if (atomic_exchange(&sCompacting, true)) return;
+
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        HugStateStoreCompact(store);
+        atomic_store(&sCompacting, false);
+    });
+}
+
+
+// Tracks/<UUID>.plist, from before Tracks.store
 static NSURL *sGetStateURLForUUID(NSUUID *UUID)
 {
     if (!UUID) return nil;
@@ -124,6 +299,33 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 }
 
 
+static NSData *sMakeOverviewPeaks(NSData *overviewData, NSInteger overviewVersion)
+{
+    if (overviewVersion < 2) return overviewData;
+
+    HugOverview *overview = HugOverviewCreate([overviewData bytes], [overviewData length]);
+    if (!overview) return nil;
+
+    NSMutableData *result = [NSMutableData dataWithLength:HugOverviewGetBinCount(overview)];
+    HugOverviewGetPeaks(overview, [result mutableBytes]);
+    HugOverviewFree(overview);
+
+    return result;
+}
+
+
+static NSData *sMakeOverviewPyramid(NSData *overviewPeaks)
+{
+    size_t size = HugOverviewPyramidGetSize([overviewPeaks length]);
+    if (!size) return nil;
+
+    NSMutableData *result = [NSMutableData dataWithLength:size];
+    HugOverviewPyramidBuild([overviewPeaks bytes], [overviewPeaks length], [result mutableBytes]);
+
+    return result;
+}
+
+
 + (NSSet *) keyPathsForValuesAffectingValueForKey:(NSString *)key
 {
     NSSet *keyPaths = [super keyPathsForValuesAffectingValueForKey:key];
@@ -132,11 +334,15 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
     if ([key isEqualToString:@"playDuration"]) {
         affectingKeys = @[ @"duration", @"decodedDuration", @"stopTime", @"startTime" ];
     } else if ([key isEqualToString:@"silenceAtStart"]) {
-        affectingKeys = @[ @"overviewData", @"startTime" ];
+        affectingKeys = @[ @"overviewPeaks", @"startTime", @"audibleStartTime", @"audibleEndTime", @"onsetTime" ];
     } else if ([key isEqualToString:@"silenceAtEnd"]) {
-        affectingKeys = @[ @"overviewData", @"stopTime" ];
+        affectingKeys = @[ @"overviewPeaks", @"stopTime", @"audibleEndTime", @"decodedDuration" ];
+    } else if ([key isEqualToString:@"overviewPeaks"] || [key isEqualToString:@"overviewPyramid"]) {
+        affectingKeys = @[ @"overviewData", @"overviewVersion" ];
     } else if ([key isEqualToString:@"tonality"]) {
-        affectingKeys = @[ @"initialKey" ];
+        affectingKeys = @[ @"initialKey", @"estimatedKey", @"estimatedKeyConfidence" ];
+    } else if ([key isEqualToString:@"displayedBeatsPerMinute"]) {
+        affectingKeys = @[ @"beatsPerMinute", @"estimatedBeatsPerMinute", @"estimatedBeatsPerMinuteConfidence" ];
     }
 
     if (affectingKeys) {
@@ -149,6 +355,9 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 
 + (void) clearPersistedState
 {
+    HugStateStore *store = sGetStateStore();
+    if (store) HugStateStoreRemoveAll(store);
+
     NSError *error;
     [[NSFileManager defaultManager] removeItemAtURL:sGetStateDirectoryURL()    error:&error];
     [[NSFileManager defaultManager] removeItemAtURL:sGetInternalDirectoryURL() error:&error];
@@ -157,17 +366,76 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 
 + (instancetype) trackWithUUID:(NSUUID *)UUID
 {
-    NSURL *stateURL = sGetStateURLForUUID(UUID);
-    NSDictionary *state = stateURL ? [NSDictionary dictionaryWithContentsOfURL:stateURL] : nil;
+    if (!UUID) return nil;
+
+    NSDictionary *state = sReadStateFromStore(UUID);
+    BOOL hasLegacyState = NO;
+
+    if (!state) {
+        NSURL *stateURL = sGetStateURLForUUID(UUID);
+        state = stateURL ? [NSDictionary dictionaryWithContentsOfURL:stateURL] : nil;
+        hasLegacyState = (state != nil);
+    }
     
     if (!state) return nil;
 
     Track *track = [[Track alloc] _initWithUUID:UUID state:state];
 
+    // Moved into the store by the first save, once the bookmark resolves
+    if (hasLegacyState) {
+        track->_hasLegacyState = YES;
+        track->_dirty = YES;
+    } else {
+        track->_savedState = state;
+    }
+
     return track;
 }
 
 
++ (NSArray<NSUUID *> *) persistedTrackUUIDs
+{
+    HugStateStore *store = sGetStateStore();
+    if (!store) return nil;
+
+    size_t count = 0;
+    HugStateStoreID *itemIDs = HugStateStoreCopyList(store, &count);
+    if (!itemIDs) return nil;
+
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+
+    for (size_t i = 0; i < count; i++) {
+        [result addObject:[[NSUUID alloc] initWithUUIDBytes:itemIDs[i].bytes]];
+    }
+
+    free(itemIDs);
+
+    return result;
+}
+
+
++ (BOOL) persistTrackUUIDs:(NSArray<NSUUID *> *)UUIDs
+{
+    HugStateStore *store = sGetStateStore();
+    if (!store) return NO;
+
+    NSUInteger count = [UUIDs count];
+    HugStateStoreID *itemIDs = malloc(MAX(count, 1) * sizeof(HugStateStoreID));
+    if (!itemIDs) return NO;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        itemIDs[i] = sGetStoreID([UUIDs objectAtIndex:i]);
+    }
+
+    BOOL result = HugStateStoreWriteList(store, itemIDs, count);
+    free(itemIDs);
+
+    sCompactStateStoreIfNeeded();
+
+    return result;
+}
+
+
 + (instancetype) trackWithFileURL:(NSURL *)url
 {
     NSUUID *UUID = [NSUUID UUID];
@@ -286,6 +554,7 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 {
     BOOL postTitleChanged = NO;
     BOOL postDurationChanged = NO;
+    BOOL postAudioFingerprintChanged = NO;
 
     for (NSString *key in state) {
         id oldValue = [self valueForKey:key];
@@ -311,6 +580,10 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
             if ([@"title" isEqualToString:key]) {
                 postTitleChanged = YES;
             }
+
+            if ([TrackKeyAudioFingerprint isEqualToString:key]) {
+                postAudioFingerprintChanged = YES;
+            }
             
             if ([@[ @"duration", @"decodedDuration", @"startTime", @"endTime" ] containsObject:key]) {
                 postDurationChanged = YES;
@@ -318,11 +591,13 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
         }
     }
 
-    NSData   *overviewData = [state objectForKey:TrackKeyOverviewData];
-    NSNumber *startTime    = [state objectForKey:TrackKeyStartTime];
-    NSNumber *stopTime     = [state objectForKey:TrackKeyStopTime];
+    NSData   *overviewData    = [state objectForKey:TrackKeyOverviewData];
+    NSNumber *overviewVersion = [state objectForKey:TrackKeyOverviewVersion];
+    NSNumber *audibleEndTime  = [state objectForKey:TrackKeyAudibleEndTime];
+    NSNumber *startTime       = [state objectForKey:TrackKeyStartTime];
+    NSNumber *stopTime        = [state objectForKey:TrackKeyStopTime];
 
-    if (overviewData || startTime || stopTime) {
+    if (overviewData || overviewVersion || audibleEndTime || startTime || stopTime) {
         [self _calculateSilence];
     }
     
@@ -346,6 +621,12 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
             [[NSNotificationCenter defaultCenter] postNotificationName:TrackDidModifyDurationNotificationName object:self];
         });
     }
+
+    if (postAudioFingerprintChanged) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [[NSNotificationCenter defaultCenter] postNotificationName:TrackDidModifyAudioFingerprintNotificationName object:self];
+        });
+    }
 }
 
 - (void) _writeStateToDictionary:(NSMutableDictionary *)state
@@ -379,6 +660,9 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
     if (_album)            [state setObject:_album                forKey:TrackKeyAlbum];
     if (_albumArtist)      [state setObject:_albumArtist          forKey:TrackKeyAlbumArtist];
     if (_artist)           [state setObject:_artist               forKey:TrackKeyArtist];
+    if (_audioFingerprint) [state setObject:  _audioFingerprint   forKey:TrackKeyAudioFingerprint];
+    if (_audibleStartTime) [state setObject:@(_audibleStartTime)  forKey:TrackKeyAudibleStartTime];
+    if (_audibleEndTime)   [state setObject:@(_audibleEndTime)    forKey:TrackKeyAudibleEndTime];
     if (_beatsPerMinute)   [state setObject:@(_beatsPerMinute)    forKey:TrackKeyBPM];
     if (_bookmark)         [state setObject:_bookmark             forKey:TrackKeyBookmark];
     if (_comments)         [state setObject:_comments             forKey:TrackKeyComments];
@@ -387,17 +671,24 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
     if (_decodedDuration)  [state setObject:@(_decodedDuration)   forKey:TrackKeyDecodedDuration];
     if (_duration)         [state setObject:@(_duration)          forKey:TrackKeyDuration];
     if (_energyLevel)      [state setObject:@(_energyLevel)       forKey:TrackKeyEnergyLevel];
+    if (_estimatedBeatsPerMinute)           [state setObject:@(_estimatedBeatsPerMinute)           forKey:TrackKeyEstimatedBPM];
+    if (_estimatedBeatsPerMinuteConfidence) [state setObject:@(_estimatedBeatsPerMinuteConfidence) forKey:TrackKeyEstimatedBPMConfidence];
+    if (_estimatedKey)                      [state setObject:  _estimatedKey                       forKey:TrackKeyEstimatedKey];
+    if (_estimatedKeyConfidence)            [state setObject:@(_estimatedKeyConfidence)            forKey:TrackKeyEstimatedKeyConfidence];
     if (_expectedDuration) [state setObject:@(_expectedDuration)  forKey:TrackKeyExpectedDuration];
     if (_genre)            [state setObject:_genre                forKey:TrackKeyGenre];
     if (_grouping)         [state setObject:_grouping             forKey:TrackKeyGrouping];
     if (_initialKey)       [state setObject:  _initialKey         forKey:TrackKeyInitialKey];
+    if (_onsetTime)        [state setObject:@(_onsetTime)         forKey:TrackKeyOnsetTime];
     if (_overviewData)     [state setObject:  _overviewData       forKey:TrackKeyOverviewData];
     if (_overviewRate)     [state setObject:@(_overviewRate)      forKey:TrackKeyOverviewRate];
+    if (_overviewVersion)  [state setObject:@(_overviewVersion)   forKey:TrackKeyOverviewVersion];
     if (_startTime)        [state setObject:@(_startTime)         forKey:TrackKeyStartTime];
     if (_stopTime)         [state setObject:@(_stopTime)          forKey:TrackKeyStopTime];
     if (_title)            [state setObject:_title                forKey:TrackKeyTitle];
     if (_trackLoudness)    [state setObject:@(_trackLoudness)     forKey:TrackKeyTrackLoudness];
     if (_trackPeak)        [state setObject:@(_trackPeak)         forKey:TrackKeyTrackPeak];
+    if (_trackTruePeak)    [state setObject:@(_trackTruePeak)     forKey:TrackKeyTrackTruePeak];
     if (_year)             [state setObject:@(_year)              forKey:TrackKeyYear];
 }
 
@@ -414,8 +705,16 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 
     [self _writeStateToDictionary:state];
 
-    NSURL *url = _UUID ? sGetStateURLForUUID(_UUID) : nil;
-    if (url) [state writeToURL:url atomically:YES];
+    if (_UUID && sWriteStateToStore(_UUID, state, _savedState)) {
+        _savedState = state;
+
+        if (_hasLegacyState) {
+            [[NSFileManager defaultManager] removeItemAtURL:sGetStateURLForUUID(_UUID) error:NULL];
+            _hasLegacyState = NO;
+        }
+    }
+
+    sCompactStateStoreIfNeeded();
     
     _dirty = NO;
     [_dirtyKeys removeAllObjects];
@@ -602,6 +901,14 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 
 #pragma mark - Metadata
 
+// overviewData and overviewVersion arrive in either order, so this runs for both
+- (void) _updateOverviewPeaks
+{
+    _overviewPeaks   = sMakeOverviewPeaks(_overviewData, _overviewVersion);
+    _overviewPyramid = sMakeOverviewPyramid(_overviewPeaks);
+}
+
+
 - (void) _invalidateSilence
 {
     _silenceAtEnd = _silenceAtStart = NAN;
@@ -610,10 +917,10 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 
 - (void) _calculateSilence
 {
-    if (!_overviewData || !_overviewRate) return;
+    if (!_overviewPeaks || !_overviewRate) return;
 
-    UInt8     *buffer      = (UInt8 *)[_overviewData bytes];
-    NSUInteger length      = [_overviewData length];
+    UInt8     *buffer      = (UInt8 *)[_overviewPeaks bytes];
+    NSUInteger length      = [_overviewPeaks length];
     UInt8      threshold   = 4;
 
     // Calculate silence at start
@@ -660,6 +967,30 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
         
         _silenceAtEnd = sampleCount / _overviewRate;
     }
+
+    // The scan's audible range is sample-accurate. Use it instead of the
+    // overview whenever startTime and stopTime leave it whole.
+    //
+    // A click or hiss can cross the audible threshold long before the music.
+    // If the onset comes more than one overview block later, the music
+    // starts there and the quiet lead-in counts as silence.
+    //
+    if (_audibleEndTime > 0) {
+        NSTimeInterval stopTime   = _stopTime ? _stopTime : _decodedDuration;
+        NSTimeInterval musicStart = _audibleStartTime;
+
+        if (_onsetTime > (_audibleStartTime + sOnsetBlockDuration)) {
+            musicStart = _onsetTime;
+        }
+
+        if (_startTime <= musicStart) {
+            _silenceAtStart = musicStart - _startTime;
+        }
+
+        if (stopTime >= _audibleEndTime) {
+            _silenceAtEnd = stopTime - _audibleEndTime;
+        }
+    }
 }
 
 
@@ -771,8 +1102,11 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 
 - (void) clearAndCleanup
 {
+    HugStateStore *store = sGetStateStore();
+    if (store && _UUID) HugStateStoreRemoveItem(store, sGetStoreID(_UUID));
+
     NSError *error = nil;
-    [[NSFileManager defaultManager] removeItemAtURL:sGetStateURLForUUID(_UUID) error:&error];
+    if (_hasLegacyState) [[NSFileManager defaultManager] removeItemAtURL:sGetStateURLForUUID(_UUID) error:&error];
     if (_internalURL) [[NSFileManager defaultManager] removeItemAtURL:_internalURL error:&error];
 
     _cleared = YES;
@@ -799,18 +1133,6 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 }
 
 
-- (NSDate *) estimatedEndTimeDate
-{
-    NSTimeInterval endTime = _estimatedEndTime;
-    
-    if (endTime < (60 * 60 * 24 * 7)) {
-        return [NSDate dateWithTimeIntervalSinceNow:endTime];
-    } else {
-        return [NSDate dateWithTimeIntervalSinceReferenceDate:endTime];
-    }
-}
-
-
 - (void) setTrackStatus:(TrackStatus)trackStatus
 {
     if (_trackStatus != trackStatus) {
@@ -836,6 +1158,43 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 }
 
 
+- (void) setOverviewData:(NSData *)overviewData
+{
+    if (_overviewData != overviewData) {
+        _overviewData = overviewData;
+        [self _updateOverviewPeaks];
+    }
+}
+
+
+- (void) setOverviewVersion:(NSInteger)overviewVersion
+{
+    if (_overviewVersion != overviewVersion) {
+        _overviewVersion = overviewVersion;
+        [self _updateOverviewPeaks];
+    }
+}
+
+
+// Silence is recalculated lazily from the overview and audible range
+- (void) setStartTime:(NSTimeInterval)startTime
+{
+    if (_startTime != startTime) {
+        _startTime = startTime;
+        [self _invalidateSilence];
+    }
+}
+
+
+- (void) setStopTime:(NSTimeInterval)stopTime
+{
+    if (_stopTime != stopTime) {
+        _stopTime = stopTime;
+        [self _invalidateSilence];
+    }
+}
+
+
 - (void) setTitle:(NSString *)title
 {
     if (_title != title) {
@@ -947,9 +1306,27 @@ static NSURL *sGetInternalURLForUUID(NSUUID *UUID, NSString *extension)
 }
 
 
+- (NSInteger) displayedBeatsPerMinute
+{
+    if (_beatsPerMinute) return _beatsPerMinute;
+
+    if (_estimatedBeatsPerMinuteConfidence >= sEstimatedBPMMinimumConfidence) {
+        return lround(_estimatedBeatsPerMinute);
+    }
+
+    return 0;
+}
+
+
 - (Tonality) tonality
 {
-    return GetTonalityForString([self initialKey]);
+    Tonality tonality = GetTonalityForString([self initialKey]);
+
+    if (tonality == Tonality_Unknown && _estimatedKeyConfidence >= sEstimatedKeyMinimumConfidence) {
+        tonality = GetTonalityForString(_estimatedKey);
+    }
+
+    return tonality;
 }
 
 
@@ -19,8 +19,18 @@ extern NSString * const TrackKeyInitialKey;
 extern NSString * const TrackKeyTonality;
 extern NSString * const TrackKeyTrackLoudness;
 extern NSString * const TrackKeyTrackPeak;
+extern NSString * const TrackKeyTrackTruePeak;
 extern NSString * const TrackKeyOverviewData;
 extern NSString * const TrackKeyOverviewRate;
+extern NSString * const TrackKeyOverviewVersion;
+extern NSString * const TrackKeyAudibleStartTime;
+extern NSString * const TrackKeyAudibleEndTime;
+extern NSString * const TrackKeyOnsetTime;
+extern NSString * const TrackKeyAudioFingerprint;
+extern NSString * const TrackKeyEstimatedBPM;
+extern NSString * const TrackKeyEstimatedBPMConfidence;
+extern NSString * const TrackKeyEstimatedKey;
+extern NSString * const TrackKeyEstimatedKeyConfidence;
 extern NSString * const TrackKeyBPM;
 extern NSString * const TrackKeyDatabaseID;
 extern NSString * const TrackKeyGrouping;
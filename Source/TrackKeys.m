@@ -22,6 +22,7 @@ NSString * const TrackKeyInitialKey       = @"initialKey";
 NSString * const TrackKeyTonality         = @"tonality";
 NSString * const TrackKeyTrackLoudness    = @"trackLoudness";
 NSString * const TrackKeyTrackPeak        = @"trackPeak";
+NSString * const TrackKeyTrackTruePeak    = @"trackTruePeak";
 NSString * const TrackKeyOverviewData     = @"overviewData";
 NSString * const TrackKeyOverviewRate     = @"overviewRate";
 NSString * const TrackKeyBPM              = @"beatsPerMinute";
@@ -35,6 +36,25 @@ NSString * const TrackKeyYear             = @"year";
 // This is the duration as reported by -[AVURLAsset duration]
 NSString * const TrackKeyDuration = @"duration";
 
+// Absent in states from before version 2 overviews (see HugOverview.h)
+NSString * const TrackKeyOverviewVersion = @"overviewVersion";
+
+// Sample-accurate times from the loudness scan, see LoudnessMeasurerGetAudibleRange()
+NSString * const TrackKeyAudibleStartTime = @"audibleStartTime";
+NSString * const TrackKeyAudibleEndTime   = @"audibleEndTime";
+NSString * const TrackKeyOnsetTime        = @"onsetTime";
+
+// Chroma fingerprint of the audible range, see HugFingerprint.h
+NSString * const TrackKeyAudioFingerprint = @"audioFingerprint";
+
+// Tempo from the loudness scan, see HugTempo.h. Tags in TrackKeyBPM take precedence.
+NSString * const TrackKeyEstimatedBPM           = @"estimatedBeatsPerMinute";
+NSString * const TrackKeyEstimatedBPMConfidence = @"estimatedBeatsPerMinuteConfidence";
+
+// Key from the fingerprint's chroma, see HugKey.h. Tags in TrackKeyInitialKey take precedence.
+NSString * const TrackKeyEstimatedKey           = @"estimatedKey";
+NSString * const TrackKeyEstimatedKeyConfidence = @"estimatedKeyConfidence";
+
 // This is the duration of the decoded PCM buffer
 NSString * const TrackKeyDecodedDuration = @"decodedDuration";
 
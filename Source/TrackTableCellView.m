@@ -6,6 +6,7 @@
 #import "Track.h"
 #import "TrackErrorButton.h"
 #import "AppDelegate.h"
+#import "SetlistController.h"
 #import "NoDropImageView.h"
 #import "Preferences.h"
 #import "TrackLabelView.h"
@@ -103,6 +104,7 @@
 
 - (void) dealloc
 {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
     [self _removeObservers];
 
     [_errorButton setTarget:nil];
@@ -145,6 +147,8 @@
 {
     [(Application *)NSApp registerEventListener:self];
 
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_handleSetlistControllerDidUpdateEndTimes:) name:SetlistControllerDidUpdateEndTimesNotificationName object:nil];
+
    
     NSTrackingAreaOptions options = NSTrackingInVisibleRect | NSTrackingMouseEnteredAndExited | NSTrackingActiveAlways;
     _trackingArea = [[NSTrackingArea alloc] initWithRect:NSZeroRect options:options owner:self userInfo:nil];
@@ -290,6 +294,7 @@
     
         if ([keyPath isEqualToString:@"trackStatus"]) {
             [self updateColors];
+            [self _updateTimeField];
             
             [NSAnimationContext runAnimationGroup:^(NSAnimationContext *ac) {
                 [ac setTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionDefault]];
@@ -297,9 +302,6 @@
                 [self _updateSpeakerIconAnimated:YES];
             } completionHandler:nil];
 
-        } else if ([keyPath isEqualToString:@"estimatedEndTime"]) {
-            [self _updateFieldStrings];
-
         } else if ([_observedKeyPaths containsObject:keyPath]) {
             [self _updateView];
         }
@@ -318,14 +320,13 @@
         @"artist",
         @"playDuration",
         @"error",
-        @"estimatedEndTime",
         @"pausesAfterPlaying",
         @"ignoresAutoGap",
         @"artist",
         @"tonality",
         @"comments",
         @"grouping",
-        @"beatsPerMinute",
+        @"displayedBeatsPerMinute",
         @"trackStatus",
         @"trackLabel",
         @"duplicate"
@@ -677,6 +678,44 @@
 }
 
 
+// End times live in SetlistController, which answers for one track in
+// O(log n), so only rows on screen ask
+//
+- (void) _updateTimeField
+{
+    Track *track = [self track];
+    if (!track) return;
+
+    NSString *timeString = @"";
+    NSString *timeStringFormat;
+    NSDate   *date;
+    
+    if ([track trackStatus] == TrackStatusPlayed) {
+        date = [track playedTimeDate];
+        timeStringFormat = NSLocalizedString(@"Played at %@", nil);
+    } else {
+        date = [[GetAppDelegate() setlistController] estimatedEndTimeDateForTrack:track];
+        timeStringFormat = NSLocalizedString(@"Ends at %@", nil);
+    }
+
+    if (date) {
+        NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+        [formatter setDateStyle:NSDateFormatterNoStyle];
+        [formatter setTimeStyle:NSDateFormatterMediumStyle];
+
+        timeString = [NSString stringWithFormat:timeStringFormat, [formatter stringFromDate:date]];
+    }
+       
+    [_timeField setStringValue:timeString];
+}
+
+
+- (void) _handleSetlistControllerDidUpdateEndTimes:(NSNotification *)note
+{
+    [self _updateTimeField];
+}
+
+
 - (void) _updateFieldStrings
 {
     Preferences *preferences = [Preferences sharedInstance];
@@ -721,7 +760,7 @@
                 string = [track artist];
 
             } else if (attribute == TrackViewAttributeBeatsPerMinute) {
-                NSInteger bpm = [track beatsPerMinute];
+                NSInteger bpm = [track displayedBeatsPerMinute];
                 if (bpm) string = [NSNumberFormatter localizedStringFromNumber:@(bpm) numberStyle:NSNumberFormatterDecimalStyle];
 
             } else if (attribute == TrackViewAttributeComments) {
@@ -820,27 +859,7 @@
     [[self lineThreeLeftField]  setStringValue:collectAttributes(a_3L)];
     [[self lineThreeRightField] setStringValue:collectAttributes(a_3R)];
 
-    NSString *timeString = @"";
-    NSString *timeStringFormat;
-    NSDate   *date;
-    
-    if ([track trackStatus] == TrackStatusPlayed) {
-        date = [track playedTimeDate];
-        timeStringFormat = NSLocalizedString(@"Played at %@", nil);
-    } else {
-        date = [track estimatedEndTimeDate];
-        timeStringFormat = NSLocalizedString(@"Ends at %@", nil);
-    }
-
-    if (date) {
-        NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
-        [formatter setDateStyle:NSDateFormatterNoStyle];
-        [formatter setTimeStyle:NSDateFormatterMediumStyle];
-
-        timeString = [NSString stringWithFormat:timeStringFormat, [formatter stringFromDate:date]];
-    }
-       
-    [_timeField setStringValue:timeString];
+    [self _updateTimeField];
     
     NSString *titleString = [track title];
     if (!titleString) titleString = @"";
@@ -11,6 +11,8 @@
 #import "TrackTableRowView.h"
 #import "MusicAppManager.h"
 #import "ExportManager.h"
+#import "HugFingerprint.h"
+#import "HugTitleIndex.h"
 
 
 NSString * const TracksControllerDidModifyTracksNotificationName = @"TracksControllerDidModifyTracks";
@@ -21,12 +23,37 @@ NSString *EmbraceQueuedTrackPasteboardType = nil;
 static NSString * const sTrackUUIDsKey = @"track-uuids";
 static NSString * const sModifiedAtKey = @"modified-at";
 
+// Minimum trigram similarity for DuplicateStatusModeSimilarTitle
+static const double sSimilarTitleThreshold = 0.6;
+
+// Minimum fingerprint similarity for the same audio. Re-encoded and
+// resampled copies score about 0.98, different recordings under 0.6.
+//
+static const double sSameAudioThreshold = 0.9;
+
 @interface TracksController () <NSMenuItemValidation>
 @property (nonatomic) NSUInteger count;
 @property (nonatomic, weak) IBOutlet TrackTableView *tableView;
 @end
 
 
+// What a track was indexed under, for -detectDuplicates
+@interface TracksControllerDuplicateEntry : NSObject
+@property (nonatomic) NSURL *externalURL;
+@property (nonatomic) NSString *title;
+@property (nonatomic) NSString *similarTitle;
+@property (nonatomic) size_t similarTitleSlot;
+@property (nonatomic) NSUInteger similarTitleCount;
+@property (nonatomic) NSData *audioFingerprint;
+@property (nonatomic) size_t audioFingerprintSlot;
+@property (nonatomic) NSUInteger sameAudioCount;
+@end
+
+
+@implementation TracksControllerDuplicateEntry
+@end
+
+
 @implementation TracksController {
     BOOL _didInit;
     NSMutableArray *_tracks;
@@ -38,6 +65,15 @@ static NSString * const sModifiedAtKey = @"modified-at";
     NSArray   *_dragCacheMetadataArray;
     NSArray   *_dragCacheFileURLs;
     NSInteger  _dragCacheChangeCount;
+
+    NSMapTable          *_duplicateEntries;
+    NSMutableDictionary *_urlToTracksMap;
+    NSMutableDictionary *_titleToTracksMap;
+    NSMutableDictionary *_similarTitleSlotToTrackMap;
+    HugTitleIndex       *_similarTitleIndex;
+    NSMutableDictionary *_audioFingerprintSlotToTrackMap;
+    HugFingerprintIndex *_audioFingerprintIndex;
+    DuplicateStatusMode  _duplicateStatusMode;
 }
 
 + (void) initialize
@@ -55,6 +91,13 @@ static NSString * const sModifiedAtKey = @"modified-at";
 }
 
 
+- (void) dealloc
+{
+    HugTitleIndexFree(_similarTitleIndex);
+    HugFingerprintIndexFree(_audioFingerprintIndex);
+}
+
+
 - (void) awakeFromNib
 {
     if (_didInit) return;
@@ -254,14 +297,17 @@ static void sCollectM3UPlaylistURL(NSURL *inURL, NSMutableArray *results, NSInte
 
 - (void) _saveState
 {
-    NSMutableArray *trackUUIDsArray = [NSMutableArray array];
+    NSMutableArray *trackUUIDs = [NSMutableArray array];
 
     for (Track *track in [self tracks]) {
         NSUUID *uuid = [track UUID];
-        if (uuid) [trackUUIDsArray addObject:[uuid UUIDString]];
+        if (uuid) [trackUUIDs addObject:uuid];
     }
 
-    [[NSUserDefaults standardUserDefaults] setObject:trackUUIDsArray forKey:sTrackUUIDsKey];
+    // The defaults key is only read when migrating from before Tracks.store
+    if ([Track persistTrackUUIDs:trackUUIDs]) {
+        [[NSUserDefaults standardUserDefaults] removeObjectForKey:sTrackUUIDsKey];
+    }
 }
 
 
@@ -270,21 +316,32 @@ static void sCollectM3UPlaylistURL(NSURL *inURL, NSMutableArray *results, NSInte
     NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
     NSMutableArray *tracks = [NSMutableArray array];
 
-    NSArray *trackUUIDs  = [defaults objectForKey:sTrackUUIDsKey];
+    NSArray *trackUUIDs = [Track persistedTrackUUIDs];
 
-    if ([trackUUIDs isKindOfClass:[NSArray class]]) {
-        for (NSString *uuidString in trackUUIDs) {
-            NSUUID *uuid = [[NSUUID alloc] initWithUUIDString:uuidString];
-            Track *track = [Track trackWithUUID:uuid];
+    if (!trackUUIDs) {
+        NSMutableArray *legacyUUIDs = [NSMutableArray array];
+        NSArray *legacyStrings = [defaults objectForKey:sTrackUUIDsKey];
 
-            if (track) [tracks addObject:track];
-            
-            TrackStatus trackStatus = [track trackStatus];
-            
-            if ((trackStatus == TrackStatusPreparing) || (trackStatus == TrackStatusPlaying)) {
-                [track setTrackStatus:TrackStatusPlayed];
+        if ([legacyStrings isKindOfClass:[NSArray class]]) {
+            for (NSString *uuidString in legacyStrings) {
+                NSUUID *uuid = [uuidString isKindOfClass:[NSString class]] ? [[NSUUID alloc] initWithUUIDString:uuidString] : nil;
+                if (uuid) [legacyUUIDs addObject:uuid];
             }
         }
+
+        trackUUIDs = legacyUUIDs;
+    }
+
+    for (NSUUID *uuid in trackUUIDs) {
+        Track *track = [Track trackWithUUID:uuid];
+
+        if (track) [tracks addObject:track];
+        
+        TrackStatus trackStatus = [track trackStatus];
+        
+        if ((trackStatus == TrackStatusPreparing) || (trackStatus == TrackStatusPlaying)) {
+            [track setTrackStatus:TrackStatusPlayed];
+        }
     }
     
     _tracks = tracks;
@@ -1182,42 +1239,232 @@ static void sCollectM3UPlaylistURL(NSURL *inURL, NSMutableArray *results, NSInte
 }
 
 
+- (void) _addTrack:(Track *)track toDuplicateMap:(NSMutableDictionary *)map key:(id)key affectedTracks:(NSMutableSet *)affectedTracks
+{
+    if (!key) return;
+
+    NSMutableArray *tracks = [map objectForKey:key];
+
+    if (!tracks) {
+        tracks = [NSMutableArray array];
+        [map setObject:tracks forKey:key];
+    }
+
+    [tracks addObject:track];
+    [affectedTracks addObjectsFromArray:tracks];
+}
+
+
+- (void) _removeTrack:(Track *)track fromDuplicateMap:(NSMutableDictionary *)map key:(id)key affectedTracks:(NSMutableSet *)affectedTracks
+{
+    if (!key) return;
+
+    NSMutableArray *tracks = [map objectForKey:key];
+
+    [tracks removeObjectIdenticalTo:track];
+    [affectedTracks addObjectsFromArray:tracks];
+
+    if (![tracks count]) {
+        [map removeObjectForKey:key];
+    }
+}
+
+
+- (void) _adjustSimilarTitleCountsForTrack:(Track *)track by:(NSInteger)delta affectedTracks:(NSMutableSet *)affectedTracks
+{
+    TracksControllerDuplicateEntry *entry = [_duplicateEntries objectForKey:track];
+    if ([entry similarTitleSlot] == HugTitleIndexNotFound) return;
+
+    size_t count = 0;
+    size_t *slots = HugTitleIndexCopySimilar(_similarTitleIndex, [entry similarTitleSlot], &count);
+
+    for (size_t i = 0; i < count; i++) {
+        Track *otherTrack = [_similarTitleSlotToTrackMap objectForKey:@(slots[i])];
+        TracksControllerDuplicateEntry *otherEntry = [_duplicateEntries objectForKey:otherTrack];
+
+        [otherEntry setSimilarTitleCount:[otherEntry similarTitleCount] + delta];
+        if (otherTrack) [affectedTracks addObject:otherTrack];
+    }
+
+    [entry setSimilarTitleCount:(delta > 0) ? count : 0];
+
+    free(slots);
+}
+
+
+- (void) _adjustSameAudioCountsForTrack:(Track *)track by:(NSInteger)delta affectedTracks:(NSMutableSet *)affectedTracks
+{
+    TracksControllerDuplicateEntry *entry = [_duplicateEntries objectForKey:track];
+    if ([entry audioFingerprintSlot] == HugFingerprintIndexNotFound) return;
+
+    size_t count = 0;
+    size_t *slots = HugFingerprintIndexCopySimilar(_audioFingerprintIndex, [entry audioFingerprintSlot], &count);
+
+    for (size_t i = 0; i < count; i++) {
+        Track *otherTrack = [_audioFingerprintSlotToTrackMap objectForKey:@(slots[i])];
+        TracksControllerDuplicateEntry *otherEntry = [_duplicateEntries objectForKey:otherTrack];
+
+        [otherEntry setSameAudioCount:[otherEntry sameAudioCount] + delta];
+        if (otherTrack) [affectedTracks addObject:otherTrack];
+    }
+
+    [entry setSameAudioCount:(delta > 0) ? count : 0];
+
+    free(slots);
+}
+
+
+- (void) _indexTrackForDuplicates:(Track *)track affectedTracks:(NSMutableSet *)affectedTracks
+{
+    TracksControllerDuplicateEntry *entry = [[TracksControllerDuplicateEntry alloc] init];
+
+    [entry setExternalURL:[track externalURL]];
+    [entry setTitle:[track title]];
+    [entry setSimilarTitle:[track titleForSimilarTitleDetection]];
+    [entry setSimilarTitleSlot:HugTitleIndexNotFound];
+    [entry setAudioFingerprint:[track audioFingerprint]];
+    [entry setAudioFingerprintSlot:HugFingerprintIndexNotFound];
+
+    [_duplicateEntries setObject:entry forKey:track];
+    [affectedTracks addObject:track];
+
+    [self _addTrack:track toDuplicateMap:_urlToTracksMap   key:[entry externalURL] affectedTracks:affectedTracks];
+    [self _addTrack:track toDuplicateMap:_titleToTracksMap key:[entry title]       affectedTracks:affectedTracks];
+
+    const char *similarTitle = [[entry similarTitle] UTF8String];
+
+    if (similarTitle && *similarTitle) {
+        size_t slot = HugTitleIndexInsert(_similarTitleIndex, similarTitle);
+
+        if (slot != HugTitleIndexNotFound) {
+            [entry setSimilarTitleSlot:slot];
+            [_similarTitleSlotToTrackMap setObject:track forKey:@(slot)];
+
+            [self _adjustSimilarTitleCountsForTrack:track by:1 affectedTracks:affectedTracks];
+        }
+    }
+
+    NSData *audioFingerprint = [entry audioFingerprint];
+
+    if (audioFingerprint) {
+        size_t slot = HugFingerprintIndexInsert(_audioFingerprintIndex, [audioFingerprint bytes], [audioFingerprint length]);
+
+        if (slot != HugFingerprintIndexNotFound) {
+            [entry setAudioFingerprintSlot:slot];
+            [_audioFingerprintSlotToTrackMap setObject:track forKey:@(slot)];
+
+            [self _adjustSameAudioCountsForTrack:track by:1 affectedTracks:affectedTracks];
+        }
+    }
+}
+
+
+- (void) _unindexTrackForDuplicates:(Track *)track affectedTracks:(NSMutableSet *)affectedTracks
+{
+    TracksControllerDuplicateEntry *entry = [_duplicateEntries objectForKey:track];
+    if (!entry) return;
+
+    [self _removeTrack:track fromDuplicateMap:_urlToTracksMap   key:[entry externalURL] affectedTracks:affectedTracks];
+    [self _removeTrack:track fromDuplicateMap:_titleToTracksMap key:[entry title]       affectedTracks:affectedTracks];
+
+    size_t slot = [entry similarTitleSlot];
+
+    if (slot != HugTitleIndexNotFound) {
+        [self _adjustSimilarTitleCountsForTrack:track by:-1 affectedTracks:affectedTracks];
+
+        HugTitleIndexRemove(_similarTitleIndex, slot);
+        [_similarTitleSlotToTrackMap removeObjectForKey:@(slot)];
+    }
+
+    size_t audioFingerprintSlot = [entry audioFingerprintSlot];
+
+    if (audioFingerprintSlot != HugFingerprintIndexNotFound) {
+        [self _adjustSameAudioCountsForTrack:track by:-1 affectedTracks:affectedTracks];
+
+        HugFingerprintIndexRemove(_audioFingerprintIndex, audioFingerprintSlot);
+        [_audioFingerprintSlotToTrackMap removeObjectForKey:@(audioFingerprintSlot)];
+    }
+
+    [_duplicateEntries removeObjectForKey:track];
+}
+
+
+// Tracks are indexed by URL, title, similar title, and audio fingerprint as
+// they are added, and unindexed as they leave or change. Only the tracks
+// sharing a key with those have their duplicate status recalculated.
+//
+// The same audio under another URL is a duplicate in every mode, like the
+// same URL is.
+//
 - (void) detectDuplicates
 {
-    NSUInteger tracksCount = [_tracks count];
+    if (!_duplicateEntries) {
+        _duplicateEntries           = [NSMapTable strongToStrongObjectsMapTable];
+        _urlToTracksMap             = [NSMutableDictionary dictionary];
+        _titleToTracksMap           = [NSMutableDictionary dictionary];
+        _similarTitleSlotToTrackMap = [NSMutableDictionary dictionary];
+        _similarTitleIndex          = HugTitleIndexCreate(sSimilarTitleThreshold);
+
+        _audioFingerprintSlotToTrackMap = [NSMutableDictionary dictionary];
+        _audioFingerprintIndex          = HugFingerprintIndexCreate(sSameAudioThreshold);
+    }
 
-    NSMutableDictionary *urlToTrackMap   = [NSMutableDictionary dictionaryWithCapacity:tracksCount];
-    NSMutableDictionary *titleToTrackMap = [NSMutableDictionary dictionaryWithCapacity:tracksCount];
+    if (!_similarTitleIndex || !_audioFingerprintIndex) return;
 
-    DuplicateStatusMode duplicateStatusMode = [[Preferences sharedInstance] duplicateStatusMode];
+    NSMutableSet *affectedTracks = [NSMutableSet set];
 
-    BOOL (^check)(NSMutableDictionary *, id, Track *) = ^(NSMutableDictionary *map, id key, Track *track) {
-        if (key) {
-            Track *existingTrack = [map objectForKey:key];
+    for (Track *track in _tracks) {
+        TracksControllerDuplicateEntry *entry = [_duplicateEntries objectForKey:track];
+
+        // Pointer comparisons: a new object with equal contents is merely reindexed
+        if (entry && (
+            [entry externalURL]      != [track externalURL] ||
+            [entry title]            != [track title] ||
+            [entry similarTitle]     != [track titleForSimilarTitleDetection] ||
+            [entry audioFingerprint] != [track audioFingerprint]
+        )) {
+            [self _unindexTrackForDuplicates:track affectedTracks:affectedTracks];
+            entry = nil;
+        }
 
-            [map setObject:track forKey:key];
+        if (!entry) {
+            [self _indexTrackForDuplicates:track affectedTracks:affectedTracks];
+        }
+    }
 
-            if (existingTrack) {
-                [existingTrack setDuplicate:YES];
-                return YES;
+    // Every current track is indexed now, so any extra entries are for removed tracks
+    if ([_duplicateEntries count] > [_tracks count]) {
+        NSHashTable *currentTracks = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+        for (Track *track in _tracks) [currentTracks addObject:track];
+
+        for (Track *track in [[_duplicateEntries keyEnumerator] allObjects]) {
+            if (![currentTracks containsObject:track]) {
+                [self _unindexTrackForDuplicates:track affectedTracks:affectedTracks];
             }
         }
-        
-        return NO;
-    };
+    }
 
-    for (Track *track in _tracks) {
-        BOOL isDuplicate = NO;
+    DuplicateStatusMode duplicateStatusMode = [[Preferences sharedInstance] duplicateStatusMode];
+
+    if (duplicateStatusMode != _duplicateStatusMode) {
+        _duplicateStatusMode = duplicateStatusMode;
+        [affectedTracks addObjectsFromArray:_tracks];
+    }
+
+    for (Track *track in affectedTracks) {
+        TracksControllerDuplicateEntry *entry = [_duplicateEntries objectForKey:track];
+        if (!entry) continue;
+
+        BOOL isDuplicate = [[_urlToTracksMap objectForKey:[entry externalURL]] count] > 1 ||
+                           [entry sameAudioCount] > 0;
 
         if (duplicateStatusMode == DuplicateStatusModeSameTitle) {
-            isDuplicate = isDuplicate || check(titleToTrackMap, [track title], track);
+            isDuplicate = isDuplicate || [[_titleToTracksMap objectForKey:[entry title]] count] > 1;
 
         } else if (duplicateStatusMode == DuplicateStatusModeSimilarTitle) {
-            isDuplicate = isDuplicate || check(titleToTrackMap, [track titleForSimilarTitleDetection], track);
+            isDuplicate = isDuplicate || [entry similarTitleCount] > 0;
         }
 
-        isDuplicate = isDuplicate || check(urlToTrackMap, [track externalURL], track);
-    
         [track setDuplicate:isDuplicate];
     }
 }
@@ -3,6 +3,7 @@
 
 #import "WaveformView.h"
 #import "Track.h"
+#import "HugOverviewPyramid.h"
 
 #import <Accelerate/Accelerate.h>
 
@@ -13,6 +14,11 @@
 @implementation WaveformView {
     CALayer   *_inactiveLayer;
     CALayer   *_activeLayer;
+
+    // Reused by every redraw, grown to the widest one so far
+    UInt8     *_reducedBytes;
+    float     *_reducedSamples;
+    NSInteger  _reducedCapacity;
 }
 
 
@@ -47,7 +53,10 @@
 
 - (void) dealloc
 {
-    [_track removeObserver:self forKeyPath:@"overviewData"];
+    [_track removeObserver:self forKeyPath:@"overviewPeaks"];
+
+    free(_reducedBytes);
+    free(_reducedSamples);
 }
 
 
@@ -73,7 +82,7 @@
 - (void) observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
 {
     if (object == _track) {
-        if ([keyPath isEqualToString:@"overviewData"]) {
+        if ([keyPath isEqualToString:@"overviewPeaks"]) {
             [_activeLayer   setNeedsDisplay];
             [_inactiveLayer setNeedsDisplay];
         }
@@ -114,27 +123,28 @@
 }
 
 
-- (NSData *) _croppedDataForTrack:(Track *)track
+- (NSInteger) _reduceOverviewForTrack:(Track *)track toCount:(NSInteger)outCount
 {
-    NSData *overviewData = [track overviewData];
-    if (!overviewData) return nil;
+    NSData *overviewPeaks   = [track overviewPeaks];
+    NSData *overviewPyramid = [track overviewPyramid];
+
+    if (!overviewPeaks || !overviewPyramid || outCount <= 0) return 0;
 
-    NSInteger inCount = [overviewData length] / sizeof(UInt8);
-    UInt8    *inBytes = (UInt8 *)[overviewData bytes];
+    NSInteger inCount = [overviewPeaks length] / sizeof(UInt8);
     
     NSTimeInterval startTime = [track startTime];
     NSTimeInterval stopTime  = [track stopTime];
    
-    NSInteger startOffset = 0;
-    NSInteger stopOffset  = inCount;
+    double startOffset = 0;
+    double stopOffset  = inCount;
    
     if (startTime || stopTime) {
         NSTimeInterval duration = [track decodedDuration];
         if (!duration) duration = [track duration];
-        if (!duration) return nil;
+        if (!duration) return 0;
     
-        if (startTime) startOffset = round((startTime / duration) * inCount);
-        if (stopTime)  stopOffset  = round((stopTime  / duration) * inCount);
+        if (startTime) startOffset = (startTime / duration) * inCount;
+        if (stopTime)  stopOffset  = (stopTime  / duration) * inCount;
     }
     
     if (startOffset < 0)       startOffset = 0;
@@ -143,65 +153,42 @@
     if (stopOffset < 0)       stopOffset = 0;
     if (stopOffset > inCount) stopOffset = inCount; 
     
-    NSInteger length = (stopOffset - startOffset);
-    if (length < 0) return nil;
-     
-    return [NSData dataWithBytes:(inBytes + startOffset) length:length];
-}
-
-
-- (NSData *) _reduceOverviewDataForTrack:(Track *)track toCount:(NSUInteger)outCount
-{
-    NSData *data = [self _croppedDataForTrack:track];
-    if (!data) return nil;
-
-    NSInteger inCount = [data length] / sizeof(UInt8);
-    UInt8 *inBytes = (UInt8 *)[data bytes];
-
-    if (inCount < outCount) return data;
-
-    UInt8 *outBytes = malloc(outCount * sizeof(UInt8));
-    
-    double stride = inCount / (double)outCount;
+    if (stopOffset <= startOffset) return 0;
 
-    dispatch_apply(outCount, dispatch_get_global_queue(0, 0), ^(size_t o) {
-        NSInteger i = llrintf(o * stride);
+    if (outCount > _reducedCapacity) {
+        free(_reducedBytes);
+        free(_reducedSamples);
 
-        NSInteger length = (NSInteger)stride;
-        
-        // Be paranoid, I saw a crash in vDSP_maxv() during development
-        if (i + length > inCount) {
-            length = (inCount - i);
-        }
+        _reducedBytes    = malloc(outCount * sizeof(UInt8));
+        _reducedSamples  = malloc(outCount * sizeof(float));
+        _reducedCapacity = outCount;
+    }
 
-        UInt8 max = 0;
-        for (NSInteger j = 0; j < length; j++) {
-            UInt8 m = inBytes[i + j];
-            if (m > max) max = m;
-        }
-        
-        outBytes[o] = max;
-    });
+    BOOL didReduce = HugOverviewPyramidReduce(
+        [overviewPyramid bytes],
+        [overviewPeaks bytes], inCount,
+        startOffset, stopOffset,
+        outCount, NULL, _reducedBytes
+    );
 
-    return [NSData dataWithBytesNoCopy:outBytes length:outCount * sizeof(UInt8) freeWhenDone:YES];
+    return didReduce ? outCount : 0;
 }
 
 
 - (void) drawLayer:(CALayer *)layer inContext:(CGContextRef)context
 {
-    if (![_track overviewData]) return;
+    if (![_track overviewPeaks]) return;
 
     CGSize size = [self bounds].size;
     CGFloat scale = [[self window] backingScaleFactor];
 
-    NSData *data = [self _reduceOverviewDataForTrack:_track toCount:size.width * scale];
-    vDSP_Length length = [data length];
+    NSInteger sampleCount = [self _reduceOverviewForTrack:_track toCount:size.width * scale];
+    vDSP_Length length = sampleCount;
 
     if (length == 0) return;
 
     CGContextSetInterpolationQuality(context, kCGInterpolationLow);
 
-    NSInteger sampleCount = [data length];
     NSInteger start = 0;
     NSInteger end = sampleCount;
 
@@ -223,8 +210,8 @@
 
     CGContextConcatCTM(context, transform);
 
-    UInt8 *byteSamples  = (UInt8 *)[data bytes];
-    float *floatSamples = malloc(length * sizeof(float));
+    UInt8 *byteSamples  = _reducedBytes;
+    float *floatSamples = _reducedSamples;
     
     vDSP_vfltu8(byteSamples, 1, floatSamples, 1, length);
 
@@ -251,8 +238,6 @@
         CGContextAddLineToPoint(context, i, -floatSamples[i]);
     }
     
-    free(floatSamples);
-    
     CGContextClosePath(context);
 
     PerformWithAppearance([self effectiveAppearance], ^{
@@ -266,9 +251,9 @@
 - (void) setTrack:(Track *)track
 {
     if (_track != track) {
-        [_track removeObserver:self forKeyPath:@"overviewData"];
+        [_track removeObserver:self forKeyPath:@"overviewPeaks"];
         _track = track;
-        [_track addObserver:self forKeyPath:@"overviewData" options:0 context:NULL];
+        [_track addObserver:self forKeyPath:@"overviewPeaks" options:0 context:NULL];
 
         [self setPercentage:FLT_EPSILON];
 
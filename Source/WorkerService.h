@@ -10,6 +10,21 @@ typedef NS_ENUM(NSInteger, WorkerTrackCommand) {
 };
 
 
+extern NSString * const WorkerStatisticThreadCount;      // Worker threads, one per core
+extern NSString * const WorkerStatisticQueuedImmediate;  // Jobs waiting, by priority
+extern NSString * const WorkerStatisticQueuedBackground;
+extern NSString * const WorkerStatisticRunning;
+extern NSString * const WorkerStatisticCompleted;
+extern NSString * const WorkerStatisticCancelled;
+extern NSString * const WorkerStatisticPreemptions;      // Immediate jobs run inside a background job
+extern NSString * const WorkerStatisticDecodedFrames;    // Frames decoded for loudness
+extern NSString * const WorkerStatisticBusyTime;         // Seconds spent in jobs, summed over threads
+extern NSString * const WorkerStatisticCacheHits;        // Loudness requests answered by the analysis cache
+extern NSString * const WorkerStatisticCacheMisses;
+extern NSString * const WorkerStatisticDecodeTime;       // Seconds spent decoding for loudness, summed over threads
+extern NSString * const WorkerStatisticAnalyzerTimes;    // Seconds spent in each analyzer, by name
+
+
 @protocol WorkerProtocol
 
 - (void) cancelUUID:(NSUUID *)uuid;
@@ -22,4 +37,10 @@ typedef NS_ENUM(NSInteger, WorkerTrackCommand) {
 
 - (void) performLibraryParseWithReply: (void (^)(NSDictionary *))reply;
 
+// Counters of the analysis pool, with WorkerStatistic keys. Throughput is the
+// change in WorkerStatisticDecodedFrames between two calls over the time
+// between them.
+//
+- (void) fetchStatisticsWithReply: (void (^)(NSDictionary *))reply;
+
 @end
@@ -3,22 +3,73 @@
 
 #import "WorkerService.h"
 
+#import "HugAnalysisCache.h"
+#import "HugAnalysisPipeline.h"
 #import "HugAudioFile.h"
+#import "HugFingerprint.h"
+#import "HugKey.h"
+#import "HugTempo.h"
 #import "HugUtils.h"
+#import "HugWorkPool.h"
 #import "TrackKeys.h"
 #import "LoudnessMeasurer.h"
 #import "MetadataParser.h"
 
 #import <iTunesLibrary/iTunesLibrary.h>
 
-static dispatch_queue_t sMetadataQueue           = nil;
-static dispatch_queue_t sLibraryQueue            = nil;
-static dispatch_queue_t sLoudnessImmediateQueue  = nil;
-static dispatch_queue_t sLoudnessBackgroundQueue = nil;
+// Metadata reads and immediate loudness scans run at HugWorkPriorityImmediate,
+// other loudness scans at HugWorkPriorityBackground, on one thread per core.
+//
+static HugWorkPool     *sWorkPool     = NULL;
+static dispatch_queue_t sLibraryQueue = nil;
 
+// Loudness results by file fingerprint, shared by every track and session.
+// Bump sAnalysisCacheName whenever sReadLoudness() changes what it returns.
+//
+static HugAnalysisCache *sAnalysisCache = NULL;
+static NSString * const  sAnalysisCacheName     = @"Analysis-6";
+static const uint64_t    sAnalysisCacheMaxBytes = 256 * 1024 * 1024;
+
+// Guarded by @synchronized on themselves, jobs run concurrently
 static NSMutableSet *sCancelledUUIDs = nil;
 static NSMutableSet *sLoudnessUUIDs  = nil;
 
+// Seconds spent in each analyzer and in decoding, summed over every scan.
+// Guarded by @synchronized (sAnalyzerTimes).
+//
+static NSMutableDictionary *sAnalyzerTimes = nil;
+static NSTimeInterval       sDecodeTime    = 0;
+
+NSString * const WorkerStatisticThreadCount      = @"threadCount";
+NSString * const WorkerStatisticQueuedImmediate  = @"queuedImmediate";
+NSString * const WorkerStatisticQueuedBackground = @"queuedBackground";
+NSString * const WorkerStatisticRunning          = @"running";
+NSString * const WorkerStatisticCompleted        = @"completed";
+NSString * const WorkerStatisticCancelled        = @"cancelled";
+NSString * const WorkerStatisticPreemptions      = @"preemptions";
+NSString * const WorkerStatisticDecodedFrames    = @"decodedFrames";
+NSString * const WorkerStatisticBusyTime         = @"busyTime";
+NSString * const WorkerStatisticCacheHits        = @"cacheHits";
+NSString * const WorkerStatisticCacheMisses      = @"cacheMisses";
+NSString * const WorkerStatisticDecodeTime       = @"decodeTime";
+NSString * const WorkerStatisticAnalyzerTimes    = @"analyzerTimes";
+
+// Immediate scans of long tracks decode this much at a time and let
+// LoudnessMeasurer split each buffer across cores
+//
+static const NSTimeInterval sParallelScanMinimumDuration = 120;
+static const NSTimeInterval sParallelScanBufferDuration  = 30;
+
+// Bins per second of the version 2 overview, about 50 KB per ten minutes of stereo
+static const size_t sOverviewBinRate = 50;
+
+// Immediate scans run their analyzers on a team this size while the next
+// buffer decodes, background scans run them on the job's own thread
+//
+static const size_t sAnalysisThreadCount = 3;
+
+typedef void (^WorkerJobBlock)(HugWorkJob *job);
+
 
 @interface Worker : NSObject <WorkerProtocol>
 
@@ -34,17 +85,50 @@ static NSMutableSet *sLoudnessUUIDs  = nil;
     static dispatch_once_t onceToken;
 
     dispatch_once(&onceToken, ^{
-        sMetadataQueue           = dispatch_queue_create("metadata",            DISPATCH_QUEUE_SERIAL);
-        sLibraryQueue            = dispatch_queue_create("library",             DISPATCH_QUEUE_SERIAL);
-        sLoudnessImmediateQueue  = dispatch_queue_create("loudness-immediate",  DISPATCH_QUEUE_SERIAL);
-        sLoudnessBackgroundQueue = dispatch_queue_create("loudness-background", DISPATCH_QUEUE_SERIAL);
+        sWorkPool     = HugWorkPoolCreate(0);
+        sLibraryQueue = dispatch_queue_create("library", DISPATCH_QUEUE_SERIAL);
 
         sCancelledUUIDs = [NSMutableSet set];
         sLoudnessUUIDs  = [NSMutableSet set];
+        sAnalyzerTimes  = [NSMutableDictionary dictionary];
+
+        NSURL    *cachesURL  = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] firstObject];
+        NSString *identifier = [[NSBundle mainBundle] bundleIdentifier];
+        NSString *cachePath  = [[[cachesURL path] stringByAppendingPathComponent:(identifier ? identifier : @"Worker")] stringByAppendingPathComponent:sAnalysisCacheName];
+
+        if (cachesURL) {
+            sAnalysisCache = HugAnalysisCacheCreate([cachePath fileSystemRepresentation], sAnalysisCacheMaxBytes);
+        }
     });
 }
 
 
+static void sPerformJobBlock(HugWorkJob *job, void *context)
+{
+    @autoreleasepool {
+        WorkerJobBlock block = CFBridgingRelease(context);
+        block(job);
+    }
+}
+
+
+static void sSubmitJob(HugWorkPriority priority, NSUUID *UUID, WorkerJobBlock block)
+{
+    HugWorkKey key;
+    [UUID getUUIDBytes:key.bytes];
+
+    HugWorkPoolSubmit(sWorkPool, priority, key, sPerformJobBlock, (void *)CFBridgingRetain([block copy]));
+}
+
+
+static BOOL sIsCancelled(NSUUID *UUID)
+{
+    @synchronized (sCancelledUUIDs) {
+        return [sCancelledUUIDs containsObject:UUID];
+    }
+}
+
+
 static NSDictionary *sReadMetadata(NSURL *internalURL, NSString *originalFilename)
 {
     NSString *fallbackTitle = [originalFilename stringByDeletingPathExtension];
@@ -55,7 +139,233 @@ static NSDictionary *sReadMetadata(NSURL *internalURL, NSString *originalFilenam
 }
 
 
-static NSDictionary *sReadLoudness(NSURL *internalURL)
+static NSDictionary *sCopyCachedLoudness(HugAnalysisCacheKey key)
+{
+    size_t length = 0;
+    void  *bytes  = HugAnalysisCacheCopyEntry(sAnalysisCache, key, &length);
+
+    if (!bytes) return nil;
+
+    NSData *data = [[NSData alloc] initWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+    id result = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:NULL];
+
+    return [result isKindOfClass:[NSDictionary class]] ? result : nil;
+}
+
+
+static void sStoreCachedLoudness(HugAnalysisCacheKey key, NSDictionary *dictionary)
+{
+    // Errors may go away, e.g. once a volume is mounted
+    if (![dictionary objectForKey:TrackKeyOverviewData]) return;
+
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:dictionary format:NSPropertyListBinaryFormat_v1_0 options:0 error:NULL];
+    if (data) HugAnalysisCacheStoreEntry(sAnalysisCache, key, [data bytes], [data length]);
+}
+
+
+#pragma mark - Analyzers
+
+// Each analyzer sees the blocks that sReadLoudness() decodes, and writes into
+// the result dictionary from its finish function. A new analysis is another
+// analyzer here, the decode is shared.
+//
+
+typedef struct {
+    LoudnessMeasurer *measurer;
+    double sampleRate;
+    size_t parallelScanFrames;
+} WorkerLoudnessAnalyzer;
+
+typedef struct {
+    HugChroma *chroma;
+} WorkerChromaAnalyzer;
+
+typedef struct {
+    HugTempo *tempo;
+} WorkerTempoAnalyzer;
+
+
+static bool sLoudnessBegin(void *context, unsigned int channels, double sampleRate, uint64_t totalFrames)
+{
+    WorkerLoudnessAnalyzer *analyzer = context;
+
+    analyzer->measurer = LoudnessMeasurerCreate(channels, sampleRate, totalFrames);
+    if (!analyzer->measurer) return false;
+
+    analyzer->sampleRate = sampleRate;
+
+    LoudnessMeasurerSetDetailedOverviewRate(analyzer->measurer, sOverviewBinRate);
+
+    if (analyzer->parallelScanFrames) {
+        LoudnessMeasurerSetParallelScan(analyzer->measurer, analyzer->parallelScanFrames, 0);
+    }
+
+    return true;
+}
+
+
+static void sLoudnessConsume(void *context, const float * const *channels, size_t frames)
+{
+    WorkerLoudnessAnalyzer *analyzer = context;
+    LoudnessMeasurerScanAudioBuffer(analyzer->measurer, channels, frames);
+}
+
+
+// Overview, audible range, onset, loudness and peaks, all from one pass
+static void sLoudnessFinish(void *context, void *resultPointer)
+{
+    WorkerLoudnessAnalyzer *analyzer = context;
+    LoudnessMeasurer *measurer = analyzer->measurer;
+    NSMutableDictionary *result = (__bridge NSMutableDictionary *)resultPointer;
+
+    if (result) {
+        size_t  overviewLength = 0;
+        void   *overviewBytes  = LoudnessMeasurerCopyDetailedOverview(measurer, &overviewLength);
+        NSData *overviewData   = nil;
+
+        if (overviewBytes) {
+            overviewData = [[NSData alloc] initWithBytesNoCopy:overviewBytes length:overviewLength freeWhenDone:YES];
+
+            [result setObject:overviewData        forKey:TrackKeyOverviewData];
+            [result setObject:@(sOverviewBinRate) forKey:TrackKeyOverviewRate];
+            [result setObject:@(2)                forKey:TrackKeyOverviewVersion];
+
+        } else {
+            overviewBytes = LoudnessMeasurerCopyOverview(measurer, &overviewLength);
+            overviewData  = [[NSData alloc] initWithBytesNoCopy:overviewBytes length:overviewLength freeWhenDone:YES];
+
+            [result setObject:overviewData forKey:TrackKeyOverviewData];
+            [result setObject:@(100)       forKey:TrackKeyOverviewRate];
+            [result setObject:@(1)         forKey:TrackKeyOverviewVersion];
+        }
+
+        size_t audibleStart, audibleEnd, onsetFrame;
+
+        if (LoudnessMeasurerGetAudibleRange(measurer, &audibleStart, &audibleEnd)) {
+            [result setObject:@(audibleStart / analyzer->sampleRate) forKey:TrackKeyAudibleStartTime];
+            [result setObject:@(audibleEnd   / analyzer->sampleRate) forKey:TrackKeyAudibleEndTime];
+        }
+
+        if (LoudnessMeasurerGetOnsetFrame(measurer, &onsetFrame)) {
+            [result setObject:@(onsetFrame / analyzer->sampleRate) forKey:TrackKeyOnsetTime];
+        }
+
+        [result setObject:@(LoudnessMeasurerGetLoudness(measurer)) forKey:TrackKeyTrackLoudness];
+        [result setObject:@(LoudnessMeasurerGetPeak(measurer))     forKey:TrackKeyTrackPeak];
+        [result setObject:@(LoudnessMeasurerGetTruePeak(measurer)) forKey:TrackKeyTrackTruePeak];
+    }
+
+    LoudnessMeasurerFree(measurer);
+    analyzer->measurer = NULL;
+}
+
+
+static bool sChromaBegin(void *context, unsigned int channels, double sampleRate, uint64_t totalFrames)
+{
+    WorkerChromaAnalyzer *analyzer = context;
+
+    analyzer->chroma = HugChromaCreate(channels, sampleRate);
+
+    return analyzer->chroma != NULL;
+}
+
+
+static void sChromaConsume(void *context, const float * const *channels, size_t frames)
+{
+    WorkerChromaAnalyzer *analyzer = context;
+    HugChromaProcess(analyzer->chroma, channels, frames);
+}
+
+
+// Fingerprint and key over the audible range, which the loudness analyzer
+// finished before this one
+//
+static void sChromaFinish(void *context, void *resultPointer)
+{
+    WorkerChromaAnalyzer *analyzer = context;
+    HugChroma *chroma = analyzer->chroma;
+    NSMutableDictionary *result = (__bridge NSMutableDictionary *)resultPointer;
+
+    NSNumber *audibleStart = [result objectForKey:TrackKeyAudibleStartTime];
+    NSNumber *audibleEnd   = [result objectForKey:TrackKeyAudibleEndTime];
+
+    if (audibleStart && audibleEnd) {
+        size_t fingerprintLength = 0;
+        void  *fingerprintBytes  = HugFingerprintCreateData(chroma, [audibleStart doubleValue], [audibleEnd doubleValue], &fingerprintLength);
+
+        if (fingerprintBytes) {
+            NSData *fingerprintData = [[NSData alloc] initWithBytesNoCopy:fingerprintBytes length:fingerprintLength freeWhenDone:YES];
+            [result setObject:fingerprintData forKey:TrackKeyAudioFingerprint];
+        }
+
+        unsigned int estimatedKey;
+        double estimatedKeyConfidence;
+
+        if (HugKeyEstimate(chroma, [audibleStart doubleValue], [audibleEnd doubleValue], &estimatedKey, &estimatedKeyConfidence)) {
+            [result setObject:@(HugKeyGetName(estimatedKey)) forKey:TrackKeyEstimatedKey];
+            [result setObject:@(estimatedKeyConfidence)      forKey:TrackKeyEstimatedKeyConfidence];
+        }
+    }
+
+    HugChromaFree(chroma);
+    analyzer->chroma = NULL;
+}
+
+
+static bool sTempoBegin(void *context, unsigned int channels, double sampleRate, uint64_t totalFrames)
+{
+    WorkerTempoAnalyzer *analyzer = context;
+
+    analyzer->tempo = HugTempoCreate(channels, sampleRate);
+
+    return analyzer->tempo != NULL;
+}
+
+
+static void sTempoConsume(void *context, const float * const *channels, size_t frames)
+{
+    WorkerTempoAnalyzer *analyzer = context;
+    HugTempoProcess(analyzer->tempo, channels, frames);
+}
+
+
+static void sTempoFinish(void *context, void *resultPointer)
+{
+    WorkerTempoAnalyzer *analyzer = context;
+    NSMutableDictionary *result = (__bridge NSMutableDictionary *)resultPointer;
+
+    double estimatedBPM, estimatedBPMConfidence;
+
+    if (result && HugTempoGetEstimate(analyzer->tempo, &estimatedBPM, &estimatedBPMConfidence)) {
+        [result setObject:@(estimatedBPM)           forKey:TrackKeyEstimatedBPM];
+        [result setObject:@(estimatedBPMConfidence) forKey:TrackKeyEstimatedBPMConfidence];
+    }
+
+    HugTempoFree(analyzer->tempo);
+    analyzer->tempo = NULL;
+}
+
+
+static void sAddAnalyzerTimes(HugAnalysisPipeline *pipeline, NSTimeInterval decodeTime)
+{
+    @synchronized (sAnalyzerTimes) {
+        for (size_t i = 0; i < HugAnalysisPipelineGetAnalyzerCount(pipeline); i++) {
+            HugAnalyzerStats stats = HugAnalysisPipelineGetAnalyzerStats(pipeline, i);
+            if (!stats.active) continue;
+
+            NSString *name = @(stats.name);
+            double seconds = [[sAnalyzerTimes objectForKey:name] doubleValue] + (stats.nanoseconds / 1e9);
+
+            [sAnalyzerTimes setObject:@(seconds) forKey:name];
+        }
+
+        sDecodeTime += decodeTime;
+    }
+}
+
+
+// Returns nil if job was cancelled while decoding, or memory ran out
+static NSDictionary *sReadLoudness(NSURL *internalURL, HugWorkJob *job)
 {
     NSMutableDictionary *result = [NSMutableDictionary dictionary];
 
@@ -66,44 +376,94 @@ static NSDictionary *sReadLoudness(NSURL *internalURL)
         AudioStreamBasicDescription format = [audioFile format];
 
         NSInteger framesRemaining = fileLengthFrames;
-        NSInteger bytesRemaining  = framesRemaining * format.mBytesPerFrame;
-        NSInteger bytesRead = 0;
 
-        LoudnessMeasurer *measurer = LoudnessMeasurerCreate(format.mChannelsPerFrame, format.mSampleRate, framesRemaining);
+        BOOL   isImmediate  = (HugWorkJobGetPriority(job) == HugWorkPriorityImmediate);
+        UInt32 bufferFrames = 4096 * 16;
+
+        WorkerLoudnessAnalyzer loudness = {0};
+        WorkerChromaAnalyzer   chroma   = {0};
+        WorkerTempoAnalyzer    tempo    = {0};
+
+        // Background scans already keep every core busy with other tracks
+        if (isImmediate && (fileLengthFrames > (sParallelScanMinimumDuration * format.mSampleRate))) {
+            bufferFrames = sParallelScanBufferDuration * format.mSampleRate;
+            loudness.parallelScanFrames = bufferFrames;
+        }
+
+        HugAnalysisPipeline *pipeline = HugAnalysisPipelineCreate(isImmediate ? sAnalysisThreadCount : 0);
+
+        // Out of memory, like a cancel: nothing is analyzed and a later request retries
+        if (!pipeline) return nil;
+
+        // Loudness first, its audible range bounds the fingerprint and key
+        HugAnalysisPipelineAddAnalyzer(pipeline, (HugAnalyzer){ "loudness", sLoudnessBegin, sLoudnessConsume, sLoudnessFinish, &loudness });
+        HugAnalysisPipelineAddAnalyzer(pipeline, (HugAnalyzer){ "chroma",   sChromaBegin,   sChromaConsume,   sChromaFinish,   &chroma   });
+        HugAnalysisPipelineAddAnalyzer(pipeline, (HugAnalyzer){ "tempo",    sTempoBegin,    sTempoConsume,    sTempoFinish,    &tempo    });
 
-        AudioBufferList *fillBufferList = HugAudioBufferListCreate(format.mChannelsPerFrame, 4096 * 16, YES);
+        BOOL ok = HugAnalysisPipelineBegin(pipeline, format.mChannelsPerFrame, format.mSampleRate, fileLengthFrames);
+        BOOL cancelled = NO;
+
+        // With a thread team, one buffer is decoded into while the analyzers
+        // read the other
+        //
+        NSInteger bufferListCount = isImmediate ? 2 : 1;
+        AudioBufferList *fillBufferLists[2] = { NULL, NULL };
+        const float *channels[2][format.mChannelsPerFrame];
+
+        for (NSInteger b = 0; b < bufferListCount; b++) {
+            fillBufferLists[b] = HugAudioBufferListCreate(format.mChannelsPerFrame, bufferFrames, YES);
+
+            for (NSInteger c = 0; c < format.mChannelsPerFrame; c++) {
+                channels[b][c] = fillBufferLists[b]->mBuffers[c].mData;
+            }
+        }
+
+        NSInteger      blockIndex = 0;
+        NSTimeInterval decodeTime = 0;
 
-        BOOL ok = YES;
         while (ok) {
-            UInt32 frameCount = (UInt32)framesRemaining;
-            ok = [audioFile readFrames:&frameCount intoBufferList:fillBufferList];
+            NSInteger b = blockIndex++ % bufferListCount;
+
+            UInt32 frameCount = (UInt32)MIN(framesRemaining, (NSInteger)bufferFrames);
+
+            UInt64 decodeStart = HugGetCurrentHostTime();
+            ok = [audioFile readFrames:&frameCount intoBufferList:fillBufferLists[b]];
+            decodeTime += HugGetDeltaInSecondsForHostTimes(HugGetCurrentHostTime(), decodeStart);
 
             if (frameCount) {
-                LoudnessMeasurerScanAudioBuffer(measurer, fillBufferList, frameCount);
+                HugAnalysisPipelineConsume(pipeline, channels[b], frameCount);
             } else {
                 break;
             }
+
+            if (!HugWorkJobCheckpoint(job, frameCount)) {
+                cancelled = YES;
+                break;
+            }
             
             framesRemaining -= frameCount;
-        
-            bytesRead      += frameCount * format.mBytesPerFrame;
-            bytesRemaining -= frameCount * format.mBytesPerFrame;
 
             if (framesRemaining == 0) {
                 break;
             }
         }
-       
-        NSTimeInterval decodedDuration = fileLengthFrames / format.mSampleRate;
-        
-        [result setObject:@(decodedDuration)                       forKey:TrackKeyDecodedDuration];
-        [result setObject:LoudnessMeasurerGetOverview(measurer)    forKey:TrackKeyOverviewData];
-        [result setObject:@(100)                                   forKey:TrackKeyOverviewRate];
-        [result setObject:@(LoudnessMeasurerGetLoudness(measurer)) forKey:TrackKeyTrackLoudness];
-        [result setObject:@(LoudnessMeasurerGetPeak(measurer))     forKey:TrackKeyTrackPeak];
 
-        HugAudioBufferListFree(fillBufferList, YES);
-        LoudnessMeasurerFree(measurer);
+        if (!cancelled) {
+            HugAnalysisPipelineFinish(pipeline, (__bridge void *)result);
+            sAddAnalyzerTimes(pipeline, decodeTime);
+
+            NSTimeInterval decodedDuration = fileLengthFrames / format.mSampleRate;
+            [result setObject:@(decodedDuration) forKey:TrackKeyDecodedDuration];
+        }
+
+        // Waits for the analyzers before their buffers go away
+        HugAnalysisPipelineFree(pipeline);
+
+        for (NSInteger b = 0; b < bufferListCount; b++) {
+            HugAudioBufferListFree(fillBufferLists[b], YES);
+        }
+
+        if (cancelled) return nil;
 
     } else {
         if ([audioFile error]) {
@@ -118,7 +478,14 @@ static NSDictionary *sReadLoudness(NSURL *internalURL)
 
 - (void) cancelUUID:(NSUUID *)UUID
 {
-    [sCancelledUUIDs addObject:UUID];
+    @synchronized (sCancelledUUIDs) {
+        [sCancelledUUIDs addObject:UUID];
+    }
+
+    HugWorkKey key;
+    [UUID getUUIDBytes:key.bytes];
+
+    HugWorkPoolCancel(sWorkPool, key);
 }
 
 
@@ -138,31 +505,88 @@ static NSDictionary *sReadLoudness(NSURL *internalURL)
     if (error) NSLog(@"%@", error);
 
     if (command == WorkerTrackCommandReadMetadata) {
-        dispatch_async(sMetadataQueue, ^{ @autoreleasepool {
-            if (![sCancelledUUIDs containsObject:UUID]) {
+        sSubmitJob(HugWorkPriorityImmediate, UUID, ^(HugWorkJob *job) {
+            if (!HugWorkJobIsCancelled(job) && !sIsCancelled(UUID)) {
                 reply(sReadMetadata(internalURL, originalFilename));
             }
-        } });
+        });
 
     } else if (command == WorkerTrackCommandReadLoudness || command == WorkerTrackCommandReadLoudnessImmediate) {
-        BOOL             isImmediate = (command == WorkerTrackCommandReadLoudnessImmediate);
-        dispatch_queue_t queue       = isImmediate ? sLoudnessImmediateQueue : sLoudnessBackgroundQueue;
+        BOOL            isImmediate = (command == WorkerTrackCommandReadLoudnessImmediate);
+        HugWorkPriority priority    = isImmediate ? HugWorkPriorityImmediate : HugWorkPriorityBackground;
 
-        dispatch_async(queue, ^{ @autoreleasepool {
-            if (![sCancelledUUIDs containsObject:UUID] && ![sLoudnessUUIDs containsObject:UUID]) {
+        sSubmitJob(priority, UUID, ^(HugWorkJob *job) {
+            if (HugWorkJobIsCancelled(job) || sIsCancelled(UUID)) return;
+
+            @synchronized (sLoudnessUUIDs) {
+                if ([sLoudnessUUIDs containsObject:UUID]) return;
                 [sLoudnessUUIDs addObject:UUID];
+            }
+
+            // Re-adding a file, or a duplicate of its track, skips the decode
+            HugAnalysisCacheKey cacheKey;
+            BOOL hasCacheKey = sAnalysisCache && HugAnalysisCacheMakeKey([internalURL fileSystemRepresentation], &cacheKey);
 
-                NSDictionary *dictionary = sReadLoudness(internalURL);
+            NSDictionary *dictionary = hasCacheKey ? sCopyCachedLoudness(cacheKey) : nil;
 
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    reply(dictionary);
-                });
+            if (!dictionary) {
+                dictionary = sReadLoudness(internalURL, job);
+
+                if (!dictionary) {
+                    // Cancelled mid-scan or out of memory, nothing was
+                    // analyzed. Allow a later request to start over.
+                    //
+                    @synchronized (sLoudnessUUIDs) {
+                        [sLoudnessUUIDs removeObject:UUID];
+                    }
+
+                    return;
+                }
+
+                if (hasCacheKey) sStoreCachedLoudness(cacheKey, dictionary);
             }
-        } });
+
+            dispatch_async(dispatch_get_main_queue(), ^{
+                reply(dictionary);
+            });
+        });
     }
 }
 
 
+- (void) fetchStatisticsWithReply:(void (^)(NSDictionary *))reply
+{
+    HugWorkPoolStats stats = HugWorkPoolGetStats(sWorkPool);
+
+    HugAnalysisCacheStats cacheStats = {0};
+    if (sAnalysisCache) cacheStats = HugAnalysisCacheGetStats(sAnalysisCache);
+
+    NSDictionary  *analyzerTimes;
+    NSTimeInterval decodeTime;
+
+    @synchronized (sAnalyzerTimes) {
+        analyzerTimes = [sAnalyzerTimes copy];
+        decodeTime    = sDecodeTime;
+    }
+
+    reply(@{
+        WorkerStatisticThreadCount:      @(stats.threadCount),
+        WorkerStatisticQueuedImmediate:  @(stats.queuedImmediate),
+        WorkerStatisticQueuedBackground: @(stats.queuedBackground),
+        WorkerStatisticRunning:          @(stats.running),
+        WorkerStatisticCompleted:        @(stats.completed),
+        WorkerStatisticCancelled:        @(stats.cancelled),
+        WorkerStatisticPreemptions:      @(stats.preemptions),
+        WorkerStatisticDecodedFrames:    @(stats.processedUnits),
+        WorkerStatisticBusyTime:         @(stats.busyNanoseconds / 1e9),
+        WorkerStatisticCacheHits:        @(cacheStats.hits),
+        WorkerStatisticCacheMisses:      @(cacheStats.misses),
+        WorkerStatisticDecodeTime:       @(decodeTime),
+        WorkerStatisticAnalyzerTimes:    analyzerTimes
+    });
+}
+
+
 - (void) performLibraryParseWithReply:(void (^)(NSDictionary *))reply
 {
     dispatch_async(sLibraryQueue, ^{
@@ -0,0 +1,220 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugAnalysisCache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define kEntryLength 1000
+
+
+static char sDirectoryPath[PATH_MAX];
+
+
+static void sWriteFile(const char *path, const uint8_t *bytes, size_t length, time_t modificationTime)
+{
+    FILE *file = fopen(path, "wb");
+    fwrite(bytes, 1, length, file);
+    fclose(file);
+
+    // Writes in quick succession can share a timestamp, so tests set it
+    struct timespec times[2] = { { modificationTime, 0 }, { modificationTime, 0 } };
+    utimensat(AT_FDCWD, path, times, 0);
+}
+
+
+static HugAnalysisCacheKey sMakeKey(uint8_t value)
+{
+    HugAnalysisCacheKey key;
+    memset(&key, value, sizeof(key));
+    return key;
+}
+
+
+static bool sHasEntry(HugAnalysisCache *cache, uint8_t value)
+{
+    size_t length = 0;
+    void *bytes = HugAnalysisCacheCopyEntry(cache, sMakeKey(value), &length);
+
+    bool result = bytes && (length == kEntryLength) && (((uint8_t *)bytes)[0] == value);
+    free(bytes);
+
+    return result;
+}
+
+
+static void sStoreEntry(HugAnalysisCache *cache, uint8_t value)
+{
+    uint8_t bytes[kEntryLength];
+    memset(bytes, value, sizeof(bytes));
+
+    HugTestAssert(HugAnalysisCacheStoreEntry(cache, sMakeKey(value), bytes, sizeof(bytes)));
+}
+
+
+static void sRemoveDirectoryContents(void)
+{
+    DIR *directory = opendir(sDirectoryPath);
+    struct dirent *item;
+
+    while (directory && (item = readdir(directory))) {
+        if (item->d_name[0] == '.') continue;
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", sDirectoryPath, item->d_name);
+        unlink(path);
+    }
+
+    if (directory) closedir(directory);
+}
+
+
+static void testKeys(void)
+{
+    size_t length = 300 * 1024;
+    uint8_t *bytes = malloc(length);
+    uint32_t seed = 11;
+
+    for (size_t i = 0; i < length; i++) {
+        bytes[i] = HugTestRandom(&seed) * 127;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/audio.bin", sDirectoryPath);
+
+    HugAnalysisCacheKey original, same, changedTail, changedTime, shorter;
+
+    sWriteFile(path, bytes, length, 1000000);
+    HugTestAssert(HugAnalysisCacheMakeKey(path, &original));
+
+    sWriteFile(path, bytes, length, 1000000);
+    HugTestAssert(HugAnalysisCacheMakeKey(path, &same));
+
+    bytes[length - 10] ^= 0xff;
+    sWriteFile(path, bytes, length, 1000000);
+    HugTestAssert(HugAnalysisCacheMakeKey(path, &changedTail));
+    bytes[length - 10] ^= 0xff;
+
+    sWriteFile(path, bytes, length, 2000000);
+    HugTestAssert(HugAnalysisCacheMakeKey(path, &changedTime));
+
+    // Smaller than the hashed ends
+    sWriteFile(path, bytes, 5000, 1000000);
+    HugTestAssert(HugAnalysisCacheMakeKey(path, &shorter));
+
+    HugTestAssert(!memcmp(&original, &same, sizeof(HugAnalysisCacheKey)));
+    HugTestAssert( memcmp(&original, &changedTail, sizeof(HugAnalysisCacheKey)));
+    HugTestAssert( memcmp(&original, &changedTime, sizeof(HugAnalysisCacheKey)));
+    HugTestAssert( memcmp(&original, &shorter,     sizeof(HugAnalysisCacheKey)));
+
+    unlink(path);
+    HugTestAssert(!HugAnalysisCacheMakeKey(path, &original));
+
+    free(bytes);
+}
+
+
+static void testStoreAndCopy(void)
+{
+    HugAnalysisCache *cache = HugAnalysisCacheCreate(sDirectoryPath, 1024 * 1024);
+    HugTestAssert(cache != NULL);
+
+    HugTestAssert(!sHasEntry(cache, 1));
+    sStoreEntry(cache, 1);
+    HugTestAssert(sHasEntry(cache, 1));
+
+    // Replacing an entry doesn't count it twice
+    sStoreEntry(cache, 1);
+
+    HugAnalysisCacheStats stats = HugAnalysisCacheGetStats(cache);
+
+    HugTestAssert(stats.entryCount == 1);
+    HugTestAssert(stats.byteCount > kEntryLength && stats.byteCount < kEntryLength + 64);
+    HugTestAssert(stats.hits == 1);
+    HugTestAssert(stats.misses == 1);
+
+    // A truncated entry is a miss and is removed
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/01010101010101010101010101010101.entry", sDirectoryPath);
+    HugTestAssert(truncate(path, 100) == 0);
+
+    HugTestAssert(!sHasEntry(cache, 1));
+    HugTestAssert(HugAnalysisCacheGetStats(cache).entryCount == 0);
+    HugTestAssert(access(path, F_OK) != 0);
+
+    HugAnalysisCacheFree(cache);
+    sRemoveDirectoryContents();
+}
+
+
+static void testEvictionAndReload(void)
+{
+    // Room for three entries
+    HugAnalysisCache *cache = HugAnalysisCacheCreate(sDirectoryPath, (kEntryLength + 64) * 3);
+
+    sStoreEntry(cache, 1);
+    sStoreEntry(cache, 2);
+    sStoreEntry(cache, 3);
+
+    // Using 1 leaves 2 as the least recently used
+    HugTestAssert(sHasEntry(cache, 1));
+    sStoreEntry(cache, 4);
+
+    HugAnalysisCacheStats stats = HugAnalysisCacheGetStats(cache);
+    HugTestAssert(stats.entryCount == 3);
+    HugTestAssert(stats.evictions == 1);
+
+    HugTestAssert(!sHasEntry(cache, 2));
+
+    HugAnalysisCacheFree(cache);
+
+    // Interrupted stores are cleaned up on the next launch
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/05050505050505050505050505050505.entry.tmp.1.0", sDirectoryPath);
+    uint8_t partial[10] = {0};
+    sWriteFile(path, partial, sizeof(partial), 1000000);
+
+    cache = HugAnalysisCacheCreate(sDirectoryPath, (kEntryLength + 64) * 3);
+
+    HugTestAssert(HugAnalysisCacheGetStats(cache).entryCount == 3);
+    HugTestAssert(sHasEntry(cache, 1));
+    HugTestAssert(sHasEntry(cache, 3));
+    HugTestAssert(sHasEntry(cache, 4));
+    HugTestAssert(access(path, F_OK) != 0);
+
+    HugAnalysisCacheFree(cache);
+
+    // A smaller cap evicts on load
+    cache = HugAnalysisCacheCreate(sDirectoryPath, kEntryLength + 64);
+    HugTestAssert(HugAnalysisCacheGetStats(cache).entryCount == 1);
+    HugAnalysisCacheFree(cache);
+
+    sRemoveDirectoryContents();
+}
+
+
+int main(int argc, const char *argv[])
+{
+    snprintf(sDirectoryPath, sizeof(sDirectoryPath), "%s/AnalysisCacheTests.XXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+
+    if (!mkdtemp(sDirectoryPath)) {
+        fprintf(stderr, "Could not create '%s'\n", sDirectoryPath);
+        return 1;
+    }
+
+    HugTestRun(testKeys);
+    HugTestRun(testStoreAndCopy);
+    HugTestRun(testEvictionAndReload);
+
+    sRemoveDirectoryContents();
+    rmdir(sDirectoryPath);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,286 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugAnalysisPipeline.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define sChannelCount  2
+#define sBlockFrames   4096
+#define sBlockCount    40
+
+
+typedef struct {
+    bool   willBegin;
+    int    finishCount;
+    bool   finishedWithResult;
+    int    finishOrder;
+
+    unsigned int channels;
+    uint64_t     totalFrames;
+
+    double   sum;
+    uint64_t frames;
+
+    // First sample of each block, to check the order blocks arrive in
+    float firsts[sBlockCount];
+    size_t blockCount;
+} sAnalyzerState;
+
+
+typedef struct {
+    int finishCount;
+} sResult;
+
+
+static bool sBegin(void *context, unsigned int channels, double sampleRate, uint64_t totalFrames)
+{
+    sAnalyzerState *state = context;
+
+    state->channels    = channels;
+    state->totalFrames = totalFrames;
+
+    return state->willBegin;
+}
+
+
+static void sConsume(void *context, const float * const *channels, size_t frames)
+{
+    sAnalyzerState *state = context;
+
+    for (unsigned int c = 0; c < state->channels; c++) {
+        for (size_t i = 0; i < frames; i++) {
+            state->sum += channels[c][i];
+        }
+    }
+
+    if (state->blockCount < sBlockCount) {
+        state->firsts[state->blockCount++] = channels[0][0];
+    }
+
+    state->frames += frames;
+}
+
+
+static void sFinish(void *context, void *result)
+{
+    sAnalyzerState *state = context;
+    sResult *r = result;
+
+    state->finishCount++;
+    state->finishedWithResult = (r != NULL);
+
+    if (r) {
+        state->finishOrder = r->finishCount++;
+    }
+}
+
+
+static HugAnalyzer sMakeAnalyzer(const char *name, sAnalyzerState *state)
+{
+    return (HugAnalyzer){ name, sBegin, sConsume, sFinish, state };
+}
+
+
+// Runs sBlockCount blocks through a pipeline, reusing two buffers the way
+// the Worker does, and returns the expected sum of every sample.
+//
+static double sRun(HugAnalysisPipeline *pipeline)
+{
+    float *buffers[2][sChannelCount];
+    double expected = 0;
+
+    for (size_t b = 0; b < 2; b++) {
+        for (size_t c = 0; c < sChannelCount; c++) {
+            buffers[b][c] = malloc(sBlockFrames * sizeof(float));
+        }
+    }
+
+    HugAnalysisPipelineBegin(pipeline, sChannelCount, 44100, sBlockFrames * sBlockCount);
+
+    for (size_t block = 0; block < sBlockCount; block++) {
+        float **channels = buffers[block % 2];
+
+        // Consume() waits for the block before last, so this buffer is free
+        for (size_t c = 0; c < sChannelCount; c++) {
+            for (size_t i = 0; i < sBlockFrames; i++) {
+                float sample = i ? ((c + 1) * 0.001f) + ((i % 7) * 0.0001f) : (float)block;
+
+                channels[c][i] = sample;
+                expected += sample;
+            }
+        }
+
+        HugAnalysisPipelineConsume(pipeline, (const float * const *)channels, sBlockFrames);
+
+        if (block % 2) {
+            HugAnalysisPipelineGetAnalyzerStats(pipeline, 0);
+        }
+    }
+
+    // Waits for the last block before the buffers go away
+    HugAnalysisPipelineGetAnalyzerStats(pipeline, 0);
+
+    for (size_t b = 0; b < 2; b++) {
+        for (size_t c = 0; c < sChannelCount; c++) {
+            free(buffers[b][c]);
+        }
+    }
+
+    return expected;
+}
+
+
+static void testFanOut(void)
+{
+    for (size_t threadCount = 0; threadCount <= 3; threadCount++) {
+        HugAnalysisPipeline *pipeline = HugAnalysisPipelineCreate(threadCount);
+        sAnalyzerState states[5] = {0};
+        sResult result = {0};
+
+        for (size_t a = 0; a < 5; a++) {
+            states[a].willBegin = true;
+            HugTestAssert(HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("test", &states[a])));
+        }
+
+        HugTestAssert(HugAnalysisPipelineGetAnalyzerCount(pipeline) == 5);
+
+        double expected = sRun(pipeline);
+        HugAnalysisPipelineFinish(pipeline, &result);
+
+        HugTestAssert(result.finishCount == 5);
+
+        for (size_t a = 0; a < 5; a++) {
+            sAnalyzerState *state = &states[a];
+
+            HugTestAssert(state->channels == sChannelCount);
+            HugTestAssert(state->totalFrames == sBlockFrames * sBlockCount);
+            HugTestAssert(state->frames == sBlockFrames * sBlockCount);
+            HugTestAssertClose(state->sum, expected, 1e-6 * expected);
+
+            HugTestAssert(state->finishCount == 1);
+            HugTestAssert(state->finishedWithResult);
+            HugTestAssert(state->finishOrder == (int)a);
+
+            HugTestAssert(state->blockCount == sBlockCount);
+
+            for (size_t block = 0; block < sBlockCount; block++) {
+                HugTestAssert(state->firsts[block] == (float)block);
+            }
+
+            HugAnalyzerStats stats = HugAnalysisPipelineGetAnalyzerStats(pipeline, a);
+            HugTestAssert(stats.active);
+            HugTestAssert(stats.frames == sBlockFrames * sBlockCount);
+            HugTestAssert(!strcmp(stats.name, "test"));
+        }
+
+        // Finished analyzers aren't finished again
+        HugAnalysisPipelineFree(pipeline);
+
+        for (size_t a = 0; a < 5; a++) {
+            HugTestAssert(states[a].finishCount == 1);
+        }
+    }
+}
+
+
+static void testInactive(void)
+{
+    HugAnalysisPipeline *pipeline = HugAnalysisPipelineCreate(2);
+    sAnalyzerState states[3] = { { .willBegin = true }, { .willBegin = false }, { .willBegin = true } };
+    sResult result = {0};
+
+    for (size_t a = 0; a < 3; a++) {
+        HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("test", &states[a]));
+    }
+
+    sRun(pipeline);
+    HugAnalysisPipelineFinish(pipeline, &result);
+
+    // The analyzer that declined sees nothing
+    HugTestAssert(states[1].frames == 0);
+    HugTestAssert(states[1].finishCount == 0);
+    HugTestAssert(!HugAnalysisPipelineGetAnalyzerStats(pipeline, 1).active);
+
+    HugTestAssert(states[0].finishOrder == 0);
+    HugTestAssert(states[2].finishOrder == 1);
+    HugTestAssert(result.finishCount == 2);
+
+    // Too late to add
+    sAnalyzerState late = { .willBegin = true };
+    HugTestAssert(!HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("late", &late)));
+
+    HugAnalysisPipelineFree(pipeline);
+
+    // Nobody begins
+    pipeline = HugAnalysisPipelineCreate(2);
+    sAnalyzerState declined = { .willBegin = false };
+
+    HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("declined", &declined));
+    HugTestAssert(!HugAnalysisPipelineBegin(pipeline, 2, 44100, 0));
+
+    HugAnalysisPipelineFree(pipeline);
+    HugTestAssert(declined.finishCount == 0);
+}
+
+
+static void testAbandon(void)
+{
+    for (size_t threadCount = 0; threadCount <= 2; threadCount++) {
+        HugAnalysisPipeline *pipeline = HugAnalysisPipelineCreate(threadCount);
+        sAnalyzerState states[3] = { { .willBegin = true }, { .willBegin = true }, { .willBegin = true } };
+
+        for (size_t a = 0; a < 3; a++) {
+            HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("test", &states[a]));
+        }
+
+        sRun(pipeline);
+
+        // Free without Finish releases every analyzer with a NULL result
+        HugAnalysisPipelineFree(pipeline);
+
+        for (size_t a = 0; a < 3; a++) {
+            HugTestAssert(states[a].finishCount == 1);
+            HugTestAssert(!states[a].finishedWithResult);
+            HugTestAssert(states[a].frames == sBlockFrames * sBlockCount);
+        }
+    }
+
+    // Never begun: nothing to release
+    HugAnalysisPipeline *pipeline = HugAnalysisPipelineCreate(2);
+    sAnalyzerState state = { .willBegin = true };
+
+    HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("test", &state));
+    HugAnalysisPipelineFree(pipeline);
+
+    HugTestAssert(state.finishCount == 0);
+}
+
+
+static void testFull(void)
+{
+    HugAnalysisPipeline *pipeline = HugAnalysisPipelineCreate(0);
+    sAnalyzerState state = {0};
+
+    for (size_t a = 0; a < HugAnalysisPipelineMaxAnalyzers; a++) {
+        HugTestAssert(HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("test", &state)));
+    }
+
+    HugTestAssert(!HugAnalysisPipelineAddAnalyzer(pipeline, sMakeAnalyzer("test", &state)));
+    HugTestAssert(HugAnalysisPipelineGetAnalyzerStats(pipeline, HugAnalysisPipelineMaxAnalyzers).name == NULL);
+
+    HugAnalysisPipelineFree(pipeline);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testFanOut);
+    HugTestRun(testInactive);
+    HugTestRun(testAbandon);
+    HugTestRun(testFull);
+
+    return HugTestFinish();
+}
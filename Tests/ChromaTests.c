@@ -0,0 +1,140 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugChroma.h"
+#include "HugFFT.h"
+
+#include <stdlib.h>
+
+
+static void testFFTMatchesDFT(void)
+{
+    size_t lengths[] = { 4, 8, 64, 1024 };
+    uint32_t seed = 5;
+
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        size_t length = lengths[l];
+        size_t binCount = (length / 2) + 1;
+
+        HugFFT *fft = HugFFTCreate(length);
+        HugTestAssert(fft != NULL);
+        HugTestAssert(HugFFTGetLength(fft) == length);
+
+        float *input     = malloc(length * sizeof(float));
+        float *real      = malloc(binCount * sizeof(float));
+        float *imaginary = malloc(binCount * sizeof(float));
+        float *power     = malloc(binCount * sizeof(float));
+
+        for (size_t i = 0; i < length; i++) {
+            input[i] = HugTestRandom(&seed);
+        }
+
+        HugFFTForward(fft, input, real, imaginary);
+        HugFFTGetPower(fft, input, power);
+
+        double maxError = 0;
+
+        for (size_t k = 0; k < binCount; k++) {
+            double expectedReal = 0, expectedImaginary = 0;
+
+            for (size_t n = 0; n < length; n++) {
+                double angle = (-2.0 * M_PI * k * n) / length;
+
+                expectedReal      += input[n] * cos(angle);
+                expectedImaginary += input[n] * sin(angle);
+            }
+
+            double expectedPower = (expectedReal * expectedReal) + (expectedImaginary * expectedImaginary);
+
+            maxError = fmax(maxError, fabs(real[k] - expectedReal));
+            maxError = fmax(maxError, fabs(imaginary[k] - expectedImaginary));
+            maxError = fmax(maxError, fabs(power[k] - expectedPower) / (1 + expectedPower));
+        }
+
+        HugTestAssert(maxError < 1e-3);
+
+        free(input);
+        free(real);
+        free(imaginary);
+        free(power);
+
+        HugFFTFree(fft);
+    }
+
+    HugTestAssert(HugFFTCreate(0)   == NULL);
+    HugTestAssert(HugFFTCreate(2)   == NULL);
+    HugTestAssert(HugFFTCreate(100) == NULL);
+}
+
+
+static void testPitchClasses(void)
+{
+    // A3, C#5, and G5 at 44.1 kHz and 48 kHz, stereo
+    double frequencies[] = { 220.0, 554.37, 783.99 };
+    size_t expectedClasses[] = { 9, 1, 7 };
+    double sampleRates[] = { 44100, 48000 };
+
+    for (size_t r = 0; r < 2; r++) {
+        double sampleRate = sampleRates[r];
+
+        for (size_t t = 0; t < 3; t++) {
+            size_t frameCount = (size_t)(sampleRate * 3);
+
+            float *left  = malloc(frameCount * sizeof(float));
+            float *right = malloc(frameCount * sizeof(float));
+
+            for (size_t i = 0; i < frameCount; i++) {
+                left[i] = right[i] = 0.5 * sin((2.0 * M_PI * frequencies[t] * i) / sampleRate);
+            }
+
+            HugChroma *chroma = HugChromaCreate(2, sampleRate);
+
+            // In uneven pieces, as the decoder hands them over
+            for (size_t offset = 0; offset < frameCount; ) {
+                size_t count = 1000 + (offset % 7919);
+                if (count > frameCount - offset) count = frameCount - offset;
+
+                const float *channels[2] = { left + offset, right + offset };
+                HugTestAssert(HugChromaProcess(chroma, channels, count));
+
+                offset += count;
+            }
+
+            size_t chromaFrames = HugChromaGetFrameCount(chroma);
+            double frameRate    = HugChromaGetFrameRate(chroma);
+
+            HugTestAssert(chromaFrames > 0);
+            HugTestAssertClose(chromaFrames / frameRate, 3.0, 0.6);
+            HugTestAssertClose(HugChromaGetFrameStep(chroma) * frameRate, sampleRate, 1e-6);
+
+            size_t misses = 0;
+
+            for (size_t f = 0; f < chromaFrames; f++) {
+                const float *frame = HugChromaGetFrames(chroma) + (f * HugChromaBinCount);
+                size_t loudest = 0;
+
+                for (size_t c = 1; c < HugChromaBinCount; c++) {
+                    if (frame[c] > frame[loudest]) loudest = c;
+                }
+
+                if (loudest != expectedClasses[t]) misses++;
+            }
+
+            HugTestAssert(misses == 0);
+
+            HugChromaFree(chroma);
+            free(left);
+            free(right);
+        }
+    }
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testFFTMatchesDFT);
+    HugTestRun(testPitchClasses);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,191 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugChunkRing.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kThreadedFrameCount 2000000
+
+
+// Each sample encodes its frame index and channel
+static float sGetSample(size_t frame, size_t channel)
+{
+    return (float)(frame % 1000000) + (channel * 0.25f);
+}
+
+
+static size_t sWriteFrames(HugChunkRing *ring, size_t *ioFrame, size_t frameCount)
+{
+    float *channels[2];
+    size_t written = 0;
+
+    while (written < frameCount) {
+        size_t frames = HugChunkRingGetWriteFrames(ring, channels);
+        if (!frames) break;
+
+        if (frames > frameCount - written) frames = frameCount - written;
+
+        for (size_t i = 0; i < frames; i++) {
+            channels[0][i] = sGetSample(*ioFrame + i, 0);
+            channels[1][i] = sGetSample(*ioFrame + i, 1);
+        }
+
+        HugChunkRingConfirmWrite(ring, frames);
+
+        *ioFrame += frames;
+        written  += frames;
+    }
+
+    return written;
+}
+
+
+static bool sCheckFrames(float * const *channels, size_t startFrame, size_t frameCount)
+{
+    for (size_t i = 0; i < frameCount; i++) {
+        if (channels[0][i] != sGetSample(startFrame + i, 0)) return false;
+        if (channels[1][i] != sGetSample(startFrame + i, 1)) return false;
+    }
+
+    return true;
+}
+
+
+static void testChunks(void)
+{
+    HugChunkRing *ring = HugChunkRingCreate(2, 1000, 4);
+    HugTestAssert(ring != NULL);
+
+    HugTestAssert(HugChunkRingGetCapacity(ring) == 4000);
+    HugTestAssert(HugChunkRingGetMemorySize(ring) >= 4000 * sizeof(float) * 2);
+
+    float *channels[2];
+
+    // Writes stop at each chunk boundary
+    HugTestAssert(HugChunkRingGetWriteFrames(ring, channels) == 1000);
+    HugChunkRingConfirmWrite(ring, 300);
+    HugTestAssert(HugChunkRingGetWriteFrames(ring, channels) == 700);
+
+    size_t writeFrame = 300;
+    HugTestAssert(sWriteFrames(ring, &writeFrame, 10000) == 3700);
+    HugTestAssert(HugChunkRingGetWriteFrames(ring, channels) == 0);
+    HugTestAssert(HugChunkRingGetAvailableFrames(ring) == 4000);
+
+    HugChunkRingFree(ring);
+}
+
+
+static void testWrapAndUnderrun(void)
+{
+    HugChunkRing *ring = HugChunkRingCreate(2, 256, 3);
+
+    float left[700], right[700];
+    float *output[2] = { left, right };
+
+    size_t writeFrame = 0, readFrame = 0;
+    size_t mismatches = 0;
+
+    // Odd read sizes land everywhere, including across the end
+    for (size_t i = 0; i < 500; i++) {
+        sWriteFrames(ring, &writeFrame, 768);
+
+        size_t frameCount = 1 + ((i * 97) % 700);
+        size_t frames = HugChunkRingRead(ring, output, frameCount);
+        if (frames > frameCount) mismatches++;
+
+        if (!sCheckFrames(output, readFrame, frames)) mismatches++;
+        readFrame += frames;
+    }
+
+    HugTestAssert(mismatches == 0);
+
+    size_t underrunsBefore = HugChunkRingGetUnderrunCount(ring);
+
+    // Drain, then a read with nothing left is an underrun
+    while (HugChunkRingRead(ring, output, 100) == 100) { }
+
+    size_t underrunCount = HugChunkRingGetUnderrunCount(ring);
+    HugTestAssert(underrunCount == underrunsBefore + 1);
+
+    HugTestAssert(HugChunkRingRead(ring, output, 100) == 0);
+    HugTestAssert(HugChunkRingGetUnderrunCount(ring)  == underrunCount + 1);
+    HugTestAssert(HugChunkRingGetUnderrunFrames(ring) >= 100);
+
+    // After Finish(), short reads are the end of the stream
+    sWriteFrames(ring, &writeFrame, 50);
+    HugChunkRingFinish(ring);
+    HugTestAssert(!HugChunkRingIsDrained(ring));
+
+    HugTestAssert(HugChunkRingRead(ring, output, 100) == 50);
+    HugTestAssert(HugChunkRingRead(ring, output, 100) == 0);
+    HugTestAssert(HugChunkRingGetUnderrunCount(ring) == underrunCount + 1);
+    HugTestAssert(HugChunkRingIsDrained(ring));
+
+    HugChunkRingFree(ring);
+}
+
+
+static void *sProducerMain(void *context)
+{
+    HugChunkRing *ring = context;
+    size_t writeFrame = 0;
+
+    while (writeFrame < kThreadedFrameCount) {
+        size_t frameCount = kThreadedFrameCount - writeFrame;
+        if (frameCount > 4096) frameCount = 4096;
+
+        if (!sWriteFrames(ring, &writeFrame, frameCount)) {
+            sched_yield();
+        }
+    }
+
+    HugChunkRingFinish(ring);
+
+    return NULL;
+}
+
+
+static void testThreadedStream(void)
+{
+    HugChunkRing *ring = HugChunkRingCreate(2, 4096, 8);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, sProducerMain, ring);
+
+    float left[512], right[512];
+    float *output[2] = { left, right };
+
+    size_t readFrame = 0, mismatches = 0;
+
+    // Underruns may happen here; frames must still arrive complete and in order
+    while (!HugChunkRingIsDrained(ring)) {
+        size_t frames = HugChunkRingRead(ring, output, 512);
+
+        if (!sCheckFrames(output, readFrame, frames)) mismatches++;
+        readFrame += frames;
+
+        if (frames < 512) sched_yield();
+    }
+
+    pthread_join(producer, NULL);
+
+    HugTestAssert(mismatches == 0);
+    HugTestAssert(readFrame == kThreadedFrameCount);
+
+    HugChunkRingFree(ring);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testChunks);
+    HugTestRun(testWrapAndUnderrun);
+    HugTestRun(testThreadedStream);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,257 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugFingerprint.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define sSongDuration 30.0
+
+
+typedef struct {
+    double sampleRate;
+    double gain;
+    double noise;
+    double leadingSilence;
+    double duration;
+} SongOptions;
+
+
+static double sMidiToFrequency(double note)
+{
+    return 440.0 * pow(2.0, (note - 69) / 12.0);
+}
+
+
+// Adds a decaying sine from first to last with a rotating phasor, which is
+// much cheaper than calling sin() for every sample
+static void sAddTone(float *samples, size_t first, size_t last, double frequency, double amplitude, double decay, double sampleRate)
+{
+    double step = (2.0 * M_PI * frequency) / sampleRate;
+    double stepReal = cos(step), stepImaginary = sin(step);
+    double real = cos(step * first), imaginary = sin(step * first);
+    double damping = exp(-decay / sampleRate);
+
+    for (size_t i = first; i < last; i++) {
+        samples[i] += amplitude * imaginary;
+
+        double nextReal = (real * stepReal) - (imaginary * stepImaginary);
+        imaginary = (real * stepImaginary) + (imaginary * stepReal);
+        real = nextReal;
+
+        amplitude *= damping;
+    }
+}
+
+
+// Two-second chords over a bass note with a melody on top, from a seeded progression
+static void *sCopyFingerprint(uint32_t songSeed, SongOptions options, size_t *outLength)
+{
+    double sampleRate = options.sampleRate;
+    size_t silenceFrames = (size_t)(options.leadingSilence * sampleRate);
+    size_t songFrames = (size_t)(options.duration * sampleRate);
+    size_t frameCount = silenceFrames + songFrames;
+
+    float *samples = calloc(frameCount, sizeof(float));
+    float *song = samples + silenceFrames;
+
+    uint32_t seed = songSeed;
+    uint32_t noiseSeed = 1234;
+
+    for (double start = 0; start < options.duration; start += 2.0) {
+        int root  = (int)((HugTestRandom(&seed) + 1) * 6) % 12;
+        int third = HugTestRandom(&seed) > 0 ? 4 : 3;
+
+        double notes[4] = { 36 + root, 60 + root, 60 + root + third, 67 + root };
+
+        size_t first = (size_t)(start * sampleRate);
+        size_t last  = (size_t)((start + 2.0) * sampleRate);
+        if (last > songFrames) last = songFrames;
+
+        for (int n = 0; n < 4; n++) {
+            double frequency = sMidiToFrequency(notes[n]);
+
+            sAddTone(song, first, last, frequency,       0.15  * options.gain, 0.8, sampleRate);
+            sAddTone(song, first, last, frequency * 2.0, 0.045 * options.gain, 0.8, sampleRate);
+        }
+
+        for (int m = 0; m < 4; m++) {
+            int note = 72 + root + (int)((HugTestRandom(&seed) + 1) * 3.5) % 7;
+
+            size_t melodyFirst = first + (size_t)(m * 0.5 * sampleRate);
+            size_t melodyLast  = first + (size_t)((m + 1) * 0.5 * sampleRate);
+            if (melodyLast > last) melodyLast = last;
+
+            if (melodyFirst < melodyLast) {
+                sAddTone(song, melodyFirst, melodyLast, sMidiToFrequency(note), 0.1 * options.gain, 0, sampleRate);
+            }
+        }
+    }
+
+    if (options.noise) {
+        for (size_t i = silenceFrames; i < frameCount; i++) {
+            samples[i] += options.noise * HugTestRandom(&noiseSeed);
+        }
+    }
+
+    HugChroma *chroma = HugChromaCreate(2, sampleRate);
+    const float *channels[2] = { samples, samples };
+
+    HugChromaProcess(chroma, channels, frameCount);
+
+    void *result = HugFingerprintCreateData(chroma, options.leadingSilence, options.leadingSilence + options.duration, outLength);
+
+    HugChromaFree(chroma);
+    free(samples);
+
+    return result;
+}
+
+
+static SongOptions sGetDefaultOptions(void)
+{
+    return (SongOptions){ 44100, 1.0, 0, 0, sSongDuration };
+}
+
+
+static void testSameAudio(void)
+{
+    size_t lengthA, lengthB, lengthC;
+
+    SongOptions options = sGetDefaultOptions();
+    void *a = sCopyFingerprint(1, options, &lengthA);
+
+    // Resampled, quieter, noisier, with extra silence in front
+    options.sampleRate     = 48000;
+    options.gain           = 0.5;
+    options.noise          = 0.01;
+    options.leadingSilence = 1.3;
+    void *b = sCopyFingerprint(1, options, &lengthB);
+
+    // Lost its last 10 seconds
+    options = sGetDefaultOptions();
+    options.duration = sSongDuration - 10;
+    void *c = sCopyFingerprint(1, options, &lengthC);
+
+    HugTestAssert(a && b && c);
+    // Twelve-byte header and seven four-second segments
+    HugTestAssert(lengthA == 12 + (7 * 12));
+
+    HugTestAssertClose(HugFingerprintGetSimilarity(a, lengthA, a, lengthA), 1.0, 1e-9);
+    HugTestAssert(HugFingerprintGetSimilarity(a, lengthA, b, lengthB) > 0.9);
+    HugTestAssert(HugFingerprintGetSimilarity(a, lengthA, c, lengthC) == 0);
+
+    // Damaged data
+    HugTestAssert(HugFingerprintGetSimilarity(a, lengthA - 1, b, lengthB) == 0);
+    HugTestAssert(HugFingerprintGetSimilarity(NULL, 0, b, lengthB) == 0);
+
+    free(a);
+    free(b);
+    free(c);
+}
+
+
+static void testDifferentAudio(void)
+{
+    void  *fingerprints[8];
+    size_t lengths[8];
+
+    for (size_t i = 0; i < 8; i++) {
+        fingerprints[i] = sCopyFingerprint(100 + (uint32_t)i, sGetDefaultOptions(), &lengths[i]);
+        HugTestAssert(fingerprints[i] != NULL);
+    }
+
+    double maximum = -1;
+
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t j = i + 1; j < 8; j++) {
+            maximum = fmax(maximum, HugFingerprintGetSimilarity(fingerprints[i], lengths[i], fingerprints[j], lengths[j]));
+        }
+    }
+
+    HugTestAssert(maximum < 0.6);
+
+    for (size_t i = 0; i < 8; i++) {
+        free(fingerprints[i]);
+    }
+}
+
+
+static void testTooShort(void)
+{
+    HugChroma *chroma = HugChromaCreate(1, 44100);
+    size_t length = 0;
+
+    HugTestAssert(HugFingerprintCreateData(chroma, 0, 7.5, &length) == NULL);
+    HugTestAssert(HugFingerprintCreateData(chroma, 5, 2, &length) == NULL);
+
+    HugChromaFree(chroma);
+}
+
+
+static void testIndex(void)
+{
+    HugFingerprintIndex *index = HugFingerprintIndexCreate(0.9);
+
+    SongOptions copyOptions = sGetDefaultOptions();
+    copyOptions.gain  = 0.7;
+    copyOptions.noise = 0.005;
+
+    size_t lengths[4];
+    void *song   = sCopyFingerprint(7, sGetDefaultOptions(), &lengths[0]);
+    void *copy   = sCopyFingerprint(7, copyOptions, &lengths[1]);
+    void *other  = sCopyFingerprint(8, sGetDefaultOptions(), &lengths[2]);
+    void *other2 = sCopyFingerprint(9, sGetDefaultOptions(), &lengths[3]);
+
+    size_t songSlot   = HugFingerprintIndexInsert(index, song,   lengths[0]);
+    size_t otherSlot  = HugFingerprintIndexInsert(index, other,  lengths[2]);
+    size_t copySlot   = HugFingerprintIndexInsert(index, copy,   lengths[1]);
+    size_t other2Slot = HugFingerprintIndexInsert(index, other2, lengths[3]);
+
+    HugTestAssert(HugFingerprintIndexGetCount(index) == 4);
+    HugTestAssert(HugFingerprintIndexInsert(index, song, lengths[0] - 3) == HugFingerprintIndexNotFound);
+
+    size_t count = 0;
+    size_t *similar = HugFingerprintIndexCopySimilar(index, songSlot, &count);
+
+    HugTestAssert(count == 1 && similar[0] == copySlot);
+    free(similar);
+
+    similar = HugFingerprintIndexCopySimilar(index, otherSlot, &count);
+    HugTestAssert(count == 0 && !similar);
+
+    HugFingerprintIndexRemove(index, copySlot);
+    HugFingerprintIndexRemove(index, copySlot);
+
+    similar = HugFingerprintIndexCopySimilar(index, songSlot, &count);
+    HugTestAssert(count == 0 && !similar);
+    HugTestAssert(HugFingerprintIndexGetCount(index) == 3);
+
+    // Reused slot
+    HugTestAssert(HugFingerprintIndexInsert(index, copy, lengths[1]) == copySlot);
+    HugTestAssert(other2Slot != copySlot);
+
+    similar = HugFingerprintIndexCopySimilar(index, copySlot, &count);
+    HugTestAssert(count == 1 && similar[0] == songSlot);
+    free(similar);
+
+    free(song);
+    free(copy);
+    free(other);
+    free(other2);
+
+    HugFingerprintIndexFree(index);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testSameAudio);
+    HugTestRun(testDifferentAudio);
+    HugTestRun(testTooShort);
+    HugTestRun(testIndex);
+
+    return HugTestFinish();
+}
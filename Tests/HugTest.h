@@ -0,0 +1,45 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+//
+// Minimal assertion helpers for the portable test executables.
+// Each test file is its own executable and returns non-zero on failure.
+//
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static int sHugTestFailures = 0;
+
+#define HugTestAssert(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+        sHugTestFailures++; \
+    } \
+} while (0)
+
+#define HugTestAssertClose(a, b, tolerance) do { \
+    double _a = (a), _b = (b); \
+    if (!(fabs(_a - _b) <= (tolerance))) { \
+        fprintf(stderr, "%s:%d: %s = %.9g, expected %.9g (+/- %g)\n", __FILE__, __LINE__, #a, _a, _b, (double)(tolerance)); \
+        sHugTestFailures++; \
+    } \
+} while (0)
+
+#define HugTestRun(fn) do { \
+    int _before = sHugTestFailures; \
+    fn(); \
+    fprintf(stderr, "%s %s\n", (sHugTestFailures == _before) ? "PASS" : "FAIL", #fn); \
+} while (0)
+
+#define HugTestFinish() (sHugTestFailures ? 1 : 0)
+
+
+// Deterministic noise in [-1, 1) so failures are reproducible
+static inline float HugTestRandom(uint32_t *state)
+{
+    *state = (*state * 1664525u) + 1013904223u;
+    return ((*state >> 8) / 8388608.0f) - 1.0f;
+}
@@ -0,0 +1,172 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugKey.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define sSampleRate 44100.0
+
+
+static double sMidiToFrequency(double note)
+{
+    return 440.0 * pow(2.0, (note - 69) / 12.0);
+}
+
+
+// Decaying sine with a rotating phasor, see FingerprintTests.c
+static void sAddTone(float *samples, size_t first, size_t last, double frequency, double amplitude)
+{
+    double step = (2.0 * M_PI * frequency) / sSampleRate;
+    double stepReal = cos(step), stepImaginary = sin(step);
+    double real = 1, imaginary = 0;
+    double damping = exp(-1.0 / sSampleRate);
+
+    for (size_t i = first; i < last; i++) {
+        samples[i] += amplitude * imaginary;
+
+        double nextReal = (real * stepReal) - (imaginary * stepImaginary);
+        imaginary = (real * stepImaginary) + (imaginary * stepReal);
+        real = nextReal;
+
+        amplitude *= damping;
+    }
+}
+
+
+// Two-second triads over their roots, with a scale run on top. Major keys
+// go I-vi-IV-V, minor keys i-iv-V-i with the raised leading tone.
+//
+static HugChroma *sCopyChroma(int tonic, bool minor, double seconds)
+{
+    static const int majorScale[7] = { 0, 2, 4, 5, 7, 9, 11 };
+    static const int minorScale[7] = { 0, 2, 3, 5, 7, 8, 11 };
+
+    static const int majorChords[4][3] = { { 0, 4, 7 }, { 9, 12, 16 }, { 5, 9, 12 }, { 7, 11, 14 } };
+    static const int minorChords[4][3] = { { 0, 3, 7 }, { 5, 8, 12 }, { 7, 11, 14 }, { 0, 3, 7 } };
+
+    const int *scale = minor ? minorScale : majorScale;
+    const int (*chords)[3] = minor ? minorChords : majorChords;
+
+    size_t frameCount = (size_t)(seconds * sSampleRate);
+    float *samples = calloc(frameCount, sizeof(float));
+
+    for (size_t bar = 0; (bar * 2.0) < seconds; bar++) {
+        size_t first = (size_t)(bar * 2.0 * sSampleRate);
+        size_t last  = (size_t)((bar + 1) * 2.0 * sSampleRate);
+        if (last > frameCount) last = frameCount;
+
+        const int *chord = chords[bar % 4];
+
+        sAddTone(samples, first, last, sMidiToFrequency(36 + tonic + chord[0]), 0.2);
+
+        for (size_t n = 0; n < 3; n++) {
+            sAddTone(samples, first, last, sMidiToFrequency(60 + tonic + chord[n]), 0.1);
+        }
+
+        for (size_t m = 0; m < 4; m++) {
+            size_t noteFirst = first + (size_t)(m * 0.5 * sSampleRate);
+            size_t noteLast  = noteFirst + (size_t)(0.5 * sSampleRate);
+            if (noteLast > last) noteLast = last;
+
+            int degree = (int)((bar * 4) + m) % 7;
+
+            if (noteFirst < noteLast) {
+                sAddTone(samples, noteFirst, noteLast, sMidiToFrequency(72 + tonic + scale[degree]), 0.08);
+            }
+        }
+    }
+
+    HugChroma *chroma = HugChromaCreate(1, sSampleRate);
+    const float *channels[1] = { samples };
+
+    HugChromaProcess(chroma, channels, frameCount);
+    free(samples);
+
+    return chroma;
+}
+
+
+static void testKeys(void)
+{
+    size_t misses = 0;
+
+    for (int tonic = 0; tonic < 12; tonic++) {
+        for (int minor = 0; minor < 2; minor++) {
+            HugChroma *chroma = sCopyChroma(tonic, minor, 16);
+
+            unsigned int key = HugKeyCount;
+            double confidence = 0;
+
+            HugTestAssert(HugKeyEstimate(chroma, 0, 16, &key, &confidence));
+            HugTestAssert(confidence > 0.6);
+
+            if (key != (unsigned int)(tonic + (minor ? 12 : 0))) {
+                fprintf(stderr, "%s estimated as %s\n", HugKeyGetName(tonic + (minor ? 12 : 0)), HugKeyGetName(key));
+                misses++;
+            }
+
+            HugChromaFree(chroma);
+        }
+    }
+
+    HugTestAssert(misses == 0);
+}
+
+
+static void testNoKey(void)
+{
+    size_t frameCount = (size_t)(sSampleRate * 10);
+    float *samples = calloc(frameCount, sizeof(float));
+    const float *channels[1] = { samples };
+
+    unsigned int key;
+    double confidence;
+
+    // Silence
+    HugChroma *chroma = HugChromaCreate(1, sSampleRate);
+    HugChromaProcess(chroma, channels, frameCount);
+
+    HugTestAssert(!HugKeyEstimate(chroma, 0, 10, &key, &confidence));
+    HugChromaFree(chroma);
+
+    // Noise fits no key well
+    uint32_t seed = 17;
+    for (size_t i = 0; i < frameCount; i++) samples[i] = 0.3 * HugTestRandom(&seed);
+
+    chroma = HugChromaCreate(1, sSampleRate);
+    HugChromaProcess(chroma, channels, frameCount);
+
+    if (HugKeyEstimate(chroma, 0, 10, &key, &confidence)) {
+        HugTestAssert(confidence < 0.6);
+    }
+
+    // Outside the frames
+    HugTestAssert(!HugKeyEstimate(chroma, 20, 30, &key, &confidence));
+
+    HugChromaFree(chroma);
+    free(samples);
+}
+
+
+static void testNames(void)
+{
+    HugTestAssert(!strcmp(HugKeyGetName(0),  "C"));
+    HugTestAssert(!strcmp(HugKeyGetName(6),  "F#"));
+    HugTestAssert(!strcmp(HugKeyGetName(13), "C#m"));
+    HugTestAssert(!strcmp(HugKeyGetName(22), "Bbm"));
+    HugTestAssert(HugKeyGetName(HugKeyCount) == NULL);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testKeys);
+    HugTestRun(testNoKey);
+    HugTestRun(testNames);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,554 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugOverview.h"
+#include "LoudnessMeasurer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static void sMakeSine(float *samples, size_t frameCount, double sampleRate, double frequency, double amplitude)
+{
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] = amplitude * sin(2.0 * M_PI * frequency * (i / sampleRate));
+    }
+}
+
+
+static LoudnessMeasurer *sMeasureStereo(float *left, float *right, size_t frameCount, double sampleRate, size_t chunkSize)
+{
+    LoudnessMeasurer *measurer = LoudnessMeasurerCreate(2, sampleRate, frameCount);
+
+    for (size_t offset = 0; offset < frameCount; offset += chunkSize) {
+        size_t frames = frameCount - offset;
+        if (frames > chunkSize) frames = chunkSize;
+
+        const float *channels[2] = { left + offset, right + offset };
+        LoudnessMeasurerScanAudioBuffer(measurer, channels, frames);
+    }
+
+    return measurer;
+}
+
+
+// EBU Tech 3341, test case 1: stereo 1 kHz sine at -23 dBFS reads -23 LUFS
+static void testSineAtMinus23(void)
+{
+    double sampleRate = 48000;
+    size_t frameCount = sampleRate * 20;
+    double amplitude  = pow(10.0, -23.0 / 20.0);
+
+    float *left  = malloc(frameCount * sizeof(float));
+    float *right = malloc(frameCount * sizeof(float));
+
+    sMakeSine(left,  frameCount, sampleRate, 1000, amplitude);
+    sMakeSine(right, frameCount, sampleRate, 1000, amplitude);
+
+    LoudnessMeasurer *measurer = sMeasureStereo(left, right, frameCount, sampleRate, 4096 * 16);
+
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(measurer), -23.0, 0.1);
+    HugTestAssertClose(LoudnessMeasurerGetPeak(measurer), amplitude, 1e-4);
+
+    size_t overviewCount = 0;
+    uint8_t *overview = LoudnessMeasurerCopyOverview(measurer, &overviewCount);
+
+    HugTestAssert(overviewCount > 1900 && overviewCount <= 2000);
+    HugTestAssert(abs((int)overview[overviewCount / 2] - (int)floor(amplitude * 255)) <= 1);
+
+    free(overview);
+    LoudnessMeasurerFree(measurer);
+    free(left);
+    free(right);
+}
+
+
+// Results must not depend on how the decoder chunks the file
+static void testChunkSizeIndependence(void)
+{
+    double sampleRate = 44100;
+    size_t frameCount = sampleRate * 6;
+
+    float *left  = malloc(frameCount * sizeof(float));
+    float *right = malloc(frameCount * sizeof(float));
+    uint32_t seed = 9;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        left[i]  = HugTestRandom(&seed) * 0.3f;
+        right[i] = HugTestRandom(&seed) * 0.2f;
+    }
+
+    LoudnessMeasurer *a = sMeasureStereo(left, right, frameCount, sampleRate, 65536);
+    LoudnessMeasurer *b = sMeasureStereo(left, right, frameCount, sampleRate, 1000);
+
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(a), LoudnessMeasurerGetLoudness(b), 1e-9);
+    HugTestAssert(LoudnessMeasurerGetPeak(a) == LoudnessMeasurerGetPeak(b));
+    HugTestAssert(LoudnessMeasurerGetTruePeak(a) == LoudnessMeasurerGetTruePeak(b));
+
+    LoudnessMeasurerFree(a);
+    LoudnessMeasurerFree(b);
+    free(left);
+    free(right);
+}
+
+
+static void testSilence(void)
+{
+    double sampleRate = 48000;
+    size_t frameCount = sampleRate * 2;
+
+    float *silence = calloc(frameCount, sizeof(float));
+    LoudnessMeasurer *measurer = sMeasureStereo(silence, silence, frameCount, sampleRate, 4096);
+
+    HugTestAssert(LoudnessMeasurerGetLoudness(measurer) == 0);
+    HugTestAssert(LoudnessMeasurerGetPeak(measurer) == 0);
+    HugTestAssert(LoudnessMeasurerGetTruePeak(measurer) == 0);
+    HugTestAssert(!LoudnessMeasurerGetAudibleRange(measurer, NULL, NULL));
+    HugTestAssert(!LoudnessMeasurerGetOnsetFrame(measurer, NULL));
+
+    LoudnessMeasurerFree(measurer);
+    free(silence);
+}
+
+
+// Channels are filtered in SIMD groups; odd counts leave lanes unused
+static void testChannelGroups(void)
+{
+    double sampleRate = 48000;
+    size_t frameCount = sampleRate * 5;
+
+    float *samples = malloc(frameCount * sizeof(float));
+    uint32_t seed = 3;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] = HugTestRandom(&seed) * 0.25f;
+    }
+
+    const float *channels[5] = { samples, samples, samples, samples, samples };
+
+    LoudnessMeasurer *mono = LoudnessMeasurerCreate(1, sampleRate, frameCount);
+    LoudnessMeasurer *five = LoudnessMeasurerCreate(5, sampleRate, frameCount);
+
+    LoudnessMeasurerScanAudioBuffer(mono, channels, frameCount);
+    LoudnessMeasurerScanAudioBuffer(five, channels, frameCount);
+
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(five), LoudnessMeasurerGetLoudness(mono) + 10 * log10(5), 1e-9);
+    HugTestAssert(LoudnessMeasurerGetPeak(five) == LoudnessMeasurerGetPeak(mono));
+
+    LoudnessMeasurerFree(mono);
+    LoudnessMeasurerFree(five);
+    free(samples);
+}
+
+
+// Segments scanned on separate threads must agree with a sequential scan
+static void testParallelScan(void)
+{
+    double sampleRate = 44100;
+    size_t frameCount = sampleRate * 70;
+
+    float *left  = malloc(frameCount * sizeof(float));
+    float *right = malloc(frameCount * sizeof(float));
+    uint32_t seed = 21;
+
+    // Loudness changes over time, so the gates matter
+    for (size_t i = 0; i < frameCount; i++) {
+        float envelope = 0.05f + 0.5f * fabs(sin(i / sampleRate * 0.7));
+
+        left[i]  = envelope * HugTestRandom(&seed);
+        right[i] = envelope * sin(2.0 * M_PI * 80 * (i / sampleRate));
+    }
+
+    LoudnessMeasurer *sequential = sMeasureStereo(left, right, frameCount, sampleRate, 4096);
+    LoudnessMeasurer *parallel   = LoudnessMeasurerCreate(2, sampleRate, frameCount);
+
+    LoudnessMeasurerSetParallelScan(parallel, sampleRate * 30, 4);
+
+    // Starts mid-hop, then one buffer long enough to split
+    size_t firstFrames = 12345;
+
+    const float *first[2] = { left, right };
+    const float *rest[2]  = { left + firstFrames, right + firstFrames };
+
+    LoudnessMeasurerScanAudioBuffer(parallel, first, firstFrames);
+    LoudnessMeasurerScanAudioBuffer(parallel, rest,  frameCount - firstFrames);
+
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(parallel), LoudnessMeasurerGetLoudness(sequential), 0.01);
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(parallel), LoudnessMeasurerGetLoudness(sequential), 1e-6);
+    HugTestAssert(LoudnessMeasurerGetPeak(parallel) == LoudnessMeasurerGetPeak(sequential));
+    HugTestAssert(LoudnessMeasurerGetTruePeak(parallel) == LoudnessMeasurerGetTruePeak(sequential));
+
+    size_t sequentialCount = 0, parallelCount = 0;
+    uint8_t *sequentialOverview = LoudnessMeasurerCopyOverview(sequential, &sequentialCount);
+    uint8_t *parallelOverview   = LoudnessMeasurerCopyOverview(parallel,   &parallelCount);
+
+    HugTestAssert(sequentialCount == parallelCount);
+    HugTestAssert(!memcmp(sequentialOverview, parallelOverview, sequentialCount));
+
+    free(sequentialOverview);
+    free(parallelOverview);
+    LoudnessMeasurerFree(sequential);
+    LoudnessMeasurerFree(parallel);
+    free(left);
+    free(right);
+}
+
+
+static void testDetailedOverview(void)
+{
+    double sampleRate = 44100;
+    size_t frameCount = sampleRate * 70;
+
+    float *left  = malloc(frameCount * sizeof(float));
+    float *right = malloc(frameCount * sizeof(float));
+
+    // Right sits below zero, so its outline isn't symmetric
+    sMakeSine(left,  frameCount, sampleRate, 1000, 0.5);
+    sMakeSine(right, frameCount, sampleRate, 440,  0.2);
+
+    for (size_t i = 0; i < frameCount; i++) {
+        right[i] -= 0.1f;
+    }
+
+    LoudnessMeasurer *plain      = sMeasureStereo(left, right, frameCount, sampleRate, 4096);
+    LoudnessMeasurer *sequential = LoudnessMeasurerCreate(2, sampleRate, frameCount);
+    LoudnessMeasurer *parallel   = LoudnessMeasurerCreate(2, sampleRate, frameCount);
+
+    LoudnessMeasurerSetDetailedOverviewRate(sequential, 100);
+    LoudnessMeasurerSetDetailedOverviewRate(parallel, 100);
+    LoudnessMeasurerSetParallelScan(parallel, sampleRate * 30, 4);
+
+    for (size_t offset = 0; offset < frameCount; offset += 4096) {
+        size_t frames = frameCount - offset;
+        if (frames > 4096) frames = 4096;
+
+        const float *channels[2] = { left + offset, right + offset };
+        LoudnessMeasurerScanAudioBuffer(sequential, channels, frames);
+    }
+
+    size_t firstFrames = 12345;
+
+    const float *first[2] = { left, right };
+    const float *rest[2]  = { left + firstFrames, right + firstFrames };
+
+    LoudnessMeasurerScanAudioBuffer(parallel, first, firstFrames);
+    LoudnessMeasurerScanAudioBuffer(parallel, rest,  frameCount - firstFrames);
+
+    // The version 1 overview doesn't change
+    size_t plainCount = 0, sequentialCount = 0;
+    uint8_t *plainOverview      = LoudnessMeasurerCopyOverview(plain,      &plainCount);
+    uint8_t *sequentialOverview = LoudnessMeasurerCopyOverview(sequential, &sequentialCount);
+
+    HugTestAssert(plainCount == sequentialCount);
+    HugTestAssert(!memcmp(plainOverview, sequentialOverview, plainCount));
+    HugTestAssert(LoudnessMeasurerCopyDetailedOverview(plain, NULL) == NULL);
+
+    size_t sequentialLength = 0, parallelLength = 0;
+    void *sequentialData = LoudnessMeasurerCopyDetailedOverview(sequential, &sequentialLength);
+    void *parallelData   = LoudnessMeasurerCopyDetailedOverview(parallel,   &parallelLength);
+
+    HugOverview *sequentialDetail = HugOverviewCreate(sequentialData, sequentialLength);
+    HugOverview *parallelDetail   = HugOverviewCreate(parallelData,   parallelLength);
+
+    HugTestAssert(sequentialDetail && parallelDetail);
+
+    if (sequentialDetail && parallelDetail) {
+        size_t binCount = HugOverviewGetBinCount(sequentialDetail);
+
+        HugTestAssert(binCount == HugOverviewGetBinCount(parallelDetail));
+        HugTestAssert(binCount > 6990 && binCount <= 7000);
+        HugTestAssert(HugOverviewGetChannelCount(sequentialDetail) == 2);
+        HugTestAssertClose(HugOverviewGetBinRate(sequentialDetail), 100, 0);
+
+        const HugOverviewBin *a = HugOverviewGetBins(sequentialDetail);
+        const HugOverviewBin *b = HugOverviewGetBins(parallelDetail);
+
+        size_t mismatches = 0;
+
+        // Sums of squares may round differently at chunk edges, a step at most
+        for (size_t i = 0; i < binCount * 2; i++) {
+            if (a[i].min != b[i].min || a[i].max != b[i].max) mismatches++;
+            if (fabs(20 * log10(a[i].rms / b[i].rms)) > 0.51) mismatches++;
+        }
+
+        HugTestAssert(mismatches == 0);
+
+        // 0.5 dB steps, so within 3% of the real values
+        const HugOverviewBin *middle = &a[(binCount / 2) * 2];
+
+        HugTestAssertClose(middle[0].max,  0.5,  0.5 * 0.03);
+        HugTestAssertClose(middle[0].min, -0.5,  0.5 * 0.03);
+        HugTestAssertClose(middle[0].rms,  0.5 / sqrt(2), 0.354 * 0.03);
+        HugTestAssertClose(middle[1].max,  0.1,  0.1 * 0.03);
+        HugTestAssertClose(middle[1].min, -0.3,  0.3 * 0.03);
+
+        // Steady tones compress to almost nothing
+        HugTestAssert(sequentialLength < binCount);
+    }
+
+    HugOverviewFree(sequentialDetail);
+    HugOverviewFree(parallelDetail);
+    free(sequentialData);
+    free(parallelData);
+    free(plainOverview);
+    free(sequentialOverview);
+    LoudnessMeasurerFree(plain);
+    LoudnessMeasurerFree(sequential);
+    LoudnessMeasurerFree(parallel);
+    free(left);
+    free(right);
+}
+
+
+// A noise floor below the threshold, a tone fading in on the left and a
+// lone click on the right after the tone ends
+static void testAudibleRange(void)
+{
+    double sampleRate = 44100;
+    size_t frameCount = sampleRate * 70;
+
+    float *left  = malloc(frameCount * sizeof(float));
+    float *right = malloc(frameCount * sizeof(float));
+
+    uint32_t seed = 7;
+    size_t toneStart = 54321;
+    size_t toneEnd   = 2900000;
+    size_t click     = 3000000;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        double fade = (i - (double)toneStart) / (sampleRate * 2);
+        if (fade > 1) fade = 1;
+
+        double tone = (i >= toneStart && i < toneEnd) ? 0.2 * fade * sin(2.0 * M_PI * 440 * (i / sampleRate)) : 0;
+
+        left[i]  = tone + 0.005f * HugTestRandom(&seed);
+        right[i] = 0.005f * HugTestRandom(&seed);
+    }
+
+    right[click] = -0.5f;
+
+    // Brute force, with the default thresholds of -34 and -30 dBFS
+    float  silenceThreshold = pow(10.0, -34 / 20.0);
+    double onsetEnergy      = pow(10.0, -30 / 10.0);
+
+    size_t expectedStart = SIZE_MAX, expectedEnd = 0, expectedOnset = SIZE_MAX;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        if (fabsf(left[i]) > silenceThreshold || fabsf(right[i]) > silenceThreshold) {
+            if (expectedStart == SIZE_MAX) expectedStart = i;
+            expectedEnd = i + 1;
+        }
+    }
+
+    for (size_t block = 0; expectedOnset == SIZE_MAX && (block + 1) * 441 <= frameCount; block++) {
+        double leftSum = 0, rightSum = 0;
+
+        for (size_t i = block * 441; i < (block + 1) * 441; i++) {
+            leftSum  += left[i]  * left[i];
+            rightSum += right[i] * right[i];
+        }
+
+        if ((leftSum / 441) >= onsetEnergy || (rightSum / 441) >= onsetEnergy) {
+            expectedOnset = block * 441;
+        }
+    }
+
+    HugTestAssert(expectedStart > toneStart && expectedStart < toneStart + (sampleRate / 2));
+    HugTestAssert(expectedEnd == click + 1);
+    HugTestAssert(expectedOnset > expectedStart && expectedOnset < toneStart + sampleRate);
+
+    LoudnessMeasurer *measurers[4] = {
+        sMeasureStereo(left, right, frameCount, sampleRate, 4096),
+        sMeasureStereo(left, right, frameCount, sampleRate, 1000),
+        LoudnessMeasurerCreate(2, sampleRate, frameCount),
+        LoudnessMeasurerCreate(2, sampleRate, frameCount)
+    };
+
+    // Parallel, and with a detailed overview splitting blocks at bin edges
+    const float *channels[2] = { left, right };
+
+    LoudnessMeasurerSetParallelScan(measurers[2], sampleRate * 30, 4);
+    LoudnessMeasurerScanAudioBuffer(measurers[2], channels, frameCount);
+
+    LoudnessMeasurerSetDetailedOverviewRate(measurers[3], 30);
+    LoudnessMeasurerScanAudioBuffer(measurers[3], channels, frameCount);
+
+    for (size_t m = 0; m < 4; m++) {
+        size_t start = 0, end = 0, onset = 0;
+
+        HugTestAssert(LoudnessMeasurerGetAudibleRange(measurers[m], &start, &end));
+        HugTestAssert(LoudnessMeasurerGetOnsetFrame(measurers[m], &onset));
+
+        HugTestAssert(start == expectedStart);
+        HugTestAssert(end   == expectedEnd);
+        HugTestAssert(onset == expectedOnset);
+
+        LoudnessMeasurerFree(measurers[m]);
+    }
+
+    // Above the tone and the click, nothing is audible
+    LoudnessMeasurer *quiet = LoudnessMeasurerCreate(2, sampleRate, frameCount);
+    LoudnessMeasurerSetSilenceThresholds(quiet, -3, -3);
+    LoudnessMeasurerScanAudioBuffer(quiet, channels, frameCount);
+
+    HugTestAssert(!LoudnessMeasurerGetAudibleRange(quiet, NULL, NULL));
+    HugTestAssert(!LoudnessMeasurerGetOnsetFrame(quiet, NULL));
+
+    LoudnessMeasurerFree(quiet);
+    free(left);
+    free(right);
+}
+
+
+// EBU Tech 3342, test case 1: 20s at -20 dBFS, then 20s at -30 dBFS
+static void testLoudnessRange(void)
+{
+    double sampleRate = 48000;
+    size_t halfCount  = sampleRate * 20;
+
+    float *samples = malloc(halfCount * 2 * sizeof(float));
+
+    sMakeSine(samples,             halfCount, sampleRate, 1000, pow(10.0, -20.0 / 20.0));
+    sMakeSine(samples + halfCount, halfCount, sampleRate, 1000, pow(10.0, -30.0 / 20.0));
+
+    LoudnessMeasurer *blocks    = sMeasureStereo(samples, samples, halfCount * 2, sampleRate, 4096);
+    LoudnessMeasurer *histogram = LoudnessMeasurerCreateWithGating(2, sampleRate, halfCount * 2, LoudnessMeasurerGatingHistogram);
+
+    const float *channels[2] = { samples, samples };
+    LoudnessMeasurerScanAudioBuffer(histogram, channels, halfCount * 2);
+
+    HugTestAssertClose(LoudnessMeasurerGetLoudnessRange(blocks),    10, 1);
+    HugTestAssertClose(LoudnessMeasurerGetLoudnessRange(histogram), 10, 1);
+    HugTestAssertClose(LoudnessMeasurerGetLoudnessRange(histogram), LoudnessMeasurerGetLoudnessRange(blocks), 0.1);
+
+    LoudnessMeasurerFree(blocks);
+    LoudnessMeasurerFree(histogram);
+    free(samples);
+}
+
+
+// Momentary and short-term readouts while the scan is in progress
+static void testStreamingReadouts(void)
+{
+    double sampleRate = 48000;
+    size_t frameCount = sampleRate * 5;
+
+    float *samples = malloc(frameCount * sizeof(float));
+    sMakeSine(samples, frameCount, sampleRate, 1000, pow(10.0, -23.0 / 20.0));
+
+    // Unknown length, nothing is sized up front
+    LoudnessMeasurer *measurer = LoudnessMeasurerCreateWithGating(2, sampleRate, 0, LoudnessMeasurerGatingHistogram);
+
+    const float *first[2] = { samples, samples };
+    LoudnessMeasurerScanAudioBuffer(measurer, first, sampleRate);
+
+    HugTestAssertClose(LoudnessMeasurerGetMomentaryLoudness(measurer), -23.0, 0.1);
+    HugTestAssert(LoudnessMeasurerGetShortTermLoudness(measurer) == -HUGE_VAL);
+
+    const float *rest[2] = { samples + (size_t)sampleRate, samples + (size_t)sampleRate };
+    LoudnessMeasurerScanAudioBuffer(measurer, rest, frameCount - sampleRate);
+
+    HugTestAssertClose(LoudnessMeasurerGetMomentaryLoudness(measurer), -23.0, 0.1);
+    HugTestAssertClose(LoudnessMeasurerGetShortTermLoudness(measurer), -23.0, 0.1);
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(measurer),          -23.0, 0.1);
+    HugTestAssertClose(LoudnessMeasurerGetLoudnessRange(measurer),       0.0, 0.1);
+
+    size_t overviewCount = 0;
+    uint8_t *overview = LoudnessMeasurerCopyOverview(measurer, &overviewCount);
+
+    HugTestAssert(overviewCount == 499);
+
+    free(overview);
+    LoudnessMeasurerFree(measurer);
+    free(samples);
+}
+
+
+// Histogram gating agrees with exact gating to within its bin size
+static void testHistogramGating(void)
+{
+    double sampleRate = 44100;
+    size_t frameCount = sampleRate * 60;
+
+    float *left  = malloc(frameCount * sizeof(float));
+    float *right = malloc(frameCount * sizeof(float));
+    uint32_t seed = 17;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        float envelope = 0.02f + 0.6f * fabs(sin(i / sampleRate * 0.3));
+
+        left[i]  = envelope * HugTestRandom(&seed);
+        right[i] = envelope * HugTestRandom(&seed);
+    }
+
+    LoudnessMeasurer *blocks    = sMeasureStereo(left, right, frameCount, sampleRate, 4096);
+    LoudnessMeasurer *histogram = LoudnessMeasurerCreateWithGating(2, sampleRate, frameCount / 2, LoudnessMeasurerGatingHistogram);
+
+    const float *channels[2] = { left, right };
+    LoudnessMeasurerScanAudioBuffer(histogram, channels, frameCount);
+
+    HugTestAssertClose(LoudnessMeasurerGetLoudness(histogram), LoudnessMeasurerGetLoudness(blocks), 0.05);
+    HugTestAssertClose(LoudnessMeasurerGetLoudnessRange(histogram), LoudnessMeasurerGetLoudnessRange(blocks), 0.1);
+    HugTestAssert(LoudnessMeasurerGetMomentaryLoudness(histogram) == LoudnessMeasurerGetMomentaryLoudness(blocks));
+
+    LoudnessMeasurerFree(blocks);
+    LoudnessMeasurerFree(histogram);
+    free(left);
+    free(right);
+}
+
+
+// EBU Tech 3341, test case 15: a fs/4 sine with every sample at 45 degrees
+// reads 3 dB under its true peak of -6 dBTP
+static void testTruePeak(void)
+{
+    double sampleRate = 48000;
+    size_t frameCount = sampleRate * 2;
+
+    float *samples = malloc(frameCount * sizeof(float));
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] = 0.5 * sin((M_PI / 2) * i + (M_PI / 4));
+    }
+
+    LoudnessMeasurer *measurer = sMeasureStereo(samples, samples, frameCount, sampleRate, 1000);
+
+    double truePeak = 20 * log10(LoudnessMeasurerGetTruePeak(measurer));
+
+    HugTestAssertClose(LoudnessMeasurerGetPeak(measurer), 0.5 * sqrt(0.5), 1e-6);
+    HugTestAssert(truePeak > -6.4 && truePeak < -5.8);
+
+    LoudnessMeasurerFree(measurer);
+
+    // Never under the sample peak, even where the filter rings low
+    uint32_t seed = 5;
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] = (i % 997 == 0) ? 0.9f : HugTestRandom(&seed) * 0.01f;
+    }
+
+    measurer = sMeasureStereo(samples, samples, frameCount, sampleRate, 4096);
+    HugTestAssert(LoudnessMeasurerGetTruePeak(measurer) >= LoudnessMeasurerGetPeak(measurer));
+
+    LoudnessMeasurerFree(measurer);
+    free(samples);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testSineAtMinus23);
+    HugTestRun(testChunkSizeIndependence);
+    HugTestRun(testSilence);
+    HugTestRun(testChannelGroups);
+    HugTestRun(testParallelScan);
+    HugTestRun(testDetailedOverview);
+    HugTestRun(testAudibleRange);
+    HugTestRun(testLoudnessRange);
+    HugTestRun(testStreamingReadouts);
+    HugTestRun(testHistogramGating);
+    HugTestRun(testTruePeak);
+
+    return HugTestFinish();
+}
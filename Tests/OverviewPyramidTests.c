@@ -0,0 +1,212 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugOverviewPyramid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static void *sCreatePyramid(const uint8_t *samples, size_t count)
+{
+    void *pyramid = malloc(HugOverviewPyramidGetSize(count));
+    HugOverviewPyramidBuild(samples, count, pyramid);
+    return pyramid;
+}
+
+
+static void sFillSamples(uint8_t *samples, size_t count, uint32_t *seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = (uint8_t)((HugTestRandom(seed) + 1.0f) * 127.5f);
+    }
+}
+
+
+// Checks each output against scans of its window, shrunk and grown by the
+// most its edges may move
+static size_t sCountMismatches(
+    const uint8_t *samples, size_t count, const void *pyramid,
+    double start, double stop, size_t outCount
+) {
+    uint8_t *outMin = malloc(outCount);
+    uint8_t *outMax = malloc(outCount);
+
+    HugOverviewPyramidReduce(pyramid, samples, count, start, stop, outCount, outMin, outMax);
+
+    double stride = (stop - start) / outCount;
+    double slack  = (stride / 4) > 0.5 ? (stride / 4) : 0.5;
+    size_t mismatches = 0;
+
+    for (size_t o = 0; o < outCount; o++) {
+        double a = start + o * stride;
+        double b = start + (o + 1) * stride;
+
+        size_t outerA = (a - slack) > 0 ? (size_t)floor(a - slack) : 0;
+        size_t outerB = (size_t)ceil(b + slack);
+        size_t innerA = (size_t)ceil(a + slack);
+        size_t innerB = (size_t)floor(b - slack);
+
+        if (outerB > count) outerB = count;
+
+        uint8_t outerMin = UINT8_MAX, outerMax = 0;
+        uint8_t innerMin = UINT8_MAX, innerMax = 0;
+
+        for (size_t i = outerA; i < outerB; i++) {
+            if (samples[i] < outerMin) outerMin = samples[i];
+            if (samples[i] > outerMax) outerMax = samples[i];
+
+            if (i >= innerA && i < innerB) {
+                if (samples[i] < innerMin) innerMin = samples[i];
+                if (samples[i] > innerMax) innerMax = samples[i];
+            }
+        }
+
+        if (outMax[o] > outerMax || outMax[o] < innerMax) mismatches++;
+        if (outMin[o] < outerMin || outMin[o] > innerMin) mismatches++;
+    }
+
+    free(outMin);
+    free(outMax);
+
+    return mismatches;
+}
+
+
+// Power-of-two windows line up with the cells and come out exact
+static void testExactWindows(void)
+{
+    uint32_t seed = 5;
+    size_t count = 4096;
+
+    uint8_t *samples = malloc(count);
+    sFillSamples(samples, count, &seed);
+
+    void *pyramid = sCreatePyramid(samples, count);
+    uint8_t outMin[64], outMax[64];
+
+    HugTestAssert(HugOverviewPyramidReduce(pyramid, samples, count, 1024, 3072, 64, outMin, outMax));
+
+    size_t mismatches = 0;
+
+    for (size_t o = 0; o < 64; o++) {
+        uint8_t expectedMin = UINT8_MAX, expectedMax = 0;
+
+        for (size_t i = 1024 + (o * 32); i < 1024 + ((o + 1) * 32); i++) {
+            if (samples[i] < expectedMin) expectedMin = samples[i];
+            if (samples[i] > expectedMax) expectedMax = samples[i];
+        }
+
+        if (outMin[o] != expectedMin || outMax[o] != expectedMax) mismatches++;
+    }
+
+    HugTestAssert(mismatches == 0);
+
+    free(pyramid);
+    free(samples);
+}
+
+
+static void testSize(void)
+{
+    HugTestAssert(HugOverviewPyramidGetSize(0) == 0);
+
+    // Up to eight samples share one min/max pair
+    size_t headerSize = HugOverviewPyramidGetSize(1) - 2;
+    HugTestAssert(HugOverviewPyramidGetSize(8) == headerSize + 2);
+
+    // 33 samples: 5 -> 3 -> 2 -> 1 cells
+    HugTestAssert(HugOverviewPyramidGetSize(33) == headerSize + (5 + 3 + 2 + 1) * 2);
+
+    // A min and a max per eight samples, halving from there
+    size_t count = 24000;
+    HugTestAssert(HugOverviewPyramidGetSize(count) < headerSize + (count / 2) + 64);
+}
+
+
+static void testMatchesScan(void)
+{
+    uint32_t seed = 17;
+
+    size_t counts[]    = { 1, 2, 3, 7, 64, 1001, 24000, 24001 };
+    size_t outCounts[] = { 1, 3, 100, 511, 800, 1600 };
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t count = counts[c];
+
+        uint8_t *samples = malloc(count);
+        sFillSamples(samples, count, &seed);
+
+        void *pyramid = sCreatePyramid(samples, count);
+
+        for (size_t w = 0; w < sizeof(outCounts) / sizeof(outCounts[0]); w++) {
+            size_t outCount = outCounts[w];
+
+            if (outCount <= count) {
+                HugTestAssert(sCountMismatches(samples, count, pyramid, 0, count, outCount) == 0);
+            }
+
+            // Cropped ranges with fractional ends
+            double start = count * 0.13 + 0.4;
+            double stop  = count * 0.91 + 0.3;
+
+            if (outCount <= (stop - start)) {
+                HugTestAssert(sCountMismatches(samples, count, pyramid, start, stop, outCount) == 0);
+            }
+        }
+
+        free(pyramid);
+        free(samples);
+    }
+}
+
+
+static void testInterpolates(void)
+{
+    uint8_t samples[] = { 0, 100, 200 };
+    void *pyramid = sCreatePyramid(samples, 3);
+
+    uint8_t outMax[6];
+    HugTestAssert(HugOverviewPyramidReduce(pyramid, samples, 3, 0, 3, 6, NULL, outMax));
+
+    // Two outputs per sample, each a quarter sample either side of it
+    HugTestAssert(outMax[0] == 0);
+    HugTestAssert(outMax[1] == 25);
+    HugTestAssert(outMax[2] == 75);
+    HugTestAssert(outMax[3] == 125);
+    HugTestAssert(outMax[4] == 175);
+    HugTestAssert(outMax[5] == 200);
+
+    free(pyramid);
+}
+
+
+static void testRejectsMismatch(void)
+{
+    uint8_t samples[16] = { 0 };
+    void *pyramid = sCreatePyramid(samples, 16);
+
+    uint8_t outMax[4];
+    HugTestAssert(!HugOverviewPyramidReduce(pyramid, samples, 15, 0, 15, 4, NULL, outMax));
+    HugTestAssert(!HugOverviewPyramidReduce(NULL, samples, 16, 0, 16, 4, NULL, outMax));
+
+    // An empty range is zero
+    memset(outMax, 0xff, sizeof(outMax));
+    HugTestAssert(HugOverviewPyramidReduce(pyramid, samples, 16, 8, 8, 4, NULL, outMax));
+    HugTestAssert(outMax[0] == 0 && outMax[3] == 0);
+
+    free(pyramid);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testSize);
+    HugTestRun(testExactWindows);
+    HugTestRun(testMatchesScan);
+    HugTestRun(testInterpolates);
+    HugTestRun(testRejectsMismatch);
+
+    return HugTestFinish();
+}
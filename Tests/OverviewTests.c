@@ -0,0 +1,143 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugOverview.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Half a step, or silence below -96 dBFS (either at the floor itself)
+static bool sIsWithinStep(float actual, float expected)
+{
+    float floor = powf(10.0f, -96.0f / 20.0f);
+
+    if (fabsf(expected) < floor * 0.97f) return actual == 0;
+    if (fabsf(expected) < floor * 1.03f) return true;
+    if ((actual < 0) != (expected < 0)) return false;
+
+    return fabs(20 * log10(actual / expected)) <= 0.2501;
+}
+
+
+static void testRoundTrip(void)
+{
+    size_t channelCount = 3;
+    size_t binCount     = 1000;
+
+    HugOverviewBin *bins = malloc(channelCount * binCount * sizeof(HugOverviewBin));
+    uint32_t seed = 9;
+
+    for (size_t i = 0; i < channelCount * binCount; i++) {
+        float level = powf(10.0f, HugTestRandom(&seed) * 3 - 3);
+
+        bins[i].min = -level * fabsf(HugTestRandom(&seed));
+        bins[i].max =  level * fabsf(HugTestRandom(&seed));
+        bins[i].rms =  level * 0.3f;
+    }
+
+    // Silence, below the floor, above the +6 dBFS ceiling and a positive minimum
+    bins[0].min = 0;   bins[0].max = 0;    bins[0].rms = 0;
+    bins[1].min = 0;   bins[1].max = 1e-6; bins[1].rms = 1e-6;
+    bins[2].min = -4;  bins[2].max = 4;    bins[2].rms = 1;
+    bins[3].min = 0.2; bins[3].max = 0.4;  bins[3].rms = 0.3;
+
+    size_t length = 0;
+    void *data = HugOverviewCreateData(bins, channelCount, binCount, 50, &length);
+    HugTestAssert(data != NULL);
+
+    HugOverview *overview = HugOverviewCreate(data, length);
+    HugTestAssert(overview != NULL);
+
+    HugTestAssert(HugOverviewGetChannelCount(overview) == channelCount);
+    HugTestAssert(HugOverviewGetBinCount(overview) == binCount);
+    HugTestAssertClose(HugOverviewGetBinRate(overview), 50, 0);
+
+    const HugOverviewBin *decoded = HugOverviewGetBins(overview);
+    size_t mismatches = 0;
+
+    for (size_t i = 4; i < channelCount * binCount; i++) {
+        if (!sIsWithinStep(decoded[i].min, bins[i].min)) mismatches++;
+        if (!sIsWithinStep(decoded[i].max, bins[i].max)) mismatches++;
+        if (!sIsWithinStep(decoded[i].rms, bins[i].rms)) mismatches++;
+    }
+
+    HugTestAssert(mismatches == 0);
+
+    HugTestAssert(decoded[0].min == 0 && decoded[0].max == 0 && decoded[0].rms == 0);
+    HugTestAssert(decoded[1].max == 0);
+    HugTestAssertClose(decoded[2].max,  1.995, 0.001);
+    HugTestAssertClose(decoded[2].min, -1.995, 0.001);
+    HugTestAssert(decoded[3].min > 0.19 && decoded[3].min < 0.21);
+
+    // Peaks are the largest magnitude over all channels, as in version 1
+    uint8_t *peaks = malloc(binCount);
+    HugOverviewGetPeaks(overview, peaks);
+
+    HugTestAssert(peaks[0] == 255);
+
+    for (size_t i = 1; i < binCount; i++) {
+        float peak = 0;
+
+        for (size_t c = 0; c < channelCount; c++) {
+            const HugOverviewBin *bin = &decoded[(i * channelCount) + c];
+            if ( bin->max > peak) peak =  bin->max;
+            if (-bin->min > peak) peak = -bin->min;
+        }
+
+        if (peaks[i] != (uint8_t)floorf(peak * 255)) mismatches++;
+    }
+
+    HugTestAssert(mismatches == 0);
+
+    free(peaks);
+    HugOverviewFree(overview);
+    free(data);
+    free(bins);
+}
+
+
+static void testRejectsDamage(void)
+{
+    HugOverviewBin bins[100];
+
+    for (size_t i = 0; i < 100; i++) {
+        bins[i] = (HugOverviewBin){ -0.5f, 0.5f * (i % 7) / 7.0f, 0.1f };
+    }
+
+    size_t length = 0;
+    uint8_t *data = HugOverviewCreateData(bins, 1, 100, 100, &length);
+
+    HugOverview *overview = HugOverviewCreate(data, length);
+    HugTestAssert(overview != NULL);
+    HugOverviewFree(overview);
+
+    // Version 1 overviews and truncated data
+    uint8_t peaks[64];
+    memset(peaks, 0x7f, sizeof(peaks));
+
+    HugTestAssert(HugOverviewCreate(peaks, sizeof(peaks)) == NULL);
+    HugTestAssert(HugOverviewCreate(data, length - 1) == NULL);
+    HugTestAssert(HugOverviewCreate(data, 8) == NULL);
+    HugTestAssert(HugOverviewCreate(NULL, 0) == NULL);
+
+    // No bins is valid
+    free(data);
+    data = HugOverviewCreateData(bins, 2, 0, 100, &length);
+
+    overview = HugOverviewCreate(data, length);
+    HugTestAssert(overview != NULL && HugOverviewGetBinCount(overview) == 0);
+
+    HugOverviewFree(overview);
+    free(data);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testRoundTrip);
+    HugTestRun(testRejectsDamage);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,799 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+
+#include "HugFastUtils.h"
+#include "HugLevelMeter.h"
+#include "HugLimiter.h"
+#include "HugLinearRamper.h"
+#include "HugLookaheadLimiter.h"
+#include "HugLoudnessMeter.h"
+#include "HugRenderChain.h"
+#include "HugStereoField.h"
+#include "LoudnessMeasurer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define kFrameCount 512
+
+
+static void testLimiterCatchesOvers(void)
+{
+    HugLimiter *limiter = HugLimiterCreate();
+    HugLimiterSetSampleRate(limiter, 48000);
+
+    float left[kFrameCount], right[kFrameCount];
+
+    HugTestAssert(!HugLimiterIsActive(limiter));
+
+    // 16 blocks stays inside the 250ms hold time at 48 kHz
+    for (int block = 0; block < 16; block++) {
+        for (size_t i = 0; i < kFrameCount; i++) {
+            left[i]  = sinf(i * 0.05f) * 1.8f;
+            right[i] = cosf(i * 0.05f) * 0.5f;
+        }
+
+        HugLimiterProcess(limiter, left, right, kFrameCount);
+
+        // The block containing the over ramps towards the peak; every
+        // block after that must stay under full scale.
+        if (block > 0) {
+            for (size_t i = 0; i < kFrameCount; i++) {
+                HugTestAssert(fabsf(left[i])  < 1.0f);
+                HugTestAssert(fabsf(right[i]) < 1.0f);
+            }
+        }
+    }
+
+    HugTestAssert(HugLimiterIsActive(limiter));
+
+    HugLimiterReset(limiter);
+    HugTestAssert(!HugLimiterIsActive(limiter));
+
+    HugLimiterFree(limiter);
+}
+
+
+static void testLimiterPassesQuietAudio(void)
+{
+    HugLimiter *limiter = HugLimiterCreate();
+    HugLimiterSetSampleRate(limiter, 44100);
+
+    float left[kFrameCount], right[kFrameCount], original[kFrameCount];
+    uint32_t seed = 5;
+
+    for (size_t i = 0; i < kFrameCount; i++) {
+        left[i] = right[i] = original[i] = HugTestRandom(&seed) * 0.5f;
+    }
+
+    HugLimiterProcess(limiter, left, right, kFrameCount);
+
+    for (size_t i = 0; i < kFrameCount; i++) {
+        HugTestAssert(left[i]  == original[i]);
+        HugTestAssert(right[i] == original[i]);
+    }
+
+    HugTestAssert(!HugLimiterIsActive(limiter));
+    HugLimiterFree(limiter);
+}
+
+
+static void sFillLookaheadInput(float *left, float *right, size_t frameCount)
+{
+    uint32_t seed = 9;
+
+    // Quiet noise with a few isolated overs and one sustained loud section
+    for (size_t i = 0; i < frameCount; i++) {
+        left[i]  = HugTestRandom(&seed) * 0.3f;
+        right[i] = HugTestRandom(&seed) * 0.3f;
+
+        if (i % 1500 == 700) left[i]  =  2.5f;
+        if (i % 2100 == 40)  right[i] = -1.6f;
+
+        if (i >= 5000 && i < 6000) {
+            left[i]  = sinf(i * 0.07f) * 1.9f;
+            right[i] = cosf(i * 0.07f) * 1.2f;
+        }
+    }
+}
+
+
+static void testLookaheadLimiter(void)
+{
+    enum { kLookaheadFrameCount = 8192 };
+
+    HugLookaheadLimiter *limiter = HugLookaheadLimiterCreate();
+    HugLookaheadLimiterSetSampleRate(limiter, 48000);
+
+    HugTestAssert(HugLookaheadLimiterGetLatency(limiter) == 96);
+
+    // Clamped to 1-5 ms
+    HugLookaheadLimiterSetLookaheadTime(limiter, 0.02);
+    HugTestAssert(HugLookaheadLimiterGetLatency(limiter) == 240);
+    HugLookaheadLimiterSetLookaheadTime(limiter, 0.0);
+    HugTestAssert(HugLookaheadLimiterGetLatency(limiter) == 48);
+    HugLookaheadLimiterSetLookaheadTime(limiter, 0.003);
+
+    size_t latency = HugLookaheadLimiterGetLatency(limiter);
+    HugTestAssert(latency == 144);
+
+    float *inputLeft  = malloc(sizeof(float) * kLookaheadFrameCount);
+    float *inputRight = malloc(sizeof(float) * kLookaheadFrameCount);
+    float *expectedLeft  = malloc(sizeof(float) * kLookaheadFrameCount);
+    float *expectedRight = malloc(sizeof(float) * kLookaheadFrameCount);
+    float *left  = malloc(sizeof(float) * kLookaheadFrameCount);
+    float *right = malloc(sizeof(float) * kLookaheadFrameCount);
+
+    sFillLookaheadInput(inputLeft, inputRight, kLookaheadFrameCount);
+
+    memcpy(expectedLeft,  inputLeft,  sizeof(float) * kLookaheadFrameCount);
+    memcpy(expectedRight, inputRight, sizeof(float) * kLookaheadFrameCount);
+    HugLookaheadLimiterProcess(limiter, expectedLeft, expectedRight, kLookaheadFrameCount);
+
+    bool sawReduction = false;
+
+    for (size_t i = 0; i < kLookaheadFrameCount; i++) {
+        HugTestAssert(fabsf(expectedLeft[i])  < 1.0f);
+        HugTestAssert(fabsf(expectedRight[i]) < 1.0f);
+
+        if (i < latency) {
+            HugTestAssert(expectedLeft[i] == 0 && expectedRight[i] == 0);
+        } else if (fabsf(expectedLeft[i]) < fabsf(inputLeft[i - latency])) {
+            sawReduction = true;
+        }
+    }
+
+    HugTestAssert(sawReduction);
+
+    // The first over is at frame 40; audio before its look-ahead window
+    // must come through delayed and untouched.
+    for (size_t i = latency; i < 40; i++) {
+        HugTestAssert(expectedLeft[i]  == inputLeft[i - latency]);
+        HugTestAssert(expectedRight[i] == inputRight[i - latency]);
+    }
+
+    // Output must not depend on how the input is split into blocks
+    const size_t blockSizes[] = { 1, 7, 64, 97, 1024 };
+
+    for (size_t b = 0; b < sizeof(blockSizes) / sizeof(blockSizes[0]); b++) {
+        memcpy(left,  inputLeft,  sizeof(float) * kLookaheadFrameCount);
+        memcpy(right, inputRight, sizeof(float) * kLookaheadFrameCount);
+
+        HugLookaheadLimiterReset(limiter);
+
+        for (size_t offset = 0; offset < kLookaheadFrameCount; offset += blockSizes[b]) {
+            size_t frameCount = kLookaheadFrameCount - offset;
+            if (frameCount > blockSizes[b]) frameCount = blockSizes[b];
+
+            HugLookaheadLimiterProcess(limiter, left + offset, right + offset, frameCount);
+        }
+
+        HugTestAssert(!memcmp(left,  expectedLeft,  sizeof(float) * kLookaheadFrameCount));
+        HugTestAssert(!memcmp(right, expectedRight, sizeof(float) * kLookaheadFrameCount));
+    }
+
+    // Gain recovers once the overs stop
+    for (size_t i = 0; i < kLookaheadFrameCount; i++) {
+        left[i] = right[i] = 0.25f;
+    }
+
+    HugLookaheadLimiterProcess(limiter, left, right, kLookaheadFrameCount);
+    HugTestAssert(!HugLookaheadLimiterIsActive(limiter));
+    HugTestAssert(left[kLookaheadFrameCount - 1] == 0.25f);
+
+    free(inputLeft);
+    free(inputRight);
+    free(expectedLeft);
+    free(expectedRight);
+    free(left);
+    free(right);
+
+    HugLookaheadLimiterFree(limiter);
+}
+
+
+static void testLevelMeter(void)
+{
+    HugLevelMeter *meter = HugLevelMeterCreate();
+    HugLevelMeterSetSampleRate(meter, 48000);
+    HugLevelMeterSetMaxFrameCount(meter, kFrameCount);
+    HugLevelMeterSetAverageEnabled(meter, 1);
+
+    float samples[kFrameCount];
+    for (size_t i = 0; i < kFrameCount; i++) {
+        samples[i] = (i % 2) ? 0.5f : -0.5f;
+    }
+    samples[100] = -0.75f;
+
+    HugLevelMeterProcess(meter, samples, kFrameCount);
+
+    HugTestAssertClose(HugLevelMeterGetPeakLevel(meter), 0.75, 1e-6);
+    HugTestAssertClose(HugLevelMeterGetHeldLevel(meter), 0.75, 1e-6);
+    HugTestAssertClose(HugLevelMeterGetAverageLevel(meter), 0.5, 1e-3);
+
+    // Silence decays peak but keeps the held level
+    for (size_t i = 0; i < kFrameCount; i++) samples[i] = 0;
+    HugLevelMeterProcess(meter, samples, kFrameCount);
+
+    HugTestAssert(HugLevelMeterGetPeakLevel(meter) < 0.75f);
+    HugTestAssertClose(HugLevelMeterGetHeldLevel(meter), 0.75, 1e-6);
+
+    HugLevelMeterFree(meter);
+}
+
+
+static void sKeepMomentaryLoudness(void *context, size_t frameOffset, const HugMeterDataStruct *left, const HugMeterDataStruct *right)
+{
+    float *outLoudness = context;
+
+    HugTestAssert(left->momentaryLoudness == right->momentaryLoudness);
+    *outLoudness = left->momentaryLoudness;
+}
+
+
+// Render-sized buffers must read the same as the offline measurer
+static void testLoudnessMeter(void)
+{
+    enum { kRenderFrameCount = 64 };
+
+    double sampleRate = 48000;
+    size_t frameCount = sampleRate * 4;
+    float  amplitude  = powf(10.0f, -23.0f / 20.0f);
+
+    float *left  = malloc(sizeof(float) * frameCount);
+    float *right = malloc(sizeof(float) * frameCount);
+
+    for (size_t i = 0; i < frameCount; i++) {
+        left[i]  = amplitude * sinf(2.0f * M_PI * 1000.0f * (i / sampleRate));
+        right[i] = amplitude * cosf(2.0f * M_PI * 1000.0f * (i / sampleRate));
+    }
+
+    HugLoudnessMeter *meter = HugLoudnessMeterCreate();
+    HugLoudnessMeterSetSampleRate(meter, sampleRate);
+
+    HugLoudnessMeter *monoMeter = HugLoudnessMeterCreate();
+    HugLoudnessMeterSetSampleRate(monoMeter, sampleRate);
+
+    LoudnessMeasurer *measurer = LoudnessMeasurerCreateWithGating(2, sampleRate, 0, LoudnessMeasurerGatingHistogram);
+
+    bool readoutsMatch = true;
+
+    for (size_t offset = 0; offset < frameCount; offset += kRenderFrameCount) {
+        HugLoudnessMeterProcess(meter, left + offset, right + offset, kRenderFrameCount);
+        HugLoudnessMeterProcess(monoMeter, left + offset, NULL, kRenderFrameCount);
+
+        const float *channels[2] = { left + offset, right + offset };
+        LoudnessMeasurerScanAudioBuffer(measurer, channels, kRenderFrameCount);
+
+        if (offset == (size_t)(sampleRate * 0.3)) {
+            HugTestAssert(HugLoudnessMeterGetMomentaryLoudness(meter) == -HUGE_VALF);
+        }
+
+        float momentary = HugLoudnessMeterGetMomentaryLoudness(meter);
+        double expected = LoudnessMeasurerGetMomentaryLoudness(measurer);
+
+        if (expected == -HUGE_VAL) {
+            if (momentary != -HUGE_VALF) readoutsMatch = false;
+        } else if (fabs(momentary - expected) > 1e-4) {
+            readoutsMatch = false;
+        }
+    }
+
+    HugTestAssert(readoutsMatch);
+
+    // EBU Tech 3341, test case 1: -23 dBFS in both channels, -23 LUFS together
+    HugTestAssertClose(HugLoudnessMeterGetShortTermLoudness(meter), -23.0, 0.1);
+    HugTestAssertClose(HugLoudnessMeterGetShortTermLoudness(meter), LoudnessMeasurerGetShortTermLoudness(measurer), 1e-4);
+    HugTestAssertClose(HugLoudnessMeterGetMomentaryLoudness(monoMeter), -26.0, 0.1);
+
+    HugLoudnessMeterReset(meter);
+    HugTestAssert(HugLoudnessMeterGetShortTermLoudness(meter) == -HUGE_VALF);
+
+    // The render chain publishes it with the level meters
+    HugRenderChain *chain = HugRenderChainCreate();
+    HugRenderChainConfigure(chain, sampleRate, kRenderFrameCount);
+    HugRenderChainReset(chain, 1, 1, 0, 1);
+
+    float chainLoudness = 0;
+
+    for (size_t offset = 0; offset < frameCount; offset += kRenderFrameCount) {
+        HugRenderChainProcess(chain, left + offset, right + offset, kRenderFrameCount, 1, 0, 1, 1, sKeepMomentaryLoudness, &chainLoudness);
+    }
+
+    HugTestAssertClose(chainLoudness, LoudnessMeasurerGetMomentaryLoudness(measurer), 1e-4);
+
+    HugRenderChainFree(chain);
+    LoudnessMeasurerFree(measurer);
+    HugLoudnessMeterFree(meter);
+    HugLoudnessMeterFree(monoMeter);
+    free(left);
+    free(right);
+}
+
+
+static void testLinearRamper(void)
+{
+    HugLinearRamper *ramper = HugLinearRamperCreate();
+    HugLinearRamperSetMaxFrameCount(ramper, kFrameCount);
+    HugLinearRamperReset(ramper, 0.0f);
+
+    float left[kFrameCount], right[kFrameCount];
+    for (size_t i = 0; i < kFrameCount; i++) left[i] = right[i] = 1.0f;
+
+    HugLinearRamperProcess(ramper, left, right, kFrameCount, 1.0f);
+
+    HugTestAssertClose(left[0], 0.0, 1e-7);
+    HugTestAssertClose(left[kFrameCount - 1], 1.0, 1e-6);
+    HugTestAssertClose(right[kFrameCount / 2], (kFrameCount / 2) / (double)(kFrameCount - 1), 1e-6);
+
+    for (size_t i = 1; i < kFrameCount; i++) {
+        HugTestAssert(left[i] >= left[i - 1]);
+    }
+
+    // Steady level is a plain multiply
+    for (size_t i = 0; i < kFrameCount; i++) left[i] = right[i] = 0.5f;
+    HugLinearRamperProcess(ramper, left, right, kFrameCount, 1.0f);
+    HugTestAssert(left[0] == 0.5f && right[kFrameCount - 1] == 0.5f);
+
+    HugLinearRamperFree(ramper);
+}
+
+
+static void testStereoField(void)
+{
+    HugStereoField *field = HugStereoFieldCreate();
+    HugStereoFieldSetMaxFrameCount(field, kFrameCount);
+
+    float left[kFrameCount], right[kFrameCount];
+
+    // Width -1 swaps channels
+    HugStereoFieldReset(field, 0, -1);
+    for (size_t i = 0; i < kFrameCount; i++) { left[i] = 1.0f; right[i] = 0.0f; }
+    HugStereoFieldProcess(field, left, right, kFrameCount, 0, -1);
+    HugTestAssertClose(left[10], 0.0, 1e-7);
+    HugTestAssertClose(right[10], 1.0, 1e-7);
+
+    // Width 0 is mono
+    HugStereoFieldReset(field, 0, 0);
+    for (size_t i = 0; i < kFrameCount; i++) { left[i] = 1.0f; right[i] = 0.0f; }
+    HugStereoFieldProcess(field, left, right, kFrameCount, 0, 0);
+    HugTestAssertClose(left[10], 0.5, 1e-7);
+    HugTestAssertClose(right[10], 0.5, 1e-7);
+
+    // Hard right balance silences left
+    HugStereoFieldReset(field, 1, 1);
+    for (size_t i = 0; i < kFrameCount; i++) { left[i] = 1.0f; right[i] = 1.0f; }
+    HugStereoFieldProcess(field, left, right, kFrameCount, 1, 1);
+    HugTestAssertClose(left[10], 0.0, 1e-7);
+    HugTestAssertClose(right[10], 1.0, 1e-7);
+
+    HugStereoFieldFree(field);
+}
+
+
+// The original per-sample pow() implementation
+static void sReferenceStereoField(float *left, float *right, size_t frameCount, float fromBalance, float toBalance, float fromWidth, float toWidth)
+{
+    for (size_t i = 0; i < frameCount; i++) {
+        float t = (float)i / ((float)frameCount - 1);
+        float w = (fromWidth * (1.0f - t)) + (toWidth * t);
+        float b = (fromBalance * (1.0f - t)) + (toBalance * t);
+
+        float l = left[i];
+        float r = right[i];
+
+        if (fromWidth != 1.0 || toWidth != 1.0) {
+            const float myWidth    = (w + 1.0f) *  0.5f;
+            const float otherWidth = (w - 1.0f) * -0.5f;
+
+            left[i]  = (l * myWidth) + (r * otherWidth);
+            right[i] = (r * myWidth) + (l * otherWidth);
+        }
+
+        if (fromBalance != 0.0 || toBalance != 0.0) {
+            float m;
+
+            m = pow(1.0 - b, 3);
+            if (m < 1.0) left[i] *= m;
+
+            m = pow(1.0 + b, 3);
+            if (m < 1.0) right[i] *= m;
+        }
+    }
+}
+
+
+static void testStereoFieldMatchesReference(void)
+{
+    const size_t frameSizes[] = { 7, 64, 509, 4096 };
+    uint32_t seed = 7;
+
+    for (size_t f = 0; f < sizeof(frameSizes) / sizeof(frameSizes[0]); f++) {
+        size_t frameCount = frameSizes[f];
+
+        float *expectedLeft  = malloc(sizeof(float) * frameCount);
+        float *expectedRight = malloc(sizeof(float) * frameCount);
+        float *actualLeft    = malloc(sizeof(float) * frameCount);
+        float *actualRight   = malloc(sizeof(float) * frameCount);
+
+        HugStereoField *field = HugStereoFieldCreate();
+
+        // Every combination of off, steady and ramping width and balance
+        for (size_t combination = 0; combination < 9; combination++) {
+            size_t widthStage   = combination / 3;
+            size_t balanceStage = combination % 3;
+
+            float fromWidth   = widthStage   == 0 ? 1 : HugTestRandom(&seed);
+            float toWidth     = widthStage   == 2 ? HugTestRandom(&seed) : fromWidth;
+            float fromBalance = balanceStage == 0 ? 0 : HugTestRandom(&seed);
+            float toBalance   = balanceStage == 2 ? HugTestRandom(&seed) : fromBalance;
+
+            for (size_t i = 0; i < frameCount; i++) {
+                expectedLeft[i]  = actualLeft[i]  = HugTestRandom(&seed);
+                expectedRight[i] = actualRight[i] = HugTestRandom(&seed);
+            }
+
+            sReferenceStereoField(expectedLeft, expectedRight, frameCount, fromBalance, toBalance, fromWidth, toWidth);
+
+            HugStereoFieldReset(field, fromBalance, fromWidth);
+            HugStereoFieldProcess(field, actualLeft, actualRight, frameCount, toBalance, toWidth);
+
+            for (size_t i = 0; i < frameCount; i++) {
+                HugTestAssertClose(actualLeft[i],  expectedLeft[i],  2e-6);
+                HugTestAssertClose(actualRight[i], expectedRight[i], 2e-6);
+            }
+        }
+
+        HugStereoFieldFree(field);
+
+        free(expectedLeft);
+        free(expectedRight);
+        free(actualLeft);
+        free(actualRight);
+    }
+}
+
+
+static void testFade(void)
+{
+    float samples[kFrameCount];
+    for (size_t i = 0; i < kFrameCount; i++) samples[i] = 1.0f;
+
+    HugApplyFade(samples, kFrameCount, 1.0, 0.0);
+
+    HugTestAssertClose(samples[0], 1.0, 1e-7);
+    HugTestAssert(samples[kFrameCount - 1] < 1.1e-6f);
+
+    for (size_t i = 1; i < kFrameCount; i++) {
+        HugTestAssert(samples[i] < samples[i - 1]);
+    }
+
+    HugApplySilence(samples, kFrameCount);
+    HugTestAssert(samples[0] == 0 && samples[kFrameCount - 1] == 0);
+}
+
+
+static void testFadeCurves(void)
+{
+    const size_t frameSizes[] = { 5, 64, 1001, 8192 };
+
+    for (size_t f = 0; f < sizeof(frameSizes) / sizeof(frameSizes[0]); f++) {
+        size_t frameCount = frameSizes[f];
+
+        float *fadeOut = malloc(sizeof(float) * frameCount);
+        float *fadeIn  = malloc(sizeof(float) * frameCount);
+
+        // Exponential against the original double-precision recurrence
+        for (size_t i = 0; i < frameCount; i++) fadeOut[i] = 1.0f;
+        HugApplyFade(fadeOut, frameCount, 1.0, 0.0);
+
+        double multiplier = pow(pow(10.0, -120.0 / 20.0), 1 / (double)frameCount);
+        double env = 1.0;
+
+        for (size_t i = 0; i < frameCount; i++) {
+            HugTestAssertClose(fadeOut[i] / env, 1.0, 1e-5);
+            env *= multiplier;
+        }
+
+        // Equal power: out^2 + in^2 == 1 throughout a crossfade
+        for (size_t i = 0; i < frameCount; i++) fadeOut[i] = fadeIn[i] = 1.0f;
+        HugApplyFadeWithCurve(fadeOut, frameCount, 1.0, 0.0, HugFadeCurveEqualPower);
+        HugApplyFadeWithCurve(fadeIn,  frameCount, 0.0, 1.0, HugFadeCurveEqualPower);
+
+        HugTestAssertClose(fadeOut[0], 1.0, 1e-7);
+        HugTestAssertClose(fadeIn[0],  0.0, 1e-7);
+
+        for (size_t i = 0; i < frameCount; i++) {
+            HugTestAssertClose((fadeOut[i] * fadeOut[i]) + (fadeIn[i] * fadeIn[i]), 1.0, 1e-5);
+            HugTestAssertClose(fadeOut[i], cos((M_PI / 2.0) * i / frameCount), 1e-5);
+        }
+
+        // Linear
+        for (size_t i = 0; i < frameCount; i++) fadeOut[i] = 1.0f;
+        HugApplyFadeWithCurve(fadeOut, frameCount, 1.0, 0.0, HugFadeCurveLinear);
+
+        for (size_t i = 0; i < frameCount; i++) {
+            HugTestAssertClose(fadeOut[i], 1.0 - ((double)i / frameCount), 1e-6);
+        }
+
+        free(fadeOut);
+        free(fadeIn);
+    }
+}
+
+
+static size_t sRenderChainCallbackCount = 0;
+
+static void sRenderChainMeterCallback(void *context, size_t frameOffset, const HugMeterDataStruct *left, const HugMeterDataStruct *right)
+{
+    HugTestAssert(frameOffset == sRenderChainCallbackCount * 1024);
+    HugTestAssert(left->peakLevel > 0 && right->peakLevel > 0);
+    sRenderChainCallbackCount++;
+}
+
+
+static void testRenderChain(void)
+{
+    enum { kChainFrameCount = 2500 };
+
+    HugRenderChain *chain = HugRenderChainCreate();
+    HugRenderChainConfigure(chain, 48000, kChainFrameCount);
+    HugRenderChainReset(chain, 1, 1, 0, 1);
+
+    HugTestAssert(HugRenderChainGetMeterFrameCount(chain) == 1024);
+
+    float *left  = malloc(sizeof(float) * kChainFrameCount);
+    float *right = malloc(sizeof(float) * kChainFrameCount);
+
+    for (size_t i = 0; i < kChainFrameCount; i++) {
+        left[i] = right[i] = 0.5f;
+    }
+
+    // Unity gain, centered, full width: the chain must be transparent
+    HugRenderChainProcessSource(chain, left, right, kChainFrameCount, 1, 0, 1, false);
+    HugRenderChainProcessOutput(chain, left, right, kChainFrameCount, 1, sRenderChainMeterCallback, NULL);
+
+    HugTestAssert(sRenderChainCallbackCount == 3);
+    HugTestAssertClose(left[kChainFrameCount - 1], 0.5, 1e-6);
+    HugTestAssertClose(right[0], 0.5, 1e-6);
+
+    HugRenderChainProcessSource(chain, left, right, kChainFrameCount, 1, 0, 1, true);
+    HugTestAssert(fabsf(left[kChainFrameCount - 1]) < 1e-6f);
+
+    free(left);
+    free(right);
+
+    HugRenderChainFree(chain);
+}
+
+
+static void testRenderChainLookaheadLimiter(void)
+{
+    enum { kChainFrameCount = 2500 };
+
+    HugRenderChain *chain = HugRenderChainCreate();
+    HugRenderChainConfigure(chain, 48000, kChainFrameCount);
+    HugRenderChainReset(chain, 1, 1, 0, 1);
+
+    HugTestAssert(HugRenderChainGetLimiterMode(chain) == HugLimiterModeEmergency);
+    HugTestAssert(HugRenderChainGetLatency(chain) == 0);
+
+    HugRenderChainSetLimiterMode(chain, HugLimiterModeLookahead);
+    HugTestAssert(HugRenderChainGetLatency(chain) == 96);
+
+    float *left  = malloc(sizeof(float) * kChainFrameCount);
+    float *right = malloc(sizeof(float) * kChainFrameCount);
+
+    for (size_t i = 0; i < kChainFrameCount; i++) {
+        left[i] = right[i] = 0.5f;
+    }
+
+    HugRenderChainProcess(chain, left, right, kChainFrameCount, 1, 0, 1, 1, NULL, NULL);
+
+    HugTestAssert(left[95] == 0 && right[95] == 0);
+    HugTestAssert(left[96] == 0.5f && right[kChainFrameCount - 1] == 0.5f);
+
+    // Overs are caught before they reach the output, on the split path too
+    for (size_t i = 0; i < kChainFrameCount; i++) {
+        left[i]  = sinf(i * 0.05f) * 1.8f;
+        right[i] = cosf(i * 0.05f) * 0.5f;
+    }
+
+    HugRenderChainProcessSource(chain, left, right, kChainFrameCount, 1, 0, 1, false);
+    HugRenderChainProcessOutput(chain, left, right, kChainFrameCount, 1, NULL, NULL);
+
+    for (size_t i = 0; i < kChainFrameCount; i++) {
+        HugTestAssert(fabsf(left[i])  < 1.0f);
+        HugTestAssert(fabsf(right[i]) < 1.0f);
+    }
+
+    HugRenderChainSetLimiterMode(chain, HugLimiterModeEmergency);
+    HugTestAssert(HugRenderChainGetLatency(chain) == 0);
+
+    free(left);
+    free(right);
+
+    HugRenderChainFree(chain);
+}
+
+
+// The render chain as separate kernel passes, before they were fused
+typedef struct {
+    HugStereoField  *stereoField;
+    HugLinearRamper *preGainRamper;
+    HugLinearRamper *volumeRamper;
+    HugLevelMeter   *leftLevelMeter;
+    HugLevelMeter   *rightLevelMeter;
+    HugLimiter      *limiter;
+} ReferenceChain;
+
+typedef struct {
+    size_t count;
+    HugMeterDataStruct data[64];
+} MeterLog;
+
+
+static void sLogMeterData(void *context, size_t frameOffset, const HugMeterDataStruct *left, const HugMeterDataStruct *right)
+{
+    MeterLog *log = (MeterLog *)context;
+
+    if (log->count + 2 <= 64) {
+        log->data[log->count++] = *left;
+        log->data[log->count++] = *right;
+    }
+}
+
+
+static void sReferenceProcess(
+    ReferenceChain *chain,
+    float *left, float *right, size_t frameCount,
+    float preGain, float balance, float width, float volume,
+    MeterLog *log
+) {
+    HugStereoFieldProcess(chain->stereoField, left, right, frameCount, balance, width);
+    HugLinearRamperProcess(chain->preGainRamper, left, right, frameCount, preGain);
+    HugLinearRamperProcess(chain->volumeRamper, left, right, frameCount, volume);
+
+    for (size_t offset = 0; offset < frameCount; offset += 1024) {
+        size_t count = (frameCount - offset) < 1024 ? (frameCount - offset) : 1024;
+
+        HugLevelMeterProcess(chain->leftLevelMeter,  left  + offset, count);
+        HugLevelMeterProcess(chain->rightLevelMeter, right + offset, count);
+        HugLimiterProcess(chain->limiter, left + offset, right + offset, count);
+
+        HugMeterDataStruct leftData = {
+            HugLevelMeterGetPeakLevel(chain->leftLevelMeter),
+            HugLevelMeterGetHeldLevel(chain->leftLevelMeter),
+            HugLimiterIsActive(chain->limiter)
+        };
+
+        HugMeterDataStruct rightData = {
+            HugLevelMeterGetPeakLevel(chain->rightLevelMeter),
+            HugLevelMeterGetHeldLevel(chain->rightLevelMeter),
+            HugLimiterIsActive(chain->limiter)
+        };
+
+        sLogMeterData(log, offset, &leftData, &rightData);
+    }
+}
+
+
+static void testFusedRenderChainMatchesKernels(void)
+{
+    const size_t frameSizes[] = { 32, 61, 128, 512, 1024, 2048, 4096 };
+    uint32_t seed = 42;
+    bool sawLimiter = false;
+
+    for (size_t f = 0; f < sizeof(frameSizes) / sizeof(frameSizes[0]); f++) {
+        size_t frameCount = frameSizes[f];
+
+        ReferenceChain reference = {
+            HugStereoFieldCreate(), HugLinearRamperCreate(), HugLinearRamperCreate(),
+            HugLevelMeterCreate(), HugLevelMeterCreate(), HugLimiterCreate()
+        };
+
+        HugStereoFieldSetMaxFrameCount(reference.stereoField, frameCount);
+        HugLinearRamperSetMaxFrameCount(reference.preGainRamper, frameCount);
+        HugLinearRamperSetMaxFrameCount(reference.volumeRamper, frameCount);
+        HugLevelMeterSetSampleRate(reference.leftLevelMeter, 44100);
+        HugLevelMeterSetSampleRate(reference.rightLevelMeter, 44100);
+        HugLevelMeterSetMaxFrameCount(reference.leftLevelMeter, 1024);
+        HugLevelMeterSetMaxFrameCount(reference.rightLevelMeter, 1024);
+        HugLimiterSetSampleRate(reference.limiter, 44100);
+
+        HugRenderChain *chain = HugRenderChainCreate();
+        HugRenderChainConfigure(chain, 44100, frameCount);
+
+        HugLinearRamperReset(reference.preGainRamper, 1);
+        HugLinearRamperReset(reference.volumeRamper, 1);
+        HugStereoFieldReset(reference.stereoField, 0, 1);
+        HugRenderChainReset(chain, 1, 1, 0, 1);
+
+        float *expectedLeft  = malloc(sizeof(float) * frameCount);
+        float *expectedRight = malloc(sizeof(float) * frameCount);
+        float *actualLeft    = malloc(sizeof(float) * frameCount);
+        float *actualRight   = malloc(sizeof(float) * frameCount);
+
+        float preGain = 1, balance = 0, width = 1, volume = 1;
+
+        for (size_t block = 0; block < 48; block++) {
+            // Alternate between steady and moving parameters, with occasional overs
+            if ((block % 3) == 1) {
+                preGain = 0.5f + (HugTestRandom(&seed) * 0.4f);
+                volume  = 0.8f + (HugTestRandom(&seed) * 0.2f);
+            }
+
+            if ((block % 4) == 2) balance = HugTestRandom(&seed) * 0.8f;
+            if ((block % 5) == 3) width   = HugTestRandom(&seed);
+
+            float amplitude = (block % 7) == 5 ? 2.5f : 0.9f;
+
+            for (size_t i = 0; i < frameCount; i++) {
+                expectedLeft[i]  = actualLeft[i]  = HugTestRandom(&seed) * amplitude;
+                expectedRight[i] = actualRight[i] = HugTestRandom(&seed) * amplitude;
+            }
+
+            MeterLog expectedLog = {0};
+            MeterLog actualLog   = {0};
+
+            sReferenceProcess(&reference, expectedLeft, expectedRight, frameCount, preGain, balance, width, volume, &expectedLog);
+
+            if (block & 1) {
+                HugRenderChainProcess(chain, actualLeft, actualRight, frameCount, preGain, balance, width, volume, sLogMeterData, &actualLog);
+            } else {
+                HugRenderChainProcessSource(chain, actualLeft, actualRight, frameCount, preGain, balance, width, false);
+                HugRenderChainProcessOutput(chain, actualLeft, actualRight, frameCount, volume, sLogMeterData, &actualLog);
+            }
+
+            HugTestAssert(!memcmp(expectedLeft,  actualLeft,  sizeof(float) * frameCount));
+            HugTestAssert(!memcmp(expectedRight, actualRight, sizeof(float) * frameCount));
+
+            HugTestAssert(expectedLog.count == actualLog.count);
+
+            for (size_t i = 0; i < expectedLog.count; i++) {
+                HugTestAssert(expectedLog.data[i].peakLevel     == actualLog.data[i].peakLevel);
+                HugTestAssert(expectedLog.data[i].heldLevel     == actualLog.data[i].heldLevel);
+                HugTestAssert(expectedLog.data[i].limiterActive == actualLog.data[i].limiterActive);
+                sawLimiter = sawLimiter || actualLog.data[i].limiterActive;
+            }
+        }
+
+        free(expectedLeft);
+        free(expectedRight);
+        free(actualLeft);
+        free(actualRight);
+
+        HugRenderChainFree(chain);
+
+        HugStereoFieldFree(reference.stereoField);
+        HugLinearRamperFree(reference.preGainRamper);
+        HugLinearRamperFree(reference.volumeRamper);
+        HugLevelMeterFree(reference.leftLevelMeter);
+        HugLevelMeterFree(reference.rightLevelMeter);
+        HugLimiterFree(reference.limiter);
+    }
+
+    HugTestAssert(sawLimiter);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testLimiterCatchesOvers);
+    HugTestRun(testLimiterPassesQuietAudio);
+    HugTestRun(testLookaheadLimiter);
+    HugTestRun(testLevelMeter);
+    HugTestRun(testLoudnessMeter);
+    HugTestRun(testLinearRamper);
+    HugTestRun(testStereoField);
+    HugTestRun(testStereoFieldMatchesReference);
+    HugTestRun(testFade);
+    HugTestRun(testFadeCurves);
+    HugTestRun(testRenderChain);
+    HugTestRun(testRenderChainLookaheadLimiter);
+    HugTestRun(testFusedRenderChainMatchesKernels);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,187 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugRingBuffer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define kThreadedPacketCount 200000
+
+
+typedef struct {
+    uint64_t sequence;
+    uint16_t type;
+    uint8_t  payload[30];
+} TestPacket;
+
+
+static void sFillPacket(TestPacket *packet, uint64_t sequence)
+{
+    memset(packet, 0, sizeof(TestPacket));
+
+    packet->sequence = sequence;
+    packet->type = (uint16_t)(sequence * 7);
+
+    for (size_t i = 0; i < sizeof(packet->payload); i++) {
+        packet->payload[i] = (uint8_t)(sequence + i);
+    }
+}
+
+
+static void testCapacity(void)
+{
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+    HugRingBuffer *buffer = HugRingBufferCreate(8196);
+    HugTestAssert(buffer != NULL);
+
+    size_t capacity = HugRingBufferGetCapacity(buffer);
+    HugTestAssert(capacity >= 8196);
+    HugTestAssert((capacity % pageSize) == 0);
+
+    // Empty: nothing to read, everything can be written
+    HugTestAssert(HugRingBufferGetReadPtr(buffer, 1) == NULL);
+    HugTestAssert(HugRingBufferGetWritePtr(buffer, capacity) != NULL);
+    HugTestAssert(HugRingBufferGetWritePtr(buffer, capacity + 1) == NULL);
+
+    HugRingBufferFree(buffer);
+}
+
+
+static void testMirroredWrap(void)
+{
+    HugRingBuffer *buffer = HugRingBufferCreate(1);
+    size_t capacity = HugRingBufferGetCapacity(buffer);
+
+    // An odd packet size makes every write land at a different offset,
+    // including ones that straddle the end of the first mapping.
+    //
+    uint8_t input[61], output[61];
+    uint64_t sequence = 0;
+
+    for (size_t i = 0; i < (capacity / sizeof(input)) * 9; i++) {
+        for (size_t j = 0; j < sizeof(input); j++) {
+            input[j] = (uint8_t)(sequence + j);
+        }
+
+        HugTestAssert(HugRingBufferWrite(buffer, input, sizeof(input)));
+        HugTestAssert(HugRingBufferRead(buffer, output, sizeof(output)));
+        HugTestAssert(!memcmp(input, output, sizeof(input)));
+
+        sequence++;
+    }
+
+    // Writes through the pointer must be visible contiguously past the end
+    uint8_t *writePtr = HugRingBufferGetWritePtr(buffer, capacity);
+    HugTestAssert(writePtr != NULL);
+
+    for (size_t i = 0; i < capacity; i++) writePtr[i] = (uint8_t)(i * 3);
+    HugRingBufferConfirmWrite(buffer, capacity);
+
+    HugTestAssert(HugRingBufferGetWritePtr(buffer, 1) == NULL);
+
+    uint8_t *readPtr = HugRingBufferGetReadPtr(buffer, capacity);
+    HugTestAssert(readPtr == writePtr);
+
+    bool matches = true;
+    for (size_t i = 0; i < capacity; i++) matches = matches && (readPtr[i] == (uint8_t)(i * 3));
+    HugTestAssert(matches);
+
+    HugRingBufferConfirmRead(buffer, capacity);
+    HugTestAssert(HugRingBufferGetReadPtr(buffer, 1) == NULL);
+
+    HugRingBufferFree(buffer);
+}
+
+
+static void testFullAndConfirmReadAll(void)
+{
+    HugRingBuffer *buffer = HugRingBufferCreate(4096);
+    size_t capacity = HugRingBufferGetCapacity(buffer);
+
+    TestPacket packet;
+    size_t written = 0;
+
+    while (1) {
+        sFillPacket(&packet, written);
+        if (!HugRingBufferWrite(buffer, &packet, sizeof(packet))) break;
+        written++;
+    }
+
+    HugTestAssert(written == capacity / sizeof(TestPacket));
+
+    // Reading one packet frees exactly enough room for one more
+    HugTestAssert(HugRingBufferRead(buffer, &packet, sizeof(packet)));
+    HugTestAssert(packet.sequence == 0);
+    HugTestAssert(HugRingBufferWrite(buffer, &packet, sizeof(packet)));
+
+    HugRingBufferConfirmReadAll(buffer);
+    HugTestAssert(HugRingBufferGetReadPtr(buffer, 1) == NULL);
+    HugTestAssert(HugRingBufferGetWritePtr(buffer, capacity) != NULL);
+
+    HugRingBufferFree(buffer);
+}
+
+
+static void *sProducerMain(void *context)
+{
+    HugRingBuffer *buffer = context;
+    TestPacket packet;
+
+    for (uint64_t sequence = 0; sequence < kThreadedPacketCount; sequence++) {
+        sFillPacket(&packet, sequence);
+
+        while (!HugRingBufferWrite(buffer, &packet, sizeof(packet))) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+
+static void testThreadedOrdering(void)
+{
+    HugRingBuffer *buffer = HugRingBufferCreate(4096);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, sProducerMain, buffer);
+
+    TestPacket packet, expected;
+    size_t mismatches = 0;
+
+    for (uint64_t sequence = 0; sequence < kThreadedPacketCount; ) {
+        if (!HugRingBufferRead(buffer, &packet, sizeof(packet))) {
+            sched_yield();
+            continue;
+        }
+
+        sFillPacket(&expected, sequence);
+        if (memcmp(&packet, &expected, sizeof(packet))) mismatches++;
+
+        sequence++;
+    }
+
+    pthread_join(producer, NULL);
+
+    HugTestAssert(mismatches == 0);
+    HugTestAssert(HugRingBufferGetReadPtr(buffer, 1) == NULL);
+
+    HugRingBufferFree(buffer);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testCapacity);
+    HugTestRun(testMirroredWrap);
+    HugTestRun(testFullAndConfirmReadAll);
+    HugTestRun(testThreadedOrdering);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,161 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugSetlistTiming.h"
+
+#include <stdlib.h>
+
+
+static double sGetNaiveEndTime(const double *spans, size_t index)
+{
+    double sum = 0;
+
+    for (size_t i = 0; i <= index; i++) {
+        sum += spans[i];
+    }
+
+    return sum;
+}
+
+
+static void testEmpty(void)
+{
+    HugSetlistTiming *timing = HugSetlistTimingCreate();
+
+    HugTestAssert(HugSetlistTimingGetCount(timing) == 0);
+    HugTestAssert(HugSetlistTimingGetEndTime(timing, 0) == 0);
+    HugTestAssert(HugSetlistTimingGetSpan(timing, 3) == 0);
+
+    // Ignored rather than written past the end
+    HugSetlistTimingSetSpan(timing, 0, 10);
+    HugTestAssert(HugSetlistTimingGetEndTime(timing, 0) == 0);
+
+    HugTestAssert(HugSetlistTimingReset(timing, NULL, 0));
+    HugTestAssert(HugSetlistTimingGetCount(timing) == 0);
+
+    HugSetlistTimingFree(timing);
+}
+
+
+static void testEndTimes(void)
+{
+    double spans[] = { 180, 3, 240.5, 0, 200 };
+
+    HugSetlistTiming *timing = HugSetlistTimingCreate();
+    HugTestAssert(HugSetlistTimingReset(timing, spans, 5));
+
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 0), 180,   0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 2), 423.5, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 4), 623.5, 0);
+
+    // Past the end is the total
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 99), 623.5, 0);
+
+    // Only entries from the changed one onward move
+    HugSetlistTimingSetSpan(timing, 1, 10);
+
+    HugTestAssertClose(HugSetlistTimingGetSpan(timing, 1), 10, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 0), 180,   0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 1), 190,   0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 4), 630.5, 0);
+
+    HugSetlistTimingFree(timing);
+}
+
+
+// The playing track's span is its remaining time when the spans were taken.
+// Editing it later must not lose the time that has elapsed since.
+//
+static void testEditPlayingTrack(void)
+{
+    // Played, playing with 200 s left, then two queued tracks
+    double spans[] = { 0, 200, 184, 244 };
+    double startTime = 1000;
+
+    HugSetlistTiming *timing = HugSetlistTimingCreate();
+    HugTestAssert(HugSetlistTimingReset(timing, spans, 4));
+    HugSetlistTimingSetStartTime(timing, startTime);
+
+    HugTestAssertClose(HugSetlistTimingGetStartTime(timing), 1000, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 1), 1200, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 3), 1628, 0);
+
+    // 50 s later, the expected duration drops by 30 s: 120 s remain
+    double now = startTime + 50;
+    HugSetlistTimingSetEndTime(timing, 1, now + 120);
+
+    HugTestAssertClose(HugSetlistTimingGetSpan(timing, 1),    170,  0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 0), 1000, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 1), 1170, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 2), 1354, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 3), 1598, 0);
+
+    // A queued track after that moves only what follows it
+    HugSetlistTimingSetSpan(timing, 2, 190);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 1), 1170, 0);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 3), 1604, 0);
+
+    // Ending before the entries ahead of it leaves an empty span
+    HugSetlistTimingSetEndTime(timing, 1, startTime - 10);
+    HugTestAssertClose(HugSetlistTimingGetSpan(timing, 1), 0, 0);
+
+    // Ignored past the end
+    HugSetlistTimingSetEndTime(timing, 4, 5000);
+    HugTestAssertClose(HugSetlistTimingGetEndTime(timing, 99), 1434, 0);
+
+    HugSetlistTimingFree(timing);
+}
+
+
+// Random edits and resizes against plain sums, through enough updates to rebuild
+static void testMatchesNaive(void)
+{
+    uint32_t seed = 99;
+
+    size_t counts[] = { 1, 2, 7, 64, 1000, 3 };
+    HugSetlistTiming *timing = HugSetlistTimingCreate();
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t count = counts[c];
+        double *spans = malloc(count * sizeof(double));
+
+        for (size_t i = 0; i < count; i++) {
+            spans[i] = 300 + (HugTestRandom(&seed) * 240);
+        }
+
+        HugTestAssert(HugSetlistTimingReset(timing, spans, count));
+
+        size_t mismatches = 0;
+
+        for (size_t update = 0; update < 5000; update++) {
+            size_t index = (size_t)((HugTestRandom(&seed) + 1) * 0.5 * count) % count;
+            spans[index] = 300 + (HugTestRandom(&seed) * 240);
+
+            HugSetlistTimingSetSpan(timing, index, spans[index]);
+
+            size_t query = (size_t)((HugTestRandom(&seed) + 1) * 0.5 * count) % count;
+            double expected = sGetNaiveEndTime(spans, query);
+
+            if (fabs(HugSetlistTimingGetEndTime(timing, query) - expected) > 1e-6) mismatches++;
+        }
+
+        HugTestAssert(mismatches == 0);
+        HugTestAssertClose(HugSetlistTimingGetEndTime(timing, count - 1), sGetNaiveEndTime(spans, count - 1), 1e-6);
+
+        free(spans);
+    }
+
+    HugSetlistTimingFree(timing);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testEmpty);
+    HugTestRun(testEndTimes);
+    HugTestRun(testEditPlayingTrack);
+    HugTestRun(testMatchesNaive);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,458 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugStateStore.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define kNumberCount 5
+#define kBlobCount   3
+
+
+static char sDirectoryPath[PATH_MAX];
+static char sStorePath[PATH_MAX];
+
+
+static HugStateStoreID sMakeID(uint32_t value)
+{
+    HugStateStoreID itemID;
+
+    memset(&itemID, 0xa5, sizeof(itemID));
+    memcpy(&itemID, &value, sizeof(value));
+
+    return itemID;
+}
+
+
+static HugStateStore *sOpen(void)
+{
+    return HugStateStoreOpen(sStorePath, kNumberCount, kBlobCount);
+}
+
+
+static uint64_t sGetFileLength(void)
+{
+    struct stat st;
+    return (stat(sStorePath, &st) == 0) ? st.st_size : 0;
+}
+
+
+static void sRemoveStore(void)
+{
+    DIR *directory = opendir(sDirectoryPath);
+    struct dirent *item;
+
+    while (directory && (item = readdir(directory))) {
+        if (item->d_name[0] == '.') continue;
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", sDirectoryPath, item->d_name);
+        unlink(path);
+    }
+
+    if (directory) closedir(directory);
+}
+
+
+static bool sHasBlob(HugStateStore *store, HugStateStoreID itemID, size_t field, const char *expected)
+{
+    size_t length = 0;
+    char *bytes = HugStateStoreCopyBlob(store, itemID, field, &length);
+
+    bool result = bytes && (length == strlen(expected)) && !memcmp(bytes, expected, length);
+    free(bytes);
+
+    return result;
+}
+
+
+static void testNumbersAndBlobs(void)
+{
+    HugStateStore *store = sOpen();
+    HugTestAssert(store != NULL);
+
+    HugStateStoreID a = sMakeID(1);
+    HugStateStoreID b = sMakeID(2);
+
+    double numbers[kNumberCount] = { 1, 2, 3, 4, 5 };
+    HugTestAssert(HugStateStoreWriteNumbers(store, a, 0x5, numbers));
+
+    // Only fields in the mask change
+    double update[kNumberCount] = { 10, 20, 30, 40, 50 };
+    HugTestAssert(HugStateStoreWriteNumbers(store, a, 0x6, update));
+
+    HugTestAssert(HugStateStoreWriteBlob(store, a, 0, "title", 5));
+    HugTestAssert(HugStateStoreWriteBlob(store, a, 2, "overview", 8));
+    HugTestAssert(HugStateStoreWriteBlob(store, a, 2, "overview2", 9));
+    HugTestAssert(HugStateStoreWriteBlob(store, b, 1, "", 0));
+
+    HugTestAssert(HugStateStoreWriteBlob(store, b, 0, "removed", 7));
+    HugTestAssert(HugStateStoreWriteBlob(store, b, 0, NULL, 0));
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint64_t mask = 0;
+        double read[kNumberCount];
+
+        HugTestAssert(HugStateStoreReadNumbers(store, a, &mask, read));
+        HugTestAssert(mask == 0x7);
+        HugTestAssert(read[0] == 1 && read[1] == 20 && read[2] == 30 && read[3] == 0 && read[4] == 0);
+
+        HugTestAssert(HugStateStoreReadNumbers(store, b, &mask, read));
+        HugTestAssert(mask == 0);
+
+        HugTestAssert( sHasBlob(store, a, 0, "title"));
+        HugTestAssert(!sHasBlob(store, a, 1, ""));
+        HugTestAssert( sHasBlob(store, a, 2, "overview2"));
+        HugTestAssert( sHasBlob(store, b, 1, ""));
+        HugTestAssert(!HugStateStoreCopyBlob(store, b, 0, NULL));
+
+        HugTestAssert(!HugStateStoreHasItem(store, sMakeID(3)));
+        HugTestAssert(HugStateStoreGetStats(store).itemCount == 2);
+
+        // Everything survives a reopen
+        HugStateStoreFree(store);
+        store = sOpen();
+    }
+
+    HugTestAssert(!HugStateStoreWriteBlob(store, a, kBlobCount, "x", 1));
+
+    HugStateStoreFree(store);
+    sRemoveStore();
+}
+
+
+static void testRemoveAndList(void)
+{
+    HugStateStore *store = sOpen();
+
+    HugStateStoreID ids[3] = { sMakeID(1), sMakeID(2), sMakeID(3) };
+    double numbers[kNumberCount] = { 7 };
+
+    for (size_t i = 0; i < 3; i++) {
+        HugStateStoreWriteNumbers(store, ids[i], 0x1, numbers);
+        HugStateStoreWriteBlob(store, ids[i], 0, "x", 1);
+    }
+
+    HugTestAssert(HugStateStoreWriteList(store, ids, 2));
+    HugTestAssert(HugStateStoreWriteList(store, ids, 3));
+    HugTestAssert(HugStateStoreRemoveItem(store, ids[1]));
+
+    // A removed item comes back empty
+    HugTestAssert(HugStateStoreWriteBlob(store, ids[1], 1, "y", 1));
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint64_t mask = 0;
+        double read[kNumberCount];
+
+        HugTestAssert(HugStateStoreReadNumbers(store, ids[1], &mask, read));
+        HugTestAssert(mask == 0 && read[0] == 0);
+        HugTestAssert(!sHasBlob(store, ids[1], 0, "x"));
+        HugTestAssert( sHasBlob(store, ids[1], 1, "y"));
+
+        size_t count = 0;
+        HugStateStoreID *list = HugStateStoreCopyList(store, &count);
+
+        HugTestAssert(count == 3);
+        HugTestAssert(list && !memcmp(list, ids, sizeof(ids)));
+        free(list);
+
+        HugStateStoreFree(store);
+        store = sOpen();
+    }
+
+    HugTestAssert(HugStateStoreRemoveItem(store, ids[0]));
+    HugTestAssert(!HugStateStoreHasItem(store, ids[0]));
+    HugTestAssert(HugStateStoreGetStats(store).itemCount == 2);
+
+    HugTestAssert(HugStateStoreRemoveAll(store));
+    HugTestAssert(!HugStateStoreHasItem(store, ids[2]));
+    HugTestAssert(!HugStateStoreCopyList(store, NULL));
+
+    HugStateStoreWriteBlob(store, ids[2], 0, "z", 1);
+    HugStateStoreFree(store);
+
+    store = sOpen();
+    HugTestAssert(HugStateStoreGetStats(store).itemCount == 1);
+    HugTestAssert(sHasBlob(store, ids[2], 0, "z"));
+
+    HugStateStoreFree(store);
+    sRemoveStore();
+}
+
+
+static void testTornAppend(void)
+{
+    HugStateStore *store = sOpen();
+
+    HugStateStoreWriteBlob(store, sMakeID(1), 0, "first", 5);
+    uint64_t goodLength = sGetFileLength();
+
+    HugStateStoreWriteBlob(store, sMakeID(2), 0, "second", 6);
+    HugStateStoreFree(store);
+
+    // Cut the last record short, as a crash mid-write would
+    HugTestAssert(truncate(sStorePath, goodLength + 20) == 0);
+
+    store = sOpen();
+    HugTestAssert(sHasBlob(store, sMakeID(1), 0, "first"));
+    HugTestAssert(!HugStateStoreHasItem(store, sMakeID(2)));
+    HugTestAssert(sGetFileLength() == goodLength);
+
+    // New records follow the last good one
+    HugStateStoreWriteBlob(store, sMakeID(3), 0, "third", 5);
+    HugStateStoreFree(store);
+
+    store = sOpen();
+    HugTestAssert(sHasBlob(store, sMakeID(3), 0, "third"));
+    HugStateStoreFree(store);
+
+    // Anything else is replaced by an empty store
+    FILE *file = fopen(sStorePath, "wb");
+    fputs("not a store", file);
+    fclose(file);
+
+    store = sOpen();
+    HugTestAssert(store && HugStateStoreGetStats(store).itemCount == 0);
+    HugStateStoreFree(store);
+
+    sRemoveStore();
+}
+
+
+static void testDamagedHeap(void)
+{
+    HugStateStore *store = sOpen();
+
+    // Large blobs are stored out of line
+    uint8_t blob[10000];
+    memset(blob, 7, sizeof(blob));
+
+    HugStateStoreWriteBlob(store, sMakeID(1), 2, blob, sizeof(blob));
+    HugStateStoreWriteBlob(store, sMakeID(2), 2, blob, sizeof(blob));
+    HugStateStoreWriteBlob(store, sMakeID(2), 0, "after", 5);
+    HugStateStoreFree(store);
+
+    HugTestAssert(sGetFileLength() < sizeof(blob));
+
+    char heapPath[PATH_MAX + 16];
+    snprintf(heapPath, sizeof(heapPath), "%s.0.heap", sStorePath);
+    HugTestAssert(truncate(heapPath, sizeof(blob) + 10) == 0);
+
+    // Only the blob that was cut off is lost
+    store = sOpen();
+
+    size_t length = 0;
+    uint8_t *copy = HugStateStoreCopyBlob(store, sMakeID(1), 2, &length);
+    HugTestAssert(copy && length == sizeof(blob) && !memcmp(copy, blob, length));
+    free(copy);
+
+    HugTestAssert(!HugStateStoreCopyBlob(store, sMakeID(2), 2, NULL));
+    HugTestAssert(sHasBlob(store, sMakeID(2), 0, "after"));
+
+    HugStateStoreFree(store);
+    sRemoveStore();
+}
+
+
+static void testFieldsAdded(void)
+{
+    HugStateStore *store = HugStateStoreOpen(sStorePath, 2, 1);
+
+    double numbers[2] = { 3, 4 };
+    HugStateStoreWriteNumbers(store, sMakeID(1), 0x3, numbers);
+    HugStateStoreWriteBlob(store, sMakeID(1), 0, "a", 1);
+    HugStateStoreFree(store);
+
+    store = sOpen();
+
+    uint64_t mask = 0;
+    double read[kNumberCount];
+
+    HugTestAssert(HugStateStoreReadNumbers(store, sMakeID(1), &mask, read));
+    HugTestAssert(mask == 0x3 && read[0] == 3 && read[1] == 4 && read[4] == 0);
+    HugTestAssert(sHasBlob(store, sMakeID(1), 0, "a"));
+
+    HugStateStoreFree(store);
+    sRemoveStore();
+}
+
+
+static void testCompaction(void)
+{
+    HugStateStore *store = sOpen();
+
+    size_t blobLength = 100 * 1024;
+    uint8_t *blob = malloc(blobLength);
+
+    // Rewriting the same fields only adds garbage
+    for (uint8_t pass = 0; pass < 40; pass++) {
+        memset(blob, pass, blobLength);
+
+        for (uint32_t i = 0; i < 4; i++) {
+            double numbers[kNumberCount] = { pass, i };
+
+            HugStateStoreWriteNumbers(store, sMakeID(i), 0x3, numbers);
+            HugStateStoreWriteBlob(store, sMakeID(i), 2, blob, blobLength);
+        }
+
+        HugTestAssert(!HugStateStoreNeedsCompaction(store) || pass > 0);
+    }
+
+    HugStateStoreID ids[2] = { sMakeID(3), sMakeID(0) };
+    HugStateStoreWriteList(store, ids, 2);
+
+    HugTestAssert(HugStateStoreNeedsCompaction(store));
+
+    HugStateStoreStats before = HugStateStoreGetStats(store);
+    HugTestAssert(HugStateStoreCompact(store));
+    HugStateStoreStats after = HugStateStoreGetStats(store);
+
+    HugTestAssert(!HugStateStoreNeedsCompaction(store));
+    HugTestAssert(after.itemCount == 4);
+    HugTestAssert(after.compactions == 1);
+    HugTestAssert(after.fileBytes == after.liveBytes);
+    HugTestAssert(after.liveBytes == before.liveBytes);
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < 4; i++) {
+            uint64_t mask = 0;
+            double read[kNumberCount];
+
+            HugTestAssert(HugStateStoreReadNumbers(store, sMakeID(i), &mask, read));
+            HugTestAssert(mask == 0x3 && read[0] == 39 && read[1] == i);
+
+            size_t length = 0;
+            uint8_t *copy = HugStateStoreCopyBlob(store, sMakeID(i), 2, &length);
+            HugTestAssert(copy && length == blobLength && copy[0] == 39 && copy[blobLength - 1] == 39);
+            free(copy);
+        }
+
+        size_t count = 0;
+        HugStateStoreID *list = HugStateStoreCopyList(store, &count);
+        HugTestAssert(count == 2 && list && !memcmp(list, ids, sizeof(ids)));
+        free(list);
+
+        HugStateStoreFree(store);
+        store = sOpen();
+    }
+
+    HugStateStoreFree(store);
+    free(blob);
+
+    sRemoveStore();
+}
+
+
+typedef struct {
+    HugStateStore *store;
+    atomic_bool    done;
+} WriterContext;
+
+
+static void *sWriterMain(void *context)
+{
+    WriterContext *writer = context;
+    uint32_t pass = 0;
+
+    while (!atomic_load(&writer->done)) {
+        for (uint32_t i = 0; i < 16; i++) {
+            double numbers[kNumberCount] = { pass, i };
+            HugStateStoreWriteNumbers(writer->store, sMakeID(i), 0x3, numbers);
+        }
+
+        pass++;
+    }
+
+    // Final values, written after every compaction has finished
+    for (uint32_t i = 0; i < 16; i++) {
+        double numbers[kNumberCount] = { -1, i };
+        HugStateStoreWriteNumbers(writer->store, sMakeID(i), 0x3, numbers);
+    }
+
+    return NULL;
+}
+
+
+static void testConcurrentCompaction(void)
+{
+    HugStateStore *store = sOpen();
+
+    size_t blobLength = 64 * 1024;
+    uint8_t *blob = calloc(1, blobLength);
+
+    for (uint32_t i = 0; i < 16; i++) {
+        blob[0] = i;
+        HugStateStoreWriteBlob(store, sMakeID(i), 1, blob, blobLength);
+    }
+
+    WriterContext context = { store, false };
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, sWriterMain, &context);
+
+    for (int i = 0; i < 20; i++) {
+        HugTestAssert(HugStateStoreCompact(store));
+    }
+
+    atomic_store(&context.done, true);
+    pthread_join(thread, NULL);
+
+    for (int pass = 0; pass < 2; pass++) {
+        HugTestAssert(HugStateStoreGetStats(store).itemCount == 16);
+
+        for (uint32_t i = 0; i < 16; i++) {
+            uint64_t mask = 0;
+            double read[kNumberCount];
+
+            HugTestAssert(HugStateStoreReadNumbers(store, sMakeID(i), &mask, read));
+            HugTestAssert(read[0] == -1 && read[1] == i);
+
+            size_t length = 0;
+            uint8_t *copy = HugStateStoreCopyBlob(store, sMakeID(i), 1, &length);
+            HugTestAssert(copy && length == blobLength && copy[0] == i);
+            free(copy);
+        }
+
+        HugStateStoreCompact(store);
+        HugStateStoreFree(store);
+        store = sOpen();
+    }
+
+    HugStateStoreFree(store);
+    free(blob);
+
+    sRemoveStore();
+}
+
+
+int main(int argc, const char *argv[])
+{
+    snprintf(sDirectoryPath, sizeof(sDirectoryPath), "%s/StateStoreTests.XXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+
+    if (!mkdtemp(sDirectoryPath)) {
+        fprintf(stderr, "Could not create '%s'\n", sDirectoryPath);
+        return 1;
+    }
+
+    snprintf(sStorePath, sizeof(sStorePath), "%s/Tracks.store", sDirectoryPath);
+
+    HugTestRun(testNumbersAndBlobs);
+    HugTestRun(testRemoveAndList);
+    HugTestRun(testTornAppend);
+    HugTestRun(testDamagedHeap);
+    HugTestRun(testFieldsAdded);
+    HugTestRun(testCompaction);
+    HugTestRun(testConcurrentCompaction);
+
+    rmdir(sDirectoryPath);
+
+    return HugTestFinish();
+}
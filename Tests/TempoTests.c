@@ -0,0 +1,122 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugTempo.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+// Decaying noise bursts on each beat, louder on the first of every four,
+// with quieter off-beats if requested
+static float *sCopyClickTrack(double bpm, double sampleRate, double seconds, bool offBeats, double noise)
+{
+    size_t frameCount = (size_t)(sampleRate * seconds);
+    float *samples = calloc(frameCount, sizeof(float));
+
+    uint32_t seed = 99;
+    double period = (60.0 * sampleRate) / bpm;
+    size_t clickLength = (size_t)(0.02 * sampleRate);
+
+    size_t beatCount = (size_t)(frameCount / period) + 1;
+
+    for (size_t beat = 0; beat < beatCount; beat++) {
+        for (size_t half = 0; half < (offBeats ? 2 : 1); half++) {
+            size_t first = (size_t)((beat + (half * 0.5)) * period);
+            double amplitude = half ? 0.15 : ((beat % 4) ? 0.5 : 0.8);
+
+            for (size_t i = 0; i < clickLength && (first + i) < frameCount; i++) {
+                samples[first + i] += amplitude * exp(-(double)i / (0.004 * sampleRate)) * HugTestRandom(&seed);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < frameCount; i++) {
+        samples[i] += noise * HugTestRandom(&seed);
+    }
+
+    return samples;
+}
+
+
+static bool sEstimate(const float *samples, size_t frameCount, double sampleRate, double *outBPM, double *outConfidence)
+{
+    HugTempo *tempo = HugTempoCreate(2, sampleRate);
+
+    // In uneven pieces, as the decoder hands them over
+    for (size_t offset = 0; offset < frameCount; ) {
+        size_t count = 1000 + (offset % 7919);
+        if (count > frameCount - offset) count = frameCount - offset;
+
+        const float *channels[2] = { samples + offset, samples + offset };
+        HugTestAssert(HugTempoProcess(tempo, channels, count));
+
+        offset += count;
+    }
+
+    bool result = HugTempoGetEstimate(tempo, outBPM, outConfidence);
+    HugTempoFree(tempo);
+
+    return result;
+}
+
+
+static void testClickTracks(void)
+{
+    double tempos[]      = { 72, 85.5, 100, 128, 140, 174 };
+    double sampleRates[] = { 44100, 48000 };
+
+    for (size_t r = 0; r < 2; r++) {
+        for (size_t t = 0; t < sizeof(tempos) / sizeof(tempos[0]); t++) {
+            double sampleRate = sampleRates[r];
+            size_t frameCount = (size_t)(sampleRate * 30);
+
+            float *samples = sCopyClickTrack(tempos[t], sampleRate, 30, (t % 2) == 1, 0.01);
+            double bpm = 0, confidence = 0;
+
+            HugTestAssert(sEstimate(samples, frameCount, sampleRate, &bpm, &confidence));
+            HugTestAssertClose(bpm, tempos[t], 0.5);
+            HugTestAssert(confidence > 0.5);
+
+            free(samples);
+        }
+    }
+}
+
+
+static void testNoOnsets(void)
+{
+    double sampleRate = 44100;
+    size_t frameCount = (size_t)(sampleRate * 20);
+    float *samples = calloc(frameCount, sizeof(float));
+
+    double bpm = 0, confidence = 0;
+
+    // Silence
+    HugTestAssert(!sEstimate(samples, frameCount, sampleRate, &bpm, &confidence));
+
+    // Noise correlates with nothing
+    uint32_t seed = 3;
+    for (size_t i = 0; i < frameCount; i++) samples[i] = 0.3 * HugTestRandom(&seed);
+
+    if (sEstimate(samples, frameCount, sampleRate, &bpm, &confidence)) {
+        HugTestAssert(confidence < 0.2);
+    }
+
+    // Too short
+    float *clicks = sCopyClickTrack(120, sampleRate, 8, false, 0);
+    HugTestAssert(!sEstimate(clicks, (size_t)(sampleRate * 8), sampleRate, &bpm, &confidence));
+
+    free(samples);
+    free(clicks);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testClickTracks);
+    HugTestRun(testNoOnsets);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,210 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugTitleIndex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static bool sIsSimilar(HugTitleIndex *index, size_t slot, size_t otherSlot)
+{
+    size_t count = 0;
+    size_t *similar = HugTitleIndexCopySimilar(index, slot, &count);
+    bool result = false;
+
+    for (size_t i = 0; i < count; i++) {
+        if (similar[i] == otherSlot) result = true;
+    }
+
+    free(similar);
+
+    return result;
+}
+
+
+static size_t sGetSimilarCount(HugTitleIndex *index, size_t slot)
+{
+    size_t count = 0;
+    free(HugTitleIndexCopySimilar(index, slot, &count));
+
+    return count;
+}
+
+
+static void testVariants(void)
+{
+    HugTitleIndex *index = HugTitleIndexCreate(0.6);
+
+    size_t song     = HugTitleIndexInsert(index, "the way you move");
+    size_t featured = HugTitleIndexInsert(index, "the way you move feat sleepy brown");
+    size_t remix    = HugTitleIndexInsert(index, "the way you move radio edit");
+    size_t typo     = HugTitleIndexInsert(index, "the way u move");
+    size_t exact    = HugTitleIndexInsert(index, "The Way You  Move");
+    size_t other    = HugTitleIndexInsert(index, "hey ya");
+
+    HugTestAssert(HugTitleIndexGetCount(index) == 6);
+
+    HugTestAssert(sIsSimilar(index, song, featured));
+    HugTestAssert(sIsSimilar(index, song, remix));
+    HugTestAssert(sIsSimilar(index, song, typo));
+    HugTestAssert(sIsSimilar(index, song, exact));
+    HugTestAssert(sIsSimilar(index, featured, song));
+    HugTestAssertClose(HugTitleIndexGetSimilarity(index, song, exact), 1, 0);
+
+    HugTestAssert(!sIsSimilar(index, song, other));
+    HugTestAssert(sGetSimilarCount(index, other) == 0);
+    HugTestAssert(sGetSimilarCount(index, song) == 4);
+
+    HugTitleIndexFree(index);
+}
+
+
+static void testWordsThatStay(void)
+{
+    HugTitleIndex *index = HugTitleIndexCreate(0.6);
+
+    // Only a trailing clause is dropped, and never the first word
+    size_t remix   = HugTitleIndexInsert(index, "remix");
+    size_t mix     = HugTitleIndexInsert(index, "mix");
+    size_t feat    = HugTitleIndexInsert(index, "feat");
+    size_t edited  = HugTitleIndexInsert(index, "edit the radio");
+    size_t station = HugTitleIndexInsert(index, "edit");
+    size_t empty   = HugTitleIndexInsert(index, "");
+    size_t blank   = HugTitleIndexInsert(index, "   ");
+
+    HugTestAssert(!sIsSimilar(index, remix, mix));
+    HugTestAssert(!sIsSimilar(index, feat, remix));
+    HugTestAssert(!sIsSimilar(index, edited, station));
+
+    HugTestAssert(sGetSimilarCount(index, empty) == 0);
+    HugTestAssert(sGetSimilarCount(index, blank) == 0);
+    HugTestAssert(HugTitleIndexGetSimilarity(index, empty, blank) == 0);
+
+    HugTitleIndexFree(index);
+}
+
+
+static void testRemove(void)
+{
+    HugTitleIndex *index = HugTitleIndexCreate(0.6);
+
+    size_t a = HugTitleIndexInsert(index, "crazy in love");
+    size_t b = HugTitleIndexInsert(index, "crazy in love feat jay z");
+    size_t c = HugTitleIndexInsert(index, "crazy in love");
+
+    HugTestAssert(sGetSimilarCount(index, a) == 2);
+
+    HugTitleIndexRemove(index, b);
+    HugTestAssert(sGetSimilarCount(index, a) == 1);
+    HugTestAssert(HugTitleIndexGetCount(index) == 2);
+
+    // Removing twice or out of range is ignored
+    HugTitleIndexRemove(index, b);
+    HugTitleIndexRemove(index, 1000);
+    HugTestAssert(HugTitleIndexGetCount(index) == 2);
+    HugTestAssert(sGetSimilarCount(index, b) == 0);
+
+    // The slot is reused
+    size_t d = HugTitleIndexInsert(index, "single ladies");
+    HugTestAssert(d == b);
+    HugTestAssert(sGetSimilarCount(index, d) == 0);
+    HugTestAssert(sIsSimilar(index, c, a));
+
+    HugTitleIndexFree(index);
+}
+
+
+// Random titles, inserted and removed through several table resizes,
+// against an exhaustive pairwise comparison
+static void testMatchesExhaustive(void)
+{
+    static const char * const words[] = {
+        "love", "night", "dance", "heart", "fire", "summer", "baby", "dream",
+        "light", "time", "home", "city", "rain", "gold", "wild", "blue"
+    };
+
+    uint32_t seed = 7;
+    size_t count = 600;
+
+    HugTitleIndex *index = HugTitleIndexCreate(0.6);
+    size_t *slots = malloc(count * sizeof(size_t));
+    bool   *alive = calloc(count, sizeof(bool));
+
+    for (size_t i = 0; i < count; i++) {
+        char title[128] = {0};
+        size_t wordCount = 2 + ((size_t)((HugTestRandom(&seed) + 1) * 1.5) % 3);
+
+        for (size_t w = 0; w < wordCount; w++) {
+            size_t word = (size_t)((HugTestRandom(&seed) + 1) * 8) % 16;
+            if (w) strcat(title, " ");
+            strcat(title, words[word]);
+        }
+
+        slots[i] = HugTitleIndexInsert(index, title);
+        alive[i] = true;
+
+        // Remove about one in five as we go
+        if (i && HugTestRandom(&seed) > 0.6) {
+            size_t victim = (size_t)((HugTestRandom(&seed) + 1) * 0.5 * i) % i;
+
+            if (alive[victim]) {
+                HugTitleIndexRemove(index, slots[victim]);
+                alive[victim] = false;
+            }
+        }
+    }
+
+    size_t missing = 0, extra = 0, expectedPairs = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!alive[i]) continue;
+
+        size_t similarCount = 0;
+        size_t *similar = HugTitleIndexCopySimilar(index, slots[i], &similarCount);
+
+        for (size_t s = 0; s < similarCount; s++) {
+            if (HugTitleIndexGetSimilarity(index, slots[i], similar[s]) < 0.6) extra++;
+        }
+
+        for (size_t j = 0; j < count; j++) {
+            if (j == i || !alive[j]) continue;
+            if (HugTitleIndexGetSimilarity(index, slots[i], slots[j]) < 0.6) continue;
+
+            expectedPairs++;
+
+            bool found = false;
+
+            for (size_t s = 0; s < similarCount; s++) {
+                if (similar[s] == slots[j]) found = true;
+            }
+
+            if (!found) missing++;
+        }
+
+        free(similar);
+    }
+
+    // Results are exact. With so few words, many pairs sit right at the
+    // threshold, where LSH misses the most, yet it still finds over nine in ten.
+    HugTestAssert(extra == 0);
+    HugTestAssert(expectedPairs > 0);
+    HugTestAssert(missing <= expectedPairs / 10);
+
+    free(slots);
+    free(alive);
+
+    HugTitleIndexFree(index);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testVariants);
+    HugTestRun(testWordsThatStay);
+    HugTestRun(testRemove);
+    HugTestRun(testMatchesExhaustive);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,184 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugTripleBuffer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kThreadedValueCount 500000
+
+
+typedef struct {
+    uint64_t sequence;
+    uint64_t words[15];
+} TestValue;
+
+
+static void sFillValue(TestValue *value, uint64_t sequence)
+{
+    value->sequence = sequence;
+
+    for (size_t i = 0; i < 15; i++) {
+        value->words[i] = sequence * 31 + i;
+    }
+}
+
+
+static bool sIsValueIntact(const TestValue *value)
+{
+    for (size_t i = 0; i < 15; i++) {
+        if (value->words[i] != value->sequence * 31 + i) return false;
+    }
+
+    return true;
+}
+
+
+static void testLatestValue(void)
+{
+    HugTripleBuffer *buffer = HugTripleBufferCreate(sizeof(TestValue));
+    HugTestAssert(buffer != NULL);
+    HugTestAssert(HugTripleBufferGetSize(buffer) == sizeof(TestValue));
+
+    TestValue value;
+    bool isNew;
+
+    // Nothing published yet: zeroed, not new
+    const TestValue *readPtr = HugTripleBufferGetReadPtr(buffer, &isNew);
+    HugTestAssert(!isNew);
+    HugTestAssert(readPtr->sequence == 0);
+
+    // Only the last of several writes is seen, and only once
+    for (uint64_t i = 1; i <= 5; i++) {
+        sFillValue(&value, i);
+        HugTripleBufferWrite(buffer, &value, sizeof(value));
+    }
+
+    memset(&value, 0, sizeof(value));
+    HugTestAssert(HugTripleBufferRead(buffer, &value, sizeof(value)));
+    HugTestAssert(value.sequence == 5);
+    HugTestAssert(sIsValueIntact(&value));
+
+    memset(&value, 0, sizeof(value));
+    HugTestAssert(!HugTripleBufferRead(buffer, &value, sizeof(value)));
+    HugTestAssert(value.sequence == 5);
+
+    // In-place writes through the write pointer
+    TestValue *writePtr = HugTripleBufferGetWritePtr(buffer);
+    sFillValue(writePtr, 6);
+    HugTripleBufferPublish(buffer);
+
+    readPtr = HugTripleBufferGetReadPtr(buffer, &isNew);
+    HugTestAssert(isNew);
+    HugTestAssert(readPtr->sequence == 6);
+    HugTestAssert(sIsValueIntact(readPtr));
+
+    HugTripleBufferFree(buffer);
+}
+
+
+static void testAlternating(void)
+{
+    HugTripleBuffer *buffer = HugTripleBufferCreate(sizeof(TestValue));
+
+    TestValue value;
+    size_t mismatches = 0;
+
+    // Every slot rotates through every role
+    for (uint64_t i = 1; i < 100; i++) {
+        sFillValue(&value, i);
+        HugTripleBufferWrite(buffer, &value, sizeof(value));
+
+        if (i % 3) {
+            memset(&value, 0, sizeof(value));
+
+            bool isNew = HugTripleBufferRead(buffer, &value, sizeof(value));
+            if (!isNew || value.sequence != i || !sIsValueIntact(&value)) mismatches++;
+        }
+    }
+
+    HugTestAssert(mismatches == 0);
+
+    HugTripleBufferFree(buffer);
+}
+
+
+typedef struct {
+    HugTripleBuffer *buffer;
+    atomic_bool finished;
+} ThreadedRun;
+
+
+static void *sProducerMain(void *context)
+{
+    ThreadedRun *run = context;
+
+    for (uint64_t sequence = 1; sequence <= kThreadedValueCount; sequence++) {
+        sFillValue(HugTripleBufferGetWritePtr(run->buffer), sequence);
+        HugTripleBufferPublish(run->buffer);
+
+        if ((sequence % 64) == 0) sched_yield();
+    }
+
+    atomic_store(&run->finished, true);
+
+    return NULL;
+}
+
+
+static void testThreadedNoTearing(void)
+{
+    ThreadedRun run;
+    run.buffer = HugTripleBufferCreate(sizeof(TestValue));
+    atomic_init(&run.finished, false);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, sProducerMain, &run);
+
+    size_t torn = 0, backwards = 0, reads = 0;
+    uint64_t lastSequence = 0;
+
+    while (1) {
+        bool finished = atomic_load(&run.finished);
+
+        bool isNew;
+        const TestValue *value = HugTripleBufferGetReadPtr(run.buffer, &isNew);
+
+        if (isNew) {
+            if (!sIsValueIntact(value)) torn++;
+            if (value->sequence <= lastSequence) backwards++;
+
+            lastSequence = value->sequence;
+            reads++;
+        }
+
+        if (finished && !isNew) break;
+        if (!isNew) sched_yield();
+    }
+
+    pthread_join(producer, NULL);
+
+    HugTestAssert(torn == 0);
+    HugTestAssert(backwards == 0);
+    HugTestAssert(reads > 0);
+
+    // The final value is never lost
+    HugTestAssert(lastSequence == kThreadedValueCount);
+
+    HugTripleBufferFree(run.buffer);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testLatestValue);
+    HugTestRun(testAlternating);
+    HugTestRun(testThreadedNoTearing);
+
+    return HugTestFinish();
+}
@@ -0,0 +1,155 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugVectorOps.h"
+
+#include <stdlib.h>
+
+#define kMaxCount 67
+
+
+static void sFillRandom(float *samples, size_t count, uint32_t seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = HugTestRandom(&seed);
+    }
+}
+
+
+static void testMaxMagnitude(void)
+{
+    float samples[kMaxCount];
+
+    for (size_t count = 1; count <= kMaxCount; count++) {
+        sFillRandom(samples, count, (uint32_t)count);
+
+        float  expectedMax   = 0;
+        size_t expectedIndex = 0;
+        float  min = samples[0], max = samples[0];
+        size_t minIndex = 0, maxIndex = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            if (samples[i] > max) { max = samples[i]; maxIndex = i; }
+            if (samples[i] < min) { min = samples[i]; minIndex = i; }
+        }
+
+        if (-min > max) { max = -min; maxIndex = minIndex; }
+        if (max > expectedMax) { expectedMax = max; expectedIndex = maxIndex; }
+
+        float  actualMax;
+        size_t actualIndex;
+        HugVectorGetMaxMagnitude(samples, count, &actualMax, &actualIndex);
+
+        HugTestAssert(actualMax == expectedMax);
+        HugTestAssert(actualIndex == expectedIndex);
+    }
+
+    // Ties resolve to the positive peak
+    float tie[4] = { 0.0f, -0.5f, 0.5f, 0.25f };
+    float  tieMax;
+    size_t tieIndex;
+    HugVectorGetMaxMagnitude(tie, 4, &tieMax, &tieIndex);
+    HugTestAssert(tieMax == 0.5f);
+    HugTestAssert(tieIndex == 2);
+
+    float  emptyMax = -1;
+    size_t emptyIndex = 99;
+    HugVectorGetMaxMagnitude(tie, 0, &emptyMax, &emptyIndex);
+    HugTestAssert(emptyMax == 0);
+    HugTestAssert(emptyIndex == 0);
+}
+
+
+static void testElementwise(void)
+{
+    float a[kMaxCount], b[kMaxCount], out[kMaxCount];
+
+    for (size_t count = 0; count <= kMaxCount; count++) {
+        sFillRandom(a, count, 1);
+        sFillRandom(b, count, 2);
+
+        HugVectorMultiplyScalar(a, 0.3f, out, count);
+        for (size_t i = 0; i < count; i++) HugTestAssert(out[i] == a[i] * 0.3f);
+
+        HugVectorMultiply(a, b, out, count);
+        for (size_t i = 0; i < count; i++) HugTestAssert(out[i] == a[i] * b[i]);
+
+        HugVectorFillRamp(out, 0.125f, -2.0f, 0.5f, count);
+        for (size_t i = 0; i < count; i++) HugTestAssert(out[i] == (((float)i * 0.125f) * -2.0f) + 0.5f);
+
+        double d[kMaxCount];
+        HugVectorConvertToDouble(a, d, count);
+        for (size_t i = 0; i < count; i++) HugTestAssert(d[i] == (double)a[i]);
+    }
+}
+
+
+static void testReductions(void)
+{
+    float  samples[kMaxCount];
+    double doubles[kMaxCount];
+
+    for (size_t count = 1; count <= kMaxCount; count++) {
+        sFillRandom(samples, count, 7);
+
+        double expected = 0;
+        for (size_t i = 0; i < count; i++) {
+            expected += samples[i] * (double)samples[i];
+            doubles[i] = samples[i];
+        }
+
+        HugTestAssertClose(HugVectorGetMeanSquare(samples, count), expected / count, 1e-5);
+        HugTestAssertClose(HugVectorGetSumOfSquaresD(doubles, count), expected, 1e-12);
+
+        float min, max;
+        HugVectorGetMinMax(samples, count, &min, &max);
+
+        for (size_t i = 0; i < count; i++) {
+            HugTestAssert(samples[i] >= min && samples[i] <= max);
+        }
+
+        float fusedMin, fusedMax, fusedSum;
+        HugVectorGetMinMaxSumOfSquares(samples, count, &fusedMin, &fusedMax, &fusedSum);
+
+        HugTestAssert(fusedMin == min && fusedMax == max);
+        HugTestAssertClose(fusedSum, expected, 1e-5 * count);
+    }
+}
+
+
+static void testBiquad(void)
+{
+    // One-pole lowpass expressed as a biquad, compared with direct recursion
+    const double coefficients[5] = { 0.2, 0.1, 0.05, -0.5, 0.1 };
+
+    double input[kMaxCount + 2];
+    double output[kMaxCount + 2];
+    uint32_t seed = 3;
+
+    for (size_t i = 0; i < kMaxCount + 2; i++) input[i] = HugTestRandom(&seed);
+    output[0] = 0.25;
+    output[1] = -0.125;
+
+    HugVectorBiquadD(input, output, coefficients, kMaxCount);
+
+    double y2 = 0.25, y1 = -0.125;
+    for (size_t n = 2; n < kMaxCount + 2; n++) {
+        double y = (0.2 * input[n]) + (0.1 * input[n - 1]) + (0.05 * input[n - 2]) - (-0.5 * y1) - (0.1 * y2);
+        HugTestAssertClose(output[n], y, 1e-15);
+        y2 = y1; y1 = y;
+    }
+}
+
+
+int main(int argc, const char *argv[])
+{
+    fprintf(stderr, "Backend: %s\n", HugVectorGetBackendName());
+
+    HugTestRun(testMaxMagnitude);
+    HugTestRun(testElementwise);
+    HugTestRun(testReductions);
+    HugTestRun(testBiquad);
+
+    return HugTestFinish();
+}
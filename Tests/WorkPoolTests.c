@@ -0,0 +1,232 @@
+// (c) 2024 Ricci Adams
+// MIT License (or) 1-clause BSD License
+
+#include "HugTest.h"
+#include "HugWorkPool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define kMaxCheckpoints 100000000
+
+
+typedef struct {
+    _Atomic size_t count;
+    _Atomic bool   released;
+    _Atomic bool   started;
+    _Atomic bool   flag;
+
+    // Execution order, priority of each job
+    _Atomic size_t orderCount;
+    int order[64];
+
+    pthread_t backgroundThread;
+    pthread_t immediateThread;
+    size_t checkpoints;
+} TestState;
+
+
+static HugWorkKey sMakeKey(uint8_t value)
+{
+    HugWorkKey key;
+    memset(&key, value, sizeof(key));
+    return key;
+}
+
+
+static void sIncrement(HugWorkJob *job, void *context)
+{
+    TestState *state = context;
+    atomic_fetch_add(&state->count, 1);
+}
+
+
+static void sBlockUntilReleased(HugWorkJob *job, void *context)
+{
+    TestState *state = context;
+    atomic_store(&state->started, true);
+
+    while (!atomic_load(&state->released)) {
+        sched_yield();
+    }
+}
+
+
+static void sRecordOrder(HugWorkJob *job, void *context)
+{
+    TestState *state = context;
+
+    size_t index = atomic_fetch_add(&state->orderCount, 1);
+    if (index < 64) state->order[index] = HugWorkJobGetPriority(job);
+}
+
+
+static void testRunsEveryJob(void)
+{
+    HugWorkPool *pool = HugWorkPoolCreate(4);
+    TestState state = {0};
+
+    for (size_t i = 0; i < 1000; i++) {
+        HugWorkPriority priority = (i % 3) ? HugWorkPriorityBackground : HugWorkPriorityImmediate;
+        HugWorkPoolSubmit(pool, priority, sMakeKey(0), sIncrement, &state);
+    }
+
+    HugWorkPoolWaitUntilIdle(pool);
+
+    HugWorkPoolStats stats = HugWorkPoolGetStats(pool);
+
+    HugTestAssert(atomic_load(&state.count) == 1000);
+    HugTestAssert(stats.threadCount == 4);
+    HugTestAssert(stats.submitted == 1000);
+    HugTestAssert(stats.completed == 1000);
+    HugTestAssert(stats.queuedImmediate == 0 && stats.queuedBackground == 0 && stats.running == 0);
+
+    HugWorkPoolFree(pool);
+
+    // Zero picks the core count
+    pool = HugWorkPoolCreate(0);
+    HugTestAssert(HugWorkPoolGetStats(pool).threadCount >= 1);
+    HugWorkPoolFree(pool);
+}
+
+
+static void testImmediateFirst(void)
+{
+    HugWorkPool *pool = HugWorkPoolCreate(1);
+    TestState state = {0};
+
+    HugWorkPoolSubmit(pool, HugWorkPriorityBackground, sMakeKey(0), sBlockUntilReleased, &state);
+    while (!atomic_load(&state.started)) sched_yield();
+
+    for (size_t i = 0; i < 5; i++) {
+        HugWorkPoolSubmit(pool, HugWorkPriorityBackground, sMakeKey(0), sRecordOrder, &state);
+        HugWorkPoolSubmit(pool, HugWorkPriorityImmediate,  sMakeKey(0), sRecordOrder, &state);
+    }
+
+    HugWorkPoolStats stats = HugWorkPoolGetStats(pool);
+    HugTestAssert(stats.queuedImmediate == 5);
+    HugTestAssert(stats.queuedBackground == 5);
+    HugTestAssert(stats.running == 1);
+
+    atomic_store(&state.released, true);
+    HugWorkPoolWaitUntilIdle(pool);
+
+    HugTestAssert(atomic_load(&state.orderCount) == 10);
+
+    bool inOrder = true;
+    for (size_t i = 0; i < 10; i++) {
+        int expected = (i < 5) ? HugWorkPriorityImmediate : HugWorkPriorityBackground;
+        if (state.order[i] != expected) inOrder = false;
+    }
+
+    HugTestAssert(inOrder);
+
+    HugWorkPoolFree(pool);
+}
+
+
+static void sSetFlag(HugWorkJob *job, void *context)
+{
+    TestState *state = context;
+
+    state->immediateThread = pthread_self();
+    atomic_store(&state->flag, true);
+}
+
+
+static void sCheckpointUntilFlag(HugWorkJob *job, void *context)
+{
+    TestState *state = context;
+
+    state->backgroundThread = pthread_self();
+    atomic_store(&state->started, true);
+
+    for (size_t i = 0; i < kMaxCheckpoints && !atomic_load(&state->flag); i++) {
+        HugWorkJobCheckpoint(job, 10);
+        state->checkpoints++;
+    }
+}
+
+
+static void testPreemption(void)
+{
+    HugWorkPool *pool = HugWorkPoolCreate(1);
+    TestState state = {0};
+
+    HugWorkPoolSubmit(pool, HugWorkPriorityBackground, sMakeKey(1), sCheckpointUntilFlag, &state);
+    while (!atomic_load(&state.started)) sched_yield();
+
+    // The only thread is busy; the background job runs this at its next checkpoint
+    HugWorkPoolSubmit(pool, HugWorkPriorityImmediate, sMakeKey(2), sSetFlag, &state);
+    HugWorkPoolWaitUntilIdle(pool);
+
+    HugWorkPoolStats stats = HugWorkPoolGetStats(pool);
+
+    HugTestAssert(atomic_load(&state.flag));
+    HugTestAssert(state.checkpoints < kMaxCheckpoints);
+    HugTestAssert(pthread_equal(state.backgroundThread, state.immediateThread));
+    HugTestAssert(stats.preemptions == 1);
+    HugTestAssert(stats.completed == 2);
+    HugTestAssert(stats.processedUnits == state.checkpoints * 10);
+
+    HugWorkPoolFree(pool);
+}
+
+
+static void sCheckpointUntilCancelled(HugWorkJob *job, void *context)
+{
+    TestState *state = context;
+
+    if (HugWorkJobIsCancelled(job)) {
+        atomic_fetch_add(&state->count, 1);
+        return;
+    }
+
+    atomic_store(&state->started, true);
+
+    for (size_t i = 0; i < kMaxCheckpoints; i++) {
+        if (!HugWorkJobCheckpoint(job, 1)) {
+            atomic_store(&state->flag, true);
+            break;
+        }
+    }
+}
+
+
+static void testCancellation(void)
+{
+    HugWorkPool *pool = HugWorkPoolCreate(1);
+    TestState state = {0};
+
+    HugWorkPoolSubmit(pool, HugWorkPriorityBackground, sMakeKey(7), sCheckpointUntilCancelled, &state);
+    HugWorkPoolSubmit(pool, HugWorkPriorityBackground, sMakeKey(7), sCheckpointUntilCancelled, &state);
+    HugWorkPoolSubmit(pool, HugWorkPriorityBackground, sMakeKey(8), sIncrement, &state);
+
+    while (!atomic_load(&state.started)) sched_yield();
+
+    // Stops the running job mid-loop; the queued one is still called, already cancelled
+    HugWorkPoolCancel(pool, sMakeKey(7));
+    HugWorkPoolWaitUntilIdle(pool);
+
+    HugWorkPoolStats stats = HugWorkPoolGetStats(pool);
+
+    HugTestAssert(atomic_load(&state.flag));
+    HugTestAssert(atomic_load(&state.count) == 2);
+    HugTestAssert(stats.cancelled == 2);
+    HugTestAssert(stats.completed == 1);
+
+    HugWorkPoolFree(pool);
+}
+
+
+int main(int argc, const char *argv[])
+{
+    HugTestRun(testRunsEveryJob);
+    HugTestRun(testImmediateFirst);
+    HugTestRun(testPreemption);
+    HugTestRun(testCancellation);
+
+    return HugTestFinish();
+}